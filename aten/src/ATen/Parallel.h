@@ -125,6 +125,46 @@ CAFFE2_API std::shared_ptr<c10::ivalue::Future> intraop_launch_future(
 // Returns number of intra-op threads used by default
 CAFFE2_API int intraop_default_num_threads();
 
+// Counters of NUMA-aware intra-op parallelism. The native backend switches to
+// one intra-op pool per NUMA node when NUMA is enabled
+// (--caffe2_cpu_numa_enabled) on a machine with several nodes; parallel tasks
+// are then assigned to the nodes in contiguous blocks of the iteration range.
+struct NUMAStats {
+  // COUNT: parallel tasks that ran on the node their block was assigned to
+  int64_t local_tasks = 0;
+  // COUNT: parallel tasks that ran on another node
+  int64_t remote_tasks = 0;
+  // COUNT: CPU allocations on the node of the allocating thread
+  int64_t local_allocations = 0;
+  // COUNT: CPU allocations on another node (e.g. reused cached blocks)
+  int64_t remote_allocations = 0;
+  // COUNT: CPU allocations placed by first touch
+  // (--caffe2_cpu_numa_first_touch)
+  int64_t first_touch_allocations = 0;
+};
+
+CAFFE2_API NUMAStats get_numa_stats();
+CAFFE2_API void reset_numa_stats();
+
+namespace internal {
+// Records a parallel task assigned to NUMA node `numa_node_id`
+CAFFE2_API void record_numa_task(int numa_node_id);
+
+// Number of the `nthreads` intra-op threads that go to NUMA node `node`: the
+// threads are spread evenly across the `num_nodes` nodes, and the first
+// nthreads % num_nodes nodes get one more
+CAFFE2_API int numa_node_num_threads(int nthreads, int num_nodes, int node);
+
+// NUMA node that task `task_id` of a parallel loop of `num_tasks` tasks is
+// assigned to: consecutive nodes get contiguous blocks of tasks, in
+// proportion to their number of threads (see numa_node_num_threads)
+CAFFE2_API int numa_node_for_task(
+    size_t task_id,
+    size_t num_tasks,
+    int nthreads,
+    int num_nodes);
+} // namespace internal
+
 } // namespace at
 
 #if AT_PARALLEL_OPENMP
@@ -133,4 +173,6 @@ CAFFE2_API int intraop_default_num_threads();
 #include <ATen/ParallelNative.h>
 #elif AT_PARALLEL_NATIVE_TBB
 #include <ATen/ParallelNativeTBB.h>
+#elif AT_PARALLEL_WORK_STEALING
+#include <ATen/ParallelWorkStealing.h>
 #endif
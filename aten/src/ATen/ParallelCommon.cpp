@@ -3,7 +3,9 @@
 #include <ATen/Config.h>
 #include <ATen/PTThreadPool.h>
 #include <ATen/Version.h>
+#include <c10/util/numa.h>
 
+#include <atomic>
 #include <sstream>
 #include <thread>
 
@@ -40,6 +42,9 @@ size_t get_env_num_threads(const char* var_name, size_t def_value = 0) {
   return def_value;
 }
 
+std::atomic<int64_t> numa_local_tasks{0};
+std::atomic<int64_t> numa_remote_tasks{0};
+
 } // namespace
 
 std::string get_parallel_info() {
@@ -78,6 +83,8 @@ std::string get_parallel_info() {
   ss << "native thread pool";
   #elif AT_PARALLEL_NATIVE_TBB
   ss << "native thread pool and TBB";
+  #elif AT_PARALLEL_WORK_STEALING
+  ss << "work-stealing thread pool";
   #endif
   #ifdef C10_MOBILE
   ss << " [mobile]";
@@ -107,4 +114,55 @@ int intraop_default_num_threads() {
 #endif
 }
 
+NUMAStats get_numa_stats() {
+  NUMAStats stats;
+  stats.local_tasks = numa_local_tasks.load();
+  stats.remote_tasks = numa_remote_tasks.load();
+  auto alloc_stats = c10::GetNUMAAllocationStats();
+  stats.local_allocations = alloc_stats.local;
+  stats.remote_allocations = alloc_stats.remote;
+  stats.first_touch_allocations = alloc_stats.first_touch;
+  return stats;
+}
+
+void reset_numa_stats() {
+  numa_local_tasks = 0;
+  numa_remote_tasks = 0;
+  c10::ResetNUMAAllocationStats();
+}
+
+namespace internal {
+
+void record_numa_task(int numa_node_id) {
+  if (c10::GetCurrentNUMANode() == numa_node_id) {
+    numa_local_tasks.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    numa_remote_tasks.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+int numa_node_num_threads(int nthreads, int num_nodes, int node) {
+  return nthreads / num_nodes + (node < nthreads % num_nodes ? 1 : 0);
+}
+
+int numa_node_for_task(
+    size_t task_id,
+    size_t num_tasks,
+    int nthreads,
+    int num_nodes) {
+  // The thread the task would run on if tasks were spread evenly across
+  // all threads, with the threads numbered node by node
+  const int thread = static_cast<int>(task_id * nthreads / num_tasks);
+  const int per_node = nthreads / num_nodes;
+  const int larger_nodes = nthreads % num_nodes;
+  // The first larger_nodes nodes have per_node + 1 threads
+  const int larger_threads = larger_nodes * (per_node + 1);
+  if (thread < larger_threads) {
+    return thread / (per_node + 1);
+  }
+  return larger_nodes + (thread - larger_threads) / per_node;
+}
+
+} // namespace internal
+
 } // namespace at
@@ -75,12 +75,107 @@ TaskThreadPoolBase& _get_intraop_pool() {
   return *pool;
 }
 
+// NUMA mode: with NUMA enabled on a machine with several nodes, the intra-op
+// threads are split into one pool per node, bound to that node. Parallel
+// loops assign contiguous blocks of their tasks to the nodes in order, so
+// consecutive loops over the same range touch the same part of their tensors
+// from the same node. Together with --caffe2_cpu_numa_first_touch the pages of
+// freshly allocated outputs end up on the node that writes them. With fewer
+// intra-op threads than nodes, some nodes would have no thread, so the
+// regular pool is used instead.
+bool _numa_mode() {
+  static bool numa_mode = []() {
+    if (!c10::IsNUMAEnabled() || c10::GetNumNUMANodes() <= 1) {
+      return false;
+    }
+    // Decided before any pool is initialized, which consumes the value
+    int nthreads = num_intraop_threads.load();
+    if (nthreads == NOT_SET) {
+      nthreads = intraop_default_num_threads();
+    }
+    return nthreads >= c10::GetNumNUMANodes();
+  }();
+  return numa_mode;
+}
+
+int _num_numa_threads() {
+  static int nthreads = []() {
+    int nthreads = num_intraop_threads.exchange(CONSUMED);
+    if (nthreads == NOT_SET) {
+      nthreads = intraop_default_num_threads();
+    }
+    return nthreads;
+  }();
+  return nthreads;
+}
+
+std::vector<std::shared_ptr<TaskThreadPoolBase>>& _get_numa_pools() {
+  static std::vector<std::shared_ptr<TaskThreadPoolBase>> pools = []() {
+    int nthreads = _num_numa_threads();
+    int num_nodes = c10::GetNumNUMANodes();
+    // The calling thread only waits for the per-node pools, so all threads
+    // go to the pools.
+    std::vector<std::shared_ptr<TaskThreadPoolBase>> node_pools;
+    for (int node = 0; node < num_nodes; ++node) {
+      node_pools.push_back(std::make_shared<PTThreadPool>(
+          internal::numa_node_num_threads(nthreads, num_nodes, node), node));
+    }
+    return node_pools;
+  }();
+  return pools;
+}
+
+// Total number of intra-op threads once the pools are initialized
+int _num_intraop_threads() {
+  if (_numa_mode()) {
+    _get_numa_pools();
+    return _num_numa_threads();
+  }
+  // plus one because of master thread
+  return _get_intraop_pool().size() + 1;
+}
+
+bool _in_intraop_pool() {
+  if (_numa_mode()) {
+    for (auto& pool : _get_numa_pools()) {
+      if (pool->inThreadPool()) {
+        return true;
+      }
+    }
+    return false;
+  }
+  return _get_intraop_pool().inThreadPool();
+}
+
+TaskThreadPoolBase& _get_launch_pool() {
+  if (_numa_mode()) {
+    auto& pools = _get_numa_pools();
+    int node = c10::GetCurrentNUMANode();
+    return *pools[node >= 0 ? node % pools.size() : 0];
+  }
+  return _get_intraop_pool();
+}
+
 #endif // C10_MOBILE
 
 // Run lambda function `fn` over `task_id` in [0, `range`) with threadpool.
 // `fn` will be called with params: (thread_pool_task_id, task_id).
 void _run_with_pool(const std::function<void(int, size_t)>& fn, size_t range) {
 #ifndef C10_MOBILE
+  if (_numa_mode()) {
+    // Contiguous blocks of tasks go to consecutive nodes; the calling thread
+    // only waits.
+    auto& pools = _get_numa_pools();
+    const int nthreads = _num_numa_threads();
+    for (size_t i = 0; i < range; ++i) {
+      int node = internal::numa_node_for_task(i, range, nthreads, pools.size());
+      pools[node]->run([fn, i, node]() {
+        internal::record_numa_task(node);
+        fn((int)i, i);
+      });
+    }
+    return;
+  }
   for (size_t i = 1; i < range; ++i) {
     _get_intraop_pool().run([fn, i]() { fn((int)i, i); });
   }
@@ -183,8 +278,7 @@ void set_num_threads(int nthreads) {
     // check that requested size is the same as the current one
     int stored_nthreads = num_intraop_threads.load();
     if (stored_nthreads <= 0) {
-      // plus one because of master thread
-      stored_nthreads = _get_intraop_pool().size() + 1;
+      stored_nthreads = _num_intraop_threads();
     }
     if (stored_nthreads != nthreads) {
       TORCH_WARN(
@@ -209,7 +303,7 @@ int get_num_threads() {
     return intraop_default_num_threads();
   } else {
     TORCH_INTERNAL_ASSERT(nthreads == CONSUMED);
-    return _get_intraop_pool().size() + 1;
+    return _num_intraop_threads();
   }
 #else
   caffe2::ThreadPool* pool = caffe2::mobile_threadpool();
@@ -227,7 +321,7 @@ bool in_parallel_region() {
   return in_parallel_region_ || (
     num_intraop_threads.load() == CONSUMED &&
     // Needed as intraop_launch() doesn't set in_parallel_region().
-    _get_intraop_pool().inThreadPool()
+    _in_intraop_pool()
   );
 #else
   return in_parallel_region_;
@@ -237,7 +331,7 @@ bool in_parallel_region() {
 void intraop_launch(std::function<void()> func) {
 #ifndef C10_MOBILE
   if (!in_parallel_region() && get_num_threads() > 1) {
-    _get_intraop_pool().run(func);
+    _get_launch_pool().run(func);
   } else {
     // execute inline if we're in parallel region
     func();
@@ -254,7 +348,7 @@ std::shared_ptr<c10::ivalue::Future> intraop_launch_future(
 #ifndef C10_MOBILE
   auto future = std::make_shared<c10::ivalue::Future>(c10::NoneType::get());
   if (!in_parallel_region() && get_num_threads() > 1) {
-    _get_intraop_pool().run(
+    _get_launch_pool().run(
       [func, future]() {
         func();
         future->markCompleted();
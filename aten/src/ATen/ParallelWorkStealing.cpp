@@ -0,0 +1,509 @@
+#if AT_PARALLEL_WORK_STEALING
+#include <ATen/Parallel.h>
+
+#include <c10/util/thread_name.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef TH_BLAS_MKL
+#include <mkl.h>
+#endif
+
+namespace at {
+namespace {
+// set in pool workers for their whole lifetime, and in the calling thread
+// while it executes parallel primitives
+thread_local bool in_parallel_region_ = false;
+
+// thread number: 0 for the calling thread, 1 + worker index for pool workers
+thread_local size_t thread_num_ = 0;
+
+const int NOT_SET = -1;
+const int CONSUMED = -2;
+
+// Number of threads set by the user
+// NOT_SET -> positive value -> CONSUMED
+// or
+// NOT_SET -> CONSUMED
+// Meaning:
+//  - NOT_SET - pool not initialized, user value is not set
+//  - positive value - pool not initialized, user value set
+//  - CONSUMED - pool is initialized
+std::atomic<int> num_intraop_threads{NOT_SET};
+
+// Adaptive ranges are never split into chunks smaller than
+// 1 / (kMaxChunksPerThread * num_threads) of the loop, which bounds the
+// scheduling overhead for loops with cheap bodies.
+constexpr int64_t kMaxChunksPerThread = 16;
+
+// Number of times an idle worker polls the queues before going to sleep.
+constexpr int kSpinCount = 64;
+
+int _num_pool_threads(int nthreads) {
+  if (nthreads == NOT_SET) {
+    nthreads = intraop_default_num_threads();
+  } else {
+    TORCH_INTERNAL_ASSERT(nthreads > 0);
+  }
+  // minus one because of the master thread
+  return nthreads - 1;
+}
+
+// A parallel primitive invocation. Loop jobs live on the stack of the calling
+// thread, which waits for `remaining` to drop to zero; launched jobs are
+// owned by the pool and deleted once executed.
+struct Job {
+  // Adaptive loop (parallel_for): ranges may be split down to chunk_size.
+  const std::function<void(int64_t, int64_t)>* adaptive_fn = nullptr;
+  // Chunked loop (parallel_reduce): fixed chunks of chunk_size, the chunk
+  // index is passed as task id.
+  const std::function<void(int64_t, int64_t, size_t)>* chunked_fn = nullptr;
+  // intraop_launch
+  std::function<void()> launch_fn;
+
+  int64_t begin = 0;
+  int64_t chunk_size = 1;
+
+  // Number of elements not processed yet.
+  std::atomic<int64_t> remaining{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr eptr;
+
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  bool done = false;
+};
+
+struct Task {
+  Job* job;
+  int64_t begin;
+  int64_t end;
+};
+
+// RAII guard marking the calling thread as in a parallel region while it
+// executes tasks; pool workers are always in a parallel region.
+struct ParallelRegionGuard {
+  ParallelRegionGuard() : prev_(in_parallel_region_) {
+    in_parallel_region_ = true;
+  }
+
+  ~ParallelRegionGuard() {
+    in_parallel_region_ = prev_;
+  }
+
+ private:
+  bool prev_;
+};
+
+// Work-stealing scheduler: every worker owns a deque, pushing and popping
+// tasks at its back and stealing from the front of other workers' deques
+// when its own is empty. Calling threads are assigned one of the deques for
+// the tasks they split off. Ranges are split lazily: a thread executing a
+// range only splits off its upper half when its deque is empty, i.e. when
+// the previously split-off work has been stolen, so the number of tasks
+// adapts to how unevenly the work is distributed.
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(int num_workers) {
+    for (int i = 0; i < num_workers; ++i) {
+      queues_.emplace_back(new WorkQueue());
+    }
+    for (int i = 0; i < num_workers; ++i) {
+      threads_.emplace_back([this, i]() { workerLoop(i); });
+    }
+  }
+
+  ~WorkStealingPool() {
+    {
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      running_ = false;
+      sleep_cv_.notify_all();
+    }
+    for (auto& t : threads_) {
+      try {
+        t.join();
+      } catch (const std::exception&) {
+      }
+    }
+  }
+
+  size_t size() const {
+    return threads_.size();
+  }
+
+  // Executes [begin, end) of a loop job on the calling thread, helps with
+  // its other tasks and returns once all of job.remaining has been
+  // processed.
+  void runAndWait(Job& job, int64_t begin, int64_t end) {
+    const int queue = callerQueue();
+    {
+      ParallelRegionGuard guard;
+      execute(queue, Task{&job, begin, end});
+      // Help with the parts of this job that have been split off but not
+      // picked up yet. Tasks of other jobs are left alone, they could
+      // observe an unexpected get_thread_num().
+      Task task;
+      while (job.remaining.load() > 0 && steal(-1, &task, &job)) {
+        execute(queue, task);
+      }
+    }
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.done_cv.wait(lock, [&job]() { return job.done; });
+  }
+
+  // Queues a task to be picked up by the workers.
+  void runLater(const Task& task) {
+    push(callerQueue(), task);
+  }
+
+  void launch(std::function<void()> func) {
+    auto* job = new Job();
+    job->launch_fn = std::move(func);
+    job->remaining.store(1);
+    push(callerQueue(), Task{job, 0, 1});
+  }
+
+ private:
+  struct alignas(64) WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::atomic<size_t> size{0};
+  };
+
+  int callerQueue() {
+    static std::atomic<int> next_queue{0};
+    thread_local int queue = next_queue++ % queues_.size();
+    return queue;
+  }
+
+  void push(int queue, const Task& task) {
+    auto& q = *queues_[queue];
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(task);
+      q.size.store(q.tasks.size(), std::memory_order_relaxed);
+    }
+    pending_.fetch_add(1);
+    if (sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      sleep_cv_.notify_one();
+    }
+  }
+
+  bool popLocal(int queue, Task* task) {
+    auto& q = *queues_[queue];
+    if (q.size.load(std::memory_order_relaxed) == 0) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) {
+      return false;
+    }
+    *task = q.tasks.back();
+    q.tasks.pop_back();
+    q.size.store(q.tasks.size(), std::memory_order_relaxed);
+    pending_.fetch_sub(1);
+    return true;
+  }
+
+  // Steals the oldest task (the largest range) from another deque. If
+  // `only_job` is set, only tasks belonging to it are taken.
+  bool steal(int self, Task* task, const Job* only_job) {
+    const size_t num_queues = queues_.size();
+    const size_t start = nextVictim() % num_queues;
+    for (size_t i = 0; i < num_queues; ++i) {
+      const size_t victim = (start + i) % num_queues;
+      if ((int)victim == self) {
+        continue;
+      }
+      auto& q = *queues_[victim];
+      if (q.size.load(std::memory_order_relaxed) == 0) {
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(q.mutex);
+      for (auto it = q.tasks.begin(); it != q.tasks.end(); ++it) {
+        if (!only_job || it->job == only_job) {
+          *task = *it;
+          q.tasks.erase(it);
+          q.size.store(q.tasks.size(), std::memory_order_relaxed);
+          pending_.fetch_sub(1);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  static size_t nextVictim() {
+    // xorshift, seeded differently for every thread
+    thread_local uint64_t state =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  void execute(int queue, Task task) {
+    Job* job = task.job;
+    if (job->launch_fn) {
+      try {
+        job->launch_fn();
+      } catch (const std::exception&) {
+      }
+      delete job;
+      return;
+    }
+    if (job->chunked_fn) {
+      runChunk(job, task.begin, task.end);
+      return;
+    }
+    int64_t begin = task.begin;
+    int64_t end = task.end;
+    while (begin < end) {
+      if (end - begin >= 2 * job->chunk_size &&
+          queues_[queue]->size.load(std::memory_order_relaxed) == 0) {
+        int64_t mid = begin + (end - begin) / 2;
+        push(queue, Task{job, mid, end});
+        end = mid;
+        continue;
+      }
+      int64_t chunk_end = std::min(end, begin + job->chunk_size);
+      runChunk(job, begin, chunk_end);
+      begin = chunk_end;
+    }
+  }
+
+  void runChunk(Job* job, int64_t begin, int64_t end) {
+    if (!job->failed.load(std::memory_order_relaxed)) {
+      try {
+        if (job->chunked_fn) {
+          (*job->chunked_fn)(
+              begin, end, (begin - job->begin) / job->chunk_size);
+        } else {
+          (*job->adaptive_fn)(begin, end);
+        }
+      } catch (...) {
+        if (!job->failed.exchange(true)) {
+          job->eptr = std::current_exception();
+        }
+      }
+    }
+    if (job->remaining.fetch_sub(end - begin) == end - begin) {
+      std::lock_guard<std::mutex> lock(job->mutex);
+      job->done = true;
+      job->done_cv.notify_all();
+    }
+  }
+
+  void workerLoop(int id) {
+    c10::setThreadName("PTWorkStealing");
+    at::init_num_threads();
+    in_parallel_region_ = true;
+    thread_num_ = id + 1;
+
+    Task task;
+    int spins = 0;
+    while (true) {
+      if (popLocal(id, &task) || steal(id, &task, nullptr)) {
+        execute(id, task);
+        spins = 0;
+        continue;
+      }
+      if (++spins < kSpinCount) {
+        std::this_thread::yield();
+        continue;
+      }
+      spins = 0;
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      sleeping_.fetch_add(1);
+      sleep_cv_.wait(
+          lock, [this]() { return !running_ || pending_.load() > 0; });
+      sleeping_.fetch_sub(1);
+      if (!running_) {
+        break;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::vector<std::thread> threads_;
+
+  // Number of tasks sitting in the deques.
+  std::atomic<int64_t> pending_{0};
+  // Number of workers blocked on sleep_cv_.
+  std::atomic<int> sleeping_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  bool running_ = true;
+};
+
+WorkStealingPool& _get_intraop_pool() {
+  static WorkStealingPool pool(
+      _num_pool_threads(num_intraop_threads.exchange(CONSUMED)));
+  return pool;
+}
+
+void _run_inline(const std::function<void()>& fn) {
+  ParallelRegionGuard guard;
+  fn();
+}
+
+} // namespace
+
+namespace internal {
+
+void _parallel_run(
+  const int64_t begin,
+  const int64_t end,
+  const int64_t grain_size,
+  const std::function<void(int64_t, int64_t, size_t)>& f) {
+  size_t num_tasks, chunk_size;
+  std::tie(num_tasks, chunk_size) =
+      internal::calc_num_tasks_and_chunk_size(begin, end, grain_size);
+  auto& pool = _get_intraop_pool();
+  if (num_tasks == 1 || pool.size() == 0) {
+    _run_inline([&]() {
+      for (size_t task_id = 0; task_id < num_tasks; ++task_id) {
+        int64_t local_start = begin + task_id * chunk_size;
+        int64_t local_end = std::min(end, (int64_t)(local_start + chunk_size));
+        f(local_start, local_end, task_id);
+      }
+    });
+    return;
+  }
+
+  Job job;
+  job.chunked_fn = &f;
+  job.begin = begin;
+  job.chunk_size = chunk_size;
+  // Fixed chunks are never split; push all but the first one up front and
+  // let the workers steal them.
+  job.remaining.store(end - begin);
+  for (size_t task_id = 1; task_id < num_tasks; ++task_id) {
+    int64_t local_start = begin + task_id * chunk_size;
+    int64_t local_end = std::min(end, (int64_t)(local_start + chunk_size));
+    pool.runLater(Task{&job, local_start, local_end});
+  }
+  pool.runAndWait(job, begin, std::min(end, (int64_t)(begin + chunk_size)));
+  if (job.eptr) {
+    std::rethrow_exception(job.eptr);
+  }
+}
+
+void _parallel_run_adaptive(
+  const int64_t begin,
+  const int64_t end,
+  const int64_t grain_size,
+  const std::function<void(int64_t, int64_t)>& f) {
+  auto& pool = _get_intraop_pool();
+  if (pool.size() == 0) {
+    _run_inline([&]() { f(begin, end); });
+    return;
+  }
+
+  Job job;
+  job.adaptive_fn = &f;
+  job.begin = begin;
+  job.chunk_size = std::max<int64_t>(
+      std::max<int64_t>(grain_size, 1),
+      divup(end - begin, (pool.size() + 1) * kMaxChunksPerThread));
+  job.remaining.store(end - begin);
+  pool.runAndWait(job, begin, end);
+  if (job.eptr) {
+    std::rethrow_exception(job.eptr);
+  }
+}
+
+} // namespace internal
+
+void init_num_threads() {
+#ifdef _OPENMP
+  omp_set_num_threads(1);
+#endif
+
+#ifdef TH_BLAS_MKL
+  mkl_set_num_threads(1);
+#endif
+}
+
+void set_num_threads(int nthreads) {
+  TORCH_CHECK(nthreads > 0, "Expected positive number of threads");
+  int no_value = NOT_SET;
+  if (!num_intraop_threads.compare_exchange_strong(no_value, nthreads)) {
+    // num_intraop_threads either stores a positive integer or CONSUMED,
+    // check that requested size is the same as the current one
+    int stored_nthreads = num_intraop_threads.load();
+    if (stored_nthreads <= 0) {
+      // plus one because of master thread
+      stored_nthreads = _get_intraop_pool().size() + 1;
+    }
+    if (stored_nthreads != nthreads) {
+      TORCH_WARN(
+        "Cannot set number of intraop threads "
+        "after parallel work has started or after set_num_threads call "
+        "when using work-stealing parallel backend");
+    }
+  }
+}
+
+int get_num_threads() {
+  // not initializing pool unnecessarily,
+  // because pool cannot be resized after initialization
+  int nthreads = num_intraop_threads.load();
+  if (nthreads > 0) {
+    return nthreads;
+  } else if (nthreads == NOT_SET) {
+    return intraop_default_num_threads();
+  } else {
+    TORCH_INTERNAL_ASSERT(nthreads == CONSUMED);
+    return _get_intraop_pool().size() + 1;
+  }
+}
+
+int get_thread_num() {
+  return thread_num_;
+}
+
+bool in_parallel_region() {
+  return in_parallel_region_;
+}
+
+void intraop_launch(std::function<void()> func) {
+  if (!in_parallel_region() && get_num_threads() > 1) {
+    _get_intraop_pool().launch(std::move(func));
+  } else {
+    // execute inline if we're in parallel region
+    func();
+  }
+}
+
+std::shared_ptr<c10::ivalue::Future> intraop_launch_future(
+    std::function<void()> func) {
+  auto future = std::make_shared<c10::ivalue::Future>(c10::NoneType::get());
+  if (!in_parallel_region() && get_num_threads() > 1) {
+    _get_intraop_pool().launch(
+      [func, future]() {
+        func();
+        future->markCompleted();
+      }
+    );
+  } else {
+    func();
+    future->markCompleted();
+  }
+  return future;
+}
+
+} // namespace at
+#endif
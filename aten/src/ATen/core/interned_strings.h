@@ -243,7 +243,8 @@ namespace c10 {
   _(attr, types)                     \
   _(attr, scope)                     \
   _(attr, keepdims)                  \
-  _(attr, new_axis)
+  _(attr, new_axis)                  \
+  _(attr, scheduled)
 #else
 #define FORALL_NS_SYMBOLS(_) \
   _(namespaces, prim)              \
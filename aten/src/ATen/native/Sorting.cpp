@@ -7,6 +7,7 @@
 #include <ATen/native/SortingUtils.h>
 #include <ATen/NamedTensorUtils.h>
 #include <ATen/NamedTensorUtils.h>
+#include <ATen/MemoryOverlap.h>
 
 namespace at {
 namespace native {
@@ -183,6 +184,45 @@ std::tuple<Tensor, Tensor> kthvalue(
   return std::make_tuple(values, indices);
 }
 
+std::tuple<Tensor&, Tensor&> sort_out_cpu(
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& self,
+    int64_t dim_,
+    bool descending) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim(), /*wrap_scalar=*/true);
+  TORCH_CHECK(
+      self.options().type_equal(values.options()),
+      "output values must be of same type as input");
+  TORCH_CHECK(
+      indices.dtype() == kLong, "output indices must be of scalar type Long");
+  TORCH_CHECK(
+      indices.device() == self.device(),
+      "output indices must be on same device as input");
+
+  // The kernel reads the input while writing the sorted values.
+  Tensor input = self;
+  if (get_overlap_status(values, self) != MemOverlapStatus::NO) {
+    input = self.clone(at::MemoryFormat::Contiguous);
+  }
+  values.resize_(self.sizes());
+  indices.resize_(self.sizes());
+  assert_no_internal_overlap(values);
+  assert_no_internal_overlap(indices);
+  sort_stub(kCPU, values, indices, input, dim, descending);
+  return std::forward_as_tuple(values, indices);
+}
+
+std::tuple<Tensor, Tensor> sort_cpu(
+    const Tensor& self,
+    int64_t dim,
+    bool descending) {
+  Tensor values = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  sort_out_cpu(values, indices, self, dim, descending);
+  return std::make_tuple(values, indices);
+}
+
 std::tuple<Tensor&, Tensor&> topk_out_cpu(
     Tensor& values,
     Tensor& indices,
@@ -303,6 +343,7 @@ Tensor median_cpu(const Tensor& self) {
   return result.view({});
 }
 
+DEFINE_DISPATCH(sort_stub);
 DEFINE_DISPATCH(topk_stub);
 
 } // namespace native
@@ -2,17 +2,240 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
 
-#include <set>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
 #include <tuple>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 namespace at {
 namespace native{
 
 namespace {
 
+// Inputs with less work than this (in elements) are grouped by a single hash
+// table on the calling thread.
+constexpr int64_t kUniqueParallelThreshold = 1 << 16;
+
+inline uint64_t hash_mix(uint64_t h) {
+  // splitmix64 finalizer
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+template <typename scalar_t>
+inline uint64_t hash_value(scalar_t value) {
+  // 0.0 and -0.0 compare equal, so they must hash equal.
+  if (value == scalar_t(0)) {
+    return hash_mix(0);
+  }
+  uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(scalar_t));
+  return hash_mix(bits);
+}
+
+// Open-addressing hash table with linear probing, grouping element indices
+// into classes of equal elements. Every class keeps the index of its first
+// inserted element as representative, its hash and its number of elements.
+template <typename Equal>
+class ClassTable {
+ public:
+  explicit ClassTable(const Equal& equal) : equal_(equal) {}
+
+  // Returns the id of the class of element `index`, whose hash is `hash`.
+  int64_t insert(int64_t index, uint64_t hash) {
+    if ((reps.size() + 1) * 2 > slots_.size()) {
+      grow();
+    }
+    uint64_t pos = hash & mask_;
+    while (true) {
+      int64_t id = slots_[pos];
+      if (id < 0) {
+        id = reps.size();
+        slots_[pos] = id;
+        reps.push_back(index);
+        hashes_.push_back(hash);
+        counts.push_back(1);
+        return id;
+      }
+      if (hashes_[id] == hash && equal_(reps[id], index)) {
+        counts[id]++;
+        return id;
+      }
+      pos = (pos + 1) & mask_;
+    }
+  }
+
+  std::vector<int64_t> reps;
+  std::vector<int64_t> counts;
+
+ private:
+  void grow() {
+    size_t capacity = std::max<size_t>(16, slots_.size() * 2);
+    slots_.assign(capacity, -1);
+    mask_ = capacity - 1;
+    for (int64_t id = 0; id < static_cast<int64_t>(reps.size()); ++id) {
+      uint64_t pos = hashes_[id] & mask_;
+      while (slots_[pos] >= 0) {
+        pos = (pos + 1) & mask_;
+      }
+      slots_[pos] = id;
+    }
+  }
+
+  const Equal& equal_;
+  std::vector<int64_t> slots_;
+  std::vector<uint64_t> hashes_;
+  uint64_t mask_ = 0;
+};
+
+// Groups the elements [0, n) into classes of equal elements in one pass.
+//
+// Elements are partitioned by the high bits of their hash, and every
+// partition is grouped by its own table on one thread, so no synchronization
+// is needed besides the partitioning itself. On return `reps` and `counts`
+// hold the representative and number of elements of every class, partition
+// after partition, and if `ids` is not null, ids[i] is the class of element i.
+// `work` estimates the cost of the whole input in elements.
+template <typename Hash, typename Equal>
+void group_equal(
+    int64_t n,
+    int64_t work,
+    const Hash& hash,
+    const Equal& equal,
+    std::vector<int64_t>& reps,
+    std::vector<int64_t>& counts,
+    int64_t* ids) {
+  const int num_threads = get_num_threads();
+  if (work < kUniqueParallelThreshold || num_threads == 1) {
+    ClassTable<Equal> table(equal);
+    for (int64_t i = 0; i < n; ++i) {
+      int64_t id = table.insert(i, hash(i));
+      if (ids) {
+        ids[i] = id;
+      }
+    }
+    reps = std::move(table.reps);
+    counts = std::move(table.counts);
+    return;
+  }
+
+  // A few partitions per thread keep the partitions balanced.
+  int partition_bits = 0;
+  while ((1 << partition_bits) < num_threads * 4) {
+    partition_bits++;
+  }
+  const int64_t num_partitions = int64_t(1) << partition_bits;
+  auto partition_of = [partition_bits](uint64_t h) -> int64_t {
+    return h >> (64 - partition_bits);
+  };
+  const int64_t num_chunks = std::min<int64_t>(num_threads, n);
+  const int64_t chunk_size = divup(n, num_chunks);
+
+  // Histogram of partitions per chunk, then the offset of every
+  // (partition, chunk) pair in the partitioned order. Keeping the chunks in
+  // order within a partition makes the first element of every class its
+  // representative, like in the serial case.
+  std::vector<int64_t> offsets(num_chunks * num_partitions, 0);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      int64_t* hist = offsets.data() + c * num_partitions;
+      int64_t last = std::min(n, (c + 1) * chunk_size);
+      for (int64_t i = c * chunk_size; i < last; ++i) {
+        hist[partition_of(hash(i))]++;
+      }
+    }
+  });
+  std::vector<int64_t> partition_begin(num_partitions + 1, 0);
+  int64_t offset = 0;
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    partition_begin[p] = offset;
+    for (int64_t c = 0; c < num_chunks; ++c) {
+      int64_t count = offsets[c * num_partitions + p];
+      offsets[c * num_partitions + p] = offset;
+      offset += count;
+    }
+  }
+  partition_begin[num_partitions] = offset;
+
+  std::vector<int64_t> order(n);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      int64_t* next = offsets.data() + c * num_partitions;
+      int64_t last = std::min(n, (c + 1) * chunk_size);
+      for (int64_t i = c * chunk_size; i < last; ++i) {
+        order[next[partition_of(hash(i))]++] = i;
+      }
+    }
+  });
+
+  // Group every partition; class ids are local to the partition until the
+  // class counts of all partitions are known.
+  std::vector<ClassTable<Equal>> tables(num_partitions, ClassTable<Equal>(equal));
+  parallel_for(0, num_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t p = begin; p < end; ++p) {
+      auto& table = tables[p];
+      for (int64_t k = partition_begin[p]; k < partition_begin[p + 1]; ++k) {
+        int64_t i = order[k];
+        int64_t id = table.insert(i, hash(i));
+        if (ids) {
+          ids[i] = id;
+        }
+      }
+    }
+  });
+
+  std::vector<int64_t> class_begin(num_partitions + 1, 0);
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    class_begin[p + 1] = class_begin[p] + tables[p].reps.size();
+  }
+  reps.resize(class_begin[num_partitions]);
+  counts.resize(class_begin[num_partitions]);
+  parallel_for(0, num_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t p = begin; p < end; ++p) {
+      auto& table = tables[p];
+      std::copy(table.reps.begin(), table.reps.end(),
+                reps.begin() + class_begin[p]);
+      std::copy(table.counts.begin(), table.counts.end(),
+                counts.begin() + class_begin[p]);
+      if (ids) {
+        for (int64_t k = partition_begin[p]; k < partition_begin[p + 1]; ++k) {
+          ids[order[k]] += class_begin[p];
+        }
+      }
+    }
+  });
+}
+
+// Computes the rank of every class when the classes are ordered by `less`
+// applied to their representatives. Returns the classes in sorted order and
+// stores the rank of class j in rank[j].
+template <typename Less>
+std::vector<int64_t> sort_classes(
+    const std::vector<int64_t>& reps,
+    const Less& less,
+    std::vector<int64_t>& rank) {
+  const int64_t num_classes = reps.size();
+  std::vector<int64_t> sorted(num_classes);
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::sort(sorted.begin(), sorted.end(), [&](int64_t a, int64_t b) {
+    return less(reps[a], reps[b]);
+  });
+  rank.resize(num_classes);
+  parallel_for(0, num_classes, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    for (int64_t j = begin; j < end; ++j) {
+      rank[sorted[j]] = j;
+    }
+  });
+  return sorted;
+}
+
 template <typename scalar_t>
 std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
     const Tensor& self,
@@ -22,49 +245,58 @@ std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
   const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data_ptr<scalar_t>();
   int64_t numel = input.numel();
-  Tensor output;
   Tensor inverse_indices = at::empty({0}, self.options().dtype(kLong));
   Tensor counts = at::empty({0}, self.options().dtype(kLong));
 
-  std::unordered_set<scalar_t> set(input_data, input_data + numel);
-  output = at::empty({static_cast<int64_t>(set.size())}, input.options());
-  scalar_t *output_data = output.data_ptr<scalar_t>();
-
+  const bool need_ids = return_inverse || return_counts;
+  if (need_ids) {
+    inverse_indices.resize_(input.sizes());
+  }
+  int64_t* ids = need_ids ? inverse_indices.data_ptr<int64_t>() : nullptr;
+
+  std::vector<int64_t> reps;
+  std::vector<int64_t> class_counts;
+  group_equal(
+      numel,
+      numel,
+      [input_data](int64_t i) { return hash_value(input_data[i]); },
+      [input_data](int64_t a, int64_t b) { return input_data[a] == input_data[b]; },
+      reps,
+      class_counts,
+      ids);
+  const int64_t num_classes = reps.size();
+
+  // Output position of every class.
+  std::vector<int64_t> order;
+  std::vector<int64_t> rank;
   if (sorted) {
-    std::vector<scalar_t> vec(set.begin(), set.end());
-    std::sort(vec.begin(), vec.end());
-    std::copy(vec.begin(), vec.end(), output_data);
-  } else {
-    std::copy(set.begin(), set.end(), output_data);
+    order = sort_classes(
+        reps,
+        [input_data](int64_t a, int64_t b) { return input_data[a] < input_data[b]; },
+        rank);
   }
 
-  if (return_inverse || return_counts) {
-    inverse_indices.resize_(input.sizes());
-    int64_t* inverse_indices_data = inverse_indices.data_ptr<int64_t>();
-    std::unordered_map<scalar_t, int64_t> inverse_map;
-    inverse_map.reserve(output.numel());
-    for (int64_t i = 0; i < output.numel(); ++i) {
-      inverse_map[output_data[i]] = i;
-    }
-    for(int64_t i = 0; i < numel; ++i) {
-      inverse_indices_data[i] = inverse_map[input_data[i]];
-    }
-    if (return_counts) {
-      std::unordered_map<scalar_t, int64_t> counts_map;
-      counts_map.reserve(output.numel());
-      for (int64_t i = 0; i < output.numel(); ++i) {
-        counts_map[output_data[i]] = 0;
-      }
-      for(int64_t i = 0; i < numel; i++) {
-        counts_map[input_data[i]] += 1;
-      }
-      counts.resize_(output.sizes());
-      counts.fill_(0);
-      int64_t *counts_data = counts.data_ptr<int64_t>();
-      for(int64_t i = 0; i < output.numel(); i++) {
-        counts_data[i] = counts_map[output_data[i]];
+  Tensor output = at::empty({num_classes}, input.options());
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  if (return_counts) {
+    counts.resize_({num_classes});
+  }
+  int64_t* counts_data = return_counts ? counts.data_ptr<int64_t>() : nullptr;
+  parallel_for(0, num_classes, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    for (int64_t j = begin; j < end; ++j) {
+      int64_t c = sorted ? order[j] : j;
+      output_data[j] = input_data[reps[c]];
+      if (counts_data) {
+        counts_data[j] = class_counts[c];
       }
     }
+  });
+  if (sorted && need_ids) {
+    parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        ids[i] = rank[ids[i]];
+      }
+    });
   }
   return std::make_tuple(output, inverse_indices, counts);
 }
@@ -121,33 +353,6 @@ std::tuple<Tensor, Tensor, Tensor> unique_consecutive_cpu_template(
   return std::make_tuple(output, inverse_indices, counts);
 }
 
-template<class ForwardIt>
-ForwardIt _unique_dim_cpu_impl(ForwardIt first, ForwardIt last,
-  std::vector<int64_t>& indices, Tensor inverse_indices_vec, Tensor counts) {
-    if (first == last) {
-      return last;
-    }
-    // save to calculate distance to iterators
-    ForwardIt begin = first;
-
-    // set first inverse index and count
-    inverse_indices_vec[indices[0]] = 0;
-    counts[0] += 1;
-
-    ForwardIt result = first;
-    while (++first != last) {
-      if (!at::equal(*result, *first) && ++result != first) {
-          *result = std::move(*first);
-      }
-      int64_t idx_result = std::distance(begin, result);
-      int64_t idx_first = std::distance(begin, first);
-      inverse_indices_vec[indices[idx_first]] = idx_result;
-      counts[idx_result] += 1;
-    }
-
-    return ++result;
-  }
-
 template <typename scalar_t>
 std::tuple<Tensor, Tensor, Tensor> _unique_dim_cpu_template(
     const Tensor& self,
@@ -181,48 +386,107 @@ std::tuple<Tensor, Tensor, Tensor> _unique_dim_cpu_template(
   auto orig_sizes = input_flat.sizes().vec();
   input_flat = input_flat.contiguous().view({input_flat.size(0), -1});
 
-  std::vector<int64_t> indices(input_flat.size(0));
-  std::iota(indices.begin(), indices.end(), 0);
-  int64_t numel = input_flat.size(1);
-  scalar_t* input_flat_ptr = ((scalar_t*)input_flat.data_ptr());
-
-  // sort indices using data
-  if (!consecutive) {
-    std::sort(indices.begin(), indices.end(),
-      [&](int64_t a, int64_t b) -> bool {
-        for (int64_t i = 0; i < numel; ++i) {
-          scalar_t lhs = input_flat_ptr[i + a * numel];
-          scalar_t rhs = input_flat_ptr[i + b * numel];
-          if (lhs < rhs) {
-            return true;
-          } else if (lhs > rhs) {
-            return false;
-          }
-        }
-        return false;
-      });
-  }
+  const int64_t num_rows = input_flat.size(0);
+  const int64_t numel = input_flat.size(1);
+  const scalar_t* input_flat_ptr = input_flat.data_ptr<scalar_t>();
 
-  Tensor input_sorted;
-  if (!consecutive) {
-    input_sorted = at::empty(input_flat.sizes(), input_flat.options());
-    for (size_t i = 0; i < indices.size(); ++i) {
-      input_sorted[i] = input_flat[indices[i]];
+  auto rows_equal = [input_flat_ptr, numel](int64_t a, int64_t b) {
+    const scalar_t* lhs = input_flat_ptr + a * numel;
+    const scalar_t* rhs = input_flat_ptr + b * numel;
+    for (int64_t i = 0; i < numel; ++i) {
+      if (!(lhs[i] == rhs[i])) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  Tensor inverse_indices = at::empty({num_rows}, self.options().dtype(kLong));
+  int64_t* inverse_data = inverse_indices.data_ptr<int64_t>();
+  // Row of the input holding every unique row, in output order.
+  std::vector<int64_t> unique_rows;
+  std::vector<int64_t> unique_counts;
+
+  if (consecutive) {
+    // A row starts a new group unless it equals the previous one.
+    std::vector<int64_t> is_new(num_rows, 1);
+    parallel_for(1, num_rows, std::max<int64_t>(1, internal::GRAIN_SIZE / numel),
+        [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; ++r) {
+        is_new[r] = rows_equal(r - 1, r) ? 0 : 1;
+      }
+    });
+    int64_t group = -1;
+    for (int64_t r = 0; r < num_rows; ++r) {
+      if (is_new[r]) {
+        group++;
+        unique_rows.push_back(r);
+        unique_counts.push_back(0);
+      }
+      inverse_data[r] = group;
+      unique_counts[group]++;
     }
   } else {
-    input_sorted = input_flat;
+    // The current implementation using `dim` always sorts, rows are ordered
+    // lexicographically.
+    std::vector<int64_t> reps;
+    std::vector<int64_t> class_counts;
+    group_equal(
+        num_rows,
+        num_rows * numel,
+        [input_flat_ptr, numel](int64_t r) {
+          const scalar_t* row = input_flat_ptr + r * numel;
+          uint64_t h = 0;
+          for (int64_t i = 0; i < numel; ++i) {
+            h = hash_mix(h ^ hash_value(row[i]));
+          }
+          return h;
+        },
+        rows_equal,
+        reps,
+        class_counts,
+        inverse_data);
+    std::vector<int64_t> rank;
+    std::vector<int64_t> order = sort_classes(
+        reps,
+        [input_flat_ptr, numel](int64_t a, int64_t b) -> bool {
+          for (int64_t i = 0; i < numel; ++i) {
+            scalar_t lhs = input_flat_ptr[i + a * numel];
+            scalar_t rhs = input_flat_ptr[i + b * numel];
+            if (lhs < rhs) {
+              return true;
+            } else if (lhs > rhs) {
+              return false;
+            }
+          }
+          return false;
+        },
+        rank);
+    for (int64_t c : order) {
+      unique_rows.push_back(reps[c]);
+      unique_counts.push_back(class_counts[c]);
+    }
+    parallel_for(0, num_rows, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; ++r) {
+        inverse_data[r] = rank[inverse_data[r]];
+      }
+    });
   }
 
-  Tensor inverse_indices = at::empty(indices.size(), self.options().dtype(kLong));
-  Tensor counts = at::zeros(indices.size(), self.options().dtype(kLong));
-  std::vector<Tensor> input_unbind = at::unbind(input_sorted, 0);
-  auto last = _unique_dim_cpu_impl(
-    input_unbind.begin(), input_unbind.end(), indices, inverse_indices, counts);
-  input_unbind.erase(last, input_unbind.end());
-  counts = at::narrow(counts, 0, 0, input_unbind.size());
+  const int64_t num_unique = unique_rows.size();
+  Tensor counts = at::empty({num_unique}, self.options().dtype(kLong));
+  std::copy(unique_counts.begin(), unique_counts.end(), counts.data_ptr<int64_t>());
+  Tensor output = at::empty({num_unique, numel}, input_flat.options());
+  scalar_t* output_ptr = output.data_ptr<scalar_t>();
+  parallel_for(0, num_unique, std::max<int64_t>(1, internal::GRAIN_SIZE / numel),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t j = begin; j < end; ++j) {
+      std::copy_n(input_flat_ptr + unique_rows[j] * numel, numel,
+                  output_ptr + j * numel);
+    }
+  });
 
   // reshape back
-  auto output = at::stack(input_unbind, 0);
   auto new_sizes = std::vector<int64_t>(orig_sizes);
   new_sizes[0] = -1;
   output = output.view(new_sizes);
@@ -5,10 +5,386 @@
 #include <ATen/native/Sorting.h>
 #include <ATen/native/SortingUtils.h>
 
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
 namespace at { namespace native {
 
 namespace {
 
+// Slices at least this long are sorted (or top-k'd) with all threads instead
+// of one thread per slice.
+constexpr int64_t kParallelSortThreshold = 1 << 16;
+// Below this, a comparison sort beats setting up radix histograms.
+constexpr int64_t kRadixSortMinSize = 256;
+constexpr int64_t kRadixBits = 8;
+constexpr int64_t kRadixSize = 1 << kRadixBits;
+
+// Offset of slice `it` of a tensor with the given sizes and strides, where
+// slices run along `dim` and are numbered in row-major order of the other
+// dimensions.
+inline int64_t slice_offset(
+    IntArrayRef sizes,
+    IntArrayRef strides,
+    int64_t dim,
+    int64_t it) {
+  int64_t offset = 0;
+  for (int64_t d = sizes.size() - 1; d >= 0; d--) {
+    if (d != dim) {
+      offset += (it % sizes[d]) * strides[d];
+      it /= sizes[d];
+    }
+  }
+  return offset;
+}
+
+// Runs f(begin, end) over [0, num_blocks), in parallel if there is more
+// than one block.
+template <typename F>
+inline void for_each_block(int64_t num_blocks, const F& f) {
+  if (num_blocks > 1) {
+    parallel_for(0, num_blocks, 1, f);
+  } else {
+    f(0, num_blocks);
+  }
+}
+
+// Maps a value to an unsigned key whose natural order is the sort order:
+// the sign bit of integers is flipped, negative floats are bit-inverted, NaN
+// maps to the largest key so that it ends up last (numpy compatible), and
+// -0.0 maps to +0.0 so that equal values keep their relative order.
+// Descending order is obtained by inverting the key.
+template <typename scalar_t, typename = void>
+struct SortKey {
+  using type = typename std::make_unsigned<scalar_t>::type;
+  static type encode(scalar_t x) {
+    constexpr type sign = std::is_signed<scalar_t>::value
+        ? type(1) << (sizeof(type) * 8 - 1)
+        : 0;
+    return static_cast<type>(x) ^ sign;
+  }
+};
+
+template <typename scalar_t>
+struct SortKey<
+    scalar_t,
+    typename std::enable_if<std::is_floating_point<scalar_t>::value>::type> {
+  using type = typename std::conditional<
+      sizeof(scalar_t) == 4, uint32_t, uint64_t>::type;
+  static type encode(scalar_t x) {
+    constexpr type sign = type(1) << (sizeof(type) * 8 - 1);
+    if (_isnan(x)) {
+      return ~type(0);
+    }
+    if (x == 0) {
+      x = 0;
+    }
+    type bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits & sign) ? ~bits : (bits | sign);
+  }
+};
+
+template <typename key_t>
+struct SortItem {
+  key_t key;
+  int64_t index;
+};
+
+template <typename key_t>
+inline bool item_less(const SortItem<key_t>& a, const SortItem<key_t>& b) {
+  return a.key < b.key;
+}
+
+// Number of elements of `a` among the first `diag` outputs of a stable merge
+// of a (length na) and b (length nb), where ties are taken from a first.
+template <typename key_t>
+int64_t merge_path(
+    const SortItem<key_t>* a,
+    int64_t na,
+    const SortItem<key_t>* b,
+    int64_t nb,
+    int64_t diag) {
+  int64_t lo = std::max<int64_t>(0, diag - nb);
+  int64_t hi = std::min(diag, na);
+  while (lo < hi) {
+    int64_t i = lo + (hi - lo) / 2;
+    if (!item_less(b[diag - i - 1], a[i])) {
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+// Stable merge sort: `num_blocks` blocks are sorted independently, then
+// merged pairwise. Every merge round is split by output position with
+// merge_path, so the last rounds use all threads as well. Returns whichever
+// of data and tmp holds the result.
+template <typename key_t>
+SortItem<key_t>* merge_sort(
+    SortItem<key_t>* data,
+    SortItem<key_t>* tmp,
+    int64_t n,
+    int64_t num_blocks) {
+  auto block_begin = [&](int64_t b) {
+    return std::min(b, num_blocks) * n / num_blocks;
+  };
+  for_each_block(num_blocks, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      std::stable_sort(
+          data + block_begin(b), data + block_begin(b + 1), item_less<key_t>);
+    }
+  });
+
+  SortItem<key_t>* src = data;
+  SortItem<key_t>* dst = tmp;
+  for (int64_t width = 1; width < num_blocks; width *= 2) {
+    parallel_for(0, n, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t b = 0; b < num_blocks; b += 2 * width) {
+        int64_t lo = block_begin(b);
+        int64_t mid = block_begin(b + width);
+        int64_t hi = block_begin(b + 2 * width);
+        if (hi <= begin || lo >= end) {
+          continue;
+        }
+        int64_t d0 = std::max(begin, lo) - lo;
+        int64_t d1 = std::min(end, hi) - lo;
+        int64_t i0 = merge_path(src + lo, mid - lo, src + mid, hi - mid, d0);
+        int64_t i1 = merge_path(src + lo, mid - lo, src + mid, hi - mid, d1);
+        std::merge(
+            src + lo + i0, src + lo + i1,
+            src + mid + (d0 - i0), src + mid + (d1 - i1),
+            dst + lo + d0,
+            item_less<key_t>);
+      }
+    });
+    std::swap(src, dst);
+  }
+  return src;
+}
+
+// Stable sort of items by key. Uses LSD radix sort, skipping digits that are
+// the same for every key, and falls back to merge sort for wide keys when
+// the remaining passes would cost more than comparison sorting. With
+// `parallel`, every pass is split into per-thread blocks with their own
+// digit histograms. Returns whichever of data and tmp holds the result.
+template <typename key_t>
+SortItem<key_t>* sort_items(
+    SortItem<key_t>* data,
+    SortItem<key_t>* tmp,
+    int64_t n,
+    bool parallel) {
+  if (n < kRadixSortMinSize) {
+    std::stable_sort(data, data + n, item_less<key_t>);
+    return data;
+  }
+  constexpr int64_t kNumDigits = sizeof(key_t) * 8 / kRadixBits;
+  const int64_t num_blocks = parallel
+      ? std::max<int64_t>(
+            1, std::min<int64_t>(get_num_threads(), n / kRadixSortMinSize))
+      : 1;
+  auto block_begin = [&](int64_t b) { return b * n / num_blocks; };
+
+  // One read pass gives the histograms of all digits, which tells which
+  // passes actually move anything.
+  std::vector<int64_t> digit_hist(num_blocks * kNumDigits * kRadixSize, 0);
+  for_each_block(num_blocks, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      int64_t* hist = digit_hist.data() + b * kNumDigits * kRadixSize;
+      for (int64_t i = block_begin(b); i < block_begin(b + 1); i++) {
+        key_t key = data[i].key;
+        for (int64_t d = 0; d < kNumDigits; d++) {
+          hist[d * kRadixSize + ((key >> (d * kRadixBits)) & (kRadixSize - 1))]++;
+        }
+      }
+    }
+  });
+  std::vector<int64_t> passes;
+  for (int64_t d = 0; d < kNumDigits; d++) {
+    int64_t first_digit_count = 0;
+    for (int64_t b = 0; b < num_blocks; b++) {
+      first_digit_count += digit_hist[(b * kNumDigits + d) * kRadixSize +
+          (data[0].key >> (d * kRadixBits) & (kRadixSize - 1))];
+    }
+    if (first_digit_count != n) {
+      passes.push_back(d);
+    }
+  }
+  if (sizeof(key_t) > 4 &&
+      static_cast<int64_t>(passes.size()) * 2 > static_cast<int64_t>(std::log2(n))) {
+    return merge_sort(data, tmp, n, num_blocks);
+  }
+
+  SortItem<key_t>* src = data;
+  SortItem<key_t>* dst = tmp;
+  std::vector<int64_t> offsets(num_blocks * kRadixSize);
+  for (size_t p = 0; p < passes.size(); p++) {
+    const int64_t shift = passes[p] * kRadixBits;
+    // The block histograms from the read pass are only valid for the first
+    // pass; later passes recount the permuted data.
+    if (p == 0) {
+      for (int64_t b = 0; b < num_blocks; b++) {
+        std::copy_n(
+            digit_hist.data() + (b * kNumDigits + passes[p]) * kRadixSize,
+            kRadixSize,
+            offsets.data() + b * kRadixSize);
+      }
+    } else {
+      std::fill(offsets.begin(), offsets.end(), 0);
+      for_each_block(num_blocks, [&](int64_t begin, int64_t end) {
+        for (int64_t b = begin; b < end; b++) {
+          int64_t* hist = offsets.data() + b * kRadixSize;
+          for (int64_t i = block_begin(b); i < block_begin(b + 1); i++) {
+            hist[(src[i].key >> shift) & (kRadixSize - 1)]++;
+          }
+        }
+      });
+    }
+    // Exclusive scan in digit-major, block-minor order keeps the scatter
+    // stable across blocks.
+    int64_t running = 0;
+    for (int64_t digit = 0; digit < kRadixSize; digit++) {
+      for (int64_t b = 0; b < num_blocks; b++) {
+        int64_t count = offsets[b * kRadixSize + digit];
+        offsets[b * kRadixSize + digit] = running;
+        running += count;
+      }
+    }
+    for_each_block(num_blocks, [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; b++) {
+        int64_t* offset = offsets.data() + b * kRadixSize;
+        for (int64_t i = block_begin(b); i < block_begin(b + 1); i++) {
+          dst[offset[(src[i].key >> shift) & (kRadixSize - 1)]++] = src[i];
+        }
+      }
+    });
+    std::swap(src, dst);
+  }
+  return src;
+}
+
+static void sort_kernel(
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& self,
+    int64_t dim,
+    bool descending) {
+  const int64_t n = self.dim() > 0 ? self.size(dim) : 1;
+  if (self.numel() == 0) {
+    return;
+  }
+  const int64_t num_slices = self.numel() / n;
+  // 0-dim tensors are sorted as a single slice of one element.
+  const int64_t self_dim_stride = self.dim() > 0 ? self.stride(dim) : 1;
+  const int64_t values_dim_stride = values.dim() > 0 ? values.stride(dim) : 1;
+  const int64_t indices_dim_stride = indices.dim() > 0 ? indices.stride(dim) : 1;
+
+  AT_DISPATCH_ALL_TYPES(self.scalar_type(), "sort_cpu", [&] {
+    using key_t = typename SortKey<scalar_t>::type;
+    using item_t = SortItem<key_t>;
+    const scalar_t* self_data = self.data_ptr<scalar_t>();
+    scalar_t* values_data = values.data_ptr<scalar_t>();
+    int64_t* indices_data = indices.data_ptr<int64_t>();
+
+    auto sort_slice = [&](int64_t it, item_t* items, item_t* tmp, bool parallel) {
+      const scalar_t* src =
+          self_data + slice_offset(self.sizes(), self.strides(), dim, it);
+      scalar_t* values_slice =
+          values_data + slice_offset(values.sizes(), values.strides(), dim, it);
+      int64_t* indices_slice =
+          indices_data + slice_offset(indices.sizes(), indices.strides(), dim, it);
+      auto encode = [&](int64_t begin, int64_t end) {
+        for (int64_t j = begin; j < end; j++) {
+          key_t key = SortKey<scalar_t>::encode(src[j * self_dim_stride]);
+          items[j].key = descending ? static_cast<key_t>(~key) : key;
+          items[j].index = j;
+        }
+      };
+      if (parallel) {
+        parallel_for(0, n, internal::GRAIN_SIZE, encode);
+      } else {
+        encode(0, n);
+      }
+      const item_t* sorted = sort_items(items, tmp, n, parallel);
+      auto gather = [&](int64_t begin, int64_t end) {
+        for (int64_t j = begin; j < end; j++) {
+          const int64_t index = sorted[j].index;
+          values_slice[j * values_dim_stride] = src[index * self_dim_stride];
+          indices_slice[j * indices_dim_stride] = index;
+        }
+      };
+      if (parallel) {
+        parallel_for(0, n, internal::GRAIN_SIZE, gather);
+      } else {
+        gather(0, n);
+      }
+    };
+
+    if (n >= kParallelSortThreshold && num_slices < get_num_threads()) {
+      // Few long slices: sort them one after the other, each with all threads.
+      std::vector<item_t> items(n);
+      std::vector<item_t> tmp(n);
+      for (int64_t it = 0; it < num_slices; it++) {
+        sort_slice(it, items.data(), tmp.data(), /*parallel=*/true);
+      }
+    } else {
+      parallel_for(
+          0,
+          num_slices,
+          std::max<int64_t>(1, internal::GRAIN_SIZE / n),
+          [&](int64_t begin, int64_t end) {
+            std::vector<item_t> items(n);
+            std::vector<item_t> tmp(n);
+            for (int64_t it = begin; it < end; it++) {
+              sort_slice(it, items.data(), tmp.data(), /*parallel=*/false);
+            }
+          });
+    }
+  });
+}
+
+// Top-k of one long slice with all threads: every block keeps its own k best
+// elements with a partial sort, and the k best of those candidates win.
+template <typename scalar_t, typename Comp>
+void topk_slice_parallel(
+    const scalar_t* src,
+    int64_t src_stride,
+    int64_t n,
+    scalar_t* values,
+    int64_t values_stride,
+    int64_t* indices,
+    int64_t indices_stride,
+    int64_t k,
+    Comp comp) {
+  using elem_t = std::pair<scalar_t, int64_t>;
+  const int64_t num_blocks =
+      std::max<int64_t>(1, std::min<int64_t>(get_num_threads(), n / (k * 64)));
+  std::vector<elem_t> candidates(num_blocks * k);
+  for_each_block(num_blocks, [&](int64_t begin, int64_t end) {
+    std::vector<elem_t> queue;
+    for (int64_t b = begin; b < end; b++) {
+      const int64_t lo = b * n / num_blocks;
+      const int64_t hi = (b + 1) * n / num_blocks;
+      queue.resize(hi - lo);
+      for (int64_t j = lo; j < hi; j++) {
+        queue[j - lo] = elem_t(src[j * src_stride], j);
+      }
+      // Blocks are at least 64 * k long, so each has k candidates.
+      std::partial_sort(queue.begin(), queue.begin() + k, queue.end(), comp);
+      std::copy_n(queue.begin(), k, candidates.begin() + b * k);
+    }
+  });
+  std::partial_sort(
+      candidates.begin(), candidates.begin() + k, candidates.end(), comp);
+  for (int64_t j = 0; j < k; j++) {
+    values[j * values_stride] = candidates[j].first;
+    indices[j * indices_stride] = candidates[j].second;
+  }
+}
+
 static void topk_kernel(
     Tensor& values,
     Tensor& indices,
@@ -17,6 +393,42 @@ static void topk_kernel(
     int64_t dim,
     bool largest,
     bool sorted) {
+  const int64_t n = self.dim() > 0 ? self.size(dim) : 1;
+  if (k > 0 && k * 64 <= n && n >= kParallelSortThreshold &&
+      self.numel() / n < get_num_threads()) {
+    AT_DISPATCH_ALL_TYPES(self.scalar_type(), "topk_cpu", [&] {
+      using elem_t = std::pair<scalar_t, int64_t>;
+      // we want NaN to be sorted as top for numpy compatibility
+      auto gt_or_nan = [](const elem_t& x, const elem_t& y) -> bool {
+        return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
+      };
+      auto lt_or_nan = [](const elem_t& x, const elem_t& y) -> bool {
+        return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
+      };
+      for (int64_t it = 0; it < self.numel() / n; it++) {
+        const scalar_t* src = self.data_ptr<scalar_t>() +
+            slice_offset(self.sizes(), self.strides(), dim, it);
+        scalar_t* values_slice = values.data_ptr<scalar_t>() +
+            slice_offset(values.sizes(), values.strides(), dim, it);
+        int64_t* indices_slice = indices.data_ptr<int64_t>() +
+            slice_offset(indices.sizes(), indices.strides(), dim, it);
+        if (largest) {
+          topk_slice_parallel(
+              src, self.stride(dim), n,
+              values_slice, values.stride(dim),
+              indices_slice, indices.stride(dim),
+              k, gt_or_nan);
+        } else {
+          topk_slice_parallel(
+              src, self.stride(dim), n,
+              values_slice, values.stride(dim),
+              indices_slice, indices.stride(dim),
+              k, lt_or_nan);
+        }
+      }
+    });
+    return;
+  }
   AT_DISPATCH_ALL_TYPES(self.scalar_type(), "topk_cpu", [&] {
     dim_apply(
         {self, values, indices},
@@ -85,6 +497,7 @@ static void topk_kernel(
 
 } // anonymous namespace
 
+REGISTER_DISPATCH(sort_stub, &sort_kernel);
 REGISTER_DISPATCH(topk_stub, &topk_kernel);
 
 }} //at::native
@@ -3,10 +3,13 @@
 #include <ATen/ATen.h>
 #include <ATen/DLConvertor.h>
 #include <ATen/Parallel.h>
+#include <c10/util/numa.h>
 
+#include <atomic>
 #include <iostream>
 #include <string.h>
 #include <sstream>
+#include <vector>
 
 using namespace at;
 
@@ -69,3 +72,76 @@ TEST(TestParallel, IntraOpLaunchFuture) {
 
   ASSERT_TRUE(v1 == 1 && v2 == 2);
 }
+
+TEST(TestParallel, ImbalancedParallelFor) {
+  // Iterations at the end of the range are much more expensive than the
+  // others; every iteration must still run exactly once, on a valid thread.
+  const int64_t N = 1 << 12;
+  std::vector<std::atomic<int>> visits(N);
+  std::atomic<bool> valid_thread_num{true};
+  at::parallel_for(0, N, 1, [&](int64_t begin, int64_t end) {
+    if (at::get_thread_num() >= at::get_num_threads()) {
+      valid_thread_num = false;
+    }
+    for (auto i = begin; i < end; ++i) {
+      if (i >= N - N / 8) {
+        volatile int64_t sink = 0;
+        for (int k = 0; k < 10000; ++k) {
+          sink = sink + k;
+        }
+      }
+      visits[i]++;
+    }
+  });
+  ASSERT_TRUE(valid_thread_num);
+  for (int64_t i = 0; i < N; ++i) {
+    ASSERT_EQ(visits[i].load(), 1);
+  }
+}
+
+TEST(TestParallel, NUMAThreadsAndTasks) {
+  // 10 threads on 4 nodes: the first nodes get the remaining threads
+  std::vector<int> threads;
+  for (int node = 0; node < 4; ++node) {
+    threads.push_back(at::internal::numa_node_num_threads(10, 4, node));
+  }
+  ASSERT_EQ(threads, (std::vector<int>{3, 3, 2, 2}));
+
+  // Nodes get contiguous blocks of tasks, in proportion to their threads
+  std::vector<int> tasks(4);
+  int last_node = 0;
+  for (size_t task = 0; task < 100; ++task) {
+    int node = at::internal::numa_node_for_task(task, 100, 10, 4);
+    ASSERT_GE(node, last_node);
+    ASSERT_LT(node, 4);
+    last_node = node;
+    tasks[node]++;
+  }
+  ASSERT_EQ(tasks, (std::vector<int>{30, 30, 20, 20}));
+
+  // With as many tasks as threads, every thread gets one
+  std::vector<int> one_per_thread(4);
+  for (size_t task = 0; task < 10; ++task) {
+    one_per_thread[at::internal::numa_node_for_task(task, 10, 10, 4)]++;
+  }
+  ASSERT_EQ(one_per_thread, threads);
+}
+
+TEST(TestParallel, NUMAStats) {
+  at::reset_numa_stats();
+  int node = c10::GetCurrentNUMANode();
+  at::internal::record_numa_task(node);
+  at::internal::record_numa_task(node);
+  at::internal::record_numa_task(node + 1);
+  auto stats = at::get_numa_stats();
+  ASSERT_EQ(stats.local_tasks, 2);
+  ASSERT_EQ(stats.remote_tasks, 1);
+
+  at::reset_numa_stats();
+  stats = at::get_numa_stats();
+  ASSERT_EQ(stats.local_tasks, 0);
+  ASSERT_EQ(stats.remote_tasks, 0);
+  ASSERT_EQ(stats.local_allocations, 0);
+  ASSERT_EQ(stats.remote_allocations, 0);
+  ASSERT_EQ(stats.first_touch_allocations, 0);
+}
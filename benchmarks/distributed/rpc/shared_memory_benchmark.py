@@ -0,0 +1,84 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+""" RPC transport benchmark.
+Measures the round trip time of rpc_sync between two workers on the same host,
+sending tensors of increasing size, once through the Gloo process group (TCP)
+and once through shared memory (use_shared_memory=True).
+Example run:
+python shared_memory_benchmark.py --sizes 1,1024,1048576,67108864 --iters 20
+"""
+
+import argparse
+import os
+import time
+from datetime import timedelta
+
+import torch
+import torch.distributed.rpc as rpc
+import torch.multiprocessing as mp
+
+
+def identity(t):
+    return t
+
+
+def run_worker(rank, args, use_shared_memory, results):
+    os.environ["MASTER_ADDR"] = "localhost"
+    os.environ["MASTER_PORT"] = str(args.port)
+    options = rpc.backend_registry.construct_rpc_backend_options(
+        rpc.backend_registry.BackendType.PROCESS_GROUP,
+        rpc_timeout=timedelta(seconds=600),
+        use_shared_memory=use_shared_memory,
+    )
+    rpc.init_rpc(
+        "worker{}".format(rank),
+        rank=rank,
+        world_size=2,
+        rpc_backend_options=options,
+    )
+    if rank == 0:
+        for size in args.sizes:
+            t = torch.rand(size // 4)
+            for _ in range(args.warmup):
+                rpc.rpc_sync("worker1", identity, args=(t,))
+            start = time.time()
+            for _ in range(args.iters):
+                rpc.rpc_sync("worker1", identity, args=(t,))
+            results[size] = (time.time() - start) / args.iters
+    rpc.shutdown()
+
+
+def benchmark(args, use_shared_memory):
+    results = mp.Manager().dict()
+    mp.spawn(
+        run_worker, args=(args, use_shared_memory, results), nprocs=2, join=True
+    )
+    return dict(results)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RPC transport benchmark")
+    parser.add_argument(
+        "--sizes",
+        type=lambda s: [int(x) for x in s.split(",")],
+        default=[4, 4096, 1 << 20, 1 << 26],
+        help="comma separated tensor sizes in bytes",
+    )
+    parser.add_argument("--iters", type=int, default=20)
+    parser.add_argument("--warmup", type=int, default=3)
+    parser.add_argument("--port", type=int, default=29500)
+    args = parser.parse_args()
+
+    gloo = benchmark(args, use_shared_memory=False)
+    shm = benchmark(args, use_shared_memory=True)
+    print("{:>12} {:>14} {:>14} {:>8}".format("bytes", "gloo (ms)", "shm (ms)", "speedup"))
+    for size in args.sizes:
+        print(
+            "{:>12} {:>14.3f} {:>14.3f} {:>8.2f}".format(
+                size, gloo[size] * 1e3, shm[size] * 1e3, gloo[size] / shm[size]
+            )
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,74 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+""" TCPStore load test.
+Simulates N clients rendezvousing through one TCPStore server, the way ranks
+exchange their addresses or RPC workers exchange their WorkerInfo: every
+client sets its own key, waits for the keys of all others and reads them,
+either one get per key or with a single multi_get.
+Example run:
+python tcp_store_benchmark.py --clients 256 --rounds 3
+"""
+
+import argparse
+import threading
+import time
+
+import torch.distributed as dist
+
+
+def run_client(args, store, client, round_, barrier, use_multi_get):
+    prefix = "round{}/".format(round_)
+    keys = [prefix + str(i) for i in range(args.clients)]
+    barrier.wait()
+    store.set(keys[client], "x" * args.value_size)
+    if use_multi_get:
+        store.multi_get(keys)
+    else:
+        for key in keys:
+            store.get(key)
+
+
+def benchmark(args, use_multi_get, port):
+    server = dist.TCPStore("127.0.0.1", port, 1, True)
+    stores = [
+        dist.TCPStore("127.0.0.1", port, 1, False) for _ in range(args.clients)
+    ]
+    times = []
+    for round_ in range(args.rounds):
+        # + 1 for this thread, which starts the clock once all are ready
+        barrier = threading.Barrier(args.clients + 1)
+        threads = [
+            threading.Thread(
+                target=run_client,
+                args=(args, stores[i], i, round_, barrier, use_multi_get),
+            )
+            for i in range(args.clients)
+        ]
+        for thread in threads:
+            thread.start()
+        barrier.wait()
+        start = time.time()
+        for thread in threads:
+            thread.join()
+        times.append(time.time() - start)
+    del stores
+    del server
+    return min(times)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="TCPStore load test")
+    parser.add_argument("--clients", type=int, default=128)
+    parser.add_argument("--rounds", type=int, default=3)
+    parser.add_argument("--value-size", type=int, default=64)
+    parser.add_argument("--port", type=int, default=29600)
+    args = parser.parse_args()
+
+    get = benchmark(args, use_multi_get=False, port=args.port)
+    multi_get = benchmark(args, use_multi_get=True, port=args.port + 1)
+    print("{:>8} {:>12} {:>14}".format("clients", "get (ms)", "multi_get (ms)"))
+    print("{:>8} {:>12.1f} {:>14.1f}".format(args.clients, get * 1e3, multi_get * 1e3))
+
+
+if __name__ == "__main__":
+    main()
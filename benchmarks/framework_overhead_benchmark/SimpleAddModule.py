@@ -8,6 +8,23 @@ def add_tensors_loop(x, y):
         z = torch.add(z, x)
     return z
 
+@torch.jit.script
+def scalar_loop(x, niters):
+    # type: (Tensor, int) -> Tensor
+    # Only int arithmetic and control flow around the tensor op, so the time
+    # is dominated by the JIT interpreter's dispatch rather than by kernels.
+    n = 0
+    for i in range(niters):
+        if i % 2 == 0:
+            n = n + i * 2
+        else:
+            n = n - 1
+    return x + n
+
+def add_scalars_loop(x, y):
+    # scalar_loop is scripted, so it stays a loop in the traced graph
+    return scalar_loop(torch.add(x, y), NUM_LOOP_ITERS)
+
 class SimpleAddModule(torch.nn.Module):
     def __init__(self, add_op):
         super(SimpleAddModule, self).__init__()
@@ -3,16 +3,20 @@ from utils import ms_to_us, benchmark_module, BenchmarkConfig, ModuleConfig
 import argparse
 from C2Module import C2SimpleNet
 
-from SimpleAddModule import SimpleAddModule, add_tensors_loop
+import torch
+from SimpleAddModule import SimpleAddModule, add_tensors_loop, add_scalars_loop
 from pt_wrapper_module import WrapperModule
 
 """ Framework overhead benchmark script.
 Benchmark framework overhead.
-Currently supported ops: add.
+Currently supported ops: add, scalar_loop (int arithmetic in a scripted loop,
+measures JIT interpreter overhead).
 As of now runs only forward pass.
 Supports both graph mode and eager mode. In graph mode the module is traced via JIT tracing.
 Debug option prints the traced graph is graph_mode is enabled.
 Graph can be saved via save option. Saved in the directory where benchmark is run.
+--disable_superinstructions runs the JIT interpreter on plain stack bytecode,
+without fusing operator calls into OPR instructions.
 Example build/run:
 To run PT benchmark:
 buck run @mode/opt <path-to-framework_overhead_benchmark>:framework_overhead_benchmark --
@@ -22,9 +26,12 @@ buck run @mode/opt <path-to-framework_overhead_benchmark>:framework_overhead_ben
 To run C2 benchmark:
 buck run @mode/opt <path-to-framework_overhead_benchmark>:framework_overhead_benchmark --
  --add_op --benchmark_c2_net
+To compare interpreter dispatch with and without superinstructions:
+buck run @mode/opt <path-to-framework_overhead_benchmark>:framework_overhead_benchmark --
+ --op scalar_loop_op [--disable_superinstructions]
 """
 
-SUPPORTED_OPS = {"add_op"}
+SUPPORTED_OPS = {"add_op", "scalar_loop_op"}
 
 def parse_op_args(op):
     op_list = ops.split(",")
@@ -70,6 +77,8 @@ def main():
     parser.add_argument("--debug", default=False, dest="debug", action="store_true")
     parser.add_argument("--save", default=False, dest="save", action="store_true")
     parser.add_argument("--eager_mode", default=False, dest="eager_mode", action="store_true")
+    parser.add_argument("--disable_superinstructions", default=False, dest="disable_superinstructions",
+                        action="store_true")
     parser.add_argument("--num_warmup_iters", type=int, default=100)
     parser.add_argument("--num_iters", type=int, default=1000)
     args = parser.parse_args()
@@ -80,6 +89,9 @@ def main():
     assert not (args.benchmark_c2_net and args.use_throughput_benchmark), \
         "Benchmarking of C2 net via throughput benchmarking is not yet supported"
 
+    if args.disable_superinstructions:
+        torch._C._jit_set_interpreter_superinstructions(False)
+
     num_warmup_iters = args.num_warmup_iters
     num_iters = args.num_iters
     config = BenchmarkConfig(num_warmup_iters, num_iters)
@@ -94,6 +106,11 @@ def main():
         else:
             module_config = ModuleConfig(add_tensors_loop, None, num_params, graph_mode)
         benchmark_simple_fn(args, config, module_config, SimpleAddModule, result)
+    elif args.op == "scalar_loop_op":
+        assert not args.benchmark_c2_net, "scalar_loop_op has no C2 equivalent"
+        num_params = 2
+        module_config = ModuleConfig(add_scalars_loop, None, num_params, graph_mode)
+        benchmark_simple_fn(args, config, module_config, SimpleAddModule, result)
     print_results(result)
 
 if __name__ == "__main__":
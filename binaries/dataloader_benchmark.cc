@@ -0,0 +1,108 @@
+#include <torch/data.h>
+#include <torch/data/detail/lock_free_queue.h>
+#include <torch/data/detail/queue.h>
+
+#include "c10/util/Flags.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+C10_DEFINE_int(threads, 8, "Number of producer and of consumer threads");
+C10_DEFINE_int(items, 10e5, "Number of items sent through each queue");
+C10_DEFINE_int(capacity, 64, "Capacity of the lock-free queue");
+C10_DEFINE_int(workers, 8, "Number of DataLoader workers");
+C10_DEFINE_int(dataset_size, 10e4, "Number of examples in the dataset");
+C10_DEFINE_int(batch_size, 1, "DataLoader batch size");
+C10_DEFINE_int(benchmark_iter, 3, "Number of times to run benchmark");
+
+namespace {
+typedef std::chrono::high_resolution_clock clock;
+typedef std::chrono::microseconds us;
+
+// A dataset whose examples cost nothing to produce, so that the loader's
+// own synchronization dominates.
+struct DummyDataset : torch::data::datasets::Dataset<DummyDataset, int> {
+  int get(size_t index) override {
+    return static_cast<int>(index);
+  }
+  torch::optional<size_t> size() const override {
+    return FLAGS_dataset_size;
+  }
+};
+
+// Returns the number of items per second that FLAGS_threads producers and as
+// many consumers manage to pass through `queue`.
+template <typename Queue>
+double run_queue(Queue& queue) {
+  const int items_per_thread = FLAGS_items / FLAGS_threads;
+  std::vector<std::thread> threads;
+  auto start_time = clock::now();
+  for (auto t = 0; t < FLAGS_threads; ++t) {
+    threads.emplace_back([&queue, items_per_thread] {
+      for (auto i = 0; i < items_per_thread; ++i) {
+        queue.push(i);
+      }
+    });
+    threads.emplace_back([&queue, items_per_thread] {
+      for (auto i = 0; i < items_per_thread; ++i) {
+        queue.pop();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto duration = static_cast<double>(
+      std::chrono::duration_cast<us>(clock::now() - start_time).count());
+  return items_per_thread * FLAGS_threads / (duration / 1e6);
+}
+
+// Returns the number of examples per second the DataLoader delivers.
+double run_data_loader() {
+  auto loader = torch::data::make_data_loader(
+      DummyDataset(),
+      torch::data::DataLoaderOptions()
+          .batch_size(FLAGS_batch_size)
+          .workers(FLAGS_workers));
+  size_t examples = 0;
+  auto start_time = clock::now();
+  for (auto& batch : *loader) {
+    examples += batch.size();
+  }
+  auto duration = static_cast<double>(
+      std::chrono::duration_cast<us>(clock::now() - start_time).count());
+  return examples / (duration / 1e6);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+
+  std::cout << "Passing " << FLAGS_items << " items through each queue using "
+            << FLAGS_threads << " producers and " << FLAGS_threads
+            << " consumers" << std::endl;
+
+  for (auto bench_iter = 0; bench_iter < FLAGS_benchmark_iter; ++bench_iter) {
+    torch::data::detail::Queue<int> queue;
+    torch::data::detail::LockFreeQueue<int> lock_free_queue(FLAGS_capacity);
+    std::cout << "Queue: " << run_queue(queue) << " items/s, "
+              << "LockFreeQueue: " << run_queue(lock_free_queue)
+              << " items/s." << std::endl;
+  }
+
+  std::cout << "Loading " << FLAGS_dataset_size << " examples in batches of "
+            << FLAGS_batch_size << " using " << FLAGS_workers << " workers"
+            << std::endl;
+
+  for (auto bench_iter = 0; bench_iter < FLAGS_benchmark_iter; ++bench_iter) {
+    std::cout << "DataLoader: " << run_data_loader() << " examples/s."
+              << std::endl;
+  }
+
+  return 0;
+}
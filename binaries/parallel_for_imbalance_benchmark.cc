@@ -0,0 +1,127 @@
+#include "ATen/Parallel.h"
+
+#include "c10/util/Flags.h"
+#include "caffe2/core/init.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+C10_DEFINE_int(range, 1 << 16, "Number of loop iterations");
+C10_DEFINE_int(grain_size, 1, "Grain size passed to at::parallel_for");
+C10_DEFINE_int(base_work, 100, "Work units of the cheapest iteration");
+C10_DEFINE_double(skew, 15.0,
+    "Work of iteration i is base_work * (1 + skew * hot(i)); see distribution");
+C10_DEFINE_string(distribution, "tail",
+    "Where the expensive iterations are: uniform, tail (last 1/8 of the "
+    "range, like sorted ragged batches) or zipf (power law over the range, "
+    "like skewed EmbeddingBag bag sizes)");
+C10_DEFINE_int(intra_op_threads, 0, "Number of intra-op threads");
+C10_DEFINE_int(warmup_iter, 3, "Number of warmup iterations");
+C10_DEFINE_int(benchmark_iter, 10, "Number of times to run benchmark");
+
+namespace {
+std::vector<int64_t> work;
+std::atomic<uint64_t> sink{0};
+
+void init_work() {
+  work.resize(FLAGS_range);
+  for (int64_t i = 0; i < FLAGS_range; ++i) {
+    double hot = 0.0;
+    if (FLAGS_distribution == "tail") {
+      hot = i >= FLAGS_range - FLAGS_range / 8 ? 1.0 : 0.0;
+    } else if (FLAGS_distribution == "zipf") {
+      hot = 64.0 / (1.0 + i * 1024.0 / FLAGS_range);
+    } else {
+      TORCH_CHECK(FLAGS_distribution == "uniform",
+          "Unknown distribution: ", FLAGS_distribution);
+    }
+    work[i] = static_cast<int64_t>(FLAGS_base_work * (1.0 + FLAGS_skew * hot));
+  }
+}
+
+uint64_t busy_work(int64_t units) {
+  uint64_t x = units;
+  for (int64_t k = 0; k < units; ++k) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+  return x;
+}
+
+float run_once() {
+  typedef std::chrono::high_resolution_clock clock;
+  typedef std::chrono::microseconds us;
+  auto start_time = clock::now();
+  at::parallel_for(0, FLAGS_range, FLAGS_grain_size,
+      [](int64_t begin, int64_t end) {
+    uint64_t acc = 0;
+    for (auto i = begin; i < end; ++i) {
+      acc += busy_work(work[i]);
+    }
+    sink += acc;
+  });
+  return static_cast<float>(
+      std::chrono::duration_cast<us>(clock::now() - start_time).count()) / 1000;
+}
+
+void print_runtime_stats(const std::vector<float>& runtimes) {
+  TORCH_INTERNAL_ASSERT(!runtimes.empty());
+  float sum = 0.0;
+  float sqr_sum = 0.0;
+  size_t N = runtimes.size();
+  for (size_t idx = 0; idx < N; ++idx) {
+    sum += runtimes[idx];
+    sqr_sum += runtimes[idx] * runtimes[idx];
+  }
+  float mean = sum / N;
+  float sd = std::sqrt(sqr_sum / N - mean * mean);
+  std::cout << "N = " << N << ", mean = " << mean << " ms, sd = " << sd
+            << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  caffe2::unsafeRunCaffe2InitFunction("registerThreadPools");
+  at::init_num_threads();
+
+  if (FLAGS_intra_op_threads > 0) {
+    at::set_num_threads(FLAGS_intra_op_threads);
+  }
+  init_work();
+
+  int64_t total_work = 0;
+  int64_t max_work = 0;
+  for (auto w : work) {
+    total_work += w;
+    max_work = std::max(max_work, w);
+  }
+  std::cout << at::get_parallel_info() << std::endl;
+  std::cout << "Running parallel_for over " << FLAGS_range
+            << " iterations, grain size " << FLAGS_grain_size
+            << ", distribution: " << FLAGS_distribution
+            << ", max/mean work per iteration: "
+            << static_cast<double>(max_work) * FLAGS_range / total_work
+            << ", using " << at::get_num_threads() << " intra-op threads"
+            << std::endl;
+
+  for (auto i = 0; i < FLAGS_warmup_iter; ++i) {
+    run_once();
+  }
+
+  std::vector<float> runtimes;
+  for (auto bench_iter = 0; bench_iter < FLAGS_benchmark_iter; ++bench_iter) {
+    auto duration = run_once();
+    runtimes.push_back(duration);
+    std::cout << "Runtime: " << duration << " ms." << std::endl;
+  }
+
+  print_runtime_stats(runtimes);
+  return 0;
+}
@@ -71,8 +71,21 @@ void* alloc_cpu(size_t nbytes) {
       nbytes,
       " bytes. Buy new RAM!");
 
-  // move data to a thread's NUMA node
-  NUMAMove(data, nbytes, GetCurrentNUMANode());
+  if (IsNUMAEnabled()) {
+    if (FLAGS_caffe2_cpu_numa_first_touch) {
+      // leave placement to the threads writing the data, e.g. the per-node
+      // intra-op pools partitioning a parallel loop
+      RecordNUMAAllocation(-1);
+    } else {
+      // move data to a thread's NUMA node
+      NUMAMove(data, nbytes, GetCurrentNUMANode());
+      // count the node the first page actually landed on, which is remote if
+      // the thread migrated in the meantime; the page is written to first, as
+      // reading an untouched page would map the shared zero page
+      *static_cast<volatile char*>(data) = 0;
+      RecordNUMAAllocation(GetNUMANode(data));
+    }
+  }
   CHECK(
       !FLAGS_caffe2_cpu_allocator_do_zero_fill ||
       !FLAGS_caffe2_cpu_allocator_do_junk_fill)
@@ -108,11 +121,30 @@ class C10_API MemoryAllocationReporter {
   size_t allocated_;
 };
 
+namespace {
+/// In the CAFFE2_FB_LIMITED_MOBILE_CAPABILITY build setting,
+/// thread_local is not supported.
+#ifndef CAFFE2_FB_LIMITED_MOBILE_CAPABILITY
+thread_local uint64_t tls_cpu_allocated_bytes = 0;
+#else
+uint64_t tls_cpu_allocated_bytes = 0;
+#endif
+} // namespace
+
+uint64_t getThreadLocalCPUAllocatedBytes() {
+  return tls_cpu_allocated_bytes;
+}
+
+void recordThreadLocalCPUAllocation(size_t nbytes) {
+  tls_cpu_allocated_bytes += nbytes;
+}
+
 struct C10_API DefaultCPUAllocator final : at::Allocator {
   DefaultCPUAllocator() {}
   ~DefaultCPUAllocator() override {}
   at::DataPtr allocate(size_t nbytes) const override {
     void* data = alloc_cpu(nbytes);
+    tls_cpu_allocated_bytes += nbytes;
     if (FLAGS_caffe2_report_cpu_memory_usage && nbytes > 0) {
       getMemoryAllocationReporter().New(data, nbytes);
       return {data, data, &ReportAndDelete, at::Device(at::DeviceType::CPU)};
@@ -145,10 +177,33 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
 
 void NoDelete(void*) {}
 
+namespace {
+/// In the CAFFE2_FB_LIMITED_MOBILE_CAPABILITY build setting,
+/// thread_local is not supported.
+#ifndef CAFFE2_FB_LIMITED_MOBILE_CAPABILITY
+thread_local at::Allocator* tls_cpu_allocator = nullptr;
+#else
+at::Allocator* tls_cpu_allocator = nullptr;
+#endif
+} // namespace
+
 at::Allocator* GetCPUAllocator() {
+  if (tls_cpu_allocator) {
+    return tls_cpu_allocator;
+  }
   return GetAllocator(DeviceType::CPU);
 }
 
+ThreadLocalCPUAllocatorGuard::ThreadLocalCPUAllocatorGuard(
+    at::Allocator* alloc)
+    : prev_(tls_cpu_allocator) {
+  tls_cpu_allocator = alloc;
+}
+
+ThreadLocalCPUAllocatorGuard::~ThreadLocalCPUAllocatorGuard() {
+  tls_cpu_allocator = prev_;
+}
+
 void SetCPUAllocator(at::Allocator* alloc) {
   SetAllocator(DeviceType::CPU, alloc);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 #include <unordered_map>
 
@@ -39,4 +40,30 @@ C10_API void SetCPUAllocator(at::Allocator* alloc);
 // Get the Default CPU Allocator
 C10_API at::Allocator* GetDefaultCPUAllocator();
 
+// Returns the number of bytes the CPU allocators allocated on the current
+// thread so far. It only grows; the difference between two calls tells how
+// much was allocated in between.
+C10_API uint64_t getThreadLocalCPUAllocatedBytes();
+
+// Counts `nbytes` allocated on the current thread. For CPU allocators other
+// than the default one, which counts its own allocations.
+C10_API void recordThreadLocalCPUAllocation(size_t nbytes);
+
+// Makes GetCPUAllocator() return `alloc` on the current thread for the
+// lifetime of the guard, in place of the allocator set by SetCPUAllocator.
+// Guards nest; the caller keeps ownership of `alloc`, which must outlive any
+// storage it allocates.
+class C10_API ThreadLocalCPUAllocatorGuard {
+ public:
+  explicit ThreadLocalCPUAllocatorGuard(at::Allocator* alloc);
+  ~ThreadLocalCPUAllocatorGuard();
+
+  ThreadLocalCPUAllocatorGuard(const ThreadLocalCPUAllocatorGuard&) = delete;
+  ThreadLocalCPUAllocatorGuard& operator=(const ThreadLocalCPUAllocatorGuard&) =
+      delete;
+
+ private:
+  at::Allocator* prev_;
+};
+
 } // namespace c10
@@ -0,0 +1,498 @@
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/util/Exception.h>
+#include <c10/util/llvmMathExtras.h>
+
+C10_DEFINE_int64(
+    caffe2_cpu_caching_allocator_thread_cache_bytes,
+    16 << 20,
+    "Maximum number of free bytes kept in each thread's cache by the CPU "
+    "caching allocator");
+
+C10_DEFINE_int64(
+    caffe2_cpu_caching_allocator_max_cached_bytes,
+    int64_t(1) << 30,
+    "Maximum number of free bytes kept in the shared arena of the CPU caching "
+    "allocator; a negative value means no limit");
+
+namespace c10 {
+namespace CPUCachingAllocator {
+
+namespace {
+
+// Size classes: multiples of 64 bytes up to 512 bytes, then four classes per
+// power of two up to kMaxCachedSize.
+constexpr size_t kSmallStep = 64;
+constexpr size_t kSmallLimit = 512;
+constexpr size_t kNumSmallClasses = kSmallLimit / kSmallStep;
+constexpr size_t kSmallLimitLog2 = 9;
+constexpr size_t kClassesPerPowerOfTwo = 4;
+constexpr size_t kMaxCachedSizeLog2 = 28;
+constexpr size_t kNumSizeClasses = kNumSmallClasses +
+    (kMaxCachedSizeLog2 - kSmallLimitLog2) * kClassesPerPowerOfTwo;
+static_assert(size_t(1) << kMaxCachedSizeLog2 == kMaxCachedSize, "");
+static_assert(size_t(1) << kSmallLimitLog2 == kSmallLimit, "");
+
+// Every block starts with a header; the user pointer follows it. Using the
+// full alignment for the header keeps the user pointer gAlignment-aligned.
+constexpr size_t kHeaderSize = gAlignment;
+constexpr size_t kUncachedClass = kNumSizeClasses;
+
+struct BlockHeader {
+  size_t class_index;
+  size_t size;
+  // NUMA node the block was placed on, -1 if unknown or left to first touch.
+  int numa_node;
+};
+static_assert(sizeof(BlockHeader) <= kHeaderSize, "");
+
+inline BlockHeader* header(void* base) {
+  return static_cast<BlockHeader*>(base);
+}
+
+inline void* userPtr(void* base) {
+  return static_cast<char*>(base) + kHeaderSize;
+}
+
+inline void* basePtr(void* ptr) {
+  return static_cast<char*>(ptr) - kHeaderSize;
+}
+
+// Counters are written only by the thread owning them, so a plain
+// load/store pair suffices and keeps the hot path free of locked
+// instructions; readers only need a consistent-enough snapshot.
+inline void bump(std::atomic<int64_t>& counter, int64_t delta) {
+  counter.store(
+      counter.load(std::memory_order_relaxed) + delta,
+      std::memory_order_relaxed);
+}
+
+inline void fillBlock(void* ptr, size_t nbytes) {
+  if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+    memset(ptr, 0, nbytes);
+  } else if (FLAGS_caffe2_cpu_allocator_do_junk_fill) {
+    memset_junk(ptr, nbytes);
+  }
+}
+
+struct ThreadCache;
+
+struct Counters {
+  int64_t allocations = 0;
+  int64_t thread_cache_hits = 0;
+  int64_t arena_hits = 0;
+  int64_t uncached_allocations = 0;
+};
+
+// Shared state: the free lists for large blocks and overflow from thread
+// caches, the segment accounting and the registry of live thread caches.
+struct Arena {
+  std::mutex mutex;
+  std::vector<void*> free_blocks[kNumSizeClasses];
+  int64_t cached_bytes = 0;
+
+  std::atomic<int64_t> segments{0};
+  std::atomic<int64_t> reserved_bytes{0};
+  std::atomic<int64_t> peak_reserved_bytes{0};
+  // Incremented by emptyCache(); thread caches compare it against the value
+  // they saw last and release their blocks when it changed.
+  std::atomic<uint64_t> epoch{0};
+
+  // Protected by registry_mutex.
+  std::mutex registry_mutex;
+  std::unordered_set<ThreadCache*> caches;
+  // Counters of threads that have exited or had no cache.
+  Counters retired;
+  // Counters at the last resetAccumulatedStats().
+  Counters baseline;
+
+  void* allocateSegment(size_t size, size_t class_index) {
+    void* base = alloc_cpu(size);
+    header(base)->class_index = class_index;
+    header(base)->size = size;
+    header(base)->numa_node =
+        IsNUMAEnabled() && !FLAGS_caffe2_cpu_numa_first_touch
+        ? GetCurrentNUMANode()
+        : -1;
+    segments.fetch_add(1, std::memory_order_relaxed);
+    int64_t reserved =
+        reserved_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t peak = peak_reserved_bytes.load(std::memory_order_relaxed);
+    while (reserved > peak &&
+           !peak_reserved_bytes.compare_exchange_weak(
+               peak, reserved, std::memory_order_relaxed)) {
+    }
+    return base;
+  }
+
+  void freeSegment(void* base) {
+    segments.fetch_sub(1, std::memory_order_relaxed);
+    reserved_bytes.fetch_sub(header(base)->size, std::memory_order_relaxed);
+    free_cpu(base);
+  }
+
+  void* pop(size_t class_index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& blocks = free_blocks[class_index];
+    if (blocks.empty()) {
+      return nullptr;
+    }
+    void* base = blocks.back();
+    blocks.pop_back();
+    cached_bytes -= header(base)->size;
+    return base;
+  }
+
+  void push(void* base) {
+    const int64_t size = header(base)->size;
+    const int64_t limit = FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (limit < 0 || cached_bytes + size <= limit) {
+        free_blocks[header(base)->class_index].push_back(base);
+        cached_bytes += size;
+        return;
+      }
+    }
+    freeSegment(base);
+  }
+
+  void release() {
+    std::vector<void*> to_free;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto& blocks : free_blocks) {
+        to_free.insert(to_free.end(), blocks.begin(), blocks.end());
+        blocks.clear();
+        blocks.shrink_to_fit();
+      }
+      cached_bytes = 0;
+    }
+    for (void* base : to_free) {
+      freeSegment(base);
+    }
+  }
+};
+
+// Intentionally leaked: blocks may be freed by static destructors running
+// after this translation unit has been torn down.
+Arena& arena() {
+  static Arena* arena_ = new Arena();
+  return *arena_;
+}
+
+struct ThreadCache {
+  std::vector<void*> free_blocks[kNumSizeClasses];
+  int64_t cached_bytes = 0;
+  uint64_t epoch;
+
+  std::atomic<int64_t> allocations{0};
+  std::atomic<int64_t> thread_cache_hits{0};
+  std::atomic<int64_t> arena_hits{0};
+  std::atomic<int64_t> uncached_allocations{0};
+  std::atomic<int64_t> cached_bytes_stat{0};
+
+  ThreadCache();
+  ~ThreadCache();
+
+  // Releases all cached blocks to the system if emptyCache() was called
+  // since the last check.
+  void checkEpoch() {
+    const uint64_t current = arena().epoch.load(std::memory_order_relaxed);
+    if (C10_UNLIKELY(current != epoch)) {
+      epoch = current;
+      for (auto& blocks : free_blocks) {
+        for (void* base : blocks) {
+          arena().freeSegment(base);
+        }
+        blocks.clear();
+        blocks.shrink_to_fit();
+      }
+      cached_bytes = 0;
+      cached_bytes_stat.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void* pop(size_t class_index) {
+    auto& blocks = free_blocks[class_index];
+    if (blocks.empty()) {
+      return nullptr;
+    }
+    void* base = blocks.back();
+    blocks.pop_back();
+    cached_bytes -= header(base)->size;
+    cached_bytes_stat.store(cached_bytes, std::memory_order_relaxed);
+    return base;
+  }
+
+  bool push(void* base) {
+    const int64_t size = header(base)->size;
+    if (size > static_cast<int64_t>(kMaxThreadCachedSize) ||
+        cached_bytes + size >
+            FLAGS_caffe2_cpu_caching_allocator_thread_cache_bytes) {
+      return false;
+    }
+    free_blocks[header(base)->class_index].push_back(base);
+    cached_bytes += size;
+    cached_bytes_stat.store(cached_bytes, std::memory_order_relaxed);
+    return true;
+  }
+};
+
+// Set once the calling thread's cache has been destroyed, so that blocks
+// freed later during thread teardown go straight to the arena instead of
+// touching a dead thread_local.
+thread_local bool tls_cache_destroyed = false;
+
+ThreadCache::ThreadCache()
+    : epoch(arena().epoch.load(std::memory_order_relaxed)) {
+  std::lock_guard<std::mutex> lock(arena().registry_mutex);
+  arena().caches.insert(this);
+}
+
+ThreadCache::~ThreadCache() {
+  tls_cache_destroyed = true;
+  for (auto& blocks : free_blocks) {
+    for (void* base : blocks) {
+      arena().push(base);
+    }
+  }
+  std::lock_guard<std::mutex> lock(arena().registry_mutex);
+  auto& retired = arena().retired;
+  retired.allocations += allocations.load(std::memory_order_relaxed);
+  retired.thread_cache_hits += thread_cache_hits.load(std::memory_order_relaxed);
+  retired.arena_hits += arena_hits.load(std::memory_order_relaxed);
+  retired.uncached_allocations +=
+      uncached_allocations.load(std::memory_order_relaxed);
+  arena().caches.erase(this);
+}
+
+ThreadCache* getThreadCache() {
+  if (tls_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+void countWithoutCache(int64_t Counters::*field) {
+  std::lock_guard<std::mutex> lock(arena().registry_mutex);
+  arena().retired.allocations++;
+  if (field) {
+    arena().retired.*field += 1;
+  }
+}
+
+void* raw_alloc(size_t nbytes) {
+  const size_t total = nbytes + kHeaderSize;
+  ThreadCache* cache = getThreadCache();
+  if (cache) {
+    cache->checkEpoch();
+  }
+
+  if (total > kMaxCachedSize) {
+    if (cache) {
+      bump(cache->allocations, 1);
+      bump(cache->uncached_allocations, 1);
+    } else {
+      countWithoutCache(&Counters::uncached_allocations);
+    }
+    return userPtr(arena().allocateSegment(total, kUncachedClass));
+  }
+
+  const size_t size = roundSize(total);
+  const size_t class_index = sizeClassIndex(size);
+  void* base = nullptr;
+  if (cache) {
+    bump(cache->allocations, 1);
+    base = cache->pop(class_index);
+    if (base) {
+      bump(cache->thread_cache_hits, 1);
+    }
+  }
+  if (!base) {
+    base = arena().pop(class_index);
+    if (cache) {
+      if (base) {
+        bump(cache->arena_hits, 1);
+      }
+    } else {
+      countWithoutCache(base ? &Counters::arena_hits : nullptr);
+    }
+  }
+  if (!base) {
+    // alloc_cpu() already takes care of NUMA placement and fill flags.
+    return userPtr(arena().allocateSegment(size, class_index));
+  }
+  // A cached block may have been placed on another node than the one of the
+  // thread reusing it.
+  RecordNUMAAllocation(header(base)->numa_node);
+  fillBlock(userPtr(base), size - kHeaderSize);
+  return userPtr(base);
+}
+
+void raw_delete(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  void* base = basePtr(ptr);
+  if (header(base)->class_index == kUncachedClass) {
+    arena().freeSegment(base);
+    return;
+  }
+  ThreadCache* cache = getThreadCache();
+  if (cache) {
+    cache->checkEpoch();
+    if (cache->push(base)) {
+      return;
+    }
+  }
+  arena().push(base);
+}
+
+struct CPUCachingAllocatorImpl final : public at::Allocator {
+  at::DataPtr allocate(size_t nbytes) const override {
+    if (nbytes == 0) {
+      return {nullptr, nullptr, &raw_delete, at::Device(at::DeviceType::CPU)};
+    }
+    // We might have clowny upstream code that tries to alloc a negative
+    // number of bytes. Let's catch it early.
+    TORCH_CHECK(
+        ((ptrdiff_t)nbytes) >= 0,
+        "CPUCachingAllocator: allocate() seems to have been called with "
+        "negative number: ",
+        nbytes);
+    void* data = raw_alloc(nbytes);
+    // Cache hits count too: they are allocations for the op that made them.
+    recordThreadLocalCPUAllocation(nbytes);
+    return {data, data, &raw_delete, at::Device(at::DeviceType::CPU)};
+  }
+
+  at::DeleterFnPtr raw_deleter() const override {
+    return &raw_delete;
+  }
+};
+
+CPUCachingAllocatorImpl g_caching_alloc;
+
+} // namespace
+
+size_t roundSize(size_t nbytes) {
+  if (nbytes <= kSmallLimit) {
+    return std::max<size_t>(1, (nbytes + kSmallStep - 1) / kSmallStep) *
+        kSmallStep;
+  }
+  if (nbytes > kMaxCachedSize) {
+    return (nbytes + gAlignment - 1) / gAlignment * gAlignment;
+  }
+  // 2^k < nbytes <= 2^(k+1), rounded up to a multiple of 2^(k-2).
+  const size_t k = llvm::Log2_64(nbytes - 1);
+  const size_t step = size_t(1) << (k - 2);
+  return (nbytes + step - 1) / step * step;
+}
+
+size_t sizeClassIndex(size_t nbytes) {
+  const size_t size = roundSize(nbytes);
+  if (size <= kSmallLimit) {
+    return size / kSmallStep - 1;
+  }
+  TORCH_CHECK(
+      size <= kMaxCachedSize,
+      "CPUCachingAllocator: no size class for ",
+      nbytes,
+      " bytes");
+  const size_t k = llvm::Log2_64(size - 1);
+  const size_t step = size_t(1) << (k - 2);
+  return kNumSmallClasses + (k - kSmallLimitLog2) * kClassesPerPowerOfTwo +
+      (size - (size_t(1) << k)) / step - 1;
+}
+
+at::Allocator* get() {
+  return &g_caching_alloc;
+}
+
+void enable() {
+  SetCPUAllocator(get());
+}
+
+void disable() {
+  SetCPUAllocator(GetDefaultCPUAllocator());
+}
+
+bool isEnabled() {
+  return GetAllocator(DeviceType::CPU) == get();
+}
+
+void emptyCache() {
+  arena().epoch.fetch_add(1, std::memory_order_relaxed);
+  arena().release();
+  if (ThreadCache* cache = getThreadCache()) {
+    cache->checkEpoch();
+  }
+}
+
+namespace {
+
+Counters totalCounters(Stats* stats) {
+  Counters total = arena().retired;
+  for (ThreadCache* cache : arena().caches) {
+    total.allocations += cache->allocations.load(std::memory_order_relaxed);
+    total.thread_cache_hits +=
+        cache->thread_cache_hits.load(std::memory_order_relaxed);
+    total.arena_hits += cache->arena_hits.load(std::memory_order_relaxed);
+    total.uncached_allocations +=
+        cache->uncached_allocations.load(std::memory_order_relaxed);
+    if (stats) {
+      stats->thread_cached_bytes +=
+          cache->cached_bytes_stat.load(std::memory_order_relaxed);
+    }
+  }
+  return total;
+}
+
+} // namespace
+
+Stats getStats() {
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> lock(arena().registry_mutex);
+    const Counters total = totalCounters(&stats);
+    const Counters& baseline = arena().baseline;
+    stats.allocations = total.allocations - baseline.allocations;
+    stats.thread_cache_hits =
+        total.thread_cache_hits - baseline.thread_cache_hits;
+    stats.arena_hits = total.arena_hits - baseline.arena_hits;
+    stats.uncached_allocations =
+        total.uncached_allocations - baseline.uncached_allocations;
+  }
+  {
+    std::lock_guard<std::mutex> lock(arena().mutex);
+    stats.arena_cached_bytes = arena().cached_bytes;
+  }
+  stats.segments = arena().segments.load(std::memory_order_relaxed);
+  stats.reserved_bytes = arena().reserved_bytes.load(std::memory_order_relaxed);
+  stats.peak_reserved_bytes =
+      arena().peak_reserved_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void resetAccumulatedStats() {
+  std::lock_guard<std::mutex> lock(arena().registry_mutex);
+  arena().baseline = totalCounters(nullptr);
+}
+
+void resetPeakStats() {
+  arena().peak_reserved_bytes.store(
+      arena().reserved_bytes.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+}
+
+} // namespace CPUCachingAllocator
+} // namespace c10
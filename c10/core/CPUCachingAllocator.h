@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <c10/core/Allocator.h>
+#include <c10/util/Flags.h>
+
+C10_DECLARE_int64(caffe2_cpu_caching_allocator_thread_cache_bytes);
+C10_DECLARE_int64(caffe2_cpu_caching_allocator_max_cached_bytes);
+
+namespace c10 {
+
+// An opt-in caching allocator for CPU memory, similar in spirit to the CUDA
+// caching allocator. Requests are rounded up to a size class (multiples of
+// 64 bytes up to 512 bytes, then four classes per power of two) and freed
+// blocks are kept for reuse instead of being returned to libc:
+//
+//  - Blocks up to kMaxThreadCachedSize are kept in per-thread free lists, so
+//    the common allocate/free cycle of small intermediates touches neither a
+//    lock nor a shared cache line.
+//  - Larger blocks, and small blocks that overflow a thread's budget or whose
+//    thread has exited, go to a shared arena protected by a mutex.
+//  - Requests above kMaxCachedSize bypass the cache and go to alloc_cpu().
+//
+// Every block carries a small header in front of the user pointer recording
+// its size class, so the allocator implements the raw interface (see
+// Allocator::raw_deleter) and blocks can be freed on any thread.
+//
+// The allocator is not installed by default; call enable() (typically during
+// initialization, see the caveats on SetAllocator) to route all CPU
+// allocations made through GetCPUAllocator() to it.
+namespace CPUCachingAllocator {
+
+// Largest block that is kept in the per-thread free lists.
+constexpr size_t kMaxThreadCachedSize = 1 << 20; // 1 MiB
+// Largest block that is cached at all.
+constexpr size_t kMaxCachedSize = 1 << 28; // 256 MiB
+
+// Snapshot of the allocator statistics, aggregated over all threads.
+struct Stats {
+  // COUNT: allocations requested by client code
+  int64_t allocations = 0;
+  // COUNT: allocations served from a per-thread free list
+  int64_t thread_cache_hits = 0;
+  // COUNT: allocations served from the shared arena
+  int64_t arena_hits = 0;
+  // COUNT: allocations too large to be cached
+  int64_t uncached_allocations = 0;
+  // COUNT: blocks currently obtained from alloc_cpu()
+  int64_t segments = 0;
+
+  // SUM: bytes currently obtained from alloc_cpu() (in use and cached)
+  int64_t reserved_bytes = 0;
+  // SUM: high-water mark of reserved_bytes since the last resetPeakStats()
+  int64_t peak_reserved_bytes = 0;
+  // SUM: bytes of free blocks held in per-thread free lists
+  int64_t thread_cached_bytes = 0;
+  // SUM: bytes of free blocks held in the shared arena
+  int64_t arena_cached_bytes = 0;
+};
+
+// Returns the caching allocator. It is always safe to free memory obtained
+// from it, even after disable() has been called.
+C10_API at::Allocator* get();
+
+// Installs the caching allocator as the CPU allocator. Not thread-safe with
+// respect to concurrent allocations; call it during initialization.
+C10_API void enable();
+// Restores the default CPU allocator.
+C10_API void disable();
+C10_API bool isEnabled();
+
+// Returns all cached blocks to the system. Per-thread free lists of other
+// threads are released the next time those threads allocate or free.
+C10_API void emptyCache();
+
+C10_API Stats getStats();
+C10_API void resetAccumulatedStats();
+C10_API void resetPeakStats();
+
+// Size class helpers, exposed for testing.
+C10_API size_t roundSize(size_t nbytes);
+C10_API size_t sizeClassIndex(size_t nbytes);
+
+} // namespace CPUCachingAllocator
+} // namespace c10
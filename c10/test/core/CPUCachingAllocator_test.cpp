@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/core/CPUCachingAllocator.h>
+
+using namespace c10;
+
+TEST(CPUCachingAllocator, SizeClasses) {
+  ASSERT_EQ(CPUCachingAllocator::roundSize(1), 64);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(64), 64);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(65), 128);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(512), 512);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(513), 640);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(1024), 1024);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(1025), 1280);
+
+  ASSERT_EQ(CPUCachingAllocator::sizeClassIndex(64), 0);
+  ASSERT_EQ(CPUCachingAllocator::sizeClassIndex(512), 7);
+  ASSERT_EQ(CPUCachingAllocator::sizeClassIndex(513), 8);
+  ASSERT_EQ(CPUCachingAllocator::sizeClassIndex(1024), 11);
+  ASSERT_EQ(CPUCachingAllocator::sizeClassIndex(1025), 12);
+
+  size_t prev = 0;
+  for (size_t n = 1; n <= CPUCachingAllocator::kMaxCachedSize; n = n * 3 / 2 + 1) {
+    size_t rounded = CPUCachingAllocator::roundSize(n);
+    ASSERT_GE(rounded, n);
+    ASSERT_EQ(rounded % gAlignment, 0);
+    // Rounding wastes at most a quarter of the request beyond the small sizes.
+    ASSERT_LE(rounded, std::max<size_t>(512, n + n / 4));
+    size_t index = CPUCachingAllocator::sizeClassIndex(n);
+    ASSERT_GE(index, prev);
+    prev = index;
+  }
+}
+
+TEST(CPUCachingAllocator, ReusesFreedBlocks) {
+  CPUCachingAllocator::emptyCache();
+  CPUCachingAllocator::resetAccumulatedStats();
+  at::Allocator* allocator = CPUCachingAllocator::get();
+
+  void* first = nullptr;
+  {
+    auto ptr = allocator->allocate(1000);
+    first = ptr.get();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(first) % gAlignment, 0);
+  }
+  {
+    auto ptr = allocator->allocate(1000);
+    ASSERT_EQ(ptr.get(), first);
+  }
+  auto stats = CPUCachingAllocator::getStats();
+  ASSERT_EQ(stats.allocations, 2);
+  ASSERT_EQ(stats.thread_cache_hits, 1);
+  ASSERT_GT(stats.thread_cached_bytes, 0);
+
+  CPUCachingAllocator::emptyCache();
+  stats = CPUCachingAllocator::getStats();
+  ASSERT_EQ(stats.thread_cached_bytes, 0);
+  ASSERT_EQ(stats.arena_cached_bytes, 0);
+  ASSERT_EQ(stats.reserved_bytes, 0);
+}
+
+TEST(CPUCachingAllocator, LargeBlocksUseArena) {
+  CPUCachingAllocator::emptyCache();
+  CPUCachingAllocator::resetAccumulatedStats();
+  at::Allocator* allocator = CPUCachingAllocator::get();
+
+  const size_t nbytes = CPUCachingAllocator::kMaxThreadCachedSize * 4;
+  void* first = nullptr;
+  {
+    auto ptr = allocator->allocate(nbytes);
+    first = ptr.get();
+  }
+  // Freed on another thread, reused on this one.
+  std::thread([&] {
+    auto ptr = allocator->allocate(nbytes);
+    ASSERT_EQ(ptr.get(), first);
+  }).join();
+
+  auto stats = CPUCachingAllocator::getStats();
+  ASSERT_EQ(stats.arena_hits, 1);
+  ASSERT_GE(stats.arena_cached_bytes, static_cast<int64_t>(nbytes));
+  ASSERT_GE(stats.peak_reserved_bytes, stats.reserved_bytes);
+  CPUCachingAllocator::emptyCache();
+}
+
+TEST(CPUCachingAllocator, CrossThreadFree) {
+  at::Allocator* allocator = CPUCachingAllocator::get();
+  void* raw = allocator->raw_allocate(128);
+  std::thread([&] { allocator->raw_deallocate(raw); }).join();
+  // The freeing thread's cache returns the block to the arena on exit.
+  auto ptr = allocator->allocate(128);
+  ASSERT_EQ(ptr.get(), raw);
+  CPUCachingAllocator::emptyCache();
+}
+
+TEST(CPUCachingAllocator, EnableDisable) {
+  ASSERT_FALSE(CPUCachingAllocator::isEnabled());
+  CPUCachingAllocator::enable();
+  ASSERT_TRUE(CPUCachingAllocator::isEnabled());
+  ASSERT_EQ(GetCPUAllocator(), CPUCachingAllocator::get());
+  auto ptr = GetCPUAllocator()->allocate(16);
+  CPUCachingAllocator::disable();
+  ASSERT_EQ(GetCPUAllocator(), GetDefaultCPUAllocator());
+  // Memory from the caching allocator outlives disabling it.
+  ptr.clear();
+  CPUCachingAllocator::emptyCache();
+}
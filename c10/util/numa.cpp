@@ -1,6 +1,12 @@
 #include "c10/util/numa.h"
 
 C10_DEFINE_bool(caffe2_cpu_numa_enabled, false, "Use NUMA whenever possible.");
+C10_DEFINE_bool(
+    caffe2_cpu_numa_first_touch,
+    false,
+    "If set together with caffe2_cpu_numa_enabled, do not move CPU allocations "
+    "to the allocating thread's NUMA node; pages are placed on the node of the "
+    "thread that first touches them.");
 
 #if defined(__linux__) && !defined(C10_DISABLE_NUMA) && !defined(C10_MOBILE)
 #include <numa.h>
@@ -9,11 +15,47 @@ C10_DEFINE_bool(caffe2_cpu_numa_enabled, false, "Use NUMA whenever possible.");
 #define C10_ENABLE_NUMA
 #endif
 
+#include <atomic>
+
 // This code used to have a lot of VLOGs. However, because allocation might be
 // triggered during static initialization, it's unsafe to invoke VLOG here
 
 namespace c10 {
 
+namespace {
+std::atomic<int64_t> numa_local_allocations{0};
+std::atomic<int64_t> numa_remote_allocations{0};
+std::atomic<int64_t> numa_first_touch_allocations{0};
+} // namespace
+
+void RecordNUMAAllocation(int numa_node_id) {
+  if (!IsNUMAEnabled()) {
+    return;
+  }
+  if (numa_node_id < 0) {
+    numa_first_touch_allocations.fetch_add(1, std::memory_order_relaxed);
+  } else if (numa_node_id == GetCurrentNUMANode()) {
+    numa_local_allocations.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    numa_remote_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+NUMAAllocationStats GetNUMAAllocationStats() {
+  NUMAAllocationStats stats;
+  stats.local = numa_local_allocations.load(std::memory_order_relaxed);
+  stats.remote = numa_remote_allocations.load(std::memory_order_relaxed);
+  stats.first_touch =
+      numa_first_touch_allocations.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void ResetNUMAAllocationStats() {
+  numa_local_allocations.store(0, std::memory_order_relaxed);
+  numa_remote_allocations.store(0, std::memory_order_relaxed);
+  numa_first_touch_allocations.store(0, std::memory_order_relaxed);
+}
+
 #ifdef C10_ENABLE_NUMA
 bool IsNUMAEnabled() {
   return FLAGS_caffe2_cpu_numa_enabled && numa_available() >= 0;
@@ -4,6 +4,7 @@
 #include <c10/util/Optional.h>
 
 C10_DECLARE_bool(caffe2_cpu_numa_enabled);
+C10_DECLARE_bool(caffe2_cpu_numa_first_touch);
 
 namespace c10 {
 
@@ -37,4 +38,26 @@ C10_API void NUMAMove(void* ptr, size_t size, int numa_node_id);
  */
 C10_API int GetCurrentNUMANode();
 
+/**
+ * Counters of CPU allocations handed out while NUMA is enabled: allocations
+ * whose memory is on the node of the allocating thread (local), on another
+ * node (remote), or left to be placed by the first thread touching it
+ */
+struct NUMAAllocationStats {
+  int64_t local = 0;
+  int64_t remote = 0;
+  int64_t first_touch = 0;
+};
+
+/**
+ * Record an allocation living on NUMA node `numa_node_id`, or left for
+ * first-touch placement if `numa_node_id` is negative. No-op unless NUMA is
+ * enabled
+ */
+C10_API void RecordNUMAAllocation(int numa_node_id);
+
+C10_API NUMAAllocationStats GetNUMAAllocationStats();
+
+C10_API void ResetNUMAAllocationStats();
+
 } // namespace c10
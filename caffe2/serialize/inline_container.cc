@@ -148,10 +148,14 @@ constexpr int MZ_ZIP_LOCAL_DIR_HEADER_SIZE = 30;
 constexpr int MZ_ZIP_LDH_FILENAME_LEN_OFS = 26;
 constexpr int MZ_ZIP_LDH_EXTRA_LEN_OFS = 28;
 
+// Padding that fits in the zip extra field next to miniz's own zip64 field.
+constexpr size_t kMaxExtraFieldPadding = MZ_UINT16_MAX - kFieldAlignment;
+
 static size_t getPadding(
     size_t cursor,
     size_t filename_size,
     size_t size,
+    uint64_t alignment,
     std::string& padding_buf) {
   size_t start = cursor + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename_size +
       sizeof(mz_uint16) * 2;
@@ -164,10 +168,14 @@ static size_t getPadding(
       start += sizeof(mz_uint64);
     }
   }
-  size_t mod = start % kFieldAlignment;
-  size_t next_offset = (mod == 0) ? start : (start + kFieldAlignment - mod);
+  size_t mod = start % alignment;
+  size_t next_offset = (mod == 0) ? start : (start + alignment - mod);
   size_t padding_size = next_offset - start;
   size_t padding_size_plus_fbxx = padding_size + 4;
+  if (padding_size_plus_fbxx > kMaxExtraFieldPadding) {
+    // Too large for the extra field; the caller writes a gap first.
+    return padding_size_plus_fbxx;
+  }
   if (padding_buf.size() < padding_size_plus_fbxx) {
     padding_buf.append(padding_size_plus_fbxx - padding_buf.size(), 'Z');
   }
@@ -211,12 +219,42 @@ size_t PyTorchStreamReader::getRecordID(const std::string& name) {
   return result;
 }
 
+static int64_t read_le_16(uint8_t* buf) {
+  return buf[0] + (buf[1] << 8);
+}
+
+// Offset of the record data, which follows the variable-length local header.
+static size_t getDataOffset(
+    ReadAdapterInterface* in,
+    const mz_zip_archive_file_stat& stat) {
+  uint8_t local_header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
+  in->read(
+      stat.m_local_header_ofs,
+      local_header,
+      MZ_ZIP_LOCAL_DIR_HEADER_SIZE,
+      "reading file header");
+  size_t filename_len = read_le_16(local_header + MZ_ZIP_LDH_FILENAME_LEN_OFS);
+  size_t extra_len = read_le_16(local_header + MZ_ZIP_LDH_EXTRA_LEN_OFS);
+  return stat.m_local_header_ofs + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename_len + extra_len;
+}
+
 // return dataptr, size
 std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getRecord(const std::string& name) {
   size_t key = getRecordID(name);
   mz_zip_archive_file_stat stat;
   mz_zip_reader_file_stat(ar_.get(), key, &stat);
   valid("retrieving file meta-data for ", name.c_str());
+  // Stored records can alias the input when the adapter supports it (e.g.
+  // MmapAdapter). Records that are not aligned as PyTorchStreamWriter would
+  // align them are still copied. Unlike extraction, this skips the CRC check.
+  if (stat.m_method == 0 && !stat.m_is_encrypted) {
+    at::DataPtr mapped =
+        in_->mapped(getDataOffset(in_.get(), stat), stat.m_uncomp_size);
+    if (mapped &&
+        reinterpret_cast<uintptr_t>(mapped.get()) % kFieldAlignment == 0) {
+      return std::make_tuple(std::move(mapped), stat.m_uncomp_size);
+    }
+  }
   void * ptr = malloc(stat.m_uncomp_size);
   mz_zip_reader_extract_to_mem(ar_.get(), key, ptr, stat.m_uncomp_size, 0);
   valid("reading file ", name.c_str());
@@ -225,23 +263,22 @@ std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getRecord(const std::string
   return std::make_tuple(std::move(retval), stat.m_uncomp_size);
 }
 
-static int64_t read_le_16(uint8_t* buf) {
-  return buf[0] + (buf[1] << 8);
+size_t PyTorchStreamReader::getRecordOffset(const std::string& name) {
+  mz_zip_archive_file_stat stat;
+  mz_zip_reader_file_stat(ar_.get(), getRecordID(name), &stat);
+  valid("retrieving file meta-data for ", name.c_str());
+  return getDataOffset(in_.get(), stat);
 }
 
-size_t PyTorchStreamReader::getRecordOffset(const std::string& name) {
+std::tuple<size_t, size_t> PyTorchStreamReader::getRecordLocation(
+    const std::string& name) {
   mz_zip_archive_file_stat stat;
   mz_zip_reader_file_stat(ar_.get(), getRecordID(name), &stat);
   valid("retrieving file meta-data for ", name.c_str());
-  uint8_t local_header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
-  in_->read(
-      stat.m_local_header_ofs,
-      local_header,
-      MZ_ZIP_LOCAL_DIR_HEADER_SIZE,
-      "reading file header");
-  size_t filename_len = read_le_16(local_header + MZ_ZIP_LDH_FILENAME_LEN_OFS);
-  size_t extra_len = read_le_16(local_header + MZ_ZIP_LDH_EXTRA_LEN_OFS);
-  return stat.m_local_header_ofs + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename_len + extra_len;
+  if (stat.m_method != 0 || stat.m_is_encrypted) {
+    CAFFE_THROW("record ", name, " is not stored uncompressed");
+  }
+  return std::make_tuple(getDataOffset(in_.get(), stat), stat.m_uncomp_size);
 }
 
 
@@ -308,16 +345,40 @@ void PyTorchStreamWriter::setup(const string& file_name) {
   writeRecord("version", version.c_str(), version.size());
 }
 
+void PyTorchStreamWriter::writeGap(size_t size) {
+  static const std::string zeros(kFieldAlignment * 64, '\0');
+  while (size > 0) {
+    size_t n = std::min(size, zeros.size());
+    ostream_write_func(this, ar_->m_archive_size, zeros.data(), n);
+    ar_->m_archive_size += n;
+    size -= n;
+  }
+}
+
 void PyTorchStreamWriter::writeRecord(
     const std::string& name,
     const void* data,
     size_t size,
-    bool compress) {
+    bool compress,
+    uint64_t alignment) {
   AT_ASSERT(!finalized_);
   AT_ASSERT(!archive_name_plus_slash_.empty());
+  AT_ASSERTM(
+      alignment >= kFieldAlignment && (alignment & (alignment - 1)) == 0,
+      "record alignment must be a power of two of at least ",
+      kFieldAlignment,
+      ", got ",
+      alignment);
   std::string full_name = archive_name_plus_slash_ + name;
-  size_t padding_size =
-      getPadding(ar_->m_archive_size, full_name.size(), size, padding_);
+  size_t padding_size = getPadding(
+      ar_->m_archive_size, full_name.size(), size, alignment, padding_);
+  // Loops only if the gap moves the local header across the zip64 limit.
+  while (padding_size > kMaxExtraFieldPadding) {
+    writeGap(padding_size - 4);
+    valid("writing padding for ", name.c_str());
+    padding_size = getPadding(
+        ar_->m_archive_size, full_name.size(), size, alignment, padding_);
+  }
   uint32_t flags = compress ? MZ_BEST_COMPRESSION : 0;
   mz_zip_writer_add_mem_ex_v2(
       ar_.get(),
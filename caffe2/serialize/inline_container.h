@@ -41,7 +41,11 @@ typedef struct mz_zip_archive mz_zip_archive;
 // 1. All files are stored uncompressed.
 // 2. All files in the archive are aligned to 64 byte boundaries such that
 //    it is possible to mmap the entire file and get an aligned pointer to
-//    tensor data.
+//    tensor data. writeRecord can align individual records further, e.g. to
+//    pages for O_DIRECT reads. Padding up to 64 KiB is stored in a zip extra
+//    field; larger padding is a gap of zeros in front of the local header,
+//    which zip readers skip because they locate files through the central
+//    directory.
 // 3. We universally write in ZIP64 format for consistency.
 
 // The PyTorchStreamReader also provides additional properties:
@@ -50,7 +54,12 @@ typedef struct mz_zip_archive mz_zip_archive;
 //    the reader can still read files that were compressed.
 // 2. It provides a getRecordOffset function which returns the offset into the
 //    raw file where file data lives. If the file was written with PyTorchStreamWriter
-//    it is guaranteed to be 64 byte aligned.
+//    it is guaranteed to be 64 byte aligned. getRecordLocation also returns the
+//    length and checks that the record is stored uncompressed, so the bytes
+//    can be consumed in place (mmap, direct I/O).
+// 3. getRecord does not copy stored records if the ReadAdapterInterface can
+//    alias its data (ReadAdapterInterface::mapped). With a MmapAdapter, tensor
+//    storages then point straight into a copy-on-write mapping of the file.
 
 // PyTorchReader/Writer handle checking the version number on the archive format
 // and ensure that all files are written to a archive_name directory so they
@@ -95,6 +104,9 @@ constexpr uint64_t kProducedFileFormatVersion = 0x2L;
 
 // Writer-specific constants
 constexpr uint64_t kFieldAlignment = 64;
+// Record alignments for direct I/O and mmap with 4 KiB or 2 MiB pages.
+constexpr uint64_t kPageAlignment = 4096;
+constexpr uint64_t kHugePageAlignment = 2 * 1024 * 1024;
 
 class CAFFE2_API PyTorchStreamReader final {
  public:
@@ -105,6 +117,8 @@ class CAFFE2_API PyTorchStreamReader final {
   // return dataptr, size
   std::tuple<at::DataPtr, size_t> getRecord(const std::string& name);
   size_t getRecordOffset(const std::string& name);
+  // return offset, size of the data of a record stored uncompressed
+  std::tuple<size_t, size_t> getRecordLocation(const std::string& name);
   bool hasRecord(const std::string& name);
   std::vector<std::string> getAllRecords();
 
@@ -133,11 +147,14 @@ class CAFFE2_API PyTorchStreamWriter final {
   explicit PyTorchStreamWriter(
       const std::function<size_t(const void*, size_t)>& writer_func);
 
+  // `alignment` is the alignment of the record data in the file; it must be
+  // a power of two and at least kFieldAlignment.
   void writeRecord(
       const std::string& name,
       const void* data,
       size_t size,
-      bool compress = false);
+      bool compress = false,
+      uint64_t alignment = kFieldAlignment);
   void writeEndOfFile();
 
   bool finalized() const {
@@ -153,6 +170,7 @@ class CAFFE2_API PyTorchStreamWriter final {
  private:
   void setup(const string& file_name);
   void valid(const char* what, const char* info = "");
+  void writeGap(size_t size);
   size_t current_pos_ = 0;
   std::unique_ptr<mz_zip_archive> ar_;
   std::string archive_name_;
@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include "caffe2/serialize/inline_container.h"
+#include "caffe2/serialize/mmap_adapter.h"
 
 namespace caffe2 {
 namespace serialize {
@@ -63,6 +64,85 @@ TEST(PyTorchStreamWriterAndReader, SaveAndLoad) {
   ASSERT_EQ(memcmp(the_file.c_str() + off2, data2.data(), data2.size()), 0);
 }
 
+TEST(PyTorchStreamWriterAndReader, RecordAlignment) {
+  std::ostringstream oss;
+  PyTorchStreamWriter writer([&](const void* b, size_t n) -> size_t {
+    oss.write(static_cast<const char*>(b), n);
+    return oss ? n : 0;
+  });
+  std::array<char, 100> data;
+  for (int i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i);
+  }
+  writer.writeRecord("small", data.data(), data.size());
+  writer.writeRecord(
+      "page", data.data(), data.size(), /*compress=*/false, kPageAlignment);
+  // Needs more padding than fits in the zip extra field.
+  writer.writeRecord(
+      "huge", data.data(), data.size(), /*compress=*/false, kHugePageAlignment);
+  writer.writeRecord("code", data.data(), data.size(), /*compress=*/true);
+  writer.writeEndOfFile();
+
+  std::string the_file = oss.str();
+  std::istringstream iss(the_file);
+  PyTorchStreamReader reader(&iss);
+  for (const auto& name_and_alignment :
+       {std::make_pair("small", kFieldAlignment),
+        std::make_pair("page", kPageAlignment),
+        std::make_pair("huge", kHugePageAlignment)}) {
+    size_t offset, size;
+    std::tie(offset, size) = reader.getRecordLocation(name_and_alignment.first);
+    ASSERT_EQ(offset % name_and_alignment.second, 0);
+    ASSERT_EQ(offset, reader.getRecordOffset(name_and_alignment.first));
+    ASSERT_EQ(size, data.size());
+    ASSERT_EQ(memcmp(the_file.c_str() + offset, data.data(), data.size()), 0);
+
+    at::DataPtr data_ptr;
+    std::tie(data_ptr, size) = reader.getRecord(name_and_alignment.first);
+    ASSERT_EQ(memcmp(data_ptr.get(), data.data(), data.size()), 0);
+  }
+  ASSERT_THROW(reader.getRecordLocation("code"), c10::Error);
+  ASSERT_THROW(
+      writer.writeRecord("bad", data.data(), data.size(), false, 100),
+      c10::Error);
+}
+
+#ifndef _WIN32
+TEST(PyTorchStreamWriterAndReader, MmapZeroCopy) {
+  std::array<char, 4096> data;
+  for (int i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i);
+  }
+  {
+    PyTorchStreamWriter writer("mmap_output.zip");
+    writer.writeRecord("key1", data.data(), data.size());
+    writer.writeEndOfFile();
+  }
+
+  at::DataPtr data_ptr;
+  int64_t size;
+  {
+    auto adapter = std::make_unique<MmapAdapter>("mmap_output.zip");
+    const char* base = static_cast<const char*>(adapter->mapped(0, 0).get());
+    PyTorchStreamReader reader(std::move(adapter));
+    std::tie(data_ptr, size) = reader.getRecord("key1");
+    ASSERT_EQ(size, data.size());
+    ASSERT_EQ(
+        static_cast<const char*>(data_ptr.get()),
+        base + reader.getRecordOffset("key1"));
+  }
+  // The record keeps the mapping alive after the reader is gone, and writes
+  // to it are not visible in the file.
+  ASSERT_EQ(memcmp(data_ptr.get(), data.data(), data.size()), 0);
+  memset(data_ptr.get(), 0, data.size());
+
+  PyTorchStreamReader reader("mmap_output.zip");
+  at::DataPtr reread_ptr;
+  std::tie(reread_ptr, size) = reader.getRecord("key1");
+  ASSERT_EQ(memcmp(reread_ptr.get(), data.data(), data.size()), 0);
+}
+#endif
+
 } // namespace
 } // namespace serialize
 } // namespace caffe2
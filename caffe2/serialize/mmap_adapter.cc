@@ -0,0 +1,98 @@
+#include "caffe2/serialize/mmap_adapter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <c10/util/Exception.h>
+
+namespace caffe2 {
+namespace serialize {
+
+struct MmapAdapter::Mapping {
+  char* base = nullptr;
+  size_t size = 0;
+
+  ~Mapping() {
+#ifndef _WIN32
+    if (base != nullptr) {
+      munmap(base, size);
+    }
+#endif
+  }
+};
+
+// Context of the DataPtrs returned by mapped(): one reference to the mapping.
+void MmapAdapter::deleteMappingRef(void* ctx) {
+  delete static_cast<std::shared_ptr<Mapping>*>(ctx);
+}
+
+MmapAdapter::MmapAdapter(const std::string& file_name)
+    : mapping_(std::make_shared<Mapping>()) {
+#ifdef _WIN32
+  AT_ERROR("MmapAdapter is not supported on Windows, file path: ", file_name);
+#else
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd == -1) {
+    AT_ERROR("open file failed, file path: ", file_name);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    int err = errno;
+    close(fd);
+    AT_ERROR("fstat failed, file path: ", file_name, ": ", strerror(err));
+  }
+  mapping_->size = file_stat.st_size;
+  if (mapping_->size > 0) {
+    // MAP_PRIVATE gives copy-on-write pages: writes never reach the file.
+    void* base = mmap(
+        nullptr, mapping_->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+      int err = errno;
+      close(fd);
+      AT_ERROR("mmap failed, file path: ", file_name, ": ", strerror(err));
+    }
+    mapping_->base = static_cast<char*>(base);
+  }
+  // The mapping keeps the file alive.
+  close(fd);
+#endif
+}
+
+size_t MmapAdapter::size() const {
+  return mapping_->size;
+}
+
+size_t MmapAdapter::read(uint64_t pos, void* buf, size_t n, const char* what)
+    const {
+  if (pos >= mapping_->size) {
+    return 0;
+  }
+  n = std::min<size_t>(n, mapping_->size - pos);
+  std::memcpy(buf, mapping_->base + pos, n);
+  return n;
+}
+
+c10::DataPtr MmapAdapter::mapped(uint64_t pos, size_t n) const {
+  TORCH_CHECK(
+      pos + n <= mapping_->size,
+      "mapped range [", pos, ", ", pos + n, ") is out of bounds of a file of ",
+      mapping_->size, " bytes");
+  return c10::DataPtr(
+      mapping_->base + pos,
+      new std::shared_ptr<Mapping>(mapping_),
+      &deleteMappingRef,
+      c10::DeviceType::CPU);
+}
+
+MmapAdapter::~MmapAdapter() {}
+
+} // namespace serialize
+} // namespace caffe2
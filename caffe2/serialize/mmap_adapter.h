@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "c10/macros/Macros.h"
+#include "caffe2/serialize/read_adapter_interface.h"
+
+namespace caffe2 {
+namespace serialize {
+
+// this is a reader over a private (copy-on-write) memory mapping of a file.
+// Records read through PyTorchStreamReader::getRecord alias the mapping
+// instead of being copied, so unmodified pages are shared with the page cache
+// and with other processes mapping the same file; writing to a record only
+// copies the touched pages. The mapping lives as long as the adapter or any
+// DataPtr handed out by it.
+class CAFFE2_API MmapAdapter final : public ReadAdapterInterface {
+ public:
+  C10_DISABLE_COPY_AND_ASSIGN(MmapAdapter);
+  explicit MmapAdapter(const std::string& file_name);
+  size_t size() const override;
+  size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
+      const override;
+  c10::DataPtr mapped(uint64_t pos, size_t n) const override;
+  ~MmapAdapter();
+
+ private:
+  struct Mapping;
+  static void deleteMappingRef(void* ctx);
+  std::shared_ptr<Mapping> mapping_;
+};
+
+} // namespace serialize
+} // namespace caffe2
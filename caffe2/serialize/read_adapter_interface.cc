@@ -3,6 +3,10 @@
 namespace caffe2 {
 namespace serialize {
 
+c10::DataPtr ReadAdapterInterface::mapped(uint64_t pos, size_t n) const {
+  return c10::DataPtr();
+}
+
 ReadAdapterInterface::~ReadAdapterInterface() {}
 
 } // namespace serialize
@@ -1,9 +1,15 @@
 #include <gtest/gtest.h>
 
 #include <torch/torch.h>
+#include <torch/csrc/autograd/activation_offload.h>
+#include <torch/csrc/autograd/engine.h>
+
+#include <c10/util/tempfile.h>
 
 #include <test/cpp/api/support.h>
 
+#include <thread>
+
 using namespace torch::autograd;
 
 #define ASSERT_VARIABLE_EQ(a,b) ASSERT_TRUE(torch::allclose((a),(b)))
@@ -123,6 +129,112 @@ TEST(AutogradAPITests, GradUnreachableTest) {
   ASSERT_FALSE(grad_res[1].defined());
 }
 
+TEST(AutogradAPITests, MultipleCPUWorkersTest) {
+  // A separate engine, since the default one may have started its workers.
+  Engine engine;
+  engine.set_num_cpu_workers(4);
+
+  Variable x = torch::randn({4, 4}, torch::requires_grad());
+  variable_list branches;
+  for (int64_t i = 0; i < 64; i++) {
+    branches.push_back((x * i).sin());
+  }
+  auto res = torch::stack(branches).sum();
+  engine.execute({impl::gradient_edge(res)}, {torch::ones({})}, false, false);
+  auto expected = torch::zeros_like(x);
+  for (int64_t i = 0; i < 64; i++) {
+    expected += (x * i).cos() * i;
+  }
+  ASSERT_VARIABLE_EQ(x.grad(), expected);
+
+  // Concurrent backward passes accumulate into the same leaf.
+  Variable y = torch::randn({4, 4}, torch::requires_grad());
+  std::vector<std::thread> threads;
+  for (int64_t t = 0; t < 8; t++) {
+    threads.emplace_back([&engine, &y] {
+      for (int64_t k = 0; k < 10; k++) {
+        auto res = (y * 2).sum();
+        engine.execute(
+            {impl::gradient_edge(res)}, {torch::ones({})}, false, false);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_VARIABLE_EQ(y.grad(), torch::full_like(y, 160));
+
+  ASSERT_THROWS_WITH(
+      engine.set_num_cpu_workers(2), "before the first backward pass");
+}
+
+TEST(AutogradAPITests, ActivationOffloadTest) {
+  Variable x = torch::randn({64, 64}, torch::requires_grad());
+  auto run = [&x] {
+    x.grad() = Variable();
+    (x * 2).sin().exp().sum().backward();
+    return x.grad();
+  };
+  auto expected = run();
+
+  OffloadConfig config(/*memory_budget=*/0);
+  config.min_bytes = 0;
+  for (auto mode : {OffloadMode::Half, OffloadMode::Int8, OffloadMode::Spill}) {
+    auto spill_file = c10::make_tempfile();
+    config.mode = mode;
+    config.spill_file = spill_file.name;
+    config.spill_budget = 1 << 20;
+    resetActivationOffloadStats();
+    enableActivationOffload(config);
+    auto grad = run();
+    disableActivationOffload();
+
+    auto stats = activationOffloadStats();
+    // sin saves its input and exp its output.
+    ASSERT_EQ(stats.offloaded, 2);
+    ASSERT_EQ(stats.restored, 2);
+    ASSERT_GT(stats.bytes_saved, 0);
+    ASSERT_EQ(stats.resident_bytes, 0);
+    if (mode == OffloadMode::Half) {
+      ASSERT_TRUE(torch::allclose(grad, expected, 1e-2, 5e-2));
+    } else if (mode == OffloadMode::Int8) {
+      ASSERT_TRUE(torch::allclose(grad, expected, 0.1, 0.25));
+    } else {
+      ASSERT_VARIABLE_EQ(grad, expected);
+    }
+  }
+
+  // Enabling spilling again with the same file leaves the activations spilled
+  // before alone.
+  {
+    auto spill_file = c10::make_tempfile();
+    config.mode = OffloadMode::Spill;
+    config.spill_file = spill_file.name;
+    x.grad() = Variable();
+    enableActivationOffload(config);
+    auto y1 = (x * 2).sin().exp().sum();
+    disableActivationOffload();
+    enableActivationOffload(config);
+    auto y2 = (x * 3).sin().exp().sum();
+    disableActivationOffload();
+    y1.backward();
+    ASSERT_VARIABLE_EQ(x.grad(), expected);
+  }
+
+  // Activations are only offloaded once the budget is used up.
+  config.memory_budget = 64 * 64 * sizeof(float);
+  config.mode = OffloadMode::Half;
+  resetActivationOffloadStats();
+  enableActivationOffload(config);
+  auto y = (x * 2).sin().exp().sum();
+  ASSERT_EQ(activationOffloadStats().offloaded, 1);
+  ASSERT_EQ(activationOffloadStats().resident_bytes, 64 * 64 * sizeof(float));
+  disableActivationOffload();
+  y.backward();
+  ASSERT_EQ(activationOffloadStats().restored, 1);
+  ASSERT_EQ(activationOffloadStats().resident_bytes, 0);
+}
+
 TEST(CustomAutogradTest, CustomFunction) {
   struct MyFunction : public Function<MyFunction> {
     static Variable forward(AutogradContext *ctx, Variable var1, int mul, Variable var2) {
@@ -485,6 +485,62 @@ TEST(DataTest, StackTransformWorksForTensorExample) {
   ASSERT_TRUE(second.data.allclose(torch::eye(4).slice(/*dim=*/0, 2, 4)));
 }
 
+struct SquaresDataset : datasets::BufferedDataset<SquaresDataset> {
+  explicit SquaresDataset(size_t buffers = 4)
+      : BufferedDataset(datasets::BatchBufferOptions({2}).buffers(buffers)) {}
+
+  void get_into(size_t index, torch::Tensor data, torch::Tensor target)
+      override {
+    data.fill_(static_cast<double>(index * index));
+    target.fill_(static_cast<int64_t>(index));
+  }
+
+  torch::optional<size_t> size() const override {
+    return 100;
+  }
+};
+
+TEST(DataTest, BufferedDatasetWritesExamplesIntoTheBatch) {
+  SquaresDataset dataset;
+  Example<> batch = dataset.get_batch({3, 1, 2});
+  ASSERT_EQ(batch.data.sizes(), std::vector<int64_t>({3, 2}));
+  ASSERT_EQ(batch.data.dtype(), torch::kFloat);
+  ASSERT_TRUE(batch.data.allclose(
+      torch::tensor({9.0f, 1.0f, 4.0f}).view({3, 1}).expand({3, 2})));
+  ASSERT_EQ(batch.target.sizes(), std::vector<int64_t>({3}));
+  ASSERT_EQ(batch.target.dtype(), torch::kLong);
+  ASSERT_TRUE(batch.target.equal(torch::tensor({3, 1, 2}, torch::kLong)));
+}
+
+TEST(DataTest, BufferedDatasetReusesBatchesOnceDropped) {
+  SquaresDataset dataset(/*buffers=*/1);
+  void* buffer = dataset.get_batch({0, 1}).data.data_ptr();
+
+  {
+    Example<> batch = dataset.get_batch({2, 3});
+    ASSERT_EQ(batch.data.data_ptr(), buffer);
+    // The only buffer is in use, so this one is freshly allocated.
+    Example<> other = dataset.get_batch({4, 5});
+    ASSERT_NE(other.data.data_ptr(), buffer);
+    ASSERT_TRUE(other.target.equal(torch::tensor({4, 5}, torch::kLong)));
+    ASSERT_TRUE(batch.target.equal(torch::tensor({2, 3}, torch::kLong)));
+  }
+
+  // A smaller batch is a view of the buffer, which keeps it in use too.
+  Example<> last = dataset.get_batch({6});
+  ASSERT_EQ(last.data.data_ptr(), buffer);
+  ASSERT_EQ(last.data.size(0), 1);
+  ASSERT_NE(dataset.get_batch({7, 8}).data.data_ptr(), buffer);
+}
+
+TEST(DataTest, BufferedDatasetCopiesDoNotShareBatches) {
+  SquaresDataset dataset(/*buffers=*/1);
+  Example<> batch = dataset.get_batch({0, 1});
+  SquaresDataset copy = dataset;
+  ASSERT_NE(copy.get_batch({2, 3}).data.data_ptr(), batch.data.data_ptr());
+  ASSERT_TRUE(batch.target.equal(torch::tensor({0, 1}, torch::kLong)));
+}
+
 // Template classes cannot be nested in functions.
 template <typename Target>
 struct T : transforms::TensorTransform<Target> {
@@ -639,6 +695,74 @@ TEST(DataTest, MapDoesNotCopy) {
   ASSERT_EQ(data[0].item<float>(), 7);
 }
 
+struct CountingDataset : datasets::Dataset<CountingDataset> {
+  Example<> get(size_t index) override {
+    ++*reads;
+    return {torch::full({4}, static_cast<double>(index)),
+            torch::tensor(static_cast<int64_t>(index))};
+  }
+
+  torch::optional<size_t> size() const override {
+    return 10;
+  }
+
+  std::shared_ptr<std::atomic<size_t>> reads =
+      std::make_shared<std::atomic<size_t>>(0);
+};
+
+TEST(DataTest, CachedDatasetServesRepeatedReadsFromMemory) {
+  CountingDataset source;
+  auto reads = source.reads;
+  datasets::CachedDataset<CountingDataset> dataset(source, 1024 * 1024);
+  ASSERT_EQ(dataset.size().value(), 10);
+
+  for (size_t epoch = 0; epoch < 3; ++epoch) {
+    auto batch = dataset.get_batch({3, 1, 4});
+    ASSERT_EQ(batch.size(), 3);
+    ASSERT_TRUE(batch[2].data.equal(torch::full({4}, 4.0)));
+    ASSERT_EQ(batch[2].target.item<int64_t>(), 4);
+  }
+  ASSERT_EQ(reads->load(), 3);
+
+  auto stats = dataset.stats();
+  ASSERT_EQ(stats.misses, 3);
+  ASSERT_EQ(stats.hits, 6);
+  ASSERT_GT(stats.memory_bytes, 0);
+  ASSERT_EQ(stats.spilled_bytes, 0);
+}
+
+TEST(DataTest, CachedDatasetSpillsToFileBeyondMemoryBudget) {
+  auto tempfile = c10::make_tempfile();
+  CountingDataset source;
+  auto reads = source.reads;
+  datasets::CachedDataset<CountingDataset> dataset(
+      source,
+      datasets::CacheOptions(/*memory_budget=*/0)
+          .spill_file(tempfile.name)
+          .spill_budget(1024 * 1024));
+
+  for (size_t epoch = 0; epoch < 2; ++epoch) {
+    for (size_t i = 0; i < 10; ++i) {
+      auto example = dataset.get(i);
+      ASSERT_TRUE(example.data.equal(torch::full({4}, static_cast<double>(i))));
+      ASSERT_EQ(example.target.item<int64_t>(), static_cast<int64_t>(i));
+    }
+  }
+  ASSERT_EQ(reads->load(), 10);
+  ASSERT_EQ(dataset.stats().memory_bytes, 0);
+  ASSERT_GT(dataset.stats().spilled_bytes, 0);
+}
+
+TEST(DataTest, CachedDatasetReadsFromSourceOnceBudgetsAreUsedUp) {
+  CountingDataset source;
+  auto reads = source.reads;
+  datasets::CachedDataset<CountingDataset> dataset(source, 0);
+  dataset.get(1);
+  dataset.get(1);
+  ASSERT_EQ(reads->load(), 2);
+  ASSERT_EQ(dataset.stats().misses, 2);
+}
+
 TEST(DataTest, QueuePushAndPopFromSameThread) {
   torch::data::detail::Queue<int> queue;
   queue.push(1);
@@ -688,6 +812,94 @@ TEST(DataTest, QueueClearEmptiesTheQueue) {
   ASSERT_THROWS_WITH(queue.pop(1 * kMillisecond), "Timeout");
 }
 
+TEST(DataTest, LockFreeQueuePushAndPopFromSameThread) {
+  torch::data::detail::LockFreeQueue<int> queue(4);
+  queue.push(1);
+  queue.push(2);
+  ASSERT_EQ(queue.pop(), 1);
+  ASSERT_EQ(queue.pop(), 2);
+}
+
+TEST(DataTest, LockFreeQueuePopWithTimeoutThrowsUponTimeout) {
+  torch::data::detail::LockFreeQueue<int> queue(4);
+  ASSERT_THROWS_WITH(
+      queue.pop(10 * kMillisecond),
+      "Timeout in DataLoader queue while waiting for next batch "
+      "(timeout was 10 ms)");
+}
+
+TEST(DataTest, LockFreeQueuePushAndPopFromDifferentThreads) {
+  using torch::data::detail::LockFreeQueue;
+
+  // First test: push batch and the pop in thread.
+  {
+    LockFreeQueue<int> queue(4);
+    queue.push(1);
+    auto future =
+        std::async(std::launch::async, [&queue] { return queue.pop(); });
+    ASSERT_EQ(future.get(), 1);
+  }
+
+  // Second test: attempt to pop batch (and block), then push.
+  {
+    LockFreeQueue<int> queue(4);
+    std::thread thread([&queue] {
+      std::this_thread::sleep_for(20 * kMillisecond);
+      queue.push(123);
+    });
+    ASSERT_EQ(queue.pop(), 123);
+    thread.join();
+  }
+}
+
+TEST(DataTest, LockFreeQueuePushBlocksWhileFull) {
+  torch::data::detail::LockFreeQueue<std::string> queue(2);
+  queue.push("a");
+  queue.push("b");
+  auto future = std::async(std::launch::async, [&queue] { queue.push("c"); });
+  ASSERT_EQ(
+      future.wait_for(20 * kMillisecond), std::future_status::timeout);
+  ASSERT_EQ(queue.pop(), "a");
+  future.get();
+  ASSERT_EQ(queue.pop(), "b");
+  ASSERT_EQ(queue.pop(), "c");
+}
+
+TEST(DataTest, LockFreeQueueManyProducersAndConsumers) {
+  const size_t kThreads = 8;
+  const int kValuesPerThread = 10000;
+  torch::data::detail::LockFreeQueue<std::unique_ptr<int>> queue(16);
+  std::atomic<int64_t> sum(0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&queue] {
+      for (int i = 1; i <= kValuesPerThread; ++i) {
+        queue.push(torch::make_unique<int>(i));
+      }
+    });
+    threads.emplace_back([&queue, &sum] {
+      for (int i = 0; i < kValuesPerThread; ++i) {
+        sum += *queue.pop();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(
+      sum.load(),
+      int64_t(kThreads) * kValuesPerThread * (kValuesPerThread + 1) / 2);
+}
+
+TEST(DataTest, LockFreeQueueClearEmptiesTheQueue) {
+  torch::data::detail::LockFreeQueue<int> queue(4);
+  queue.push(1);
+  queue.push(2);
+  queue.push(3);
+  ASSERT_EQ(queue.clear(), 3);
+  ASSERT_THROWS_WITH(queue.pop(1 * kMillisecond), "Timeout");
+}
+
 TEST(DataTest, DataShuttleCanPushAndPopJob) {
   torch::data::detail::DataShuttle<int, int> shuttle;
   shuttle.push_job(1);
@@ -1532,6 +1744,46 @@ TEST(DataLoaderTest, StatefulDatasetWithManyWorkers) {
   }
 }
 
+TEST(DataLoaderTest, CanLoadBufferedDatasetWithWorkers) {
+  auto data_loader = torch::data::make_data_loader(
+      SquaresDataset(),
+      DataLoaderOptions().batch_size(16).workers(4).max_jobs(8));
+
+  int64_t sum = 0;
+  size_t examples = 0;
+  for (auto& batch : *data_loader) {
+    ASSERT_TRUE(batch.data.select(1, 0).equal(
+        (batch.target * batch.target).to(torch::kFloat)));
+    sum += batch.target.sum().item<int64_t>();
+    examples += batch.target.size(0);
+  }
+  ASSERT_EQ(examples, 100);
+  ASSERT_EQ(sum, 99 * 100 / 2);
+}
+
+TEST(DataLoaderTest, CachedDatasetIsSharedByWorkers) {
+  CountingDataset source;
+  auto reads = source.reads;
+  datasets::CachedDataset<CountingDataset> dataset(source, 1024 * 1024);
+  auto data_loader = torch::data::make_data_loader(
+      dataset, DataLoaderOptions().batch_size(3).workers(4));
+
+  for (size_t epoch = 0; epoch < 3; ++epoch) {
+    std::vector<int64_t> indices;
+    for (auto& batch : *data_loader) {
+      for (auto& example : batch) {
+        indices.push_back(example.target.item<int64_t>());
+      }
+    }
+    std::sort(indices.begin(), indices.end());
+    std::vector<int64_t> expected(10);
+    std::iota(expected.begin(), expected.end(), 0);
+    ASSERT_EQ(indices, expected);
+  }
+  ASSERT_EQ(reads->load(), 10);
+  ASSERT_EQ(dataset.stats().hits, 20);
+}
+
 TEST(DataLoaderTest, StatefulDatasetWithMap) {
   const int kNumberOfExamplesAfterWhichTheDatasetExhausts = 10;
 
@@ -2302,4 +2554,77 @@ TEST(DataLoaderTest, CustomPreprocessPolicy) {
       }
     }
   }
-}
\ No newline at end of file
+}
+TEST(DataLoaderTest, ChunkDatasetKeepsSeveralAsyncReadsInFlight) {
+  const size_t chunk_count_ = 8;
+  const size_t chunk_size = 10;
+
+  struct AsyncChunkDataReader : datasets::ChunkDataReader<int> {
+   public:
+    using BatchType = datasets::ChunkDataReader<int>::ChunkType;
+
+    BatchType read_chunk(size_t chunk_index) override {
+      return BatchType(chunk_size, static_cast<int>(chunk_index));
+    }
+
+    std::future<BatchType> read_chunk_async(size_t chunk_index) override {
+      auto counters = counters_;
+      auto reads = ++counters->reads_in_flight;
+      auto peak = counters->peak_reads_in_flight.load();
+      while (reads > peak &&
+             !counters->peak_reads_in_flight.compare_exchange_weak(
+                 peak, reads)) {
+      }
+      return std::async(std::launch::async, [this, counters, chunk_index] {
+        std::this_thread::sleep_for(20 * kMillisecond);
+        --counters->reads_in_flight;
+        return read_chunk(chunk_index);
+      });
+    }
+
+    size_t chunk_count() override {
+      return chunk_count_;
+    };
+
+    void reset() override{};
+
+    struct Counters {
+      std::atomic<size_t> reads_in_flight{0};
+      std::atomic<size_t> peak_reads_in_flight{0};
+    };
+    std::shared_ptr<Counters> counters_ = std::make_shared<Counters>();
+  };
+
+  AsyncChunkDataReader data_reader;
+  auto counters = data_reader.counters_;
+  samplers::SequentialSampler sampler(0);
+  datasets::ChunkDataset<
+      AsyncChunkDataReader,
+      samplers::SequentialSampler,
+      samplers::SequentialSampler>
+      dataset(
+          data_reader,
+          sampler,
+          sampler,
+          datasets::ChunkDatasetOptions(1, chunk_size, chunk_count_ * chunk_size)
+              .max_chunks_in_flight(4));
+  dataset.reset();
+
+  std::vector<int> chunks;
+  while (auto batch = dataset.get_batch()) {
+    ASSERT_EQ(batch->size(), chunk_size);
+    chunks.push_back(batch->front());
+  }
+
+  // Reads complete in order, even though several of them are in flight.
+  std::vector<int> expected(chunk_count_);
+  std::iota(expected.begin(), expected.end(), 0);
+  ASSERT_EQ(chunks, expected);
+  ASSERT_GT(counters->peak_reads_in_flight.load(), 1);
+  ASSERT_LE(counters->peak_reads_in_flight.load(), 4);
+
+  auto stats = dataset.stats();
+  ASSERT_EQ(stats.cached_examples, 0);
+  ASSERT_EQ(stats.chunks_in_flight, 0);
+  ASSERT_GT(stats.consumer_stall_time.count(), 0);
+}
@@ -0,0 +1,108 @@
+#include <test/cpp/jit/test_base.h>
+#include <test/cpp/jit/test_utils.h>
+
+#include <torch/csrc/jit/fork_scheduler.h>
+#include <torch/csrc/jit/interpreter.h>
+#include <torch/csrc/jit/irparser.h>
+#include <torch/csrc/jit/passes/fork_independent_branches.h>
+
+#include <limits>
+
+namespace torch {
+namespace jit {
+
+namespace {
+size_t countNodes(const std::shared_ptr<Graph>& graph, NodeKind kind) {
+  size_t count = 0;
+  for (Node* n : graph->nodes()) {
+    count += n->kind() == kind;
+  }
+  return count;
+}
+} // namespace
+
+void testForkIndependentBranches() {
+  {
+    // a chain has no independent branches
+    const auto graph_string = R"IR(
+graph(%x : Tensor):
+  %a : Tensor = aten::relu(%x)
+  %b : Tensor = aten::mm(%a, %a)
+  return (%b))IR";
+    auto graph = std::make_shared<Graph>();
+    script::parseIR(graph_string, graph.get());
+    ForkIndependentBranches(graph);
+    ASSERT_EQ(countNodes(graph, prim::fork), 0);
+  }
+
+  const auto graph_string = R"IR(
+graph(%x : Tensor, %w1 : Tensor, %w2 : Tensor):
+  %one : int = prim::Constant[value=1]()
+  %a1 : Tensor = aten::mm(%x, %w1)
+  %a2 : Tensor = aten::relu(%a1)
+  %b1 : Tensor = aten::mm(%x, %w2)
+  %b2 : Tensor = aten::relu(%b1)
+  %c : Tensor = aten::add(%a2, %b2, %one)
+  return (%c))IR";
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(graph_string, graph.get());
+  ForkIndependentBranches(graph);
+  graph->lint();
+  // the first tower is forked, and the second one runs in the meantime
+  ASSERT_EQ(countNodes(graph, prim::fork), 1);
+  ASSERT_EQ(countNodes(graph, aten::wait), 1);
+  ASSERT_EQ(countNodes(graph, aten::mm), 1);
+  ASSERT_EQ(countNodes(graph, aten::relu), 1);
+  for (Node* n : graph->nodes()) {
+    if (n->kind() == prim::fork) {
+      auto subgraph = n->g(attr::Subgraph);
+      ASSERT_EQ(countNodes(subgraph, aten::mm), 1);
+      ASSERT_EQ(countNodes(subgraph, aten::relu), 1);
+      ASSERT_EQ(n->inputs().size(), 2);
+      ASSERT_TRUE(n->hasAttribute(attr::scheduled));
+    }
+  }
+
+  auto x = at::randn({4, 8});
+  auto w1 = at::randn({8, 8});
+  auto w2 = at::randn({8, 8});
+  auto expected = at::relu(x.mm(w1)) + at::relu(x.mm(w2));
+
+  const auto old_options = getForkSchedulerOptions();
+  ForkSchedulerOptions options;
+  options.min_launch_work_us = 0;
+  options.min_idle_cores = 0;
+  options.max_in_flight = 4;
+  setForkSchedulerOptions(options);
+  resetForkSchedulerStats();
+  Code code(graph);
+  const auto run = [&]() {
+    InterpreterState interp(code);
+    Stack stack{x, w1, w2};
+    interp.run(stack);
+    ASSERT_EQ(stack.size(), 1);
+    ASSERT_TRUE(almostEqual(stack[0].toTensor(), expected));
+  };
+  // launched runs are measured too
+  for (int i = 0; i < 3; ++i) {
+    run();
+  }
+  auto stats = getForkSchedulerStats();
+  ASSERT_EQ(stats.inlined, 0);
+  ASSERT_EQ(stats.launched, 3);
+
+  // once measured, branches that take too little time run inline
+  options.min_launch_work_us = std::numeric_limits<int32_t>::max();
+  setForkSchedulerOptions(options);
+  resetForkSchedulerStats();
+  for (int i = 0; i < 3; ++i) {
+    run();
+  }
+  stats = getForkSchedulerStats();
+  setForkSchedulerOptions(old_options);
+  ASSERT_EQ(stats.inlined, 3);
+  ASSERT_EQ(stats.launched, 0);
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,99 @@
+#include <test/cpp/jit/test_base.h>
+#include <test/cpp/jit/test_utils.h>
+
+#include <torch/csrc/jit/interpreter.h>
+#include <torch/csrc/jit/irparser.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <c10/core/CPUAllocator.h>
+
+namespace torch {
+namespace jit {
+namespace {
+// Counts the allocations of the size of the graph's tensors and of its
+// arena.
+struct CountingCPUAllocator final : at::Allocator {
+  at::DataPtr allocate(size_t nbytes) const override {
+    if (nbytes == 128) {
+      ++tensor_allocations;
+    } else if (nbytes == 2 * 128) {
+      ++arena_allocations;
+    }
+    return c10::GetDefaultCPUAllocator()->allocate(nbytes);
+  }
+  mutable size_t tensor_allocations = 0;
+  mutable size_t arena_allocations = 0;
+};
+} // namespace
+
+void testMemoryPlanning() {
+  const auto graph_string = R"IR(
+graph(%x : Tensor):
+  %one : int = prim::Constant[value=1]()
+  %a : Tensor = aten::mul(%x, %x)
+  %b : Tensor = aten::add(%a, %x, %one)
+  %c : Tensor = aten::mul(%b, %b)
+  %d : Tensor = aten::add(%c, %x, %one)
+  %e : Tensor = aten::mul(%d, %x)
+  return (%e))IR";
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(graph_string, graph.get());
+  // 128 bytes per tensor
+  auto type = TensorType::createContiguous(at::kFloat, at::kCPU, {4, 8});
+  graph->inputs().at(0)->setType(type);
+  for (Node* n : graph->nodes()) {
+    for (Value* v : n->outputs()) {
+      if (v->type()->cast<TensorType>()) {
+        v->setType(type);
+      }
+    }
+  }
+
+  auto plan = PlanMemory(graph);
+  // %e is the graph output and is not planned
+  ASSERT_EQ(plan.buffers.size(), 4);
+  ASSERT_EQ(plan.total_size, 4 * 128);
+  // each intermediate dies at its only use, so two buffers take turns
+  ASSERT_EQ(plan.arena_size, 2 * 128);
+  for (size_t i = 0; i + 1 < plan.buffers.size(); ++i) {
+    ASSERT_EQ(plan.buffers[i].nbytes, 128);
+    ASSERT_NE(plan.buffers[i].offset, plan.buffers[i + 1].offset);
+  }
+
+  auto x = at::randn({4, 8});
+  auto a = x * x;
+  auto c = (a + x) * (a + x);
+  auto expected = (c + x) * x;
+  CountingCPUAllocator allocator;
+  const auto run = [&](Code& code) {
+    Stack stack{x};
+    {
+      c10::ThreadLocalCPUAllocatorGuard guard(&allocator);
+      InterpreterState interp(code);
+      interp.run(stack);
+    }
+    ASSERT_EQ(stack.size(), 1);
+    ASSERT_TRUE(almostEqual(stack[0].toTensor(), expected));
+  };
+
+  // without a plan, every tensor is allocated on every run
+  Code unplanned(graph);
+  run(unplanned);
+  ASSERT_EQ(allocator.tensor_allocations, 5);
+
+  bool old_mode = getMemoryPlanningMode();
+  getMemoryPlanningMode() = true;
+  Code code(graph);
+  getMemoryPlanningMode() = old_mode;
+  // The intermediates go to the arena, which later runs reuse: only the
+  // output, which is not planned, is allocated on its own.
+  for (int i = 0; i < 3; ++i) {
+    allocator.tensor_allocations = 0;
+    allocator.arena_allocations = 0;
+    run(code);
+    ASSERT_EQ(allocator.tensor_allocations, 1);
+    ASSERT_EQ(allocator.arena_allocations, i == 0 ? 1 : 0);
+  }
+}
+} // namespace jit
+} // namespace torch
@@ -42,6 +42,8 @@
 #include "torch/csrc/utils/hash.h"
 #include "torch/csrc/utils/memory.h"
 
+#include "torch/csrc/autograd/continuous_profiler.h"
+#include "torch/csrc/autograd/op_stats.h"
 #include "torch/csrc/autograd/engine.h"
 #include "torch/csrc/autograd/variable.h"
 
@@ -55,14 +57,18 @@
 #include "onnx/onnx_pb.h"
 
 #include <c10/util/Exception.h>
+#include <c10/util/tempfile.h>
 
 #include <algorithm>
 #include <cstddef>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
 #include <utility>
@@ -843,6 +849,105 @@ void testRecordFunction() {
   autograd::profiler::popCallback();
 }
 
+void testContinuousProfiler() {
+  auto t = torch::randn({1, 2, 3}, at::kCPU);
+  auto count = [](const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = 0; (pos = haystack.find(needle, pos)) != std::string::npos;
+         count++, pos++) {
+    }
+    return count;
+  };
+  auto read = [](const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+  };
+
+  auto trace = c10::make_tempfile();
+  autograd::profiler::ContinuousProfilerConfig config(trace.name);
+  config.sampling_rate = 1.0;
+  config.flush_interval_ms = 1;
+  autograd::profiler::enableContinuousProfiler(config);
+  TORCH_CHECK(autograd::profiler::continuousProfilerEnabled());
+  for (auto k = 0; k < 100; k++) {
+    invokeTestRecordFunction(t);
+  }
+  auto stats = autograd::profiler::disableContinuousProfiler();
+  TORCH_CHECK(!autograd::profiler::continuousProfilerEnabled());
+  TORCH_CHECK(stats.dropped == 0);
+  TORCH_CHECK(stats.recorded >= 100);
+  auto json = read(trace.name);
+  TORCH_CHECK(json.front() == '[');
+  TORCH_CHECK(count(json, "\"name\": \"test\"") == 100);
+  TORCH_CHECK(count(json, "\"ph\": \"X\"") == stats.recorded);
+  TORCH_CHECK(autograd::profiler::getSamplingProbability() == 1.0);
+
+  // Events that don't fit into the buffer between two flushes are dropped.
+  auto binary_trace = c10::make_tempfile();
+  config = autograd::profiler::ContinuousProfilerConfig(binary_trace.name);
+  config.format = autograd::profiler::TraceFormat::Binary;
+  config.sampling_rate = 0.5;
+  config.buffer_size = 4;
+  config.flush_interval_ms = 60 * 1000;
+  autograd::profiler::enableContinuousProfiler(config);
+  for (auto k = 0; k < 1000; k++) {
+    invokeTestRecordFunction(t);
+  }
+  stats = autograd::profiler::disableContinuousProfiler();
+  TORCH_CHECK(stats.recorded == 4);
+  TORCH_CHECK(stats.dropped > 0 && stats.recorded + stats.dropped < 2000);
+  auto binary = read(binary_trace.name);
+  TORCH_CHECK(binary.compare(0, 8, "PTTRACE1") == 0);
+  TORCH_CHECK(autograd::profiler::getSamplingProbability() == 1.0);
+}
+
+void testOpStats() {
+  autograd::profiler::LatencyHistogram histogram;
+  for (int64_t value = 1; value <= 1000; value++) {
+    histogram.record(value * 1000);
+  }
+  TORCH_CHECK(histogram.count() == 1000);
+  TORCH_CHECK(histogram.min() == 1000 && histogram.max() == 1000 * 1000);
+  auto p50 = histogram.percentile(50);
+  auto p99 = histogram.percentile(99);
+  // Buckets are at most 1/16th of their values wide.
+  TORCH_CHECK(p50 >= 500 * 1000 && p50 <= 500 * 1000 * 17 / 16);
+  TORCH_CHECK(p99 >= 990 * 1000 && p99 <= histogram.max());
+  TORCH_CHECK(histogram.percentile(100) == histogram.max());
+
+  auto t = torch::randn({1, 2, 3}, at::kCPU);
+  autograd::profiler::enableOpStats();
+  TORCH_CHECK(autograd::profiler::opStatsEnabled());
+  for (auto k = 0; k < 100; k++) {
+    invokeTestRecordFunction(t);
+  }
+  std::thread thread([&t]() {
+    for (auto k = 0; k < 50; k++) {
+      invokeTestRecordFunction(t);
+    }
+  });
+  thread.join();
+  autograd::profiler::disableOpStats();
+  TORCH_CHECK(!autograd::profiler::opStatsEnabled());
+
+  auto stats = autograd::profiler::snapshotOpStats();
+  TORCH_CHECK(stats.count("test") == 1);
+  TORCH_CHECK(stats["test"].calls == 150);
+  TORCH_CHECK(stats["test"].latency.count() == 150);
+  TORCH_CHECK(
+      stats["test"].latency.percentile(50) <=
+      stats["test"].latency.percentile(99));
+  // pow allocates its result.
+  TORCH_CHECK(stats["test"].cpu_bytes_allocated >= 150 * 6 * sizeof(float));
+
+  // The stats of the thread that exited outlive it until they are reset.
+  stats = autograd::profiler::snapshotOpStats(/* reset */ true);
+  TORCH_CHECK(stats["test"].calls == 150);
+  TORCH_CHECK(autograd::profiler::snapshotOpStats().empty());
+}
+
 class TestThreadLocalDebugInfo
   : public at::ThreadLocalDebugInfoBase {
  public:
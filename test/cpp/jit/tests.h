@@ -54,6 +54,8 @@ namespace jit {
   _(InsertBailOuts)                    \
   _(PeepholeOptimize)                  \
   _(RecordFunction)                    \
+  _(ContinuousProfiler)                \
+  _(OpStats)                           \
   _(ThreadLocalDebugInfo)              \
   _(SubgraphMatching)                  \
   _(SubgraphRewriter)                  \
@@ -65,6 +67,8 @@ namespace jit {
   _(ScriptObject)                      \
   _(SaveExtraFilesHook)                \
   _(DCE)                               \
+  _(MemoryPlanning)                    \
+  _(ForkIndependentBranches)           \
   _(CustomFusionNestedBlocks)          \
   _(ClassDerive)                       \
   _(ModuleInterfaceSerialization)      \
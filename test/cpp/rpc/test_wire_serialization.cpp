@@ -50,3 +50,41 @@ TEST(WireSerialize, RecopySparseTensors) {
   EXPECT_TRUE(torch::equal(tiny, deser.second[0]));
   EXPECT_LT(ser.size(), (tiny.element_size() * k1K) + k1K);
 }
+
+TEST(WireSerialize, Scattered) {
+  auto run = [](const std::string& payload,
+                const std::vector<at::Tensor>& tensors) {
+    auto ser = torch::distributed::rpc::wireSerializeScattered(
+        std::vector<char>(payload.begin(), payload.end()), tensors);
+    const std::string& header = ser.first;
+    auto sizes = torch::distributed::rpc::wireBufferSizes(
+        header.data(), header.size());
+    EXPECT_EQ(sizes.size(), ser.second.size());
+    // "receive" the tensor data into fresh buffers
+    std::vector<at::Tensor> buffers;
+    std::vector<const void*> bufferPtrs;
+    size_t dataSize = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      EXPECT_EQ(sizes[i], ser.second[i].numel());
+      dataSize += sizes[i];
+      buffers.push_back(torch::empty({sizes[i]}, torch::kChar));
+      buffers.back().copy_(ser.second[i]);
+      bufferPtrs.push_back(buffers.back().data_ptr());
+    }
+    // the tensor data is not part of the header
+    EXPECT_LT(header.size(), payload.size() + 1024);
+    auto deser = torch::distributed::rpc::wireDeserializeScattered(
+        header.data(), header.size(), std::move(buffers));
+    EXPECT_EQ(payload, std::string(deser.first.begin(), deser.first.end()));
+    EXPECT_EQ(tensors.size(), deser.second.size());
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      EXPECT_TRUE(torch::equal(tensors[i], deser.second[i]));
+      // the tensors take over the buffers they were received into
+      EXPECT_EQ(deser.second[i].storage().data(), bufferPtrs[i]);
+    }
+  };
+  run("", {});
+  run("hi", {});
+  run("", {torch::randn({5, 5})});
+  run("more", {torch::randn({64, 64}), torch::rand({10, 10})});
+}
@@ -1372,6 +1372,36 @@ class RpcTest(RpcAgentTestFixture):
         _wait_all_workers()
         rpc.shutdown()
 
+    @dist_init(setup_rpc=False)
+    @requires_process_group_agent("PROCESS_GROUP rpc backend specific test, skip")
+    def test_shared_memory(self):
+        # All test workers run on the same host, so every message to a peer
+        # goes through shared memory.
+        rpc_backend_options = self.rpc_backend_options
+        rpc_backend_options.use_shared_memory = True
+        rpc.init_rpc(
+            name="worker%d" % self.rank,
+            backend=self.rpc_backend,
+            rank=self.rank,
+            world_size=self.world_size,
+            rpc_backend_options=rpc_backend_options,
+        )
+        dst_rank = (self.rank + 1) % self.world_size
+        # small tensors are copied through the ring buffer, large ones
+        # through shared memory segments of their own
+        for n in [1, 10, 1000]:
+            futs = [
+                rpc.rpc_async(
+                    "worker{}".format(dst_rank),
+                    torch.add,
+                    args=(torch.ones(n, n), torch.ones(n, n) * i),
+                )
+                for i in range(10)
+            ]
+            for i, fut in enumerate(futs):
+                self.assertEqual(fut.wait(), torch.ones(n, n) * (i + 1))
+        rpc.shutdown()
+
     @dist_init(setup_rpc=False)
     def test_get_rpc_timeout(self):
         timeout = timedelta(seconds=1)
@@ -254,6 +254,19 @@ class StoreTestBase(object):
     def test_set_get(self):
         self._test_set_get(self._create_store())
 
+    def _test_multi_set_get(self, fs):
+        fs.multi_set(["mkey0", "mkey1", "mkey2"], ["value0", "value1", "value2"])
+        fs.set("mkey3", "value3")
+        self.assertEqual(
+            [b"value3", b"value0", b"value2"],
+            fs.multi_get(["mkey3", "mkey0", "mkey2"]))
+        self.assertEqual([], fs.multi_get([]))
+        with self.assertRaisesRegex(ValueError, "as many values as keys"):
+            fs.multi_set(["mkey4", "mkey5"], ["value4"])
+
+    def test_multi_set_get(self):
+        self._test_multi_set_get(self._create_store())
+
 
 class FileStoreTest(TestCase, StoreTestBase):
     def setUp(self):
@@ -775,9 +788,9 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
             opts = c10d.AllreduceOptions()
             pg.allreduce([t1, t3], opts)
 
-    def _test_allreduce_basics(self, fn):
+    def _test_allreduce_basics(self, fn, opts=None):
         store = c10d.FileStore(self.file_name, self.world_size)
-        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts or self.opts())
 
         # Single input tests
         tests = simple_reduce_tests(self.rank, self.world_size)
@@ -814,9 +827,9 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
     def test_allreduce_basics_cuda(self):
         self._test_allreduce_basics(lambda t: t.clone().cuda())
 
-    def _test_allreduce_stress(self, inputs):
+    def _test_allreduce_stress(self, inputs, opts=None):
         store = c10d.FileStore(self.file_name, self.world_size)
-        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts(threads=8))
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts or self.opts(threads=8))
         work_handles = [pg.allreduce(inputs[i]) for i in range(len(inputs))]
         for i, work_handle in enumerate(work_handles):
             work_handle.wait()
@@ -839,6 +852,48 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
         inputs = [torch.tensor([i + self.rank]).cuda() for i in range(1000)]
         self._test_allreduce_stress(inputs)
 
+    def hierarchical_opts(self, host_id=None, threads=2):
+        opts = self.opts(threads=threads)
+        opts.hierarchicalAllreduce = True
+        # Small chunks, so that all but the smallest tensors are pipelined
+        opts.hierarchicalChunkBytes = 64
+        if host_id is not None:
+            opts.hostId = host_id
+        return opts
+
+    def two_hosts_id(self):
+        # Pretend that pairs of processes run on separate hosts
+        return "host%d" % (self.rank // 2)
+
+    def test_allreduce_basics_hierarchical(self):
+        self._test_allreduce_basics(lambda t: t.clone(), self.hierarchical_opts())
+
+    def test_allreduce_basics_hierarchical_two_hosts(self):
+        self._test_allreduce_basics(
+            lambda t: t.clone(), self.hierarchical_opts(self.two_hosts_id()))
+
+    def test_allreduce_stress_hierarchical_two_hosts(self):
+        inputs = [torch.tensor([i + self.rank]) for i in range(1000)]
+        self._test_allreduce_stress(
+            inputs, self.hierarchical_opts(self.two_hosts_id(), threads=8))
+
+    def test_allreduce_chunked_hierarchical_two_hosts(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(
+            store, self.rank, self.world_size, self.hierarchical_opts(self.two_hosts_id()))
+        rank_sum = self.world_size * (self.world_size - 1) // 2
+        for dtype in [torch.float, torch.double, torch.int32, torch.int64, torch.uint8]:
+            for numel in [0, 1, 15, 16, 17, 1000]:
+                tensor = torch.arange(numel).to(dtype) + self.rank
+                pg.allreduce(tensor).wait()
+                expected = torch.arange(numel).to(dtype) * self.world_size + rank_sum
+                self.assertEqual(expected, tensor)
+
+        # Non contiguous input
+        tensor = torch.arange(2000.0).view(1000, 2)[:, 0] + self.rank
+        pg.allreduce(tensor).wait()
+        self.assertEqual(torch.arange(2000.0).view(1000, 2)[:, 0] * self.world_size + rank_sum, tensor)
+
     def test_allreduce_coalesced_checks(self):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
@@ -2060,6 +2115,99 @@ class DistributedDataParallelTest(MultiProcessTestCase):
         devices = list([torch.device('cuda:' + str(i)) for i in int_devices])
         self._test_gloo_backend(devices, [], multi_device=True)
 
+    def _create_ddp_with_comm_hook(self, model, hook, options):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg_options = c10d.ProcessGroupGloo.Options()
+        pg_options.devices = [c10d.ProcessGroupGloo.create_device(interface=LOOPBACK)]
+        process_group = c10d.ProcessGroupGloo(store, self.rank, self.world_size, pg_options)
+        ddp_model = DistributedDataParallel(
+            copy.deepcopy(model),
+            process_group=process_group,
+            bucket_cap_mb=0.001)
+        ddp_model.register_comm_hook(hook, **options)
+        return ddp_model
+
+    def _test_ddp_comm_hook(self, model, hook, options, input, target, prec=None):
+        """
+        Trains ``model`` with DDP and the comm hook ``hook``, and checks that
+        it ends up with the same parameters as training it on the full batch.
+        """
+        ddp_model = self._create_ddp_with_comm_hook(model, hook, options)
+
+        local_batch_size = input.size(0) // self.world_size
+        local_input = input[self.rank * local_batch_size: (self.rank + 1) * local_batch_size]
+        local_target = target[self.rank * local_batch_size: (self.rank + 1) * local_batch_size]
+        for _ in range(2):
+            for m, x, y in ((model, input, target), (ddp_model, local_input, local_target)):
+                F.mse_loss(m(x), y).backward()
+                for param in m.parameters():
+                    param.data -= param.grad
+                    param.grad = None
+            for i, j in zip(model.parameters(), ddp_model.parameters()):
+                self.assertEqual(i, j, prec=prec)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_fp16_gloo(self):
+        input = torch.randn(2 * self.world_size, 2)
+        target = torch.randn(2 * self.world_size, 4)
+        self._test_ddp_comm_hook(Net(), "fp16", {}, input, target, prec=1e-2)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_topk_gloo(self):
+        # Nothing is left out when keeping all entries.
+        input = torch.randn(2 * self.world_size, 2)
+        target = torch.randn(2 * self.world_size, 4)
+        self._test_ddp_comm_hook(Net(), "topk", {"ratio": 1.0}, input, target)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_powersgd_gloo(self):
+        # With a single sample per process, the gradient of a linear layer is
+        # the average of rank 1 matrices, which rank 2 captures exactly.
+        self.assertEqual(self.world_size, 2)
+        model = nn.Linear(64, 64, bias=False)
+        input = torch.randn(self.world_size, 64)
+        target = torch.randn(self.world_size, 64)
+        self._test_ddp_comm_hook(model, "powersgd", {"rank": 2}, input, target, prec=1e-4)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_powersgd_error_feedback_gloo(self):
+        # Rank 1 leaves part of the gradients out, which the residuals carry
+        # over to the next iterations. Checks against PowerSGD with error
+        # feedback applied by hand to the gradients of every process.
+        torch.manual_seed(0)
+        model = nn.Linear(16, 16, bias=False)
+        local_batch_size = 8
+        input = torch.randn(local_batch_size * self.world_size, 16)
+        target = torch.randn(local_batch_size * self.world_size, 16)
+        ddp_model = self._create_ddp_with_comm_hook(model, "powersgd", {"rank": 1})
+
+        def local_batch(rank):
+            return (input[rank * local_batch_size: (rank + 1) * local_batch_size],
+                    target[rank * local_batch_size: (rank + 1) * local_batch_size])
+
+        # The hook seeds the first Q with the bucket index.
+        q = torch.randn(16, 1, generator=torch.Generator().manual_seed(0))
+        residuals = [torch.zeros(16, 16) for _ in range(self.world_size)]
+        for _ in range(3):
+            corrected = []
+            for rank in range(self.world_size):
+                x, y = local_batch(rank)
+                F.mse_loss(model(x), y).backward()
+                corrected.append(model.weight.grad / self.world_size + residuals[rank])
+                model.weight.grad = None
+            p = torch.qr(sum(m.mm(q) for m in corrected))[0]
+            q = sum(m.t().mm(p) for m in corrected)
+            approximation = p.mm(q.t())
+            residuals = [m - approximation / self.world_size for m in corrected]
+            model.weight.data -= approximation
+
+            x, y = local_batch(self.rank)
+            F.mse_loss(ddp_model(x), y).backward()
+            for param in ddp_model.parameters():
+                param.data -= param.grad
+                param.grad = None
+            self.assertEqual(model.weight, ddp_model.module.weight, prec=1e-4)
+
     def _test_nccl_backend(self, devices, device_ids, multi_device=False):
         store = c10d.FileStore(self.file_name, self.world_size)
         process_group = c10d.ProcessGroupNCCL(store, self.rank, self.world_size)
@@ -3120,6 +3268,72 @@ class ReducerTest(TestCase):
             output.backward()
             optimizer.step()
 
+    def test_rebuild_buckets(self):
+        batch_size = 10
+        model = self._create_mixed_precision_model()
+        reference = copy.deepcopy(model)
+        parameters = list(model.parameters())
+        # One bucket per parameter in the order they are defined, the reverse
+        # of the order in which their gradients become ready.
+        reducer = dist.Reducer(
+            [parameters],
+            [[0], [1], [2]],
+            self.process_group,
+            bucket_bytes_cap=1)
+        loss = nn.CrossEntropyLoss()
+        sizes = [p.numel() * p.element_size() for p in parameters]
+        for i in range(2):
+            input = torch.rand([batch_size, 2], dtype=torch.double)
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            output = loss(model(input), target)
+            reducer.prepare_for_backward(output)
+            output.backward()
+            loss(reference(input), target).backward()
+
+            stats = reducer.get_overlap_stats()
+            self.assertEqual(len(stats.bucket_ready_times), 3)
+            self.assertGreaterEqual(stats.exposed_communication_time, 0)
+            if i == 0:
+                self.assertFalse(stats.rebuilt_buckets)
+                self.assertEqual(stats.bucket_sizes, sizes)
+            else:
+                self.assertTrue(stats.rebuilt_buckets)
+                self.assertEqual(stats.bucket_bytes_cap, 1)
+                self.assertEqual(stats.bucket_sizes, list(reversed(sizes)))
+
+        for parameter, expected in zip(model.parameters(), reference.parameters()):
+            self.assertEqual(parameter.grad, expected.grad)
+
+    def test_forward_backward_comm_hooks(self):
+        batch_size = 10
+        hooks = [
+            ("fp16", {}, 1e-2),
+            ("topk", {"ratio": 1.0}, None),
+            ("powersgd", {}, None),
+        ]
+        for name, options, prec in hooks:
+            model = self._create_mixed_precision_model()
+            reference = copy.deepcopy(model)
+            reducer = self._create_reducer_for_models([model])
+            reducer.register_comm_hook(dist._create_comm_hook(name, options))
+            loss = nn.CrossEntropyLoss()
+            input = torch.rand([batch_size, 2], dtype=torch.double)
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            output = loss(model(input), target)
+            reducer.prepare_for_backward(output)
+            output.backward()
+            loss(reference(input), target).backward()
+            for parameter, expected in zip(model.parameters(), reference.parameters()):
+                self.assertEqual(parameter.grad, expected.grad, prec=prec)
+
+    def test_create_comm_hook_errors(self):
+        with self.assertRaisesRegex(RuntimeError, "Unknown comm hook"):
+            dist._create_comm_hook("unknown")
+        with self.assertRaisesRegex(RuntimeError, "Unknown option"):
+            dist._create_comm_hook("topk", {"rank": 2})
+        with self.assertRaisesRegex(RuntimeError, "ratio"):
+            dist._create_comm_hook("topk", {"ratio": 0})
+
 
 class ComputeBucketAssignmentTest(TestCase):
     def test_single_limit_single_dtype(self):
@@ -3627,6 +3627,67 @@ graph(%Ra, %Rb):
         out = torch.jit.trace(fn, (torch.ones(2, 2),))
         check(out)
 
+    def test_save_tensor_alignment(self):
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.weight = nn.Parameter(torch.randn(3, 5))
+                self.bias = nn.Parameter(torch.randn(7))
+
+            @torch.jit.script_method
+            def forward(self, x):
+                return x.mm(self.weight)
+
+        m = M()
+        buffer = io.BytesIO()
+        torch.jit.save(m, buffer, _tensor_alignment=4096)
+
+        buffer.seek(0)
+        reader = torch._C.PyTorchFileReader(buffer)
+        tensor_records = [r for r in reader.get_all_records() if r.startswith('archive/data/')]
+        self.assertEqual(len(tensor_records), 2)
+        for record in tensor_records:
+            offset, size = reader.get_record_location(record[len('archive/'):])
+            self.assertEqual(offset % 4096, 0)
+
+        # still a plain zip file, loadable as usual
+        buffer.seek(0)
+        self.assertIsNone(zipfile.ZipFile(buffer).testzip())
+        buffer.seek(0)
+        loaded = torch.jit.load(buffer)
+        self.assertEqual(m.weight, loaded.weight)
+        self.assertEqual(m.bias, loaded.bias)
+
+        with self.assertRaisesRegex(RuntimeError, "power of two"):
+            torch.jit.save(m, io.BytesIO(), _tensor_alignment=100)
+
+    @unittest.skipIf(IS_WINDOWS, "mmap loading is not supported on windows")
+    def test_load_mmap(self):
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.weight = nn.Parameter(torch.randn(64, 64))
+
+            @torch.jit.script_method
+            def forward(self, x):
+                return x.mm(self.weight)
+
+        m = M()
+        with TemporaryFileName() as fname:
+            m.save(fname)
+            loaded = torch.jit.load(fname, mmap=True)
+            input = torch.randn(2, 64)
+            self.assertEqual(m(input), loaded(input))
+
+            # writes stay private to the process
+            with torch.no_grad():
+                loaded.weight.zero_()
+            reloaded = torch.jit.load(fname, mmap=True)
+            self.assertEqual(m.weight, reloaded.weight)
+
+        with self.assertRaisesRegex(ValueError, "file name"):
+            torch.jit.load(io.BytesIO(), mmap=True)
+
     @unittest.skipIf(IS_WINDOWS or True, "TODO: need to fix this test case for "
                                          "Windows, re-enable with https://github.com/pytorch/pytorch/pull/29339")
     def test_torch_load_error(self):
@@ -11672,6 +11733,32 @@ a")
             self.assertEqual(torch.autograd.grad(slstm(*inputs).sum(), inputs),
                              torch.autograd.grad(lstm(*inputs).sum(), inputs))
 
+    def test_interpreter_superinstructions(self):
+        src = dedent('''
+        def fn(x, n):
+            # type: (Tensor, int) -> Tuple[Tensor, Tensor, Tensor, int]
+            acc = 0
+            for i in range(n):
+                if i % 3 == 0:
+                    acc = acc + i * 2
+                elif i > 5 and i != 8:
+                    acc = acc - 1
+                x = x + acc
+            a, b = x.max(0)
+            return x * acc, a, b, acc
+        ''')
+
+        def run(enabled):
+            old = torch._C._jit_set_interpreter_superinstructions(enabled)
+            try:
+                fn = torch.jit.CompilationUnit(src).fn
+                x = torch.arange(4.)
+                return [fn(x, n) for n in range(12)]
+            finally:
+                torch._C._jit_set_interpreter_superinstructions(old)
+
+        self.assertEqual(run(True), run(False))
+
     def test_loop_unrolling(self):
         def fn(x):
             y = 0
@@ -3,13 +3,18 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
 import unittest
 import torch
 import torch.nn as nn
 import torch.nn.functional as F
 from torch.testing import FileCheck
 
-from common_utils import run_tests, IS_SANDCASTLE, ProfilingMode, GRAPH_EXECUTOR, \
+from common_utils import run_tests, IS_SANDCASTLE, IS_WINDOWS, ProfilingMode, GRAPH_EXECUTOR, \
     enable_profiling_mode
 from textwrap import dedent
 from itertools import product, permutations
@@ -78,6 +83,39 @@ class TestFuser(JitTestCase):
     def test_abs_cpu(self):
         self._test_fused_abs()
 
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    @unittest.skipIf(IS_WINDOWS, "fused kernels are not cached on Windows")
+    def test_kernel_cache_cpu(self):
+        # The cache directory is read once per process, so each run is a
+        # fresh interpreter. Large enough to be split across threads.
+        script = dedent('''
+            import torch
+            torch._C._jit_override_can_fuse_on_cpu(True)
+
+            @torch.jit.script
+            def f(x, y):
+                return (x * y + x).sigmoid()
+
+            x = torch.randn(100000)
+            y = torch.randn(100000)
+            for _ in range(3):
+                out = f(x, y)
+            assert torch.allclose(out, (x * y + x).sigmoid())
+        ''')
+        cache_dir = tempfile.mkdtemp()
+        try:
+            env = os.environ.copy()
+            env['PYTORCH_FUSION_CACHE_DIR'] = cache_dir
+            subprocess.check_call([sys.executable, '-c', script], env=env)
+            cached = sorted(os.listdir(cache_dir))
+            self.assertTrue(any(f.endswith('.so') for f in cached))
+            self.assertTrue(any(f.endswith('.cpp') for f in cached))
+            # the second process loads the kernels instead of compiling them
+            subprocess.check_call([sys.executable, '-c', script], env=env)
+            self.assertEqual(sorted(os.listdir(cache_dir)), cached)
+        finally:
+            shutil.rmtree(cache_dir)
+
     @unittest.skipIf(not RUN_CUDA, "requires CUDA")
     def test_abs_cuda(self):
         self._test_fused_abs(device="cuda")
@@ -1944,6 +1944,38 @@ class _TestTorchMixin(object):
         self.assertIsOrdered('descending', x, res2val, res2ind,
                              'random with NaNs')
 
+    def test_sort_large(self):
+        # long enough to be sorted with all threads on CPU; the small values
+        # give many duplicates, which have to keep their order
+        for dtype in [torch.uint8, torch.int16, torch.int32, torch.int64, torch.float, torch.double]:
+            x = torch.randint(0, 100, (1 << 17,)).to(dtype)
+            if dtype.is_floating_point:
+                x = (x - 50) / 7
+                x[::1000] = float('nan')
+                x[1::1000] = -0.0
+            for descending in [False, True]:
+                values, indices = torch.sort(x, descending=descending)
+                self.assertEqual(x[indices], values, 0)
+                self.assertEqual(torch.bincount(indices), torch.ones(x.numel(), dtype=torch.long))
+                finite = values[~torch.isnan(values)] if dtype.is_floating_point else values
+                if descending:
+                    self.assertTrue((finite[:-1] >= finite[1:]).all())
+                else:
+                    self.assertTrue((finite[:-1] <= finite[1:]).all())
+                ties = values[:-1] == values[1:]
+                self.assertTrue((indices[:-1][ties] < indices[1:][ties]).all())
+
+            # a few long rows along a non-contiguous dim
+            rows = x.view(4, -1).t()
+            values, indices = torch.sort(rows, dim=0)
+            for i in range(4):
+                self.assertEqual(values[:, i], torch.sort(rows[:, i])[0], 0)
+                self.assertEqual(indices[:, i], torch.sort(rows[:, i])[1], 0)
+
+            values, indices = x.topk(10)
+            self.assertEqual(values, torch.sort(x, descending=True)[0][:10], 0)
+            self.assertEqual(x[indices], values, 0)
+
     def test_topk(self):
         def topKViaSort(t, k, dim, dir):
             sorted, indices = t.sort(dim, dir)
@@ -12653,6 +12685,30 @@ class TestTorchDeviceType(TestCase):
                                     count += 1
                             self.assertEqual(j, count)
 
+    @dtypes(torch.long, torch.float)
+    def test_unique_large(self, device, dtype):
+        # large enough to be grouped in parallel on CPU
+        x = torch.randint(-1000, 1000, (1 << 18,), device=device).to(dtype)
+        x[0] = 0
+        x[1] = -0.0 if dtype.is_floating_point else 0
+        expected_unique = torch.tensor(sorted(set(x.tolist())), dtype=dtype, device=device)
+        output, inverse, counts = torch.unique(x, sorted=True, return_inverse=True, return_counts=True)
+        self.assertEqual(expected_unique, output)
+        self.assertEqual(x, output[inverse])
+        self.assertEqual(torch.bincount(inverse, minlength=output.numel()), counts)
+
+        output, inverse, counts = torch.unique(x, sorted=False, return_inverse=True, return_counts=True)
+        self.assertEqual(expected_unique, output.sort()[0])
+        self.assertEqual(x, output[inverse])
+        self.assertEqual(torch.bincount(inverse, minlength=output.numel()), counts)
+
+        rows = x.view(-1, 4).remainder(3)
+        output, inverse, counts = torch.unique(rows, dim=0, return_inverse=True, return_counts=True)
+        self.assertEqual(rows, output[inverse])
+        self.assertEqual(torch.bincount(inverse, minlength=output.size(0)), counts)
+        self.assertEqual(set(map(tuple, rows.tolist())), set(map(tuple, output.tolist())))
+        self.assertEqual(sorted(output.tolist()), output.tolist())
+
     @dtypes(*set(torch.testing.get_all_dtypes()) - {torch.bfloat16})
     def test_unique_consecutive(self, device, dtype):
         if dtype is torch.half and self.device_type == 'cpu':
@@ -35,6 +35,8 @@ libtorch_sources = [
     "torch/csrc/autograd/VariableTypeManual.cpp",
     "torch/csrc/autograd/anomaly_mode.cpp",
     "torch/csrc/autograd/autograd.cpp",
+    "torch/csrc/autograd/continuous_profiler.cpp",
+    "torch/csrc/autograd/op_stats.cpp",
     "torch/csrc/autograd/custom_function.cpp",
     "torch/csrc/autograd/cpp_hook.cpp",
     "torch/csrc/autograd/engine.cpp",
@@ -48,6 +50,7 @@ libtorch_sources = [
     "torch/csrc/autograd/profiler.cpp",
     "torch/csrc/autograd/record_function.cpp",
     "torch/csrc/autograd/record_function_ops.cpp",
+    "torch/csrc/autograd/activation_offload.cpp",
     "torch/csrc/autograd/saved_variable.cpp",
     "torch/csrc/autograd/variable.cpp",
     "torch/csrc/distributed/autograd/utils.cpp",
@@ -85,6 +88,7 @@ libtorch_sources = [
     "torch/csrc/jit/pass_manager.cpp",
     "torch/csrc/jit/pickler.cpp",
     "torch/csrc/jit/unpickler.cpp",
+    "torch/csrc/jit/fork_scheduler.cpp",
     "torch/csrc/jit/graph_executor.cpp",
     "torch/csrc/jit/import.cpp",
     "torch/csrc/jit/import_legacy.cpp",
@@ -96,6 +100,7 @@ libtorch_sources = [
     "torch/csrc/jit/irparser.cpp",
     "torch/csrc/jit/jit_log.cpp",
     "torch/csrc/jit/netdef_converter.cpp",
+    "torch/csrc/jit/planned_allocator.cpp",
     "torch/csrc/jit/register_c10_ops.cpp",
     "torch/csrc/jit/subgraph_matcher.cpp",
     "torch/csrc/jit/symbolic_script.cpp",
@@ -116,6 +121,7 @@ libtorch_sources = [
     "torch/csrc/jit/passes/dead_code_elimination.cpp",
     "torch/csrc/jit/passes/erase_number_types.cpp",
     "torch/csrc/jit/passes/fixup_trace_scope_blocks.cpp",
+    "torch/csrc/jit/passes/fork_independent_branches.cpp",
     "torch/csrc/jit/passes/graph_fuser.cpp",
     "torch/csrc/jit/passes/guard_elimination.cpp",
     "torch/csrc/jit/passes/inline_autodiff_subgraphs.cpp",
@@ -126,6 +132,7 @@ libtorch_sources = [
     "torch/csrc/jit/passes/insert_guards.cpp",
     "torch/csrc/jit/passes/liveness.cpp",
     "torch/csrc/jit/passes/loop_unrolling.cpp",
+    "torch/csrc/jit/passes/memory_planning.cpp",
     "torch/csrc/jit/passes/lower_grad_of.cpp",
     "torch/csrc/jit/passes/lower_graph.cpp",
     "torch/csrc/jit/passes/lower_tuples.cpp",
@@ -297,6 +304,7 @@ def add_torch_libs():
         "torch/csrc/autograd/python_variable_indexing.cpp",
         "torch/csrc/distributed/autograd/init.cpp",
         "torch/csrc/distributed/c10d/comm.cpp",
+        "torch/csrc/distributed/c10d/comm_hooks.cpp",
         "torch/csrc/distributed/c10d/init.cpp",
         "torch/csrc/distributed/c10d/reducer.cpp",
         "torch/csrc/distributed/rpc/init.cpp",
@@ -307,6 +315,7 @@ def add_torch_libs():
         "torch/csrc/distributed/rpc/request_callback_impl.cpp",
         "torch/csrc/distributed/rpc/rref.cpp",
         "torch/csrc/distributed/rpc/rref_context.cpp",
+        "torch/csrc/distributed/rpc/shared_memory_channel.cpp",
         "torch/csrc/jit/init.cpp",
         "torch/csrc/jit/passes/inline_fork_wait.cpp",
         "torch/csrc/jit/passes/onnx.cpp",
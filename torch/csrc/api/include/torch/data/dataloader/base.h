@@ -37,6 +37,7 @@ class DataLoaderBase {
       std::unique_ptr<Dataset> main_thread_dataset = nullptr)
       : options_(std::move(options)),
         main_thread_dataset_(std::move(main_thread_dataset)),
+        shuttle_(options_.max_jobs + options_.workers),
         sequencer_(new_sequencer()) {}
 
   virtual ~DataLoaderBase() {
@@ -233,7 +234,8 @@ class DataLoaderBase {
   /// The worker threads, running the `worker_thread()` method.
   std::vector<std::thread> workers_;
 
-  /// The `DataShuttle` which takes care of the life cycle of a job.
+  /// The `DataShuttle` which takes care of the life cycle of a job. Its
+  /// queues hold all jobs in flight, plus one 'quit' message per worker.
   detail::DataShuttle<Job, Result> shuttle_;
 
   /// The `Sequencer`, which handles optional ordering of batches.
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <torch/data/datasets/base.h>
+#include <torch/data/datasets/buffered.h>
+#include <torch/data/datasets/cached.h>
 #include <torch/data/datasets/chunk.h>
 #include <torch/data/datasets/map.h>
 #include <torch/data/datasets/mnist.h>
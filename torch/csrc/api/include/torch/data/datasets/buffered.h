@@ -0,0 +1,193 @@
+#pragma once
+
+#include <torch/arg.h>
+#include <torch/data/datasets/base.h>
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <c10/util/ArrayRef.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace datasets {
+
+/// Options to configure the batches of a `BufferedDataset`.
+struct BatchBufferOptions {
+  BatchBufferOptions(
+      std::vector<int64_t> data_shape,
+      std::vector<int64_t> target_shape = {})
+      : data_shape_(std::move(data_shape)),
+        target_shape_(std::move(target_shape)) {}
+
+  /// The shape of the data of a single example.
+  TORCH_ARG(std::vector<int64_t>, data_shape);
+
+  /// The shape of the target of a single example. Scalar by default.
+  TORCH_ARG(std::vector<int64_t>, target_shape);
+
+  /// The options (dtype, device) of the data tensor of a batch.
+  TORCH_ARG(TensorOptions, data_options) = kFloat;
+
+  /// The options (dtype, device) of the target tensor of a batch.
+  TORCH_ARG(TensorOptions, target_options) = kLong;
+
+  /// The number of batches that are recycled. A batch is only written to
+  /// again once the consumer dropped all references to it. If all of them are
+  /// still in use, a fresh batch is allocated instead. Keep this above the
+  /// number of batches a single worker can have in flight.
+  TORCH_ARG(size_t, buffers) = 4;
+
+  /// Whether to allocate batches in page-locked memory, so that they can be
+  /// copied to a CUDA device asynchronously. Requires CUDA. Such a copy must
+  /// have completed before the batch is dropped, since it may be reused right
+  /// away.
+  TORCH_ARG(bool, pin_memory) = false;
+};
+
+namespace detail {
+/// A ring of preallocated batches, handed out once their previous user is
+/// done with them.
+///
+/// Copying a `BatchBufferPool` only copies its options. This way every worker
+/// of a `DataLoader`, which gets its own copy of the dataset, has its own
+/// batches and the pool needs no synchronization.
+class BatchBufferPool {
+ public:
+  explicit BatchBufferPool(BatchBufferOptions options)
+      : options_(std::move(options)) {}
+
+  BatchBufferPool(const BatchBufferPool& other) : options_(other.options_) {}
+
+  BatchBufferPool& operator=(const BatchBufferPool& other) {
+    options_ = other.options_;
+    buffers_.clear();
+    next_ = 0;
+    return *this;
+  }
+
+  BatchBufferPool(BatchBufferPool&&) = default;
+  BatchBufferPool& operator=(BatchBufferPool&&) = default;
+
+  /// Returns a batch of `batch_size` examples whose data and target are not
+  /// referenced by anyone else. Their contents are unspecified.
+  Example<> acquire(size_t batch_size) {
+    if (buffers_.size() < options_.buffers()) {
+      buffers_.push_back(allocate(batch_size));
+      return slice(buffers_.back(), batch_size);
+    }
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      auto& buffer = buffers_[(next_ + i) % buffers_.size()];
+      if (is_free(buffer)) {
+        next_ = (next_ + i + 1) % buffers_.size();
+        if (static_cast<int64_t>(batch_size) > buffer.data.size(0)) {
+          buffer = allocate(batch_size);
+        }
+        return slice(buffer, batch_size);
+      }
+    }
+    // The consumer holds on to all of our batches.
+    return allocate(batch_size);
+  }
+
+  const BatchBufferOptions& options() const noexcept {
+    return options_;
+  }
+
+ private:
+  Example<> allocate(size_t batch_size) const {
+    return {
+        allocate(batch_size, options_.data_shape(), options_.data_options()),
+        allocate(
+            batch_size, options_.target_shape(), options_.target_options())};
+  }
+
+  Tensor allocate(
+      size_t batch_size,
+      const std::vector<int64_t>& example_shape,
+      const TensorOptions& tensor_options) const {
+    std::vector<int64_t> shape = {static_cast<int64_t>(batch_size)};
+    shape.insert(shape.end(), example_shape.begin(), example_shape.end());
+    auto tensor = torch::empty(shape, tensor_options);
+    return options_.pin_memory() ? tensor.pin_memory() : tensor;
+  }
+
+  /// A batch is free once only the pool references it, either directly or
+  /// through a view (such as the ones returned by `slice()`), which keeps the
+  /// storage alive.
+  static bool is_free(const Example<>& buffer) {
+    return is_free(buffer.data) && is_free(buffer.target);
+  }
+
+  static bool is_free(const Tensor& tensor) {
+    return tensor.use_count() == 1 && tensor.storage().use_count() == 1;
+  }
+
+  static Example<> slice(const Example<>& buffer, size_t batch_size) {
+    if (static_cast<int64_t>(batch_size) == buffer.data.size(0)) {
+      return buffer;
+    }
+    return {buffer.data.narrow(0, 0, batch_size),
+            buffer.target.narrow(0, 0, batch_size)};
+  }
+
+  BatchBufferOptions options_;
+  std::vector<Example<>> buffers_;
+  size_t next_ = 0;
+};
+} // namespace detail
+
+/// A dataset that writes each example straight into its row of a batch,
+/// instead of returning a tensor per example that `transforms::Stack` then
+/// copies into the batch.
+///
+/// Batches are taken from a small ring of preallocated tensors, and recycled
+/// once the consumer drops them, so that loading a batch allocates nothing.
+/// In exchange, each example must have the fixed shape and options given in
+/// the `BatchBufferOptions`.
+///
+/// \rst
+/// .. code-block:: cpp
+///   struct Squares : datasets::BufferedDataset<Squares> {
+///     Squares() : BufferedDataset(datasets::BatchBufferOptions({1})) {}
+///     void get_into(size_t index, Tensor data, Tensor target) override {
+///       data.fill_(static_cast<double>(index * index));
+///       target.fill_(static_cast<int64_t>(index));
+///     }
+///     optional<size_t> size() const override { return 100; }
+///   };
+/// \endrst
+template <typename Self>
+class BufferedDataset : public BatchDataset<Self, Example<>> {
+ public:
+  explicit BufferedDataset(BatchBufferOptions options)
+      : pool_(std::move(options)) {}
+
+  /// Writes the example at the given index into `data` and `target`, which
+  /// are rows of the batch with the shapes given in the options.
+  virtual void get_into(size_t index, Tensor data, Tensor target) = 0;
+
+  /// Returns a batch, calling `get_into()` for every requested index.
+  Example<> get_batch(ArrayRef<size_t> indices) override {
+    auto batch = pool_.acquire(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+      get_into(indices[i], batch.data[i], batch.target[i]);
+    }
+    return batch;
+  }
+
+  /// Returns the options the batches are allocated with.
+  const BatchBufferOptions& buffer_options() const noexcept {
+    return pool_.options();
+  }
+
+ private:
+  detail::BatchBufferPool pool_;
+};
+} // namespace datasets
+} // namespace data
+} // namespace torch
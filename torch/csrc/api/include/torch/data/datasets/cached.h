@@ -0,0 +1,246 @@
+#pragma once
+
+#include <torch/arg.h>
+#include <torch/data/datasets/base.h>
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <c10/util/Exception.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace datasets {
+
+/// Options to configure a `CachedDataset`.
+struct CacheOptions {
+  /* implicit */ CacheOptions(size_t memory_budget)
+      : memory_budget_(memory_budget) {}
+
+  /// The number of bytes of examples to keep in memory.
+  TORCH_ARG(size_t, memory_budget);
+
+  /// A file to spill examples to once the memory budget is used up. The file
+  /// is created (or overwritten) with a size of `spill_budget` bytes, and
+  /// mapped into memory. Spilling is disabled if empty.
+  TORCH_ARG(std::string, spill_file);
+
+  /// The number of bytes of examples to spill to `spill_file`.
+  TORCH_ARG(size_t, spill_budget) = 0;
+};
+
+/// Counters describing how well a `CachedDataset` works.
+struct CacheStats {
+  /// The number of examples served from the cache.
+  size_t hits = 0;
+
+  /// The number of examples read from the source dataset.
+  size_t misses = 0;
+
+  /// The number of bytes of examples kept in memory.
+  size_t memory_bytes = 0;
+
+  /// The number of bytes of examples spilled to the spill file.
+  size_t spilled_bytes = 0;
+};
+
+namespace detail {
+/// Converts the examples a `CachedDataset` supports to and from the tensors
+/// they consist of.
+template <typename ExampleType>
+struct CachedExample {
+  static_assert(
+      !std::is_same<ExampleType, ExampleType>::value,
+      "CachedDataset only supports datasets of Example<Tensor, Tensor> or "
+      "TensorExample");
+};
+
+template <>
+struct CachedExample<Example<>> {
+  static std::vector<Tensor> to_tensors(const Example<>& example) {
+    return {example.data, example.target};
+  }
+  static Example<> from_tensors(const std::vector<Tensor>& tensors) {
+    return {tensors[0], tensors[1]};
+  }
+};
+
+template <>
+struct CachedExample<TensorExample> {
+  static std::vector<Tensor> to_tensors(const TensorExample& example) {
+    return {example.data};
+  }
+  static TensorExample from_tensors(const std::vector<Tensor>& tensors) {
+    return {tensors[0]};
+  }
+};
+
+/// The state of a `CachedDataset`, which is shared by all of its copies.
+class ExampleCache {
+ public:
+  explicit ExampleCache(CacheOptions options) : options_(std::move(options)) {
+    if (!options_.spill_file().empty() && options_.spill_budget() > 0) {
+      spill_ = torch::from_file(
+          options_.spill_file(),
+          /*shared=*/true,
+          options_.spill_budget(),
+          kByte);
+    }
+  }
+
+  /// Returns the tensors of the example at `index`, or an empty vector if
+  /// it is not cached.
+  std::vector<Tensor> find(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(index);
+    if (it == entries_.end()) {
+      ++stats_.misses;
+      return {};
+    }
+    ++stats_.hits;
+    return it->second;
+  }
+
+  /// Caches the tensors of the example at `index`, in memory if it fits the
+  /// memory budget, and in the spill file otherwise. Does nothing if both are
+  /// used up.
+  void insert(size_t index, std::vector<Tensor> tensors) {
+    size_t bytes = 0;
+    for (const auto& tensor : tensors) {
+      TORCH_CHECK(
+          tensor.device().is_cpu(),
+          "CachedDataset only supports examples of CPU tensors");
+      bytes += round_up(tensor.numel() * tensor.element_size());
+    }
+
+    size_t offset = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entries_.count(index) != 0) {
+        return;
+      }
+      if (stats_.memory_bytes + bytes <= options_.memory_budget()) {
+        stats_.memory_bytes += bytes;
+        entries_.emplace(index, std::move(tensors));
+        return;
+      }
+      if (!spill_.defined() ||
+          stats_.spilled_bytes + bytes > options_.spill_budget()) {
+        return;
+      }
+      // Only reserve the space, so that copying doesn't block other workers.
+      offset = stats_.spilled_bytes;
+      stats_.spilled_bytes += bytes;
+    }
+
+    std::vector<Tensor> spilled;
+    spilled.reserve(tensors.size());
+    for (const auto& tensor : tensors) {
+      auto spill = spill_;
+      auto view = torch::from_blob(
+          spill_.data_ptr<uint8_t>() + offset,
+          tensor.sizes(),
+          // Keeps the file mapped while the example is in use.
+          [spill](void*) {},
+          tensor.options());
+      view.copy_(tensor);
+      spilled.push_back(std::move(view));
+      offset += round_up(tensor.numel() * tensor.element_size());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.emplace(index, std::move(spilled));
+  }
+
+  CacheStats stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  /// Tensors are spilled at cache line boundaries.
+  static size_t round_up(size_t bytes) {
+    return (bytes + 63) / 64 * 64;
+  }
+
+  const CacheOptions options_;
+
+  /// The spill file, mapped into memory as a tensor of bytes.
+  Tensor spill_;
+
+  std::mutex mutex_;
+  std::unordered_map<size_t, std::vector<Tensor>> entries_;
+  CacheStats stats_;
+};
+} // namespace detail
+
+/// A dataset that caches the examples of another dataset, so that only the
+/// first epoch pays for reading and decoding them.
+///
+/// Examples are kept in memory up to `CacheOptions::memory_budget` bytes, and
+/// then written to a memory-mapped spill file, if one is configured. Examples
+/// that fit into neither are read from the source dataset every time.
+///
+/// Examples are cached by index, so samplers, including the distributed ones,
+/// keep randomizing the order in which they are returned. All copies of a
+/// `CachedDataset`, such as the ones each `DataLoader` worker gets, share the
+/// same cache, while each keeps its own copy of the source dataset.
+///
+/// Cached examples are returned without copying them, so they must not be
+/// modified in place.
+template <typename SourceDataset>
+class CachedDataset : public Dataset<
+                          CachedDataset<SourceDataset>,
+                          typename SourceDataset::ExampleType> {
+ public:
+  using ExampleType = typename SourceDataset::ExampleType;
+
+  CachedDataset(SourceDataset dataset, CacheOptions options)
+      : dataset_(std::move(dataset)),
+        cache_(std::make_shared<detail::ExampleCache>(std::move(options))) {}
+
+  /// Returns the example at the given index, reading it from the source
+  /// dataset if it is not cached yet.
+  ExampleType get(size_t index) override {
+    auto tensors = cache_->find(index);
+    if (!tensors.empty()) {
+      return detail::CachedExample<ExampleType>::from_tensors(tensors);
+    }
+    auto example = dataset_.get(index);
+    cache_->insert(
+        index, detail::CachedExample<ExampleType>::to_tensors(example));
+    return example;
+  }
+
+  /// Returns the size of the source dataset.
+  optional<size_t> size() const override {
+    return dataset_.size();
+  }
+
+  /// Returns counters describing the use of the cache, across all copies of
+  /// this dataset.
+  CacheStats stats() const {
+    return cache_->stats();
+  }
+
+  /// Returns the underlying dataset.
+  const SourceDataset& dataset() noexcept {
+    return dataset_;
+  }
+
+ private:
+  SourceDataset dataset_;
+  std::shared_ptr<detail::ExampleCache> cache_;
+};
+} // namespace datasets
+} // namespace data
+} // namespace torch
@@ -4,6 +4,9 @@
 #include <torch/csrc/utils/memory.h>
 #include <torch/data/datasets/stateful.h>
 #include <torch/data/samplers.h>
+#include <chrono>
+#include <deque>
+#include <future>
 #include <queue>
 #include <thread>
 
@@ -30,6 +33,22 @@ class ChunkDataReader {
   /// Read an entire chunk.
   virtual ChunkType read_chunk(size_t chunk_index) = 0;
 
+  /// Starts reading an entire chunk, and returns a future for it.
+  ///
+  /// `ChunkDataset` keeps up to `max_chunks_in_flight` of these reads per
+  /// preloader in flight, so readers backed by slow storage can override this
+  /// to overlap several reads. Like `read_chunk()`, it is called concurrently
+  /// by all preloaders. The default implementation reads the chunk right away.
+  virtual std::future<ChunkType> read_chunk_async(size_t chunk_index) {
+    std::promise<ChunkType> promise;
+    try {
+      promise.set_value(read_chunk(chunk_index));
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+    return promise.get_future();
+  }
+
   /// Returns the number of chunks available in this reader.
   virtual size_t chunk_count() = 0;
 
@@ -37,6 +56,25 @@ class ChunkDataReader {
   virtual void reset() = 0;
 };
 
+/// Statistics about the prefetching of a `ChunkDataset` in the current epoch.
+/// They help telling whether the preloaders keep up with the consumer.
+struct ChunkDatasetStats {
+  /// The number of examples currently in the cache.
+  size_t cached_examples = 0;
+
+  /// The average number of examples in the cache when a batch was requested.
+  double average_cached_examples = 0;
+
+  /// The number of chunk reads that were issued, but not finished yet.
+  size_t chunks_in_flight = 0;
+
+  /// The time `get_batch()` spent waiting for the preloaders.
+  std::chrono::nanoseconds consumer_stall_time{0};
+
+  /// The time the preloaders spent waiting for room in the cache.
+  std::chrono::nanoseconds producer_stall_time{0};
+};
+
 namespace detail {
 /// BatchDataBuffer manages a queue of UnwrappedBatchData. After a new chunk is
 /// loaded, BatchDataBuffer splits it into small batches and push them into the
@@ -64,6 +102,9 @@ class BatchDataBuffer {
   /// thread.
   BatchType get_batch() {
     std::unique_lock<std::mutex> lock(queue_mutex_);
+    cached_examples_sum_ += total_example_count_in_queue_;
+    ++batch_requests_;
+    const auto start = std::chrono::steady_clock::now();
     cv_read_.wait(lock, [this] {
       // wait till there is available data in the queue or if all chunks are
       // loaded (i.e. the dataset is exhausted for this epoch)
@@ -71,6 +112,7 @@ class BatchDataBuffer {
           this->total_example_count_in_queue_ >= batch_size_ ||
           this->stop_);
     });
+    consumer_stall_time_ += std::chrono::steady_clock::now() - start;
     if (batch_queue_.empty()) {
       AT_ASSERT(stop_);
       // All batches have been retrieved. Return an empty batch.
@@ -94,11 +136,13 @@ class BatchDataBuffer {
   /// threads.
   void add_chunk_data(UnwrappedBatchType data) {
     std::unique_lock<std::mutex> lock(queue_mutex_);
+    const auto start = std::chrono::steady_clock::now();
     cv_write_.wait(lock, [this] {
       // stop loading if we have preloaded enough data.
       return this->total_example_count_in_queue_ < this->queue_capacity_ ||
           this->stop_;
     });
+    producer_stall_time_ += std::chrono::steady_clock::now() - start;
     if (stop_) {
       // When stop_ is true, it means no further chunk loading is necessary.
       // Return without any further processing.
@@ -195,6 +239,24 @@ class BatchDataBuffer {
     // notify all readers too.
     cv_read_.notify_all();
   }
+
+  /// Returns the number of examples in the queue.
+  size_t occupancy() {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    return total_example_count_in_queue_;
+  }
+
+  /// Fills in the statistics tracked by the buffer.
+  void stats(ChunkDatasetStats& stats) {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stats.cached_examples = total_example_count_in_queue_;
+    stats.average_cached_examples = batch_requests_ == 0
+        ? 0
+        : static_cast<double>(cached_examples_sum_) / batch_requests_;
+    stats.consumer_stall_time = consumer_stall_time_;
+    stats.producer_stall_time = producer_stall_time_;
+  }
+
   /// The batch size is needed to create batches from the chunk data. Similar to
   /// regular dataloader where the batches are created with prefetches,
   /// BatchDataBuffer perform the batch creation using the provided batch size.
@@ -225,6 +287,12 @@ class BatchDataBuffer {
   // sync batch_queue_ update.
   std::mutex queue_mutex_;
 
+  // statistics reported by stats(), guarded by queue_mutex_.
+  size_t batch_requests_ = 0;
+  size_t cached_examples_sum_ = 0;
+  std::chrono::nanoseconds consumer_stall_time_{0};
+  std::chrono::nanoseconds producer_stall_time_{0};
+
   std::condition_variable cv_read_;
   std::condition_variable cv_write_;
 
@@ -292,6 +360,13 @@ struct ChunkDatasetOptions {
   // penalty when this value is greater than 1, as we need to do extra merge
   // between multiple chunks before performing example sampling.
   TORCH_ARG(size_t, cross_chunk_shuffle_count) = 1;
+
+  // The maximum number of chunk reads each preloader keeps in flight through
+  // `ChunkDataReader::read_chunk_async()`. Preloaders read further ahead the
+  // emptier the cache is: up to this many reads when it is empty, and a single
+  // one when it is full. Only useful with readers that override
+  // `read_chunk_async()`.
+  TORCH_ARG(size_t, max_chunks_in_flight) = 1;
 };
 
 /// A stateful dataset that support hierarchical sampling and prefetching of
@@ -332,7 +407,12 @@ class ChunkDataset final
         preprocessing_policy_(preprocessing_policy),
         quit_worker_(false),
         running_preloaders_(0),
-        load_checkpoint_(false) {}
+        chunks_in_flight_(0),
+        load_checkpoint_(false) {
+    TORCH_CHECK(
+        options_.max_chunks_in_flight() > 0,
+        "max_chunks_in_flight needs to be greater than 0.");
+  }
 
   virtual ~ChunkDataset() {
     // stop batch buffer first.
@@ -404,6 +484,16 @@ class ChunkDataset final
     return torch::nullopt;
   }
 
+  /// Returns statistics about the prefetching in the current epoch.
+  ChunkDatasetStats stats() {
+    ChunkDatasetStats stats;
+    if (batch_buffer_) {
+      batch_buffer_->stats(stats);
+    }
+    stats.chunks_in_flight = chunks_in_flight_.load();
+    return stats;
+  }
+
   // provide a references to chunk sampler. Used mainly in distributed data
   // loading to set the epoch number for the sampler.
   ChunkSamplerType& chunk_sampler() {
@@ -424,20 +514,44 @@ class ChunkDataset final
  private:
   /// running on worker thread to preload chunk data.
   void preloader(size_t id) {
+    // Reads issued by this preloader, oldest first. Each entry holds the reads
+    // of the chunks that are shuffled together.
+    std::deque<std::vector<std::future<UnwrappedBatchType>>> reads;
+    bool chunks_exhausted = false;
     while (!quit_worker_.load()) {
       try {
-        std::vector<size_t> chunk_idx;
-        {
-          std::lock_guard<std::mutex> lock(chunk_index_guard_);
-          if (auto chunk_sampler_result = chunk_sampler_.next(this->options_.cross_chunk_shuffle_count())) {
-            chunk_idx = chunk_sampler_result.value();
-          } else {
-            break;
+        while (!chunks_exhausted && reads.size() < readahead_depth()) {
+          std::vector<size_t> chunk_idx;
+          {
+            std::lock_guard<std::mutex> lock(chunk_index_guard_);
+            if (auto chunk_sampler_result = chunk_sampler_.next(this->options_.cross_chunk_shuffle_count())) {
+              chunk_idx = chunk_sampler_result.value();
+            } else {
+              chunks_exhausted = true;
+              break;
+            }
           }
+          std::vector<std::future<UnwrappedBatchType>> chunk_reads;
+          for (size_t index : chunk_idx) {
+            chunk_reads.push_back(chunk_reader_.read_chunk_async(index));
+          }
+          chunks_in_flight_ += chunk_reads.size();
+          reads.push_back(std::move(chunk_reads));
+        }
+        if (reads.empty()) {
+          break;
         }
-        UnwrappedBatchType data = chunk_reader_.read_chunk(chunk_idx[0]);
-        for (size_t i = 1; i < chunk_idx.size(); ++i) {
-          auto chunk_data = chunk_reader_.read_chunk(chunk_idx[i]);
+
+        auto chunk_reads = std::move(reads.front());
+        reads.pop_front();
+        for (auto& read : chunk_reads) {
+          read.wait();
+        }
+        chunks_in_flight_ -= chunk_reads.size();
+
+        UnwrappedBatchType data = chunk_reads[0].get();
+        for (size_t i = 1; i < chunk_reads.size(); ++i) {
+          auto chunk_data = chunk_reads[i].get();
           std::move(
               chunk_data.begin(), chunk_data.end(), std::back_inserter(data));
         }
@@ -451,6 +565,14 @@ class ChunkDataset final
         batch_buffer_->add_chunk_data(std::current_exception());
       }
     }
+    // The reader may still be working on reads issued before we were told to
+    // quit, so wait for them before the dataset can go away.
+    for (auto& chunk_reads : reads) {
+      for (auto& read : chunk_reads) {
+        read.wait();
+      }
+      chunks_in_flight_ -= chunk_reads.size();
+    }
     AT_ASSERT(running_preloaders_.load() > 0);
     --running_preloaders_;
     if (running_preloaders_.load() == 0) {
@@ -459,6 +581,15 @@ class ChunkDataset final
     }
   }
 
+  /// The number of chunk reads a preloader should keep in flight, between 1
+  /// when the cache is full and `max_chunks_in_flight` when it is empty.
+  size_t readahead_depth() {
+    const auto max_depth = options_.max_chunks_in_flight();
+    const auto capacity = options_.cache_size();
+    const auto room = capacity - std::min(batch_buffer_->occupancy(), capacity);
+    return std::max<size_t>(1, (max_depth * room + capacity - 1) / capacity);
+  }
+
   /// Block the current thread until the workers finish execution and exit.
   void free_workers() {
     if (!quit_worker_.load()) {
@@ -510,6 +641,9 @@ class ChunkDataset final
   // indicates that the chunk loading is completed.
   std::atomic<size_t> running_preloaders_;
 
+  // number of chunk reads issued by the preloaders that did not finish yet.
+  std::atomic<size_t> chunks_in_flight_;
+
   // mutex to synchronize chunk sampler next() call.
   mutable std::mutex chunk_index_guard_;
 
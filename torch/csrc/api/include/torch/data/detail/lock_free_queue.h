@@ -0,0 +1,236 @@
+#pragma once
+
+#include <torch/types.h>
+
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+/// A bounded, blocking MPMC queue whose `push` and `pop` don't take a lock
+/// while the queue is neither empty nor full.
+///
+/// Elements live in a ring of `capacity` cells (rounded up to a power of
+/// two). Each cell carries a sequence number telling whether it is ready to be
+/// written or read in the current lap of the ring, so that producers and
+/// consumers only contend on the two position counters, which they advance
+/// with a compare-and-swap (see Dmitry Vyukov's bounded MPMC queue).
+///
+/// A `pop` on an empty queue and a `push` on a full one spin briefly, then
+/// sleep on a condition variable. The other side only takes the mutex to wake
+/// them up if somebody is actually sleeping.
+///
+/// Like `Queue`, this is written for the `DataLoader`, which bounds the number
+/// of jobs and results in flight.
+template <typename T>
+class LockFreeQueue {
+ public:
+  explicit LockFreeQueue(size_t capacity)
+      : mask_(round_up_to_power_of_two(capacity) - 1),
+        cells_(new Cell[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~LockFreeQueue() {
+    clear();
+  }
+
+  LockFreeQueue(const LockFreeQueue&) = delete;
+  LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+  /// Pushes a new value to the back of the `LockFreeQueue`, blocking while
+  /// the queue is full, and wakes up one thread waiting in `pop()`.
+  void push(T value) {
+    if (!spin([&] { return try_push(value); })) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      waiting_producers_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      not_full_.wait(lock, [&] { return try_push(value); });
+      waiting_producers_.fetch_sub(1);
+    }
+    notify(waiting_consumers_, not_empty_);
+  }
+
+  /// Blocks until at least one element is ready to be popped from the front of
+  /// the queue. An optional `timeout` in seconds can be used to limit the time
+  /// spent waiting for an element. If the wait times out, an exception is
+  /// raised.
+  T pop(optional<std::chrono::milliseconds> timeout = nullopt) {
+    optional<T> value;
+    if (!spin([&] { return (value = try_pop()).has_value(); })) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      waiting_consumers_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const auto ready = [&] { return (value = try_pop()).has_value(); };
+      bool popped = true;
+      if (timeout) {
+        popped = not_empty_.wait_for(lock, *timeout, ready);
+      } else {
+        not_empty_.wait(lock, ready);
+      }
+      waiting_consumers_.fetch_sub(1);
+      if (!popped) {
+        // clang-format off
+        AT_ERROR(
+            "Timeout in DataLoader queue while waiting for next batch"
+            " (timeout was ", timeout->count(), " ms)");
+        // clang-format on
+      }
+    }
+    notify(waiting_producers_, not_full_);
+    return std::move(*value);
+  }
+
+  /// Empties the queue and returns the number of elements that were removed.
+  /// Only producers blocked on a full queue are notified, as this is assumed
+  /// to be used to drain the queue during shutdown of a `DataLoader`.
+  size_t clear() {
+    size_t size = 0;
+    while (try_pop()) {
+      ++size;
+    }
+    if (size > 0) {
+      notify(waiting_producers_, not_full_);
+    }
+    return size;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  /// Number of attempts before a blocked `push` or `pop` goes to sleep.
+  static constexpr int kSpinCount = 64;
+
+  static constexpr size_t kCacheLineSize = 64;
+
+  static size_t round_up_to_power_of_two(size_t n) {
+    size_t power = 2;
+    while (power < n) {
+      power <<= 1;
+    }
+    return power;
+  }
+
+  template <typename F>
+  static bool spin(F&& attempt) {
+    for (int i = 0; i < kSpinCount; ++i) {
+      if (attempt()) {
+        return true;
+      }
+      std::this_thread::yield();
+    }
+    return false;
+  }
+
+  /// Moves `value` into the queue unless it is full.
+  bool try_push(T& value) {
+    size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[position & mask_];
+      const auto sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto difference =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    new (&cell->storage) T(std::move(value));
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Takes the front element out of the queue, unless it is empty.
+  optional<T> try_pop() {
+    size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[position & mask_];
+      const auto sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<intptr_t>(sequence) -
+          static_cast<intptr_t>(position + 1);
+      if (difference == 0) {
+        if (dequeue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        return nullopt;
+      } else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    T* element = reinterpret_cast<T*>(&cell->storage);
+    optional<T> value(std::move(*element));
+    element->~T();
+    cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+    return value;
+  }
+
+  /// Wakes up one of the threads sleeping on `condition`, if any. A sleeper
+  /// increments `waiters` before its last attempt under the mutex, so either
+  /// that attempt succeeds or it is seen here, after the fence.
+  void notify(
+      std::atomic<size_t>& waiters,
+      std::condition_variable& condition) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) > 0) {
+      // Taking the mutex ensures the sleeper is either before its last attempt
+      // or already waiting on `condition`.
+      { std::lock_guard<std::mutex> lock(mutex_); }
+      condition.notify_one();
+    }
+  }
+
+  const size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+
+  /// Padded to separate cache lines, as producers and consumers update them
+  /// concurrently.
+  char padding0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_position_{0};
+  char padding1_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> dequeue_position_{0};
+  char padding2_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+
+  std::atomic<size_t> waiting_producers_{0};
+  std::atomic<size_t> waiting_consumers_{0};
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+template <typename T>
+constexpr int LockFreeQueue<T>::kSpinCount;
+
+template <typename T>
+constexpr size_t LockFreeQueue<T>::kCacheLineSize;
+
+} // namespace detail
+} // namespace data
+} // namespace torch
@@ -0,0 +1,353 @@
+#include <torch/csrc/autograd/activation_offload.h>
+
+#include <torch/csrc/autograd/grad_mode.h>
+#include <torch/csrc/utils/memory.h>
+
+#include <TH/THAllocator.h>
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace torch { namespace autograd {
+
+namespace {
+
+std::atomic<bool> enabled{false};
+std::atomic<uint64_t> resident_bytes{0};
+std::atomic<uint64_t> offloaded{0};
+std::atomic<uint64_t> bytes_saved{0};
+std::atomic<uint64_t> restored{0};
+std::atomic<int64_t> restore_time_ns{0};
+
+// Hands out consecutive regions of a spill file, and starts over once all of
+// them were freed. Every arena maps a file of its own, so that enabling
+// offloading again doesn't overwrite activations still spilled to an older
+// arena: a fresh file next to the configured path, which is unlinked once
+// mapped. Windows can't unlink mapped files, so there the configured file is
+// mapped, and only once no older arena uses it.
+class SpillArena {
+ public:
+  SpillArena(const std::string& path, size_t capacity) : capacity_(capacity) {
+#ifndef _WIN32
+    std::vector<char> name(path.begin(), path.end());
+    const std::string pattern = ".XXXXXX";
+    name.insert(name.end(), pattern.begin(), pattern.end());
+    name.push_back('\0');
+    const int fd = mkstemp(name.data());
+    TORCH_CHECK(
+        fd != -1,
+        "unable to create a spill file next to <",
+        path,
+        ">: ",
+        std::strerror(errno));
+    ::close(fd);
+    try {
+      mapping_ = THMapAllocator::makeDataPtr(
+          name.data(),
+          TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_UNLINK,
+          capacity,
+          nullptr);
+    } catch (...) {
+      unlink(name.data());
+      throw;
+    }
+#else
+    mapping_ = THMapAllocator::makeDataPtr(
+        path.c_str(), TH_ALLOCATOR_MAPPED_SHARED, capacity, nullptr);
+#endif
+  }
+
+  // Returns `bytes` bytes of the mapping, or nullptr if they don't fit.
+  uint8_t* allocate(size_t bytes) {
+    // Regions start at cache line boundaries.
+    bytes = (bytes + 63) / 64 * 64;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (offset_ + bytes > capacity_) {
+      return nullptr;
+    }
+    auto* region = static_cast<uint8_t*>(mapping_.get()) + offset_;
+    offset_ += bytes;
+    ++num_regions_;
+    return region;
+  }
+
+  void free() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--num_regions_ == 0) {
+      offset_ = 0;
+    }
+  }
+
+ private:
+  at::DataPtr mapping_;
+  const size_t capacity_;
+  std::mutex mutex_;
+  size_t offset_ = 0;
+  size_t num_regions_ = 0;
+};
+
+struct State {
+  explicit State(OffloadConfig config) : config(std::move(config)) {}
+
+  const OffloadConfig config;
+  std::shared_ptr<SpillArena> arena;
+};
+
+std::mutex state_mutex;
+std::shared_ptr<const State> state;
+#ifdef _WIN32
+// The arenas mapping each spill file, guarded by state_mutex.
+std::unordered_map<std::string, std::weak_ptr<SpillArena>> spill_arenas;
+#endif
+
+class HalfActivation : public detail::OffloadedActivation {
+ public:
+  explicit HalfActivation(const at::Tensor& data)
+      : data_(at::empty(data.sizes(), data.options().dtype(at::kHalf))
+                  .copy_(data)),
+        dtype_(data.scalar_type()) {}
+
+ protected:
+  at::Tensor restoreImpl() const override {
+    return data_.to(dtype_);
+  }
+
+ private:
+  at::Tensor data_;
+  const at::ScalarType dtype_;
+};
+
+class Int8Activation : public detail::OffloadedActivation {
+ public:
+  explicit Int8Activation(const at::Tensor& data)
+      : dtype_(data.scalar_type()) {
+    // Quantizes in single precision, which the CPU kernels support for all
+    // floating point types.
+    auto scaled = at::empty(data.sizes(), data.options().dtype(computeType()))
+                      .copy_(data);
+    min_ = scaled.min().item<double>();
+    scale_ = (scaled.max().item<double>() - min_) / 255;
+    if (scale_ > 0) {
+      scaled.sub_(min_).div_(scale_).round_();
+    } else {
+      scaled.zero_();
+    }
+    data_ = scaled.to(at::kByte);
+  }
+
+ protected:
+  at::Tensor restoreImpl() const override {
+    return data_.to(computeType()).mul_(scale_).add_(min_).to(dtype_);
+  }
+
+ private:
+  at::ScalarType computeType() const {
+    return dtype_ == at::kDouble ? at::kDouble : at::kFloat;
+  }
+
+  at::Tensor data_;
+  const at::ScalarType dtype_;
+  double min_;
+  double scale_;
+};
+
+class SpilledActivation : public detail::OffloadedActivation {
+ public:
+  SpilledActivation(
+      std::shared_ptr<SpillArena> arena,
+      uint8_t* region,
+      const at::Tensor& data)
+      : arena_(std::move(arena)),
+        region_(region),
+        sizes_(data.sizes().vec()),
+        options_(data.options()) {
+    at::from_blob(region_, sizes_, options_).copy_(data);
+  }
+
+  ~SpilledActivation() override {
+    arena_->free();
+  }
+
+ protected:
+  at::Tensor restoreImpl() const override {
+    // Copies the activation out of the file, whose space is reused once the
+    // SavedVariable is gone.
+    return at::from_blob(region_, sizes_, options_).clone();
+  }
+
+ private:
+  std::shared_ptr<SpillArena> arena_;
+  uint8_t* region_;
+  std::vector<int64_t> sizes_;
+  at::TensorOptions options_;
+};
+
+bool canOffload(const at::Tensor& data, OffloadMode mode) {
+  if (data.layout() != at::kStrided || data.numel() == 0) {
+    return false;
+  }
+  switch (mode) {
+    case OffloadMode::Half:
+      return at::isFloatingType(data.scalar_type()) &&
+          data.scalar_type() != at::kHalf;
+    case OffloadMode::Int8:
+      return at::isFloatingType(data.scalar_type());
+    case OffloadMode::Spill:
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+void enableActivationOffload(OffloadConfig config) {
+  TORCH_CHECK(
+      config.mode != OffloadMode::Spill ||
+          (!config.spill_file.empty() && config.spill_budget > 0),
+      "Spilling activations needs a spill file and a spill budget");
+  auto new_state = std::make_shared<State>(std::move(config));
+
+  std::lock_guard<std::mutex> lock(state_mutex);
+  TORCH_CHECK(!state, "Activation offloading is already enabled");
+  if (new_state->config.mode == OffloadMode::Spill) {
+#ifdef _WIN32
+    auto& old_arena = spill_arenas[new_state->config.spill_file];
+    TORCH_CHECK(
+        old_arena.expired(),
+        "The spill file <",
+        new_state->config.spill_file,
+        "> still holds activations spilled before offloading was last "
+        "enabled; free them (e.g. by running backward) or use another file");
+#endif
+    new_state->arena = std::make_shared<SpillArena>(
+        new_state->config.spill_file, new_state->config.spill_budget);
+#ifdef _WIN32
+    old_arena = new_state->arena;
+#endif
+  }
+  state = std::move(new_state);
+  enabled = true;
+}
+
+void disableActivationOffload() {
+  std::lock_guard<std::mutex> lock(state_mutex);
+  TORCH_CHECK(state, "Activation offloading is not enabled");
+  state.reset();
+  enabled = false;
+}
+
+bool activationOffloadEnabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+OffloadStats activationOffloadStats() {
+  OffloadStats stats;
+  stats.resident_bytes = resident_bytes.load();
+  stats.offloaded = offloaded.load();
+  stats.bytes_saved = bytes_saved.load();
+  stats.restored = restored.load();
+  stats.restore_time_ns = restore_time_ns.load();
+  return stats;
+}
+
+void resetActivationOffloadStats() {
+  offloaded = 0;
+  bytes_saved = 0;
+  restored = 0;
+  restore_time_ns = 0;
+}
+
+namespace detail {
+
+bool ResidentBytes::tryAcquire(size_t bytes, size_t budget) {
+  TORCH_INTERNAL_ASSERT(bytes_ == 0);
+  if (resident_bytes.fetch_add(bytes) + bytes > budget) {
+    resident_bytes -= bytes;
+    return false;
+  }
+  bytes_ = bytes;
+  return true;
+}
+
+void ResidentBytes::release() {
+  resident_bytes -= bytes_;
+  bytes_ = 0;
+}
+
+at::Tensor OffloadedActivation::restore() const {
+  const auto start = std::chrono::steady_clock::now();
+  at::Tensor result;
+  {
+    AutoGradMode grad_mode(false);
+    result = restoreImpl();
+  }
+  ++restored;
+  restore_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  return result;
+}
+
+std::unique_ptr<OffloadedActivation> offloadActivation(
+    const at::Tensor& data,
+    ResidentBytes& resident) {
+  std::shared_ptr<const State> current;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    current = state;
+  }
+  if (!current || !data.device().is_cpu()) {
+    return nullptr;
+  }
+  const auto& config = current->config;
+  const size_t bytes = data.numel() * data.element_size();
+  const auto keep = [&] {
+    resident.tryAcquire(bytes, std::numeric_limits<size_t>::max());
+    return nullptr;
+  };
+  if (resident.tryAcquire(bytes, config.memory_budget)) {
+    return nullptr;
+  }
+  if (bytes < config.min_bytes || !canOffload(data, config.mode)) {
+    return keep();
+  }
+
+  AutoGradMode grad_mode(false);
+  std::unique_ptr<OffloadedActivation> activation;
+  size_t offloaded_bytes = 0;
+  switch (config.mode) {
+    case OffloadMode::Half:
+      activation = make_unique<HalfActivation>(data);
+      offloaded_bytes = data.numel() * at::elementSize(at::kHalf);
+      break;
+    case OffloadMode::Int8:
+      activation = make_unique<Int8Activation>(data);
+      offloaded_bytes = data.numel();
+      break;
+    case OffloadMode::Spill:
+      if (auto* region = current->arena->allocate(bytes)) {
+        activation =
+            make_unique<SpilledActivation>(current->arena, region, data);
+      } else {
+        return keep();
+      }
+      break;
+  }
+  ++offloaded;
+  bytes_saved += bytes - offloaded_bytes;
+  return activation;
+}
+
+} // namespace detail
+}} // namespace torch::autograd
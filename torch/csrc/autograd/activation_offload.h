@@ -0,0 +1,137 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <ATen/ATen.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace torch { namespace autograd {
+
+// Note [Activation offloading]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Activation offloading keeps the memory held by the tensors saved for
+// backward (see SavedVariable) within a budget.
+//
+// Activations, i.e. non-leaf CPU tensors saved for backward, are kept as they
+// are until they take up OffloadConfig::memory_budget bytes. The ones saved
+// once the budget is used up are offloaded in the way OffloadConfig::mode
+// says, and restored when backward unpacks them. The memory of an offloaded
+// activation is freed once the forward pass drops its own references to it.
+//
+// This trades memory for the time spent offloading and restoring, and,
+// unless spilling, for precision. Dropping activations and recomputing them
+// during backward needs to rerun the forward, which only the Python
+// torch.utils.checkpoint can do, so it is not a mode here.
+
+enum class OffloadMode {
+  // Converts floating point activations to half precision.
+  Half,
+  // Quantizes floating point activations to 8 bits, with a scale and offset
+  // per tensor.
+  Int8,
+  // Copies activations to a memory-mapped file, which the OS may write back
+  // and evict from memory.
+  Spill,
+};
+
+struct TORCH_API OffloadConfig {
+  explicit OffloadConfig(size_t memory_budget) : memory_budget(memory_budget) {}
+
+  // The number of bytes of activations to keep as they are.
+  size_t memory_budget;
+  OffloadMode mode = OffloadMode::Half;
+  // For OffloadMode::Spill: where to spill to. Each enableActivationOffload
+  // call creates a file of spill_budget bytes next to this path, and unlinks
+  // it right away, so the space is returned once the activations spilled to
+  // it are gone (on Windows, the file at this path is used instead). Space is
+  // reused once all spilled activations are freed, e.g. at the end of each
+  // backward pass. Activations that don't fit are kept as they are.
+  std::string spill_file;
+  size_t spill_budget = 0;
+  // Activations smaller than this are never offloaded.
+  size_t min_bytes = 4096;
+};
+
+struct TORCH_API OffloadStats {
+  // Bytes of activations currently kept as they are.
+  uint64_t resident_bytes = 0;
+  // The number of activations offloaded.
+  uint64_t offloaded = 0;
+  // Bytes of memory offloading saved, i.e. the size of the offloaded
+  // activations minus the memory their offloaded form takes.
+  uint64_t bytes_saved = 0;
+  // The number of activations restored for backward, and the time spent
+  // restoring them in ns.
+  uint64_t restored = 0;
+  int64_t restore_time_ns = 0;
+};
+
+// NOTE: enabling and disabling offloading only affects the activations saved
+// afterwards. Those offloaded before can still be restored.
+TORCH_API void enableActivationOffload(OffloadConfig config);
+TORCH_API void disableActivationOffload();
+TORCH_API bool activationOffloadEnabled();
+// Returns the stats since they were last reset. resident_bytes is never
+// reset.
+TORCH_API OffloadStats activationOffloadStats();
+TORCH_API void resetActivationOffloadStats();
+
+namespace detail {
+
+// Counts the bytes of an activation a SavedVariable keeps as they are
+// towards OffloadStats::resident_bytes, until it is destroyed or reset.
+class TORCH_API ResidentBytes {
+ public:
+  ResidentBytes() = default;
+  ResidentBytes(ResidentBytes&& other) noexcept : bytes_(other.bytes_) {
+    other.bytes_ = 0;
+  }
+  ResidentBytes& operator=(ResidentBytes&& other) noexcept {
+    reset();
+    bytes_ = other.bytes_;
+    other.bytes_ = 0;
+    return *this;
+  }
+  ~ResidentBytes() {
+    reset();
+  }
+
+  // Counts `bytes` if they fit into `budget`, and returns whether they did.
+  bool tryAcquire(size_t bytes, size_t budget);
+  void reset() {
+    if (bytes_ != 0) {
+      release();
+    }
+  }
+
+ private:
+  void release();
+
+  size_t bytes_ = 0;
+};
+
+// An offloaded activation.
+class TORCH_API OffloadedActivation {
+ public:
+  virtual ~OffloadedActivation() = default;
+
+  // Returns a copy of the activation, as a contiguous tensor.
+  at::Tensor restore() const;
+
+ protected:
+  virtual at::Tensor restoreImpl() const = 0;
+};
+
+// Returns the offloaded form of `data`, a tensor SavedVariable saves for a
+// non-leaf variable, or nullptr if it is to be kept as it is, in which case
+// `resident` counts it.
+TORCH_API std::unique_ptr<OffloadedActivation> offloadActivation(
+    const at::Tensor& data,
+    ResidentBytes& resident);
+
+} // namespace detail
+}} // namespace torch::autograd
@@ -0,0 +1,369 @@
+#include <torch/csrc/autograd/continuous_profiler.h>
+
+#include <torch/csrc/autograd/profiler.h>
+#include <torch/csrc/autograd/record_function.h>
+#include <torch/csrc/utils/memory.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace torch { namespace autograd { namespace profiler {
+
+namespace {
+
+struct Record {
+  StringView name;
+  int64_t start_ns = 0;
+  int64_t end_ns = 0;
+};
+
+// The events of a single thread. The thread pushes them and the flusher
+// drains them, without taking a lock.
+class RecordBuffer {
+ public:
+  RecordBuffer(size_t capacity, uint32_t thread_id)
+      : records_(capacity), thread_id_(thread_id) {}
+
+  // Called from the owning thread only.
+  void push(Record record) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == records_.size()) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    records_[tail % records_.size()] = std::move(record);
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  // Called from the flusher only.
+  template <typename F>
+  void drain(F&& fn) {
+    auto head = head_.load(std::memory_order_relaxed);
+    const auto tail = tail_.load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+      auto& record = records_[head % records_.size()];
+      fn(record);
+      // Releases the name, in case the thread owned it.
+      record = Record();
+    }
+    head_.store(head, std::memory_order_release);
+  }
+
+  uint32_t thread_id() const {
+    return thread_id_;
+  }
+
+  uint64_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // Start times of the sampled operators running on the owning thread.
+  std::vector<int64_t> start_times;
+
+ private:
+  std::vector<Record> records_;
+  const uint32_t thread_id_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+class TraceWriter {
+ public:
+  explicit TraceWriter(const std::string& path)
+      : out_(path, std::ios::out | std::ios::trunc | std::ios::binary) {
+    TORCH_CHECK(out_, "could not open ", path, " for the continuous profiler");
+  }
+  virtual ~TraceWriter() = default;
+
+  virtual void write(
+      const Record& record,
+      uint32_t thread_id,
+      int64_t origin) = 0;
+
+  virtual void finish() {}
+
+  void flush() {
+    out_.flush();
+  }
+
+ protected:
+  std::ofstream out_;
+};
+
+class ChromeTraceWriter : public TraceWriter {
+ public:
+  explicit ChromeTraceWriter(const std::string& path) : TraceWriter(path) {
+    out_ << "[\n" << std::fixed << std::setprecision(3);
+  }
+
+  void write(const Record& record, uint32_t thread_id, int64_t origin)
+      override {
+    if (!first_) {
+      out_ << ",\n";
+    }
+    first_ = false;
+    out_ << "{\"name\": \"";
+    for (const char* c = record.name.str(); *c; ++c) {
+      if (*c == '"' || *c == '\\') {
+        out_ << '\\';
+      }
+      out_ << *c;
+    }
+    out_ << "\", \"ph\": \"X\", \"ts\": " << (record.start_ns - origin) / 1000.0
+         << ", \"dur\": " << (record.end_ns - record.start_ns) / 1000.0
+         << ", \"tid\": " << thread_id
+         << ", \"pid\": \"CPU Functions\", \"args\": {}}";
+  }
+
+  void finish() override {
+    out_ << "\n]\n";
+  }
+
+ private:
+  bool first_ = true;
+};
+
+class BinaryTraceWriter : public TraceWriter {
+ public:
+  explicit BinaryTraceWriter(const std::string& path) : TraceWriter(path) {
+    out_.write("PTTRACE1", 8);
+  }
+
+  void write(const Record& record, uint32_t thread_id, int64_t origin)
+      override {
+    const std::string name = record.name.str();
+    auto it = name_ids_.find(name);
+    if (it == name_ids_.end()) {
+      const auto id = static_cast<uint32_t>(name_ids_.size());
+      it = name_ids_.emplace(name, id).first;
+      put<uint8_t>(0);
+      put<uint32_t>(it->second);
+      put<uint32_t>(static_cast<uint32_t>(name.size()));
+      out_.write(name.data(), name.size());
+    }
+    put<uint8_t>(1);
+    put<uint32_t>(it->second);
+    put<uint32_t>(thread_id);
+    put<int64_t>(record.start_ns - origin);
+    put<int64_t>(record.end_ns - record.start_ns);
+  }
+
+ private:
+  template <typename T>
+  void put(T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out_.write(bytes, sizeof(T));
+  }
+
+  std::unordered_map<std::string, uint32_t> name_ids_;
+};
+
+// The state of one enableContinuousProfiler() .. disableContinuousProfiler()
+// period. The callbacks hold on to it, so it outlives the operators running
+// while the profiler gets disabled.
+class Session {
+ public:
+  Session(uint64_t id, const ContinuousProfilerConfig& config)
+      : id_(id),
+        buffer_size_(config.buffer_size),
+        flush_interval_(config.flush_interval_ms),
+        origin_ns_(getTime()) {
+    if (config.format == TraceFormat::ChromeTrace) {
+      writer_ = torch::make_unique<ChromeTraceWriter>(config.path);
+    } else {
+      writer_ = torch::make_unique<BinaryTraceWriter>(config.path);
+    }
+    flusher_ = std::thread([this] { flushLoop(); });
+  }
+
+  ~Session() {
+    stop();
+  }
+
+  RecordBuffer& buffer();
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_) {
+        return;
+      }
+      stopped_ = true;
+    }
+    cv_.notify_one();
+    flusher_.join();
+  }
+
+  ContinuousProfilerStats stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ContinuousProfilerStats stats;
+    stats.recorded = recorded_;
+    stats.dropped = dropped_by_exited_threads_;
+    for (const auto& buffer : buffers_) {
+      stats.dropped += buffer->dropped();
+    }
+    return stats;
+  }
+
+ private:
+  void flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+      cv_.wait_for(lock, flush_interval_);
+      // Events are only drained here, so they can be written without holding
+      // the lock and blocking threads that register their buffer.
+      auto buffers = buffers_;
+      lock.unlock();
+      uint64_t recorded = 0;
+      for (const auto& buffer : buffers) {
+        buffer->drain([&](const Record& record) {
+          writer_->write(record, buffer->thread_id(), origin_ns_);
+          ++recorded;
+        });
+      }
+      writer_->flush();
+      buffers.clear();
+      lock.lock();
+      recorded_ += recorded;
+      // Forget the buffers of threads that exited, after writing the events
+      // they recorded since they were drained.
+      for (auto it = buffers_.begin(); it != buffers_.end();) {
+        if (it->use_count() == 1) {
+          (*it)->drain([&](const Record& record) {
+            writer_->write(record, (*it)->thread_id(), origin_ns_);
+            ++recorded_;
+          });
+          dropped_by_exited_threads_ += (*it)->dropped();
+          it = buffers_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    // stop() may have been called while the buffers were drained without the
+    // lock, after some events were recorded.
+    for (const auto& buffer : buffers_) {
+      buffer->drain([&](const Record& record) {
+        writer_->write(record, buffer->thread_id(), origin_ns_);
+        ++recorded_;
+      });
+    }
+    writer_->finish();
+    writer_->flush();
+  }
+
+  const uint64_t id_;
+  const size_t buffer_size_;
+  const std::chrono::milliseconds flush_interval_;
+  const int64_t origin_ns_;
+  std::unique_ptr<TraceWriter> writer_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::list<std::shared_ptr<RecordBuffer>> buffers_;
+  uint32_t next_thread_id_ = 0;
+  uint64_t recorded_ = 0;
+  uint64_t dropped_by_exited_threads_ = 0;
+  bool stopped_ = false;
+  std::thread flusher_;
+};
+
+thread_local std::shared_ptr<RecordBuffer> thread_buffer;
+thread_local uint64_t thread_session_id = 0;
+
+RecordBuffer& Session::buffer() {
+  if (thread_session_id != id_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_buffer =
+        std::make_shared<RecordBuffer>(buffer_size_, next_thread_id_++);
+    buffers_.push_back(thread_buffer);
+    thread_session_id = id_;
+  }
+  return *thread_buffer;
+}
+
+std::mutex session_mutex;
+std::shared_ptr<Session> active_session;
+uint64_t next_session_id = 1;
+double previous_sampling_probability = 1.0;
+
+} // namespace
+
+void enableContinuousProfiler(ContinuousProfilerConfig config) {
+  TORCH_CHECK(
+      config.sampling_rate > 0 && config.sampling_rate <= 1,
+      "Expected the sampling rate of the continuous profiler to be in (0, 1], "
+      "got ",
+      config.sampling_rate);
+  TORCH_CHECK(
+      config.buffer_size > 0,
+      "Expected a positive buffer size for the continuous profiler");
+  TORCH_CHECK(
+      config.flush_interval_ms > 0,
+      "Expected a positive flush interval for the continuous profiler");
+
+  std::lock_guard<std::mutex> lock(session_mutex);
+  TORCH_CHECK(!active_session, "The continuous profiler is already enabled");
+  auto session = std::make_shared<Session>(next_session_id++, config);
+
+  previous_sampling_probability = getSamplingProbability();
+  setSamplingProbability(config.sampling_rate);
+  pushCallback(
+      [session](const RecordFunction& /* unused */) {
+        session->buffer().start_times.push_back(getTime());
+      },
+      [session](const RecordFunction& fn) {
+        auto& buffer = session->buffer();
+        // The operator may have started before the profiler was enabled.
+        if (buffer.start_times.empty()) {
+          return;
+        }
+        Record record;
+        record.name = fn.name();
+        record.start_ns = buffer.start_times.back();
+        record.end_ns = getTime();
+        buffer.start_times.pop_back();
+        buffer.push(std::move(record));
+      },
+      /* needs_inputs */ false,
+      /* sampled */ true);
+  active_session = std::move(session);
+}
+
+ContinuousProfilerStats disableContinuousProfiler() {
+  std::shared_ptr<Session> session;
+  {
+    std::lock_guard<std::mutex> lock(session_mutex);
+    TORCH_CHECK(active_session, "The continuous profiler is not enabled");
+    popCallback();
+    setSamplingProbability(previous_sampling_probability);
+    session = std::move(active_session);
+  }
+  session->stop();
+  return session->stats();
+}
+
+bool continuousProfilerEnabled() {
+  std::lock_guard<std::mutex> lock(session_mutex);
+  return active_session != nullptr;
+}
+
+ContinuousProfilerStats continuousProfilerStats() {
+  std::lock_guard<std::mutex> lock(session_mutex);
+  TORCH_CHECK(active_session, "The continuous profiler is not enabled");
+  return active_session->stats();
+}
+
+}}} // namespace torch::autograd::profiler
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace torch { namespace autograd { namespace profiler {
+
+// A profiler meant to stay enabled in production.
+//
+// Unlike enableProfiler(), which keeps every event in memory until the
+// profiler is disabled, it samples a fraction of the operators and records
+// them into a fixed-size buffer per thread. A background thread drains the
+// buffers every flush_interval_ms and appends the events to a file, so memory
+// use is bounded and the trace can be read while the process runs. Events are
+// dropped, rather than blocking the operator, when a buffer is full.
+//
+// Sampling uses the sampled RecordFunction callbacks, so enabling the
+// continuous profiler sets the sampling probability of all of them. It is
+// restored when the profiler is disabled.
+
+enum class TraceFormat {
+  // A JSON array of complete ("ph": "X") events, which chrome://tracing
+  // opens even if the closing bracket is missing, e.g. because the process
+  // crashed.
+  ChromeTrace,
+  // A compact stream of records in host byte order, after the 8 byte magic
+  // "PTTRACE1". Each record starts with a uint8 kind:
+  //   0: name      uint32 name id, uint32 length, length chars
+  //   1: event     uint32 name id, uint32 thread id, int64 start (ns since
+  //                the profiler was enabled), int64 duration (ns)
+  // A name record precedes the first event that uses its id.
+  Binary,
+};
+
+struct TORCH_API ContinuousProfilerConfig {
+  explicit ContinuousProfilerConfig(std::string path) : path(std::move(path)) {}
+
+  // The file to write the trace to. It is truncated when the profiler is
+  // enabled.
+  std::string path;
+  TraceFormat format = TraceFormat::ChromeTrace;
+  // The probability with which each operator is recorded.
+  double sampling_rate = 0.01;
+  // The number of events each thread can buffer between two flushes.
+  size_t buffer_size = 16384;
+  int64_t flush_interval_ms = 100;
+};
+
+struct TORCH_API ContinuousProfilerStats {
+  // Events written to the trace.
+  uint64_t recorded = 0;
+  // Events dropped because the buffer of their thread was full.
+  uint64_t dropped = 0;
+};
+
+// NOTE: like enableProfiler(), this is **NOT THREAD SAFE** with respect to
+// operators running concurrently, and it pushes a RecordFunction callback, so
+// other profilers enabled after it must be disabled first.
+TORCH_API void enableContinuousProfiler(ContinuousProfilerConfig config);
+// Writes the remaining events, closes the trace and returns the final stats.
+TORCH_API ContinuousProfilerStats disableContinuousProfiler();
+TORCH_API bool continuousProfilerEnabled();
+TORCH_API ContinuousProfilerStats continuousProfilerStats();
+
+} // namespace profiler
+}} // namespace torch::autograd
@@ -47,17 +47,23 @@ static thread_local int worker_device = NO_DEVICE;
 static thread_local bool checkpoint_valid = true;
 
 // XXX: Changes to the way multithreading works in execute should be done with
-// great care. Right now the implementation guarantees that a single function's
-// apply will never be entered concurrently (even if multiple graphs are
-// executed at the same time). Adding multiple threads per-device or removing
-// engine thread affinity to the device can break this invariant, and we depend
-// on it in a few places (e.g. AccumulateGrad function).
+// great care. With a single CPU worker (the default), the implementation
+// guarantees that a single function's apply will never be entered
+// concurrently (even if multiple graphs are executed at the same time). With
+// several CPU workers (see Engine::set_num_cpu_workers), this only holds
+// within a single graph, so functions that several graphs may share must
+// synchronize themselves (e.g. AccumulateGrad function).
 
 // Number of nested reentrant backwards calls currently on this thread
 static thread_local int current_depth = 0;
 // Total nested reentrant backwards calls over all threads for workder_device
 static thread_local int total_depth = 0;
 
+// The ready queue served by this thread, and the worker of it this thread
+// acts as. See Note [Work stealing ready queues]
+static thread_local ReadyQueue* worker_queue = nullptr;
+static thread_local size_t worker_index = 0;
+
 // Returns true when t2 should be (weakly) BEFORE t1 in the queue.
 // Shutdown tasks are first and then empty NodeTask are next.
 struct CompareNodeTaskTime {
@@ -76,21 +82,67 @@ struct CompareNodeTaskTime {
   }
 };
 
+// Note [Work stealing ready queues]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A ReadyQueue is served by one or more worker threads: the CPU queue by
+// Engine::num_cpu_workers_ of them and every device queue by one. Rather than
+// a single heap behind a single mutex, it keeps a heap per worker, each with
+// its own mutex. Workers push the tasks they make ready onto their own heap
+// and pop from it, so they rarely wait for a lock another thread holds, and a
+// worker whose heap is empty steals the most urgent task of another worker.
+// Tasks pushed by other threads are spread over the heaps round robin.
+// Priorities (see CompareNodeTaskTime) are thus only kept per worker.
+//
+// Workers only sleep on the condition variable when no heap has a task, and
+// pushing a task only takes its mutex to wake a worker when one sleeps, so a
+// busy queue doesn't pay for wakeups.
+//
+// Shutdown tasks and the tasks waking up the owner of a GraphTask (see Note
+// [Reentrant backwards]) are meant for a specific worker, so they are pushed
+// onto a list of its own that other workers never steal from.
 struct ReadyQueue {
-  std::priority_queue<NodeTask, std::vector<NodeTask>, CompareNodeTaskTime> heap_;
-  // To notify threads waiting on the ReadyQueue of available tasks on the heap_
-  std::condition_variable not_empty_;
-  // To protect read and writes to heap_
-  mutable std::mutex mutex_;
+  explicit ReadyQueue(size_t num_workers);
 
   // incrementOutstandingTasks indicates whether or not we should increment
   // 'outstanding_tasks_' for the associated GraphTask. This should mostly
   // always be true, see the doc for 'enqueue_blocked_task_on_cpu' for when we
   // might set this to false.
   void push(NodeTask item, bool incrementOutstandingTasks = true);
+  // Pushes a task that only the given worker runs.
+  void pushToWorker(size_t worker, NodeTask item);
   void pushShutdownTask();
-  NodeTask pop();
+  NodeTask pop(size_t worker);
   size_t size() const;
+
+  // Returns the index of the worker the calling thread serves the queue as.
+  size_t registerWorker();
+
+ private:
+  struct Worker {
+    std::priority_queue<NodeTask, std::vector<NodeTask>, CompareNodeTaskTime> heap_;
+    // Tasks no other worker may run. They run before the ones on the heap_.
+    std::deque<NodeTask> own_tasks_;
+    std::atomic<size_t> num_own_tasks_{0};
+    // To protect reads and writes to heap_ and own_tasks_
+    mutable std::mutex mutex_;
+  };
+
+  c10::optional<NodeTask> tryPop(size_t worker);
+  void wakeUp(bool all);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> num_registered_workers_{0};
+  // The worker that gets the next task pushed by another thread
+  std::atomic<size_t> next_worker_{0};
+  // The number of tasks on all heaps. It is incremented before a task is
+  // pushed, so it may briefly count a task that isn't there yet, but never
+  // misses one.
+  std::atomic<size_t> num_tasks_{0};
+  // The number of workers about to wait, or waiting, on not_empty_
+  std::atomic<size_t> num_sleeping_workers_{0};
+  // To notify workers waiting on the ReadyQueue of available tasks
+  std::condition_variable not_empty_;
+  std::mutex sleep_mutex_;
 };
 
 // Note [Reentrant backwards]
@@ -158,45 +210,142 @@ int NodeTask::getReentrantDepth() const {
   return graph_task->reentrant_depth_;
 }
 
+ReadyQueue::ReadyQueue(size_t num_workers) {
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back(make_unique<Worker>());
+  }
+}
+
+size_t ReadyQueue::registerWorker() {
+  auto worker = num_registered_workers_++;
+  TORCH_INTERNAL_ASSERT(worker < workers_.size());
+  return worker;
+}
+
 auto ReadyQueue::push(NodeTask item, bool incrementOutstandingTasks) -> void {
+  if (incrementOutstandingTasks) {
+    std::shared_ptr<GraphTask> graph_task = item.base_.lock();
+    TORCH_INTERNAL_ASSERT(graph_task, "GraphTask is no longer valid!");
+    ++graph_task->outstanding_tasks_;
+  }
+  auto& worker = worker_queue == this
+      ? *workers_[worker_index]
+      : *workers_[next_worker_++ % workers_.size()];
+  ++num_tasks_;
   {
     // Lock mutex for writing to heap_
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (incrementOutstandingTasks) {
-      std::shared_ptr<GraphTask> graph_task = item.base_.lock();
-      TORCH_INTERNAL_ASSERT(graph_task, "GraphTask is no longer valid!");
-      ++graph_task->outstanding_tasks_;
-    }
-    heap_.push(std::move(item));
+    std::lock_guard<std::mutex> lock(worker.mutex_);
+    worker.heap_.push(std::move(item));
+  }
+  wakeUp(/* all */ false);
+}
+
+auto ReadyQueue::pushToWorker(size_t worker_idx, NodeTask item) -> void {
+  std::shared_ptr<GraphTask> graph_task = item.base_.lock();
+  TORCH_INTERNAL_ASSERT(graph_task, "GraphTask is no longer valid!");
+  ++graph_task->outstanding_tasks_;
+  auto& worker = *workers_.at(worker_idx);
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex_);
+    worker.own_tasks_.push_back(std::move(item));
+    ++worker.num_own_tasks_;
   }
-  not_empty_.notify_one();
+  // The worker may not be the one notify_one() would wake up.
+  wakeUp(/* all */ true);
 }
 
 auto ReadyQueue::pushShutdownTask() -> void {
+  for (auto& worker : workers_) {
+    std::lock_guard<std::mutex> lock(worker->mutex_);
+    worker->own_tasks_.push_back(NodeTask({}, nullptr, InputBuffer(0), true));
+    ++worker->num_own_tasks_;
+  }
+  wakeUp(/* all */ true);
+}
+
+void ReadyQueue::wakeUp(bool all) {
+  // A worker increments num_sleeping_workers_ before checking for tasks for
+  // the last time, and we counted the task before getting here, so either it
+  // sees the task or we see it sleeping.
+  if (num_sleeping_workers_.load() == 0) {
+    return;
+  }
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    heap_.push(NodeTask({}, nullptr, InputBuffer(0), true));
+    // Makes sure that the worker is waiting rather than about to, or it would
+    // miss the notification.
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+  }
+  if (all) {
+    not_empty_.notify_all();
+  } else {
+    not_empty_.notify_one();
   }
-  not_empty_.notify_one();
 }
 
 size_t ReadyQueue::size() const {
-  // Lock mutex for accesses to heap_
-  std::unique_lock<std::mutex> lock(mutex_);
-  return heap_.size();
+  size_t size = 0;
+  for (const auto& worker : workers_) {
+    // Lock mutex for accesses to heap_
+    std::lock_guard<std::mutex> lock(worker->mutex_);
+    size += worker->heap_.size() + worker->own_tasks_.size();
+  }
+  return size;
 }
 
-auto ReadyQueue::pop() -> NodeTask {
-  // Lock mutex for accesses to heap_
-  std::unique_lock<std::mutex> lock(mutex_);
-  not_empty_.wait(lock, [this]{ return !heap_.empty(); });
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-  auto task = std::move(const_cast<NodeTask&>(heap_.top())); heap_.pop();
-  return task;
+auto ReadyQueue::tryPop(size_t worker_idx) -> c10::optional<NodeTask> {
+  auto& worker = *workers_[worker_idx];
+  {
+    // Lock mutex for accesses to heap_
+    std::lock_guard<std::mutex> lock(worker.mutex_);
+    if (!worker.own_tasks_.empty()) {
+      c10::optional<NodeTask> task(std::move(worker.own_tasks_.front()));
+      worker.own_tasks_.pop_front();
+      --worker.num_own_tasks_;
+      return task;
+    }
+    if (!worker.heap_.empty()) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+      c10::optional<NodeTask> task(
+          std::move(const_cast<NodeTask&>(worker.heap_.top())));
+      worker.heap_.pop();
+      --num_tasks_;
+      return task;
+    }
+  }
+  // Steal the most urgent task of the next worker that has one.
+  for (size_t i = 1; i < workers_.size() && num_tasks_.load() > 0; ++i) {
+    auto& victim = *workers_[(worker_idx + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex_);
+    if (!victim.heap_.empty()) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+      c10::optional<NodeTask> task(
+          std::move(const_cast<NodeTask&>(victim.heap_.top())));
+      victim.heap_.pop();
+      --num_tasks_;
+      return task;
+    }
+  }
+  return c10::nullopt;
+}
+
+auto ReadyQueue::pop(size_t worker_idx) -> NodeTask {
+  auto& worker = *workers_[worker_idx];
+  while (true) {
+    if (auto task = tryPop(worker_idx)) {
+      return std::move(*task);
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    ++num_sleeping_workers_;
+    not_empty_.wait(lock, [this, &worker] {
+      return num_tasks_.load() > 0 || worker.num_own_tasks_.load() > 0;
+    });
+    --num_sleeping_workers_;
+  }
 }
 
 // This limit is based on the default python recursion limit which is 1000
-Engine::Engine() : max_recursion_depth_(100) {}
+Engine::Engine() : max_recursion_depth_(100), num_cpu_workers_(1) {}
 
 // Send shutdown tasks to all ReadyQueues if no backward tasks are running
 // Even though readyQueue should be empty, shutdown tasks have the highest
@@ -204,8 +353,7 @@ Engine::Engine() : max_recursion_depth_(100) {}
 Engine::~Engine() {
   bool noBackward = true;
   for (auto& queue: ready_queues_) {
-    std::lock_guard<std::mutex> lock(queue->mutex_);
-    noBackward =  noBackward && queue->heap_.empty();
+    noBackward =  noBackward && queue->size() == 0;
   }
   if (noBackward) {
     for (auto& queue : ready_queues_) {
@@ -255,6 +403,8 @@ auto Engine::thread_init(int device) -> void {
   // arbitrarily picked to colocate devices.  Maybe the other approach is
   // better.
   set_device(device);
+  worker_queue = &ready_queue_by_index(device);
+  worker_index = worker_queue->registerWorker();
   std::shared_ptr<GraphTask> graph_task = nullptr;
   thread_main(graph_task, /* reentrant_thread */ false);
 }
@@ -284,7 +434,7 @@ auto Engine::thread_main(
   // Why the test on graph_task->outstanding_tasks_?  See
   // Note [Reentrant backwards]
   while (!reentrant_thread || graph_task->outstanding_tasks_ > 0) {
-    NodeTask task = queue->pop();
+    NodeTask task = queue->pop(worker_index);
     // This will only work if the worker is running a non backward task
     // TODO Needs to be fixed this to work in all cases
     if (task.isShutdownTask_) {
@@ -327,18 +477,20 @@ auto Engine::thread_main(
     } else {
       // If it's a task initiated from this thread, decrease the counter, but
       // don't do anything - loop condition will do all checks for us next.
-      if (base_owner == worker_device) {
+      if (base_owner == worker_device &&
+          local_graph_task->owner_worker_ == worker_index) {
         --local_graph_task->outstanding_tasks_;
         // Otherwise send a dummy function task to the owning thread just to
         // ensure that it's not sleeping. If it has work, it might see that
         // graph_task->outstanding_tasks_ == 0 before it gets to the task, but
         // it's a no-op anyway.
-      } else if (base_owner != worker_device) {
+      } else {
         if (--local_graph_task->outstanding_tasks_ == 0) {
           // Synchronize outstanding_tasks_ with queue mutex
           std::atomic_thread_fence(std::memory_order_release);
-          ready_queue_by_index(base_owner)
-              .push(NodeTask(local_graph_task, nullptr, InputBuffer(0)));
+          ready_queue_by_index(base_owner).pushToWorker(
+              local_graph_task->owner_worker_,
+              NodeTask(local_graph_task, nullptr, InputBuffer(0)));
         }
       }
     }
@@ -372,6 +524,9 @@ void Engine::reentrant_thread_init() {
       continue;
     }
     set_device(graph_task->owner_);
+    // Stands in for the owner, which waits for the graph task to complete.
+    worker_queue = &ready_queue_by_index(graph_task->owner_);
+    worker_index = graph_task->owner_worker_;
     total_depth = graph_task->reentrant_depth_;
     thread_main(graph_task, /* reentrant thread*/ true);
   }
@@ -742,6 +897,12 @@ variable_list Engine::execute_with_graph_task(
   // Lock mutex for GraphTask.
   std::unique_lock<std::mutex> lock(graph_task->mutex_);
 
+  // Set before pushing the root, since another CPU worker may run it.
+  if (worker_device != NO_DEVICE) {
+    graph_task->owner_ = worker_device;
+    graph_task->owner_worker_ = worker_index;
+  }
+
   ready_queue(at::kCPU).push(
       NodeTask(graph_task, std::move(graph_root), InputBuffer(0)));
 
@@ -751,7 +912,6 @@ variable_list Engine::execute_with_graph_task(
     graph_task->not_done_.wait(
         lock, [&graph_task] { return graph_task_completed(*graph_task); });
   } else {
-    graph_task->owner_ = worker_device;
     ++total_depth;
     if(current_depth >= max_recursion_depth_){
       // See Note [Reentrant backwards]
@@ -836,6 +996,15 @@ bool Engine::is_checkpoint_valid() {
   return checkpoint_valid;
 }
 
+void Engine::set_num_cpu_workers(size_t num_workers) {
+  TORCH_CHECK(num_workers > 0, "Expected at least one CPU worker");
+  TORCH_CHECK(
+      ready_queues_.empty(),
+      "The number of CPU workers can only be set before the first backward "
+      "pass");
+  num_cpu_workers_ = num_workers;
+}
+
 size_t Engine::ready_queue_size(at::Device device) {
   if (ready_queues_.empty()) {
     // The vector ready_queues_ is initialized in start_threads, but this method
@@ -874,14 +1043,20 @@ auto Engine::start_threads() -> void {
 
   // One for CPU, plus one for every GPU device (but colocate GPUs of different
   // types)
-  int num_threads = num_devices + 1;
-  ready_queues_ = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
-  for (auto& queue : ready_queues_)
-    queue.reset(new ReadyQueue());
+  int num_queues = num_devices + 1;
+  ready_queues_ = std::vector<std::shared_ptr<ReadyQueue>>(num_queues);
+  for (int i = 0; i < num_queues; ++i) {
+    ready_queues_[i] =
+        std::make_shared<ReadyQueue>(i == 0 ? num_cpu_workers_ : 1);
+  }
 
   thread_pool_shared_ = std::make_shared<ThreadPoolShared>();
 
-  for (int i = 0; i < num_threads; ++i) {
+  for (size_t i = 0; i < num_cpu_workers_; ++i) {
+    std::thread t(&Engine::thread_init, this, -1);
+    t.detach();
+  }
+  for (int i = 1; i < num_queues; ++i) {
     std::thread t(&Engine::thread_init, this, i - 1);
     t.detach();
   }
@@ -87,6 +87,10 @@ struct GraphTask {
   // See Note [Reentrant backwards]
   // Safe to read owner_ and reentrant_depth_ without synchronizaton
   int owner_;
+  // The worker of the ready queue of owner_ that created this task, which is
+  // the only one that may be woken up when it finishes.
+  // See Note [Work stealing ready queues]
+  size_t owner_worker_;
   // The number of parent graph tasks for this graph task
   const int reentrant_depth_;
 
@@ -113,6 +117,7 @@ struct GraphTask {
         keep_graph_(keep_graph),
         grad_mode_(grad_mode),
         owner_(NO_DEVICE),
+        owner_worker_(0),
         reentrant_depth_(reentrant_depth),
         exit_on_error_(exit_on_error) {}
 };
@@ -193,6 +198,12 @@ struct TORCH_API Engine {
 
   size_t ready_queue_size(at::Device device);
 
+  // Sets the number of threads executing CPU tasks, which is 1 by default.
+  // More threads let independent branches of the graph run in parallel, at
+  // the cost of not running the CPU tasks of a graph in a deterministic
+  // order anymore. Must be called before the first backward pass.
+  void set_num_cpu_workers(size_t num_workers);
+
  protected:
   void compute_dependencies(Node* root, GraphTask& task);
   void evaluate_function(
@@ -223,6 +234,8 @@ struct TORCH_API Engine {
   std::mutex post_callbacks_lock_;
   // How many nested reentrant calls are allowed until a new thread is used
   int max_recursion_depth_;
+  // The number of threads serving the CPU ready queue
+  size_t num_cpu_workers_;
 
   struct ThreadPoolShared {
     // Data structures used by the threads for executing reentrant backwards
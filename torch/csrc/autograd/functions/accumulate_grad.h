@@ -4,6 +4,8 @@
 #include <torch/csrc/autograd/variable.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
 
+#include <mutex>
+
 namespace torch { namespace autograd {
 
 struct TORCH_API AccumulateGrad : public Node {
@@ -12,6 +14,10 @@ struct TORCH_API AccumulateGrad : public Node {
   variable_list apply(variable_list&& grads) override;
 
   Variable variable;
+
+  // Serializes apply(), which several CPU workers of the engine may call at
+  // once for graphs sharing this leaf.
+  std::mutex mutex_;
 };
 
 }} // namespace torch::autograd
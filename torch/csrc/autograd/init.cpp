@@ -2,6 +2,9 @@
 
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/utils/pybind.h>
+#include <torch/csrc/autograd/activation_offload.h>
+#include <torch/csrc/autograd/continuous_profiler.h>
+#include <torch/csrc/autograd/engine.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/autograd/python_function.h>
@@ -52,9 +55,63 @@ PyObject* THPAutograd_initExtension(PyObject* _unused, PyObject *unused) {
   m.def("_disable_profiler", disableProfiler);
   m.def("_profiler_enabled", profilerEnabled);
 
+  py::enum_<TraceFormat>(m, "TraceFormat")
+      .value("ChromeTrace", TraceFormat::ChromeTrace)
+      .value("Binary", TraceFormat::Binary);
+
+  py::class_<ContinuousProfilerConfig>(m, "ContinuousProfilerConfig")
+      .def(py::init<std::string>())
+      .def_readwrite("path", &ContinuousProfilerConfig::path)
+      .def_readwrite("format", &ContinuousProfilerConfig::format)
+      .def_readwrite("sampling_rate", &ContinuousProfilerConfig::sampling_rate)
+      .def_readwrite("buffer_size", &ContinuousProfilerConfig::buffer_size)
+      .def_readwrite(
+          "flush_interval_ms", &ContinuousProfilerConfig::flush_interval_ms);
+
+  py::class_<ContinuousProfilerStats>(m, "ContinuousProfilerStats")
+      .def_readonly("recorded", &ContinuousProfilerStats::recorded)
+      .def_readonly("dropped", &ContinuousProfilerStats::dropped);
+
+  m.def("_enable_continuous_profiler", enableContinuousProfiler);
+  m.def("_disable_continuous_profiler", disableContinuousProfiler);
+  m.def("_continuous_profiler_enabled", continuousProfilerEnabled);
+  m.def("_continuous_profiler_stats", continuousProfilerStats);
+
   m.def("_push_range", [](std::string name) { pushRange(std::move(name)); });
   m.def("_pop_range", []() { popRange(); });
 
+  using namespace torch::autograd;
+  py::enum_<OffloadMode>(m, "OffloadMode")
+      .value("Half", OffloadMode::Half)
+      .value("Int8", OffloadMode::Int8)
+      .value("Spill", OffloadMode::Spill);
+
+  py::class_<OffloadConfig>(m, "OffloadConfig")
+      .def(py::init<size_t>())
+      .def_readwrite("memory_budget", &OffloadConfig::memory_budget)
+      .def_readwrite("mode", &OffloadConfig::mode)
+      .def_readwrite("spill_file", &OffloadConfig::spill_file)
+      .def_readwrite("spill_budget", &OffloadConfig::spill_budget)
+      .def_readwrite("min_bytes", &OffloadConfig::min_bytes);
+
+  py::class_<OffloadStats>(m, "OffloadStats")
+      .def_readonly("resident_bytes", &OffloadStats::resident_bytes)
+      .def_readonly("offloaded", &OffloadStats::offloaded)
+      .def_readonly("bytes_saved", &OffloadStats::bytes_saved)
+      .def_readonly("restored", &OffloadStats::restored)
+      .def_readonly("restore_time_ns", &OffloadStats::restore_time_ns);
+
+  m.def("_enable_activation_offload", enableActivationOffload);
+  m.def("_disable_activation_offload", disableActivationOffload);
+  m.def("_activation_offload_enabled", activationOffloadEnabled);
+  m.def("_activation_offload_stats", activationOffloadStats);
+  m.def("_reset_activation_offload_stats", resetActivationOffloadStats);
+
+  m.def("_set_num_autograd_cpu_workers", [](size_t num_workers) {
+    torch::autograd::Engine::get_default_engine().set_num_cpu_workers(
+        num_workers);
+  });
+
   Py_RETURN_TRUE;
 }
 
@@ -0,0 +1,247 @@
+#include <torch/csrc/autograd/op_stats.h>
+
+#include <torch/csrc/autograd/profiler.h>
+#include <torch/csrc/autograd/record_function.h>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/util/string_view.h>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace torch { namespace autograd { namespace profiler {
+
+constexpr int LatencyHistogram::kSubBucketBits;
+constexpr int64_t LatencyHistogram::kSubBucketCount;
+
+size_t LatencyHistogram::bucketIndex(int64_t value) {
+  if (value < kSubBucketCount) {
+    return static_cast<size_t>(std::max<int64_t>(value, 0));
+  }
+  int exponent = 63;
+  while (!(value & (int64_t(1) << exponent))) {
+    --exponent;
+  }
+  const int shift = exponent - kSubBucketBits;
+  const auto sub_bucket = (value >> shift) - kSubBucketCount;
+  return kSubBucketCount + shift * kSubBucketCount + sub_bucket;
+}
+
+int64_t LatencyHistogram::bucketUpperBound(size_t index) {
+  if (index < static_cast<size_t>(kSubBucketCount)) {
+    return index;
+  }
+  const auto shift = (index - kSubBucketCount) / kSubBucketCount;
+  const auto sub_bucket = (index - kSubBucketCount) % kSubBucketCount;
+  return ((kSubBucketCount + sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t value) {
+  value = std::max<int64_t>(value, 0);
+  const auto index = bucketIndex(value);
+  if (index >= counts_.size()) {
+    counts_.resize(index + 1);
+  }
+  ++counts_[index];
+  min_ = count_ == 0 ? value : std::min(min_, value);
+  max_ = std::max(max_, value);
+  sum_ += value;
+  ++count_;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  if (other.counts_.size() > counts_.size()) {
+    counts_.resize(other.counts_.size());
+  }
+  for (size_t i = 0; i < other.counts_.size(); ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+  count_ += other.count_;
+}
+
+int64_t LatencyHistogram::percentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  const auto rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(bucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+namespace {
+
+// FNV-1a over the bytes of a view. std::hash<c10::string_view> copies the
+// view into a std::string to hash it.
+struct StringViewHash {
+  size_t operator()(c10::string_view s) const {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : s) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+  }
+};
+
+// The stats of one thread. The owning thread is the only one recording
+// into it, and the mutex is only contended while a snapshot is taken.
+struct Shard {
+  struct Entry {
+    explicit Entry(std::string name) : name(std::move(name)) {}
+    const std::string name;
+    OpStats stats;
+  };
+
+  std::mutex mutex;
+  // Keyed by views of Entry::name, so that looking up an op doesn't need to
+  // copy its name.
+  std::unordered_map<c10::string_view, std::unique_ptr<Entry>, StringViewHash>
+      entries;
+
+  void record(const char* name, int64_t latency, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(c10::string_view(name));
+    if (it == entries.end()) {
+      auto entry = std::unique_ptr<Entry>(new Entry(name));
+      const c10::string_view key(entry->name);
+      it = entries.emplace(key, std::move(entry)).first;
+    }
+    auto& stats = it->second->stats;
+    ++stats.calls;
+    stats.cpu_bytes_allocated += bytes;
+    stats.latency.record(latency);
+  }
+
+  // Must be called with the mutex held.
+  void mergeInto(OpStatsSnapshot& snapshot) const {
+    for (const auto& entry : entries) {
+      auto& stats = snapshot[entry.second->name];
+      stats.calls += entry.second->stats.calls;
+      stats.cpu_bytes_allocated += entry.second->stats.cpu_bytes_allocated;
+      stats.latency.merge(entry.second->stats.latency);
+    }
+  }
+};
+
+// What an op looked like when it started.
+struct Start {
+  int64_t time;
+  uint64_t cpu_allocated_bytes;
+};
+
+std::mutex shards_mutex;
+std::list<std::shared_ptr<Shard>> shards;
+// Stats of threads that exited since the last reset.
+OpStatsSnapshot retired_stats;
+bool enabled = false;
+// Incremented when the stats are enabled, to tell stale per-thread state
+// apart.
+uint64_t generation = 0;
+
+thread_local std::shared_ptr<Shard> thread_shard;
+thread_local std::vector<Start> thread_starts;
+thread_local uint64_t thread_generation = 0;
+
+Shard& threadShard() {
+  if (!thread_shard) {
+    thread_shard = std::make_shared<Shard>();
+    std::lock_guard<std::mutex> lock(shards_mutex);
+    shards.push_back(thread_shard);
+  }
+  return *thread_shard;
+}
+
+std::vector<Start>& threadStarts() {
+  // Ops that were running while the stats got disabled never ended.
+  if (thread_generation != generation) {
+    thread_generation = generation;
+    thread_starts.clear();
+  }
+  return thread_starts;
+}
+
+} // namespace
+
+void enableOpStats() {
+  TORCH_CHECK(!enabled, "Op stats are already enabled");
+  ++generation;
+  pushCallback(
+      [](const RecordFunction& /* unused */) {
+        threadStarts().push_back(
+            {getTime(), c10::getThreadLocalCPUAllocatedBytes()});
+      },
+      [](const RecordFunction& fn) {
+        auto& starts = threadStarts();
+        // The op may have started before the stats were enabled.
+        if (starts.empty()) {
+          return;
+        }
+        const auto start = starts.back();
+        starts.pop_back();
+        threadShard().record(
+            fn.name().str(),
+            getTime() - start.time,
+            c10::getThreadLocalCPUAllocatedBytes() - start.cpu_allocated_bytes);
+      });
+  enabled = true;
+}
+
+void disableOpStats() {
+  TORCH_CHECK(enabled, "Op stats are not enabled");
+  popCallback();
+  enabled = false;
+}
+
+bool opStatsEnabled() {
+  return enabled;
+}
+
+OpStatsSnapshot snapshotOpStats(bool reset) {
+  std::lock_guard<std::mutex> lock(shards_mutex);
+  OpStatsSnapshot snapshot = retired_stats;
+  for (auto it = shards.begin(); it != shards.end();) {
+    auto& shard = *it;
+    {
+      std::lock_guard<std::mutex> shard_lock(shard->mutex);
+      shard->mergeInto(snapshot);
+      if (reset) {
+        shard->entries.clear();
+      }
+    }
+    // The thread exited, so nobody will record into the shard anymore.
+    if (shard.use_count() == 1) {
+      if (!reset) {
+        std::lock_guard<std::mutex> shard_lock(shard->mutex);
+        shard->mergeInto(retired_stats);
+      }
+      it = shards.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (reset) {
+    retired_stats.clear();
+  }
+  return snapshot;
+}
+
+void resetOpStats() {
+  snapshotOpStats(/* reset */ true);
+}
+
+}}} // namespace torch::autograd::profiler
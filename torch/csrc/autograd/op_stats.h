@@ -0,0 +1,85 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace torch { namespace autograd { namespace profiler {
+
+// A histogram of non-negative values (latencies in ns here) with a bounded
+// relative error, in the spirit of HdrHistogram: values below 16 have a
+// bucket each, and every power of two above is split into 16 buckets, so a
+// bucket is at most 1/16th of its values wide.
+class TORCH_API LatencyHistogram {
+ public:
+  void record(int64_t value);
+  void merge(const LatencyHistogram& other);
+
+  uint64_t count() const {
+    return count_;
+  }
+  int64_t min() const {
+    return count_ == 0 ? 0 : min_;
+  }
+  int64_t max() const {
+    return max_;
+  }
+  int64_t sum() const {
+    return sum_;
+  }
+
+  // Returns the largest value that falls into the same bucket as the value
+  // below which `percentile` percent of the recorded values are, e.g.
+  // percentile(99) for the p99. Returns 0 if nothing was recorded.
+  int64_t percentile(double percentile) const;
+
+ private:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int64_t kSubBucketCount = int64_t(1) << kSubBucketBits;
+
+  static size_t bucketIndex(int64_t value);
+  static int64_t bucketUpperBound(size_t index);
+
+  // Grown on demand, up to the bucket of the largest value recorded.
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  int64_t min_ = 0;
+  int64_t max_ = 0;
+  int64_t sum_ = 0;
+};
+
+struct TORCH_API OpStats {
+  uint64_t calls = 0;
+  // Bytes allocated by the CPU allocators (the default and the caching one)
+  // while the op ran.
+  uint64_t cpu_bytes_allocated = 0;
+  // Wall time of the op, in ns.
+  LatencyHistogram latency;
+};
+
+// Keyed by the name of the RecordFunction, e.g. "aten::add".
+using OpStatsSnapshot = std::unordered_map<std::string, OpStats>;
+
+// Aggregates the calls, latency and allocations of every operator that goes
+// through RecordFunction, without keeping the events themselves. Stats are
+// kept per thread, so recording only takes a lock nobody else holds, except
+// while a snapshot is taken. Nested ops count towards their parent as well.
+//
+// NOTE: like enableProfiler(), enabling and disabling is **NOT THREAD SAFE**
+// with respect to operators running concurrently, and pushes or pops a
+// RecordFunction callback.
+TORCH_API void enableOpStats();
+TORCH_API void disableOpStats();
+TORCH_API bool opStatsEnabled();
+
+// Returns the stats recorded since they were last reset, merged across
+// threads. Resets them as well if `reset` is true.
+TORCH_API OpStatsSnapshot snapshotOpStats(bool reset = false);
+TORCH_API void resetOpStats();
+
+} // namespace profiler
+}} // namespace torch::autograd
@@ -20,6 +20,7 @@ class CallbackManager {
       sampling_prop_set = true;
     }
     sampling_prob = prob;
+    ++sampling_generation;
   }
 
   double getSamplingProbability() {
@@ -27,8 +28,7 @@ class CallbackManager {
   }
 
   bool shouldRunSampledCallbacks() {
-    return (num_sampled_callbacks > 0) &&
-        (!sampling_prop_set || (sample_zero_one() < sampling_prob));
+    return (num_sampled_callbacks > 0) && (!sampling_prop_set || sample());
   }
 
   void pushCallback(
@@ -81,11 +81,36 @@ class CallbackManager {
   size_t callback_needs_inputs = 0;
   bool sampling_prop_set = false;
   double sampling_prob = 1.0;
+  // Incremented when sampling_prob changes, so that threads redraw the
+  // number of calls they skip.
+  uint64_t sampling_generation = 0;
+
+  // Sampling each call with probability sampling_prob is the same as skipping
+  // a geometrically distributed number of calls between two samples. This
+  // only costs a decrement for calls that aren't sampled, instead of drawing
+  // a random number for every call.
+  bool sample() {
+    static thread_local int64_t calls_to_skip = 0;
+    static thread_local uint64_t thread_generation = 0;
+    if (sampling_prob == 0.0) {
+      return false;
+    }
+    if (thread_generation != sampling_generation) {
+      thread_generation = sampling_generation;
+      calls_to_skip = draw_calls_to_skip();
+    }
+    if (calls_to_skip > 0) {
+      --calls_to_skip;
+      return false;
+    }
+    calls_to_skip = draw_calls_to_skip();
+    return true;
+  }
 
-  static double sample_zero_one() {
+  int64_t draw_calls_to_skip() {
     static thread_local auto gen =
         torch::make_unique<std::mt19937>(std::random_device()());
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::geometric_distribution<int64_t> dist(sampling_prob);
     return dist(*gen);
   }
 };
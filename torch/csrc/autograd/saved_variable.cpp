@@ -33,11 +33,18 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output, bool is_i
     }
     version_counter_ = impl::version_counter(variable);
     saved_version_ = version_counter_.current_version();
+
+    if (has_grad_fn_ && activationOffloadEnabled()) {
+      offloaded_ = detail::offloadActivation(data_, resident_bytes_);
+      if (offloaded_) {
+        data_.reset();
+      }
+    }
   }
 }
 
 Variable SavedVariable::unpack(std::shared_ptr<Node> saved_for) const {
-  if (!data_.defined()) {
+  if (!data_.defined() && !offloaded_) {
     if (!was_default_constructed_) {
       throw std::runtime_error(ERR_BACKWARD_TWICE);
     }
@@ -54,11 +61,13 @@ Variable SavedVariable::unpack(std::shared_ptr<Node> saved_for) const {
     grad_fn = std::move(saved_for);
   }
 
+  const auto data = offloaded_ ? offloaded_->restore() : data_;
+
   if (saved_version_ != version_counter_.current_version()) {
     std::stringstream message;
     message << "one of the variables needed for gradient computation has been "
-        "modified by an inplace operation: [" << data_.toString() << " "
-        << data_.sizes() << "]";
+        "modified by an inplace operation: [" << data.toString() << " "
+        << data.sizes() << "]";
     if (grad_fn) {
         message << ", which is output " << output_nr_
             << " of " << grad_fn->name() << ",";
@@ -83,9 +92,9 @@ Variable SavedVariable::unpack(std::shared_ptr<Node> saved_for) const {
   // in-place functions on unpacked variables.
   Variable var;
   if (grad_fn) {
-    var = make_variable(data_, Edge(std::move(grad_fn), output_nr_));
+    var = make_variable(data, Edge(std::move(grad_fn), output_nr_));
   } else {
-    var = make_variable(data_, requires_grad_);
+    var = make_variable(data, requires_grad_);
   }
   impl::set_version_counter(var, saved_version_);
 
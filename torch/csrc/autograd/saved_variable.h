@@ -1,6 +1,7 @@
 #pragma once
 
 #include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/autograd/activation_offload.h>
 
 #include <ATen/ATen.h>
 
@@ -29,7 +30,9 @@ class TORCH_API SavedVariable {
   Variable unpack(std::shared_ptr<Node> saved_for = nullptr) const;
 
   void reset_data() {
-    return data_.reset();
+    data_.reset();
+    offloaded_.reset();
+    resident_bytes_.reset();
   }
 
   void reset_grad_function() {
@@ -38,6 +41,10 @@ class TORCH_API SavedVariable {
 
  private:
   at::Tensor data_;
+  // Set instead of data_ if the variable is an activation that was offloaded.
+  // See Note [Activation offloading]
+  std::unique_ptr<detail::OffloadedActivation> offloaded_;
+  detail::ResidentBytes resident_bytes_;
 
   // The gradient function associated with this node. If has_grad_fn
   // is false, then this is a leaf node. Note that the grad_fn is not saved if
@@ -0,0 +1,271 @@
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <ATen/CPUGenerator.h>
+#include <ATen/Parallel.h>
+#include <c10/util/Exception.h>
+
+namespace c10d {
+
+C10_DEFINE_SHARED_REGISTRY(
+    CommHookRegistry,
+    CommHook,
+    const CommHookOptions& /* options */);
+
+namespace {
+
+void checkOptions(
+    const CommHookOptions& options,
+    const std::vector<std::string>& known,
+    const char* hook) {
+  for (const auto& option : options) {
+    TORCH_CHECK(
+        std::find(known.begin(), known.end(), option.first) != known.end(),
+        "Unknown option for the ",
+        hook,
+        " comm hook: ",
+        option.first);
+  }
+}
+
+double getOption(
+    const CommHookOptions& options,
+    const std::string& name,
+    double defaultValue) {
+  const auto it = options.find(name);
+  return it == options.end() ? defaultValue : it->second;
+}
+
+void checkSingleReplica(const GradBucket& bucket, const char* hook) {
+  TORCH_CHECK(
+      bucket.tensors.size() == 1,
+      "The ",
+      hook,
+      " comm hook supports a single model replica per process.");
+}
+
+// Returns a future completed with the result of `fn` once all of `work`
+// has finished. The wait happens on the inter-op thread pool, so that the
+// caller can move on to the next bucket in the meantime.
+std::shared_ptr<GradBucketFuture> then(
+    std::vector<std::shared_ptr<ProcessGroup::Work>> work,
+    std::function<std::vector<at::Tensor>()> fn) {
+  auto future = std::make_shared<GradBucketFuture>();
+  at::launch([work, fn, future]() {
+    try {
+      for (const auto& w : work) {
+        w->wait();
+      }
+      future->markCompleted(fn());
+    } catch (const std::exception& e) {
+      future->setError(e.what());
+    }
+  });
+  return future;
+}
+
+std::shared_ptr<GradBucketFuture> allreduce(
+    ProcessGroup& process_group,
+    std::vector<at::Tensor> tensors) {
+  auto work = process_group.allreduce(tensors);
+  return then({work}, [tensors]() { return tensors; });
+}
+
+class Fp16CommHook : public CommHook {
+ public:
+  explicit Fp16CommHook(const CommHookOptions& options) {
+    checkOptions(options, {}, "fp16");
+  }
+
+  std::shared_ptr<GradBucketFuture> runHook(
+      ProcessGroup& process_group,
+      const GradBucket& bucket) override {
+    std::vector<at::Tensor> tensors;
+    tensors.reserve(bucket.tensors.size());
+    for (const auto& tensor : bucket.tensors) {
+      tensors.push_back(tensor.to(at::kHalf));
+    }
+    // The reducer casts the result back when it copies it into the bucket.
+    return allreduce(process_group, std::move(tensors));
+  }
+};
+
+// Every process contributes its `ratio` largest entries by magnitude. The
+// entries left out are added to the gradients of the next iteration, so that
+// all of the gradient is applied eventually.
+class TopKCommHook : public CommHook {
+ public:
+  explicit TopKCommHook(const CommHookOptions& options)
+      : ratio_(getOption(options, "ratio", 0.01)) {
+    checkOptions(options, {"ratio"}, "topk");
+    TORCH_CHECK(
+        ratio_ > 0 && ratio_ <= 1,
+        "Expected the ratio of the topk comm hook to be in (0, 1], got ",
+        ratio_);
+  }
+
+  std::shared_ptr<GradBucketFuture> runHook(
+      ProcessGroup& process_group,
+      const GradBucket& bucket) override {
+    checkSingleReplica(bucket, "topk");
+    const auto& grad = bucket.tensors[0];
+    const auto numel = grad.numel();
+    const auto k = std::min<int64_t>(
+        numel, std::max<int64_t>(1, std::ceil(ratio_ * numel)));
+
+    auto& residual = residuals_[bucket.index];
+    if (!residual.defined() || residual.numel() != numel) {
+      residual = at::zeros_like(grad);
+    }
+    auto corrected = grad + residual;
+    std::vector<at::Tensor> indices = {
+        std::get<1>(corrected.abs().topk(k, 0, true, false))};
+    std::vector<at::Tensor> values = {corrected.index_select(0, indices[0])};
+    residual = corrected.index_fill_(0, indices[0], 0);
+
+    const auto size = process_group.getSize();
+    std::vector<std::vector<at::Tensor>> allIndices(1);
+    std::vector<std::vector<at::Tensor>> allValues(1);
+    for (int i = 0; i < size; i++) {
+      allIndices[0].push_back(at::empty_like(indices[0]));
+      allValues[0].push_back(at::empty_like(values[0]));
+    }
+    auto indicesWork = process_group.allgather(allIndices, indices);
+    auto valuesWork = process_group.allgather(allValues, values);
+    return then({indicesWork, valuesWork}, [grad, allIndices, allValues]() {
+      auto result = at::zeros_like(grad);
+      for (size_t i = 0; i < allIndices[0].size(); i++) {
+        result.index_add_(0, allIndices[0][i], allValues[0][i]);
+      }
+      return std::vector<at::Tensor>{result};
+    });
+  }
+
+  void reset() override {
+    residuals_.clear();
+  }
+
+ private:
+  const double ratio_;
+
+  // Only used from runHook, which the reducer calls from a single thread.
+  std::unordered_map<size_t, at::Tensor> residuals_;
+};
+
+// Views the bucket as a roughly square matrix M and allreduces its rank `r`
+// approximation P Q^T in two steps: P = M Q, orthogonalized, then
+// Q = M^T P. Q is kept as the starting point of the next iteration, and the
+// approximation error is added to the gradients of the next iteration.
+class PowerSGDCommHook : public CommHook {
+ public:
+  explicit PowerSGDCommHook(const CommHookOptions& options)
+      : rank_(getOption(options, "rank", 2)) {
+    checkOptions(options, {"rank"}, "powersgd");
+    TORCH_CHECK(
+        rank_ >= 1,
+        "Expected the rank of the powersgd comm hook to be positive, got ",
+        rank_);
+  }
+
+  std::shared_ptr<GradBucketFuture> runHook(
+      ProcessGroup& process_group,
+      const GradBucket& bucket) override {
+    checkSingleReplica(bucket, "powersgd");
+    const auto& grad = bucket.tensors[0];
+    const auto numel = grad.numel();
+    const auto rows = static_cast<int64_t>(std::ceil(std::sqrt(numel)));
+    const auto cols = (numel + rows - 1) / rows;
+
+    // Small buckets don't get any smaller.
+    if (rank_ * (rows + cols) >= numel) {
+      return allreduce(process_group, bucket.tensors);
+    }
+
+    auto& state = states_[bucket.index];
+    if (!state || state->residual.numel() != numel) {
+      state = std::make_shared<State>();
+      state->residual = at::zeros_like(grad);
+      // Every process starts from the same Q, without communicating.
+      auto generator = at::detail::createCPUGenerator(bucket.index);
+      state->q = at::randn(
+                     {cols, rank_},
+                     generator.get(),
+                     grad.options().device(at::kCPU))
+                     .to(grad.device());
+    }
+
+    auto corrected = grad + state->residual;
+    auto matrix = at::zeros({rows * cols}, grad.options());
+    matrix.narrow(0, 0, numel).copy_(corrected);
+    matrix = matrix.view({rows, cols});
+
+    // The second step needs the reduced P, so the first one can't overlap
+    // with anything.
+    std::vector<at::Tensor> p = {matrix.mm(state->q)};
+    process_group.allreduce(p)->wait();
+    p[0] = std::get<0>(at::qr(p[0]));
+
+    std::vector<at::Tensor> q = {matrix.t().mm(p[0])};
+    auto work = process_group.allreduce(q);
+
+    // The next call for this bucket happens after the reducer waited for the
+    // returned future, so it sees the updated state.
+    auto currentState = state;
+    const auto size = process_group.getSize();
+    return then({work}, [currentState, corrected, p, q, numel, size]() {
+      auto approximation = p[0].mm(q[0].t()).view({-1}).narrow(0, 0, numel);
+      // The reducer divided the bucket by the number of processes, so
+      // `corrected` is this process' share of the sum that `approximation`
+      // approximates: the residuals of all processes add up to what was
+      // left out.
+      currentState->residual = corrected - approximation / size;
+      currentState->q = q[0];
+      return std::vector<at::Tensor>{approximation};
+    });
+  }
+
+  void reset() override {
+    states_.clear();
+  }
+
+ private:
+  struct State {
+    at::Tensor q;
+    at::Tensor residual;
+  };
+
+  const int64_t rank_;
+
+  std::unordered_map<size_t, std::shared_ptr<State>> states_;
+};
+
+std::shared_ptr<CommHook> makeFp16CommHook(const CommHookOptions& options) {
+  return std::make_shared<Fp16CommHook>(options);
+}
+
+std::shared_ptr<CommHook> makeTopKCommHook(const CommHookOptions& options) {
+  return std::make_shared<TopKCommHook>(options);
+}
+
+std::shared_ptr<CommHook> makePowerSGDCommHook(
+    const CommHookOptions& options) {
+  return std::make_shared<PowerSGDCommHook>(options);
+}
+
+} // namespace
+
+C10_REGISTER_CREATOR(CommHookRegistry, fp16, makeFp16CommHook);
+C10_REGISTER_CREATOR(CommHookRegistry, topk, makeTopKCommHook);
+C10_REGISTER_CREATOR(CommHookRegistry, powersgd, makePowerSGDCommHook);
+
+std::shared_ptr<CommHook> createCommHook(
+    const std::string& name,
+    const CommHookOptions& options) {
+  TORCH_CHECK(CommHookRegistry()->Has(name), "Unknown comm hook: ", name);
+  return CommHookRegistry()->Create(name, options);
+}
+
+} // namespace c10d
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <c10/util/Registry.h>
+#include <c10d/ProcessGroup.hpp>
+#include <torch/csrc/utils/future.h>
+
+namespace c10d {
+
+// The flattened gradients of a single bucket, as handed to a CommHook.
+struct GradBucket {
+  // Position of the bucket in the reduction order. It identifies the bucket
+  // across iterations, until the bucket assignment changes.
+  size_t index;
+
+  // One flat tensor per model replica. They are already divided by the
+  // world size, so summing them across processes yields the average.
+  std::vector<at::Tensor> tensors;
+};
+
+// Completed with the reduced bucket, one tensor per model replica. The
+// tensors may have a different dtype than the bucket; the reducer copies
+// them back into it.
+using GradBucketFuture = torch::utils::Future<std::vector<at::Tensor>>;
+
+// A CommHook replaces the allreduce the reducer runs on every dense bucket,
+// e.g. to compress gradients before they are sent over the network.
+class CommHook {
+ public:
+  virtual ~CommHook() = default;
+
+  // Called once per bucket and iteration, in bucket order, always from the
+  // same thread. Collectives issued from this function are therefore issued
+  // in the same order on all processes. The returned future must not depend
+  // on collectives issued by a later call.
+  //
+  // This runs concurrently with the rest of the backward pass, and the
+  // reducer only waits for the returned future at the end of it.
+  virtual std::shared_ptr<GradBucketFuture> runHook(
+      ProcessGroup& process_group,
+      const GradBucket& bucket) = 0;
+
+  // Called when the bucket assignment changes, to drop per-bucket state.
+  virtual void reset() {}
+};
+
+// Numeric options for the hooks in CommHookRegistry, e.g. {"ratio": 0.01}.
+using CommHookOptions = std::unordered_map<std::string, double>;
+
+// Hooks that can be created by name, including from Python. Extensions can
+// register their own with C10_REGISTER_CREATOR(CommHookRegistry, name, fn).
+//
+// Built in:
+//   fp16      Allreduces the bucket in half precision.
+//   topk      Allgathers only the `ratio` (default 0.01) largest entries of
+//             every process, and feeds the rest back into the next
+//             iteration (error feedback).
+//   powersgd  Allreduces a rank `rank` (default 2) approximation of the
+//             bucket, viewed as a matrix, with error feedback as well.
+C10_DECLARE_SHARED_REGISTRY(
+    CommHookRegistry,
+    CommHook,
+    const CommHookOptions& /* options */);
+
+std::shared_ptr<CommHook> createCommHook(
+    const std::string& name,
+    const CommHookOptions& options = {});
+
+} // namespace c10d
@@ -23,6 +23,7 @@
 
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/distributed/c10d/comm.h>
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
 #include <torch/csrc/distributed/c10d/ddp.h>
 #include <torch/csrc/distributed/c10d/reducer.h>
 #include <torch/csrc/utils/object_ptr.h>
@@ -116,17 +117,44 @@ PyObject* c10d_init(PyObject* _unused) {
 
   auto module = py::handle(c10d_module).cast<py::module>();
 
+  shared_ptr_class_<::c10d::CommHook>(module, "_CommHook");
+
+  module.def(
+      "_create_comm_hook",
+      &::c10d::createCommHook,
+      py::arg("name"),
+      py::arg("options") = ::c10d::CommHookOptions());
+
+  py::class_<::c10d::Reducer::OverlapStats>(module, "_OverlapStats")
+      .def_readonly(
+          "backward_time", &::c10d::Reducer::OverlapStats::backward_time)
+      .def_readonly(
+          "bucket_ready_times",
+          &::c10d::Reducer::OverlapStats::bucket_ready_times)
+      .def_readonly(
+          "exposed_communication_time",
+          &::c10d::Reducer::OverlapStats::exposed_communication_time)
+      .def_readonly(
+          "bucket_sizes", &::c10d::Reducer::OverlapStats::bucket_sizes)
+      .def_readonly(
+          "rebuilt_buckets", &::c10d::Reducer::OverlapStats::rebuilt_buckets)
+      .def_readonly(
+          "bucket_bytes_cap",
+          &::c10d::Reducer::OverlapStats::bucket_bytes_cap);
+
   shared_ptr_class_<::c10d::Reducer>(module, "Reducer")
       .def(
           py::init<
               std::vector<std::vector<torch::autograd::Variable>>,
               std::vector<std::vector<size_t>>,
               std::shared_ptr<::c10d::ProcessGroup>,
-              std::vector<std::vector<bool>>>(),
+              std::vector<std::vector<bool>>,
+              size_t>(),
           py::arg("replicas"),
           py::arg("bucket_indices"),
           py::arg("process_group"),
-          py::arg("expect_sparse_gradients") = std::vector<std::vector<bool>>())
+          py::arg("expect_sparse_gradients") = std::vector<std::vector<bool>>(),
+          py::arg("bucket_bytes_cap") = ::c10d::kDefaultBucketBytesCap)
       .def(
           "initialize_buckets",
           &::c10d::Reducer::initialize_buckets,
@@ -140,7 +168,13 @@ PyObject* c10d_init(PyObject* _unused) {
           [](::c10d::Reducer& reducer, const torch::autograd::Variable& output)
               -> void { reducer.prepare_for_backward({output}); },
           py::call_guard<py::gil_scoped_release>())
-      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats);
+      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats)
+      .def("get_overlap_stats", &::c10d::Reducer::get_overlap_stats)
+      .def(
+          "register_comm_hook",
+          &::c10d::Reducer::register_comm_hook,
+          py::arg("hook"),
+          py::call_guard<py::gil_scoped_release>());
 
   py::enum_<::c10d::ReduceOp>(module, "ReduceOp", R"(
 An enum-like class for available reduction operations: ``SUM``, ``PRODUCT``,
@@ -229,6 +263,34 @@ They are used in specifying strategies for reduction collectives, e.g.,
                     reinterpret_cast<char*>(value.data()), value.size());
               },
               py::call_guard<py::gil_scoped_release>())
+          .def(
+              "multi_set",
+              [](::c10d::Store& store,
+                 const std::vector<std::string>& keys,
+                 const std::vector<std::string>& values) {
+                std::vector<std::vector<uint8_t>> values_;
+                values_.reserve(values.size());
+                for (const auto& value : values) {
+                  values_.emplace_back(value.begin(), value.end());
+                }
+                store.multiSet(keys, values_);
+              },
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "multi_get",
+              [](::c10d::Store& store, const std::vector<std::string>& keys) {
+                std::vector<std::vector<uint8_t>> values;
+                {
+                  py::gil_scoped_release release;
+                  values = store.multiGet(keys);
+                }
+                py::list result;
+                for (auto& value : values) {
+                  result.append(py::bytes(
+                      reinterpret_cast<char*>(value.data()), value.size()));
+                }
+                return result;
+              })
           .def(
               "add",
               &::c10d::Store::add,
@@ -509,7 +571,14 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def(py::init<>())
       .def_readwrite("devices", &::c10d::ProcessGroupGloo::Options::devices)
       .def_readwrite("timeout", &::c10d::ProcessGroupGloo::Options::timeout)
-      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads);
+      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads)
+      .def_readwrite(
+          "hierarchicalAllreduce",
+          &::c10d::ProcessGroupGloo::Options::hierarchicalAllreduce)
+      .def_readwrite(
+          "hierarchicalChunkBytes",
+          &::c10d::ProcessGroupGloo::Options::hierarchicalChunkBytes)
+      .def_readwrite("hostId", &::c10d::ProcessGroupGloo::Options::hostId);
 
   processGroupGloo.def_static(
       "create_device",
@@ -1,5 +1,6 @@
 #include <torch/csrc/distributed/c10d/reducer.h>
 
+#include <algorithm>
 #include <functional>
 
 #include <c10/core/DeviceGuard.h>
@@ -37,13 +38,87 @@ inline int64_t current_time_in_nanos() {
   return torch::autograd::profiler::getTime();
 }
 
+// Buckets rebuilt from measurements are at least this large, unless the
+// bucket size cap is smaller.
+constexpr size_t kMinBucketBytes = 256 * 1024;
+
+// Largest allreduce used to measure the bandwidth of the process group.
+constexpr size_t kMaxProbeBytes = 4 * 1024 * 1024;
+
+// Stands in for a collective until the comm hook thread has issued it.
+class QueuedWork : public c10d::ProcessGroup::Work {
+ public:
+  void issued(std::shared_ptr<c10d::ProcessGroup::Work> work) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      work_ = std::move(work);
+    }
+    finish();
+  }
+
+  void failed(std::exception_ptr exception) {
+    finish(exception);
+  }
+
+  bool isCompleted() override {
+    return Work::isCompleted() &&
+        (!isSuccess() || issuedWork()->isCompleted());
+  }
+
+  bool wait() override {
+    Work::wait();
+    return issuedWork()->wait();
+  }
+
+  std::vector<at::Tensor> result() const override {
+    return issuedWork()->result();
+  }
+
+ private:
+  std::shared_ptr<c10d::ProcessGroup::Work> issuedWork() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TORCH_INTERNAL_ASSERT(work_);
+    return work_;
+  }
+
+  std::shared_ptr<c10d::ProcessGroup::Work> work_;
+};
+
+// The work of a comm hook, completed with the future it returned.
+class CommHookWork : public c10d::ProcessGroup::Work {
+ public:
+  explicit CommHookWork(std::shared_ptr<GradBucketFuture> future)
+      : future_(std::move(future)) {}
+
+  bool isCompleted() override {
+    return future_->completed();
+  }
+
+  bool isSuccess() const override {
+    return !future_->hasError();
+  }
+
+  bool wait() override {
+    future_->wait();
+    return true;
+  }
+
+  std::vector<at::Tensor> result() const override {
+    return future_->wait();
+  }
+
+ private:
+  const std::shared_ptr<GradBucketFuture> future_;
+};
+
 } // namespace
 
 Reducer::Reducer(
     std::vector<std::vector<torch::autograd::Variable>> replicas,
     std::vector<std::vector<size_t>> bucket_indices,
     std::shared_ptr<c10d::ProcessGroup> process_group,
-    std::vector<std::vector<bool>> expect_sparse_gradients)
+    std::vector<std::vector<bool>> expect_sparse_gradients,
+    size_t bucket_bytes_cap)
     : replicas_(std::move(replicas)),
       process_group_(std::move(process_group)),
       expect_sparse_gradients_(std::move(expect_sparse_gradients)),
@@ -52,7 +127,10 @@ Reducer::Reducer(
       next_bucket_(0),
       has_marked_unused_parameters_(false),
       local_used_maps_reduced_(false),
-      backward_stats_base_(0) {
+      backward_stats_base_(0),
+      bucket_bytes_cap_(bucket_bytes_cap),
+      num_iterations_(0),
+      has_rebuilt_buckets_(false) {
   TORCH_CHECK(replicas_.size() >= 1, "Expected at least one model replica.");
   TORCH_CHECK(replicas_[0].size() >= 1, "Expected at least one parameter.");
 
@@ -193,6 +271,16 @@ Reducer::Reducer(
 }
 
 Reducer::~Reducer() noexcept(false) {
+  // Collectives still queued are dropped, this reducer won't wait for them.
+  if (comm_hook_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(comm_hook_mutex_);
+      comm_hook_stop_ = true;
+    }
+    comm_hook_cv_.notify_one();
+    comm_hook_thread_.join();
+  }
+
   // Remove all hooks on variables registered by this Reducer. This is necessary
   // to make DDP failure recoverable. Otherwise, multiple Reducer instances
   // (from recoveries) will add their hooks to the original model, and those
@@ -293,6 +381,11 @@ void Reducer::autograd_hook(VariableIndex index) {
     }
   }
 
+  // Record the order in which gradients become ready to rebuild buckets.
+  if (!has_rebuilt_buckets_ && index.replica_index == 0) {
+    ready_order_.push_back(index.variable_index);
+  }
+
   // Finally mark variable for which this function was originally called.
   mark_variable_ready(index);
 }
@@ -367,13 +460,17 @@ void Reducer::mark_variable_ready(VariableIndex index) {
   // Run finalizer function and kick off reduction for local_used_maps once the
   // final bucket was marked ready.
   if (next_bucket_ == buckets_.size()) {
+    overlap_stats_.backward_time =
+        current_time_in_nanos() - backward_stats_base_;
+
     // H2D from local_used_maps_ to local_used_maps_dev_
     for (size_t i = 0; i < local_used_maps_.size(); i++) {
       // We do async H2D to avoid the blocking overhead. The async copy and
       // allreduce respect the current stream, so will be sequenced correctly.
       local_used_maps_dev_[i].copy_(local_used_maps_[i], true);
     }
-    local_used_work_ = process_group_->allreduce(local_used_maps_dev_);
+    local_used_work_ = issue_collective(
+        [this] { return process_group_->allreduce(local_used_maps_dev_); });
 
     torch::autograd::Engine::get_default_engine().queue_callback([=] {
       std::lock_guard<std::mutex> lock(this->mutex_);
@@ -398,6 +495,8 @@ void Reducer::mark_bucket_ready(size_t bucket_index) {
   for (; next_bucket_ < buckets_.size() && buckets_[next_bucket_].pending == 0;
        next_bucket_++) {
     auto& bucket = buckets_[next_bucket_];
+    overlap_stats_.bucket_ready_times[next_bucket_] =
+        current_time_in_nanos() - backward_stats_base_;
     std::vector<at::Tensor> tensors;
     tensors.reserve(bucket.replicas.size());
     for (const auto& replica : bucket.replicas) {
@@ -412,7 +511,68 @@ void Reducer::mark_bucket_ready(size_t bucket_index) {
       //
       tensors.push_back(replica.contents);
     }
-    bucket.work = process_group_->allreduce(tensors);
+    if (comm_hook_ && !bucket.expect_sparse_gradient) {
+      auto hook = comm_hook_;
+      auto process_group = process_group_;
+      GradBucket grad_bucket{next_bucket_, std::move(tensors)};
+      bucket.work = issue_collective([=] {
+        return std::make_shared<CommHookWork>(
+            hook->runHook(*process_group, grad_bucket));
+      });
+    } else {
+      bucket.work = issue_collective([=]() mutable {
+        return process_group_->allreduce(tensors);
+      });
+    }
+  }
+}
+
+std::shared_ptr<c10d::ProcessGroup::Work> Reducer::issue_collective(
+    std::function<std::shared_ptr<c10d::ProcessGroup::Work>()> fn) {
+  if (!comm_hook_) {
+    return fn();
+  }
+
+  auto work = std::make_shared<QueuedWork>();
+  {
+    std::lock_guard<std::mutex> lock(comm_hook_mutex_);
+    comm_hook_queue_.emplace_back([work, fn] {
+      try {
+        work->issued(fn());
+      } catch (...) {
+        work->failed(std::current_exception());
+      }
+    });
+  }
+  comm_hook_cv_.notify_one();
+  return work;
+}
+
+void Reducer::run_comm_hook_loop() {
+  std::unique_lock<std::mutex> lock(comm_hook_mutex_);
+  for (;;) {
+    comm_hook_cv_.wait(
+        lock, [&] { return comm_hook_stop_ || !comm_hook_queue_.empty(); });
+    if (comm_hook_stop_) {
+      return;
+    }
+    auto fn = std::move(comm_hook_queue_.front());
+    comm_hook_queue_.pop_front();
+    lock.unlock();
+    fn();
+    lock.lock();
+  }
+}
+
+void Reducer::register_comm_hook(std::shared_ptr<CommHook> hook) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TORCH_CHECK(hook, "Expected a comm hook.");
+  TORCH_CHECK(
+      !expect_autograd_hooks_,
+      "`register_comm_hook` must NOT be called during autograd execution.");
+  comm_hook_ = std::move(hook);
+  if (!comm_hook_thread_.joinable()) {
+    comm_hook_thread_ = std::thread(&Reducer::run_comm_hook_loop, this);
   }
 }
 
@@ -425,8 +585,16 @@ void Reducer::initialize_buckets(
       !expect_autograd_hooks_,
       "`initialize_buckets` must NOT be called during autograd execution.");
 
+  assign_buckets(std::move(bucket_indices));
+}
+
+// Requires `mutex_` to be held.
+void Reducer::assign_buckets(std::vector<std::vector<size_t>> bucket_indices) {
   // Clear current bucket assignment.
   buckets_.clear();
+  if (comm_hook_) {
+    comm_hook_->reset();
+  }
   variable_locators_.clear();
 
   // Ensure we have a bucket index for every variable.
@@ -563,10 +731,19 @@ void Reducer::prepare_for_backward(
         "list, dict, iterable).");
   }
 
+  // The first iteration shows the order in which gradients become ready.
+  if (!has_rebuilt_buckets_ && num_iterations_ > 0) {
+    rebuild_buckets();
+  }
+  num_iterations_++;
+
   // Reset accounting.
   expect_autograd_hooks_ = true;
   next_bucket_ = 0;
   backward_stats_base_ = current_time_in_nanos();
+  overlap_stats_.backward_time = 0;
+  overlap_stats_.bucket_ready_times.assign(buckets_.size(), 0);
+  overlap_stats_.exposed_communication_time = 0;
   for (auto& bucket : buckets_) {
     for (auto& replica : bucket.replicas) {
       replica.pending = replica.variables.size();
@@ -693,6 +870,174 @@ void Reducer::finalize_bucket_sparse(Bucket& bucket) {
   }
 }
 
+void Reducer::rebuild_buckets() {
+  const auto variable_count = replicas_[0].size();
+  const auto bucket_bytes_cap = measure_bucket_bytes_cap();
+
+  // Gradients may become ready in a different order on other processes, and
+  // buckets must be the same everywhere, so rank 0 decides. It broadcasts
+  // [bucket size cap, number of recorded variables, variable indices...].
+  auto decision =
+      at::zeros({static_cast<long>(variable_count + 2)}, at::kLong);
+  if (process_group_->getRank() == 0) {
+    auto data = decision.data_ptr<int64_t>();
+    std::vector<bool> seen(variable_count, false);
+    size_t recorded = 0;
+    for (const auto variable_index : ready_order_) {
+      if (!seen[variable_index]) {
+        seen[variable_index] = true;
+        data[2 + recorded++] = variable_index;
+      }
+    }
+    data[0] = bucket_bytes_cap;
+    data[1] = recorded;
+  }
+  ready_order_.clear();
+
+  std::vector<at::Tensor> tensors = {
+      decision.to(replicas_[0][0].device())};
+  issue_collective([=]() mutable {
+    return process_group_->broadcast(tensors);
+  })->wait();
+  decision = tensors[0].cpu();
+  const auto data = decision.data_ptr<int64_t>();
+
+  // Nothing to go by if no gradient became ready on rank 0, e.g. because the
+  // output wasn't differentiated. Try again after the next iteration.
+  const auto recorded = static_cast<size_t>(data[1]);
+  if (recorded == 0) {
+    return;
+  }
+
+  // Variables without a gradient on rank 0 go last, in the reverse order of
+  // their definition, as in the initial assignment.
+  std::vector<size_t> variable_order;
+  variable_order.reserve(variable_count);
+  std::vector<bool> seen(variable_count, false);
+  for (size_t i = 0; i < recorded; i++) {
+    const auto variable_index = static_cast<size_t>(data[2 + i]);
+    TORCH_INTERNAL_ASSERT(variable_index < variable_count);
+    variable_order.push_back(variable_index);
+    seen[variable_index] = true;
+  }
+  for (size_t i = variable_count; i-- > 0;) {
+    if (!seen[i]) {
+      variable_order.push_back(i);
+    }
+  }
+
+  // As in the initial assignment, the small first bucket size limit goes to
+  // the bucket that becomes ready last, so that little is left to reduce
+  // once the backward pass is done. Hence assign in reverse.
+  std::reverse(variable_order.begin(), variable_order.end());
+  std::vector<at::Tensor> ordered_variables;
+  std::vector<bool> ordered_expect_sparse_gradient;
+  ordered_variables.reserve(variable_count);
+  ordered_expect_sparse_gradient.reserve(variable_count);
+  for (const auto variable_index : variable_order) {
+    ordered_variables.push_back(replicas_[0][variable_index]);
+    ordered_expect_sparse_gradient.push_back(
+        expect_sparse_gradients_[0][variable_index]);
+  }
+
+  const size_t cap = data[0];
+  auto bucket_indices = compute_bucket_assignment_by_size(
+      ordered_variables,
+      {std::min(kDefaultFirstBucketBytes, cap), cap},
+      ordered_expect_sparse_gradient);
+  for (auto& bucket : bucket_indices) {
+    for (auto& index : bucket) {
+      index = variable_order[index];
+    }
+  }
+  std::reverse(bucket_indices.begin(), bucket_indices.end());
+  assign_buckets(std::move(bucket_indices));
+
+  has_rebuilt_buckets_ = true;
+  overlap_stats_.rebuilt_buckets = true;
+  overlap_stats_.bucket_bytes_cap = cap;
+}
+
+// Fits `latency + bytes / bandwidth` to the time allreduce takes, and picks
+// the bucket size at which the latency is 10% of the time of a reduction.
+// Smaller buckets overlap better with the backward pass, but pay the latency
+// more often.
+size_t Reducer::measure_bucket_bytes_cap() {
+  // The result is clamped to [kMinBucketBytes, bucket_bytes_cap_] anyway.
+  if (bucket_bytes_cap_ <= kMinBucketBytes) {
+    return bucket_bytes_cap_;
+  }
+
+  const auto options = at::TensorOptions()
+                           .device(replicas_[0][0].device())
+                           .dtype(at::kFloat);
+  const auto time_allreduce = [&](size_t bytes) {
+    // Number of timed allreduces, after one to warm up.
+    constexpr int kIterations = 3;
+    std::vector<at::Tensor> tensors = {
+        at::zeros({static_cast<long>(bytes / sizeof(float))}, options)};
+    int64_t start = 0;
+    for (int i = 0; i <= kIterations; i++) {
+      if (i == 1) {
+        start = current_time_in_nanos();
+      }
+      issue_collective([=]() mutable {
+        return process_group_->allreduce(tensors);
+      })->wait();
+    }
+    // Wait for the device as well.
+    tensors[0].cpu();
+    return (current_time_in_nanos() - start) / kIterations;
+  };
+
+  const auto probe_bytes = std::min(bucket_bytes_cap_, kMaxProbeBytes);
+  const auto latency = time_allreduce(sizeof(float));
+  const auto duration = time_allreduce(probe_bytes);
+  if (duration <= latency) {
+    return bucket_bytes_cap_;
+  }
+  const double nanos_per_byte =
+      static_cast<double>(duration - latency) / (probe_bytes - sizeof(float));
+  const auto bytes = static_cast<size_t>(9 * latency / nanos_per_byte);
+  return std::min(bucket_bytes_cap_, std::max(kMinBucketBytes, bytes));
+}
+
+Reducer::OverlapStats Reducer::get_overlap_stats() const {
+  auto stats = overlap_stats_;
+  stats.bucket_sizes.reserve(buckets_.size());
+  for (const auto& bucket : buckets_) {
+    size_t bytes = 0;
+    for (const auto& variable : bucket.replicas[0].variables) {
+      bytes += variable.numel() * variable.element_size();
+    }
+    stats.bucket_sizes.push_back(bytes);
+  }
+  return stats;
+}
+
+// Comm hooks return the reduced bucket instead of reducing it in place.
+void Reducer::copy_comm_hook_result(Bucket& bucket) {
+  const auto result = bucket.work->result();
+  TORCH_CHECK(
+      result.size() == bucket.replicas.size(),
+      "Expected the comm hook to return ",
+      bucket.replicas.size(),
+      " tensors, got ",
+      result.size());
+  for (size_t i = 0; i < bucket.replicas.size(); i++) {
+    auto& contents = bucket.replicas[i].contents;
+    TORCH_CHECK(
+        result[i].numel() == contents.numel(),
+        "Expected the comm hook to return a tensor of ",
+        contents.numel(),
+        " elements, got ",
+        result[i].numel());
+    if (!result[i].is_same(contents)) {
+      contents.copy_(result[i].view({-1}));
+    }
+  }
+}
+
 void Reducer::finalize_backward() {
   // No longer expect autograd hooks to fire after this function returns.
   TORCH_INTERNAL_ASSERT(expect_autograd_hooks_);
@@ -708,10 +1053,16 @@ void Reducer::finalize_backward() {
   // Wait for asynchronous reduction to complete and unflatten contents.
   for (auto& bucket : buckets_) {
     TORCH_INTERNAL_ASSERT(bucket.work);
+    const auto wait_start = current_time_in_nanos();
     bucket.work->wait();
+    overlap_stats_.exposed_communication_time +=
+        current_time_in_nanos() - wait_start;
     if (bucket.expect_sparse_gradient) {
       finalize_bucket_sparse(bucket);
     } else {
+      if (comm_hook_) {
+        copy_comm_hook_result(bucket);
+      }
       finalize_bucket_dense(bucket);
     }
   }
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -10,20 +14,33 @@
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
 
 namespace c10d {
 
+// Bucket size limits used by DistributedDataParallel. The first bucket is
+// kept small, so that reducing the first gradients doesn't have to wait for
+// a large bucket to fill up.
+constexpr size_t kDefaultFirstBucketBytes = 1024 * 1024;
+constexpr size_t kDefaultBucketBytesCap = 25 * 1024 * 1024;
+
 class Reducer {
  public:
   // The constructor takes a list of variables for every model replica.
   // The bucket assignment for this reducer is specified as a list of
   // buckets, each of which is specified as a list of indices into the
   // variables list for **a single replica** (i.e. `variables[0]`).
+  //
+  // After the first iteration, buckets are rebuilt to follow the order in
+  // which gradients became ready on rank 0, with at most `bucket_bytes_cap`
+  // bytes per bucket, or less if the measured latency and bandwidth of the
+  // process group favor smaller buckets.
   explicit Reducer(
       std::vector<std::vector<torch::autograd::Variable>> replicas,
       std::vector<std::vector<size_t>> bucket_indices,
       std::shared_ptr<c10d::ProcessGroup> process_group,
-      std::vector<std::vector<bool>> expect_sparse_gradients);
+      std::vector<std::vector<bool>> expect_sparse_gradients,
+      size_t bucket_bytes_cap = kDefaultBucketBytesCap);
 
   ~Reducer() noexcept(false);
 
@@ -47,6 +64,36 @@ class Reducer {
     return backward_stats_;
   }
 
+  // How well reductions overlapped with the backward pass in the last
+  // iteration. Times are in nanoseconds, relative to the time
+  // `prepare_for_backward` was called.
+  struct OverlapStats {
+    // When the last gradient became ready.
+    int64_t backward_time = 0;
+
+    // When each bucket became ready and its reduction was kicked off.
+    std::vector<int64_t> bucket_ready_times;
+
+    // Time spent waiting for reductions once all gradients were ready,
+    // i.e. communication that didn't overlap with the backward pass.
+    int64_t exposed_communication_time = 0;
+
+    // Size in bytes of each bucket, in reduction order.
+    std::vector<size_t> bucket_sizes;
+
+    // Whether buckets were rebuilt from the observed gradient order, and
+    // the bucket size limit picked then.
+    bool rebuilt_buckets = false;
+    size_t bucket_bytes_cap = 0;
+  };
+
+  OverlapStats get_overlap_stats() const;
+
+  // Runs `hook` on every dense bucket in place of the allreduce. The hook
+  // and all other collectives of this reducer are then issued from a
+  // dedicated thread, in the same order on all processes.
+  void register_comm_hook(std::shared_ptr<CommHook> hook);
+
  protected:
   // Forward declaration.
   struct Bucket;
@@ -106,8 +153,27 @@ class Reducer {
 
   void finalize_bucket_sparse(Bucket& replica);
 
+  void copy_comm_hook_result(Bucket& bucket);
+
   void finalize_backward();
 
+  // Requires `mutex_` to be held.
+  void assign_buckets(std::vector<std::vector<size_t>> bucket_indices);
+
+  // Rebuilds buckets from the order recorded in `ready_order_` on rank 0.
+  // Must be called by all processes at the same point.
+  void rebuild_buckets();
+
+  // Picks a bucket size limit from the latency and bandwidth of allreduce.
+  size_t measure_bucket_bytes_cap();
+
+  // Issues the collective returned by `fn`. With a comm hook, this happens
+  // on the comm hook thread, in the order of calls to this function.
+  std::shared_ptr<c10d::ProcessGroup::Work> issue_collective(
+      std::function<std::shared_ptr<c10d::ProcessGroup::Work>()> fn);
+
+  void run_comm_hook_loop();
+
   // A bucket replica represents [1..N] gradients to be reduced,
   // with the same dtype, on the same device.
   //
@@ -186,6 +252,25 @@ class Reducer {
   // the point in time buckets were ready, or ideal bucket assignment/ordering.
   int64_t backward_stats_base_;
   std::vector<std::vector<int64_t>> backward_stats_;
+
+  // Buckets are rebuilt once, at the start of the second iteration, from the
+  // order in which gradients of the first replica became ready in the first.
+  const size_t bucket_bytes_cap_;
+  size_t num_iterations_;
+  bool has_rebuilt_buckets_;
+  std::vector<size_t> ready_order_;
+
+  OverlapStats overlap_stats_;
+
+  // Set by `register_comm_hook`. Collectives are then queued to the comm
+  // hook thread, so that hooks can compress a bucket while the autograd
+  // thread keeps computing gradients for the next ones.
+  std::shared_ptr<CommHook> comm_hook_;
+  std::thread comm_hook_thread_;
+  std::deque<std::function<void()>> comm_hook_queue_;
+  std::mutex comm_hook_mutex_;
+  std::condition_variable comm_hook_cv_;
+  bool comm_hook_stop_ = false;
 };
 
 std::vector<std::vector<size_t>> compute_bucket_assignment_by_size(
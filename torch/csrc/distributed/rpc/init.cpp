@@ -207,7 +207,10 @@ If the future completes with an error, an exception is thrown.
       .def(py::init<>())
       .def_readwrite(
           "num_send_recv_threads",
-          &ProcessGroupRpcBackendOptions::numSendRecvThreads);
+          &ProcessGroupRpcBackendOptions::numSendRecvThreads)
+      .def_readwrite(
+          "use_shared_memory",
+          &ProcessGroupRpcBackendOptions::useSharedMemory);
 
   shared_ptr_class_<ProcessGroupAgent>(module, "ProcessGroupAgent", rpcAgent)
       .def(
@@ -215,11 +218,13 @@ If the future completes with an error, an exception is thrown.
               std::string,
               std::shared_ptr<::c10d::ProcessGroup>,
               int,
-              std::chrono::milliseconds>(),
+              std::chrono::milliseconds,
+              bool>(),
           py::arg("name"),
           py::arg("process_group"),
           py::arg("num_send_recv_threads"),
-          py::arg("rpc_timeout"))
+          py::arg("rpc_timeout"),
+          py::arg("use_shared_memory") = false)
       .def(
           "get_worker_info",
           (const WorkerInfo& (ProcessGroupAgent::*)(void)const) &
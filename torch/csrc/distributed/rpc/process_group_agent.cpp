@@ -6,11 +6,45 @@
 #include <torch/csrc/distributed/rpc/utils.h>
 
 #include <Python.h>
+#include <unistd.h>
+
+#include <fstream>
 
 namespace torch {
 namespace distributed {
 namespace rpc {
 
+namespace {
+
+// Size of the ring buffer of each shared memory channel.
+constexpr size_t kShmChannelCapacity = 4 * 1024 * 1024;
+// Tensor data of at least this many bytes is passed to a peer on the same
+// host in a shared memory segment of its own instead of through the ring.
+constexpr int64_t kShmInlineThreshold = 64 * 1024;
+constexpr size_t kMaxHostIdLen = 256;
+
+// Identifies the host, and which boot of it, to tell which peers share
+// memory with us.
+std::string getHostId() {
+  char hostname[kMaxHostIdLen] = {0};
+  gethostname(hostname, sizeof(hostname) - 1);
+  std::string hostId(hostname);
+  std::ifstream bootIdFile("/proc/sys/kernel/random/boot_id");
+  std::string bootId;
+  if (bootIdFile >> bootId) {
+    hostId.append("/").append(bootId);
+  }
+  return hostId.substr(0, kMaxHostIdLen - 1);
+}
+
+// The channel process `pid` receives the messages from rank `src` on.
+std::string shmChannelName(int64_t pid, int src) {
+  return "/torch_rpc_channel_" + c10::to_string(pid) + "_" +
+      c10::to_string(src);
+}
+
+} // namespace
+
 //////////////////////////  MessageCounter  /////////////////////////////////
 
 ProcessGroupAgent::MessageCounter::MessageCounter(int worldSize)
@@ -63,11 +97,116 @@ void ProcessGroupAgent::collectNames() {
   }
 }
 
+void ProcessGroupAgent::connectLocalPeers() {
+  const auto worldSize = pg_->getSize();
+  const auto rank = pg_->getRank();
+
+  // use c10d allgather to collect host ids and pids
+  const std::string hostId = getHostId();
+  torch::Tensor hostIdTensor = torch::zeros({kMaxHostIdLen}, torch::kChar);
+  memcpy(hostIdTensor.storage().data(), hostId.c_str(), hostId.length());
+  std::vector<torch::Tensor> inputHostId = {hostIdTensor};
+  std::vector<torch::Tensor> inputPid = {
+      torch::tensor({(int64_t)getpid()}, {torch::kInt64})};
+  std::vector<std::vector<torch::Tensor>> outputHostIds(1);
+  std::vector<std::vector<torch::Tensor>> outputPids(1);
+  for (int i = 0; i < worldSize; ++i) {
+    outputHostIds[0].emplace_back(
+        torch::empty({kMaxHostIdLen}, {torch::kChar}));
+    outputPids[0].emplace_back(torch::empty({1}, {torch::kInt64}));
+  }
+  pg_->allgather(outputHostIds, inputHostId)->wait();
+  pg_->allgather(outputPids, inputPid)->wait();
+
+  std::vector<int> localPeers;
+  for (int i = 0; i < worldSize; ++i) {
+    std::string peerHostId(
+        (const char*)outputHostIds[0][i].storage().data<signed char>());
+    if (i != rank && peerHostId == hostId) {
+      localPeers.push_back(i);
+    }
+  }
+
+  shmInboxes_.resize(worldSize);
+  shmOutboxes_.resize(worldSize);
+  for (int peer : localPeers) {
+    shmInboxes_[peer] =
+        ShmChannel::create(shmChannelName(getpid(), peer), kShmChannelCapacity);
+  }
+  // peers open our inboxes only once everyone created theirs
+  pg_->barrier()->wait();
+  for (int peer : localPeers) {
+    shmOutboxes_[peer] = ShmChannel::open(
+        shmChannelName(outputPids[0][peer].item<int64_t>(), rank));
+    if (!shmOutboxes_[peer]) {
+      LOG(WARNING) << "Failed to open the shared memory channel to "
+                   << allWorkerInfo_[peer].name_
+                   << ", sending through the ProcessGroup instead.";
+    }
+  }
+}
+
+bool ProcessGroupAgent::sendOverSharedMemory(
+    int dst,
+    const Message& message,
+    const std::string& header,
+    const std::vector<torch::Tensor>& buffers) {
+  // Large tensor data is copied before taking the lock, so that other
+  // messages to dst don't wait for it.
+  std::vector<std::string> segments(buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    if (buffers[i].numel() >= kShmInlineThreshold) {
+      segments[i] = copyToSharedMemory(buffers[i]);
+    }
+  }
+
+  // Format: type, id and size of the header, the header, then for each
+  // tensor buffer the length of its segment name followed by the name, or 0
+  // followed by the data.
+  auto writeMessage = [&](ShmChannel& channel) {
+    int64_t preamble[] = {(int64_t)message.type(),
+                          (int64_t)message.id(),
+                          (int64_t)header.size()};
+    if (!channel.write(preamble, sizeof(preamble)) ||
+        !channel.write(header.data(), header.size())) {
+      return false;
+    }
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      int64_t nameLen = segments[i].size();
+      if (!channel.write(&nameLen, sizeof(nameLen))) {
+        return false;
+      }
+      bool written = nameLen != 0
+          ? channel.write(segments[i].data(), nameLen)
+          : channel.write(buffers[i].data_ptr(), buffers[i].numel());
+      if (!written) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  bool ok;
+  {
+    std::lock_guard<std::mutex> guard(sendMutexes_[dst]);
+    ok = writeMessage(*shmOutboxes_[dst]);
+  }
+  if (!ok) {
+    for (const auto& segment : segments) {
+      if (!segment.empty()) {
+        unlinkSharedMemory(segment);
+      }
+    }
+  }
+  return ok;
+}
+
 ProcessGroupAgent::ProcessGroupAgent(
     std::string workerName,
     std::shared_ptr<c10d::ProcessGroup> pg,
     int numSendRecvThreads,
-    std::chrono::milliseconds rpcTimeout)
+    std::chrono::milliseconds rpcTimeout,
+    bool useSharedMemory)
     : RpcAgent(
           WorkerInfo(std::move(workerName), pg->getRank()),
           std::make_unique<RequestCallbackImpl>(),
@@ -108,6 +247,10 @@ ProcessGroupAgent::ProcessGroupAgent(
   for (int rank = 0; rank < (int)tmpWorkerIds.size(); ++rank) {
     allWorkerInfo_.emplace_back(std::move(tmpWorkerIds[rank]), rank);
   }
+
+  if (useSharedMemory) {
+    connectLocalPeers();
+  }
 }
 
 const WorkerInfo& ProcessGroupAgent::getWorkerInfo(
@@ -206,6 +349,12 @@ void ProcessGroupAgent::start() {
   listenerThread_ = std::thread(&ProcessGroupAgent::listenLoop, this);
   futureTimeoutThread_ =
       std::thread(&ProcessGroupAgent::pollTimedOutRPCs, this);
+  for (int rank = 0; rank < (int)shmInboxes_.size(); ++rank) {
+    if (shmInboxes_[rank]) {
+      shmListenerThreads_.emplace_back(
+          &ProcessGroupAgent::sharedMemoryListenLoop, this, rank);
+    }
+  }
 }
 
 void ProcessGroupAgent::shutdown() {
@@ -223,6 +372,14 @@ void ProcessGroupAgent::shutdown() {
       recvWork_->abort();
     }
   }
+  for (auto& inbox : shmInboxes_) {
+    if (inbox) {
+      inbox->close();
+    }
+  }
+  for (auto& thread : shmListenerThreads_) {
+    thread.join();
+  }
   threadPool_.waitWorkComplete();
   listenerThread_.join();
 }
@@ -287,11 +444,20 @@ std::shared_ptr<FutureMessage> ProcessGroupAgent::send(
           // Unlike the other cases, need to add a tensor deleter, since the
           // data outlives the scope of this function. It's shared_ptr<> due
           // to c++11 lambda capture limitations with unique_ptr<>.
-          auto payload = std::make_unique<std::string>(
-              wireSerialize(message.payload(), message.tensors()));
+          auto serialized =
+              wireSerializeScattered(message.payload(), message.tensors());
+          auto payload =
+              std::make_unique<std::string>(std::move(serialized.first));
           const char* data = payload->data();
           size_t len = payload->length();
           std::string* delete_when_done = payload.release();
+          // The receiver must not share storage with the sender, so the
+          // buffers are copied once, as sending them would.
+          std::vector<torch::Tensor> buffers;
+          buffers.reserve(serialized.second.size());
+          for (const auto& buffer : serialized.second) {
+            buffers.push_back(buffer.clone());
+          }
           enqueueRecv(RecvWork(
               getWorkerInfo(pg_->getRank()),
               message.type(),
@@ -300,7 +466,8 @@ std::shared_ptr<FutureMessage> ProcessGroupAgent::send(
                   (void*)data,
                   len,
                   [delete_when_done](void*) { delete delete_when_done; },
-                  {torch::kChar})));
+                  {torch::kChar}),
+              std::move(buffers)));
         },
         std::move(message)));
     return future;
@@ -323,8 +490,22 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
   // NB: this can be changed to use a native move capture when moved to C++14
   threadPool_.run(std::bind(
       [this](const SendWork& work) {
-        std::string serializedPayload =
-            wireSerialize(work.message_.payload(), work.message_.tensors());
+        // The tensor data is not copied into the serialized payload but sent
+        // from the tensors' storages, after it.
+        auto serialized = wireSerializeScattered(
+            work.message_.payload(), work.message_.tensors());
+        std::string& serializedPayload = serialized.first;
+        const auto dst = work.to_.id_;
+
+        if ((size_t)dst < shmOutboxes_.size() && shmOutboxes_[dst]) {
+          sendCounts_.increment(dst);
+          if (!sendOverSharedMemory(
+                  dst, work.message_, serializedPayload, serialized.second)) {
+            LOG(WARNING) << "Dropping RPC message to " << work.to_.name_
+                         << ", its shared memory channel was closed.";
+          }
+          return;
+        }
 
         std::vector<torch::Tensor> preamble = {torch::tensor(
             {(int64_t)pg_->getRank(),
@@ -336,12 +517,11 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
         // ProcessGroup is not thread-safe when sending with the same tag, hence
         // the lock
         std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingSends;
-        const auto dst = work.to_.id_;
         std::vector<torch::Tensor> payload = {torch::from_blob(
             (void*)serializedPayload.c_str(),
             serializedPayload.length(),
             {torch::kChar})};
-        pendingSends.reserve(2);
+        pendingSends.reserve(2 + serialized.second.size());
 
         sendCounts_.increment(dst);
 
@@ -351,6 +531,16 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
               pg_->send(preamble, dst, dst /* channelTag */));
           pendingSends.emplace_back(
               pg_->send(payload, dst, dst /* channelTag */));
+          for (auto& buffer : serialized.second) {
+            // the receiver knows the sizes from the header and does not
+            // expect empty buffers
+            if (buffer.numel() == 0) {
+              continue;
+            }
+            std::vector<torch::Tensor> tensors = {buffer};
+            pendingSends.emplace_back(
+                pg_->send(tensors, dst, dst /* channelTag */));
+          }
         }
         for (auto& pendingSend : pendingSends) {
           pendingSend->wait();
@@ -363,7 +553,10 @@ void ProcessGroupAgent::enqueueRecv(RecvWork work) {
   threadPool_.run(std::bind(
       [&](RecvWork& work) {
         torch::Tensor& payload = work.payload_;
-        auto data = wireDeserialize(payload.storage().data(), payload.numel());
+        auto data = wireDeserializeScattered(
+            payload.storage().data(),
+            payload.numel(),
+            std::move(work.buffers_));
         Message message(
             std::move(data.first),
             std::move(data.second),
@@ -474,8 +667,78 @@ void ProcessGroupAgent::listenLoop() {
     std::vector<torch::Tensor> tensors = {torch::empty({size}, {torch::kChar})};
     pg_->recv(tensors, srcRank, pg_->getRank())->wait();
 
-    enqueueRecv(
-        RecvWork(allWorkerInfo_[srcRank], type, id, std::move(tensors[0])));
+    // The tensor data follows the header, and is received directly into the
+    // storages of the deserialized tensors.
+    const auto bufferSizes =
+        wireBufferSizes(tensors[0].storage().data(), tensors[0].numel());
+    std::vector<torch::Tensor> buffers;
+    std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingRecvs;
+    buffers.reserve(bufferSizes.size());
+    for (int64_t bufferSize : bufferSizes) {
+      buffers.push_back(torch::empty({bufferSize}, {torch::kChar}));
+      if (bufferSize != 0) {
+        std::vector<torch::Tensor> buffer = {buffers.back()};
+        pendingRecvs.emplace_back(pg_->recv(buffer, srcRank, pg_->getRank()));
+      }
+    }
+    for (auto& pendingRecv : pendingRecvs) {
+      pendingRecv->wait();
+    }
+
+    enqueueRecv(RecvWork(
+        allWorkerInfo_[srcRank],
+        type,
+        id,
+        std::move(tensors[0]),
+        std::move(buffers)));
+  }
+}
+
+void ProcessGroupAgent::sharedMemoryListenLoop(int srcRank) {
+  ShmChannel& channel = *shmInboxes_[srcRank];
+  // See sendOverSharedMemory() for the format. The channel is closed on
+  // shutdown.
+  while (rpcRunning_.load()) {
+    int64_t preamble[3];
+    if (!channel.read(preamble, sizeof(preamble))) {
+      return;
+    }
+    MessageType type = MessageType(preamble[0]);
+    int64_t id = preamble[1];
+    torch::Tensor header = torch::empty({preamble[2]}, {torch::kChar});
+    if (!channel.read(header.storage().data(), preamble[2])) {
+      return;
+    }
+
+    const auto bufferSizes =
+        wireBufferSizes(header.storage().data(), header.numel());
+    std::vector<torch::Tensor> buffers;
+    buffers.reserve(bufferSizes.size());
+    for (int64_t bufferSize : bufferSizes) {
+      int64_t nameLen;
+      if (!channel.read(&nameLen, sizeof(nameLen))) {
+        return;
+      }
+      if (nameLen != 0) {
+        std::string name(nameLen, '\0');
+        if (!channel.read(&name[0], nameLen)) {
+          return;
+        }
+        buffers.push_back(mapSharedMemory(name, bufferSize));
+      } else {
+        buffers.push_back(torch::empty({bufferSize}, {torch::kChar}));
+        if (!channel.read(buffers.back().data_ptr(), bufferSize)) {
+          return;
+        }
+      }
+    }
+
+    enqueueRecv(RecvWork(
+        allWorkerInfo_[srcRank],
+        type,
+        id,
+        std::move(header),
+        std::move(buffers)));
   }
 }
 
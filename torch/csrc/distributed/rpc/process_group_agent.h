@@ -4,6 +4,7 @@
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/distributed/rpc/python_rpc_handler.h>
 #include <torch/csrc/distributed/rpc/rpc_agent.h>
+#include <torch/csrc/distributed/rpc/shared_memory_channel.h>
 
 #include <atomic>
 #include <thread>
@@ -15,6 +16,7 @@ namespace rpc {
 struct ProcessGroupRpcBackendOptions : public RpcBackendOptions {
   ProcessGroupRpcBackendOptions() = default;
   int numSendRecvThreads;
+  bool useSharedMemory = false;
 };
 
 // SendWork and RecvWork will be put into a task queue, and later picked up by
@@ -27,20 +29,28 @@ struct SendWork {
   Message message_;
 };
 
-// SendWork wraps a Message and RecvWork wraps a Tensor. The difference here is
+// SendWork wraps a Message and RecvWork wraps Tensors. The difference here is
 // to allow us to run serialization/deserialization in the worker threads.
+// The payload is the header of the wireSerializeScattered() format, and the
+// tensor data was received into the buffers.
 struct RecvWork {
   RecvWork(
       const WorkerInfo& from,
       MessageType type,
       int64_t id,
-      torch::Tensor&& payload)
-      : from_(from), type_(type), id_(id), payload_(payload) {}
+      torch::Tensor&& payload,
+      std::vector<torch::Tensor>&& buffers)
+      : from_(from),
+        type_(type),
+        id_(id),
+        payload_(payload),
+        buffers_(std::move(buffers)) {}
 
   const WorkerInfo& from_;
   const MessageType type_;
   const int64_t id_;
   torch::Tensor payload_;
+  std::vector<torch::Tensor> buffers_;
 };
 
 class ProcessGroupAgent : public RpcAgent {
@@ -49,7 +59,8 @@ class ProcessGroupAgent : public RpcAgent {
       std::string workerName,
       std::shared_ptr<c10d::ProcessGroup> pg,
       int numSendRecvThreads,
-      std::chrono::milliseconds rpcTimeout);
+      std::chrono::milliseconds rpcTimeout,
+      bool useSharedMemory = false);
 
   const WorkerInfo& getWorkerInfo(const std::string& workerName) const override;
 
@@ -113,12 +124,23 @@ class ProcessGroupAgent : public RpcAgent {
   };
 
   void collectNames();
+  // Sets up the shared memory channels with the peers on the same host.
+  void connectLocalPeers();
+  // Writes a serialized message to the channel of a peer on the same host,
+  // returns false if it was closed.
+  bool sendOverSharedMemory(
+      int dst,
+      const Message& message,
+      const std::string& header,
+      const std::vector<torch::Tensor>& buffers);
   // put SendWork into a queue and notify the worker thread
   void enqueueSend(SendWork work);
   // put RecvWork into a queue and notify the worker thread
   void enqueueRecv(RecvWork work);
   // receiving messages
   void listenLoop();
+  // receiving messages from the shared memory channel of peer srcRank
+  void sharedMemoryListenLoop(int srcRank);
   // poll for timed out RPCs
   void pollTimedOutRPCs();
   // process timed out futures
@@ -177,6 +199,13 @@ class ProcessGroupAgent : public RpcAgent {
   // when using the same tag.
   std::vector<std::mutex> sendMutexes_;
   std::thread listenerThread_;
+  // Messages between workers on the same host go through shared memory
+  // ring buffers instead of the ProcessGroup, if enabled. Indexed by rank,
+  // null for peers on other hosts and for ourselves. Writes to
+  // shmOutboxes_[dst] are serialized by sendMutexes_[dst].
+  std::vector<std::unique_ptr<ShmChannel>> shmInboxes_;
+  std::vector<std::unique_ptr<ShmChannel>> shmOutboxes_;
+  std::vector<std::thread> shmListenerThreads_;
   // A thread to poll existing futures and check for timed out ones.
   std::thread futureTimeoutThread_;
   // Lock and shared ptr to currently pending work, set in listenloop() and
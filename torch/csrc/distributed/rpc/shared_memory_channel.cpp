@@ -0,0 +1,280 @@
+#include <torch/csrc/distributed/rpc/shared_memory_channel.h>
+
+#include <c10/util/Exception.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+struct ShmRingHeader {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  uint64_t capacity;
+  // total number of bytes written and read; head - tail bytes are in the ring
+  uint64_t head;
+  uint64_t tail;
+  bool closed;
+};
+
+namespace {
+
+constexpr size_t kRingOffset =
+    (sizeof(ShmRingHeader) + alignof(std::max_align_t) - 1) /
+    alignof(std::max_align_t) * alignof(std::max_align_t);
+
+class ShmLock {
+ public:
+  explicit ShmLock(ShmRingHeader* header) : header_(header) {
+    pthread_mutex_lock(&header_->mutex);
+  }
+  ~ShmLock() {
+    pthread_mutex_unlock(&header_->mutex);
+  }
+  void wait() {
+    pthread_cond_wait(&header_->cond, &header_->mutex);
+  }
+
+ private:
+  ShmRingHeader* header_;
+};
+
+void* mapSegment(int fd, size_t size) {
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+} // namespace
+
+std::unique_ptr<ShmChannel> ShmChannel::create(
+    const std::string& name,
+    size_t capacity) {
+  // A segment left behind by a crashed process that had our pid is stale.
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  TORCH_CHECK(
+      fd != -1,
+      "Failed to create shared memory segment ",
+      name,
+      ": ",
+      strerror(errno));
+  const size_t size = kRingOffset + capacity;
+  void* mapping = nullptr;
+  if (ftruncate(fd, size) == 0) {
+    mapping = mapSegment(fd, size);
+  }
+  const int err = errno;
+  ::close(fd);
+  if (!mapping) {
+    shm_unlink(name.c_str());
+  }
+  TORCH_CHECK(
+      mapping,
+      "Failed to map shared memory segment ",
+      name,
+      ": ",
+      strerror(err));
+
+  auto header = new (mapping) ShmRingHeader();
+  pthread_mutexattr_t mutexAttr;
+  pthread_mutexattr_init(&mutexAttr);
+  pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+  pthread_mutex_init(&header->mutex, &mutexAttr);
+  pthread_mutexattr_destroy(&mutexAttr);
+  pthread_condattr_t condAttr;
+  pthread_condattr_init(&condAttr);
+  pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+  pthread_cond_init(&header->cond, &condAttr);
+  pthread_condattr_destroy(&condAttr);
+  header->capacity = capacity;
+  header->head = 0;
+  header->tail = 0;
+  header->closed = false;
+  return std::unique_ptr<ShmChannel>(
+      new ShmChannel(name, mapping, size, /* owner */ true));
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::open(const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd == -1) {
+    return nullptr;
+  }
+  struct stat st;
+  void* mapping = nullptr;
+  if (fstat(fd, &st) == 0 && st.st_size > (off_t)kRingOffset) {
+    mapping = mapSegment(fd, st.st_size);
+  }
+  ::close(fd);
+  if (!mapping) {
+    return nullptr;
+  }
+  return std::unique_ptr<ShmChannel>(
+      new ShmChannel(name, mapping, st.st_size, /* owner */ false));
+}
+
+ShmChannel::ShmChannel(
+    std::string name,
+    void* mapping,
+    size_t mappingSize,
+    bool owner)
+    : name_(std::move(name)),
+      mapping_(mapping),
+      mappingSize_(mappingSize),
+      header_(static_cast<ShmRingHeader*>(mapping)),
+      owner_(owner) {}
+
+ShmChannel::~ShmChannel() {
+  munmap(mapping_, mappingSize_);
+  if (owner_) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+char* ShmChannel::ring() const {
+  return static_cast<char*>(mapping_) + kRingOffset;
+}
+
+// The ring is only modified by the one writer between head and tail +
+// capacity, and by the one reader between tail and head, so bytes are copied
+// without holding the lock.
+bool ShmChannel::write(const void* data, size_t size) {
+  const char* src = static_cast<const char*>(data);
+  const uint64_t capacity = header_->capacity;
+  while (size > 0) {
+    uint64_t head;
+    size_t n;
+    {
+      ShmLock lock(header_);
+      while (!header_->closed && header_->head - header_->tail == capacity) {
+        lock.wait();
+      }
+      if (header_->closed) {
+        return false;
+      }
+      head = header_->head;
+      n = std::min<uint64_t>(size, capacity - (head - header_->tail));
+    }
+    const size_t pos = head % capacity;
+    const size_t first = std::min<size_t>(n, capacity - pos);
+    memcpy(ring() + pos, src, first);
+    memcpy(ring(), src + first, n - first);
+    {
+      ShmLock lock(header_);
+      header_->head = head + n;
+    }
+    pthread_cond_broadcast(&header_->cond);
+    src += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool ShmChannel::read(void* data, size_t size) {
+  char* dst = static_cast<char*>(data);
+  const uint64_t capacity = header_->capacity;
+  while (size > 0) {
+    uint64_t tail;
+    size_t n;
+    {
+      ShmLock lock(header_);
+      while (!header_->closed && header_->head == header_->tail) {
+        lock.wait();
+      }
+      if (header_->closed) {
+        return false;
+      }
+      tail = header_->tail;
+      n = std::min<uint64_t>(size, header_->head - tail);
+    }
+    const size_t pos = tail % capacity;
+    const size_t first = std::min<size_t>(n, capacity - pos);
+    memcpy(dst, ring() + pos, first);
+    memcpy(dst + first, ring(), n - first);
+    {
+      ShmLock lock(header_);
+      header_->tail = tail + n;
+    }
+    pthread_cond_broadcast(&header_->cond);
+    dst += n;
+    size -= n;
+  }
+  return true;
+}
+
+void ShmChannel::close() {
+  {
+    ShmLock lock(header_);
+    header_->closed = true;
+  }
+  pthread_cond_broadcast(&header_->cond);
+}
+
+std::string copyToSharedMemory(const at::Tensor& buffer) {
+  static std::atomic<uint64_t> counter{0};
+  const std::string name = "/torch_rpc_tensor_" + c10::to_string(getpid()) + "_" +
+      c10::to_string(counter++);
+  const size_t size = buffer.nbytes();
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  TORCH_CHECK(
+      fd != -1,
+      "Failed to create shared memory segment ",
+      name,
+      ": ",
+      strerror(errno));
+  void* ptr = nullptr;
+  if (ftruncate(fd, size) == 0) {
+    ptr = mapSegment(fd, size);
+  }
+  const int err = errno;
+  ::close(fd);
+  if (!ptr) {
+    shm_unlink(name.c_str());
+  }
+  TORCH_CHECK(
+      ptr, "Failed to map shared memory segment ", name, ": ", strerror(err));
+  memcpy(ptr, buffer.data_ptr(), size);
+  munmap(ptr, size);
+  return name;
+}
+
+at::Tensor mapSharedMemory(const std::string& name, int64_t size) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  TORCH_CHECK(
+      fd != -1,
+      "Failed to open shared memory segment ",
+      name,
+      ": ",
+      strerror(errno));
+  // only this mapping refers to the segment from now on
+  shm_unlink(name.c_str());
+  void* ptr = mapSegment(fd, size);
+  const int err = errno;
+  ::close(fd);
+  TORCH_CHECK(
+      ptr, "Failed to map shared memory segment ", name, ": ", strerror(err));
+  return at::from_blob(
+      ptr,
+      {size},
+      [size](void* p) { munmap(p, size); },
+      at::TensorOptions(at::kChar));
+}
+
+void unlinkSharedMemory(const std::string& name) {
+  shm_unlink(name.c_str());
+}
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
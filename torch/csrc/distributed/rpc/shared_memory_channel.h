@@ -0,0 +1,68 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <memory>
+#include <string>
+
+namespace torch {
+namespace distributed {
+namespace rpc {
+
+struct ShmRingHeader;
+
+// A single-producer single-consumer byte stream between two processes on the
+// same host, backed by a ring buffer in a POSIX shared memory segment. The
+// receiving end creates the segment and the sending end opens it by name.
+// Both ends block while the ring is full or empty, on a process-shared
+// condition variable.
+class TORCH_API ShmChannel {
+ public:
+  // Creates the segment `name` holding a ring of `capacity` bytes. The
+  // segment is unlinked when the channel is destroyed.
+  static std::unique_ptr<ShmChannel> create(
+      const std::string& name,
+      size_t capacity);
+  // Opens the segment `name` created by the other end. Returns nullptr if it
+  // can't, e.g. if the other end is in another IPC namespace.
+  static std::unique_ptr<ShmChannel> open(const std::string& name);
+
+  ~ShmChannel();
+
+  ShmChannel(const ShmChannel&) = delete;
+  ShmChannel& operator=(const ShmChannel&) = delete;
+
+  // Both return false if the channel was closed before `size` bytes were
+  // transferred.
+  bool write(const void* data, size_t size);
+  bool read(void* data, size_t size);
+
+  // Fails all pending and future reads and writes, on both ends.
+  void close();
+
+ private:
+  ShmChannel(std::string name, void* mapping, size_t mappingSize, bool owner);
+
+  char* ring() const;
+
+  const std::string name_;
+  void* const mapping_;
+  const size_t mappingSize_;
+  ShmRingHeader* const header_;
+  // whether this end created the segment and unlinks it
+  const bool owner_;
+};
+
+// Tensor data too large to be worth streaming through a ShmChannel goes
+// through a shared memory segment of its own instead: the sender copies it
+// there once, and the receiver maps the segment as the tensor's storage.
+TORCH_API std::string copyToSharedMemory(const at::Tensor& buffer);
+// Maps the segment `name` of `size` bytes as a char tensor and unlinks it.
+TORCH_API at::Tensor mapSharedMemory(const std::string& name, int64_t size);
+// Removes a segment that will not be mapped, e.g. if sending failed.
+TORCH_API void unlinkSharedMemory(const std::string& name);
+
+} // namespace rpc
+} // namespace distributed
+} // namespace torch
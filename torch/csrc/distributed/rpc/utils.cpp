@@ -101,6 +101,9 @@ std::unique_ptr<RpcCommandBase> deserializeResponse(const Message& response) {
 
 namespace {
 
+static const char* kMeta = "meta";
+static const char* kPayload = "payload";
+
 // Helper for wireDeserialize() below.
 //
 // The format we use below looks like:
@@ -115,10 +118,17 @@ namespace {
 //    - "meta"    - metadata for the unpickler
 //    - "0" ...   - tensor sections for the unpickler
 //
+// In the scattered format (wireSerializeScattered), the tensor sections are
+// listed in the header but their data is sent separately; if `bufferSizes` is
+// given, their sizes are appended to it and they are not expected to follow.
+//
 // Note that per the header comments, the format is subject to change,
 // and is best used for rpcs, rather than persistent disk storage.
 std::unordered_map<std::string, std::pair<const char*, size_t>>
-parseWireSections(const void* data, size_t data_size) {
+parseWireSections(
+    const void* data,
+    size_t data_size,
+    std::vector<int64_t>* bufferSizes = nullptr) {
   const char* ptr = static_cast<const char*>(data);
   const char* endp = ptr + data_size;
 
@@ -160,6 +170,11 @@ parseWireSections(const void* data, size_t data_size) {
 
   std::unordered_map<std::string, std::pair<const char*, size_t>> out;
   for (const auto& headerEnt : headerEnts) {
+    if (bufferSizes && headerEnt.first != kPayload &&
+        headerEnt.first != kMeta) {
+      bufferSizes->push_back(headerEnt.second);
+      continue;
+    }
     out[headerEnt.first] = {ptr, headerEnt.second};
     ptr += headerEnt.second;
   }
@@ -169,43 +184,20 @@ parseWireSections(const void* data, size_t data_size) {
   return out;
 }
 
-static const char* kMeta = "meta";
-static const char* kPayload = "payload";
-}; // namespace
-
-c10::List<at::Tensor> cloneSparseTensors(
-    const std::vector<at::Tensor>& tensors) {
-  // Sanity-check: If the majority of bits don't need to go over the wire,
-  // force a clone(). Some Tensors are effectively small views, only using
-  // ~1% of the underlying Storage.
-  auto worthRecopying = [](const at::Tensor& t) -> bool {
-    auto storageSize = t.storage().elementSize() * t.storage().numel();
-    auto usefulSize = t.element_size() * t.numel();
-    constexpr size_t kMinMultiple = 2;
-    constexpr size_t kMinRecopyBytes = 8 * 1024;
-    return storageSize >= kMinRecopyBytes &&
-        storageSize >= usefulSize * kMinMultiple;
-  };
-  c10::List<at::Tensor> pTensors;
-  pTensors.reserve(tensors.size());
-  for (const auto& t : tensors) {
-    pTensors.push_back(worthRecopying(t) ? t.clone() : t);
-  }
-  return pTensors;
-}
+struct WireEntry {
+  std::string name;
+  const char* data;
+  size_t size;
+};
 
-std::string wireSerialize(
+// Lists the payload and the sections pickling `tensors` into `metaEntry`,
+// whose data stays valid as long as `tensorData`.
+std::vector<WireEntry> wireEntries(
     const std::vector<char>& payload,
-    const std::vector<at::Tensor>& tensors) {
-  struct Ent {
-    std::string name;
-    const char* data;
-    size_t size;
-  };
-  std::vector<Ent> entries;
-  std::string metaEntry;
-  std::vector<jit::WriteableTensorData> tensorData;
-
+    const std::vector<at::Tensor>& tensors,
+    std::string& metaEntry,
+    std::vector<jit::WriteableTensorData>& tensorData) {
+  std::vector<WireEntry> entries;
   if (!payload.empty()) {
     entries.push_back({kPayload, payload.data(), payload.size()});
   }
@@ -220,7 +212,6 @@ std::string wireSerialize(
     pickler.protocol();
     pickler.pushIValue(cloneSparseTensors(tensors));
     pickler.stop();
-    // tensorData is in function scope so that the data() pointers stay valid.
     tensorData = pickler.tensorData();
     entries.push_back({kMeta, metaEntry.data(), metaEntry.size()});
     for (size_t i = 0; i < tensorData.size(); i++) {
@@ -229,17 +220,95 @@ std::string wireSerialize(
                          tensorData[i].sizeInBytes()});
     }
   }
+  return entries;
+}
 
+std::string wireHeader(const std::vector<WireEntry>& entries) {
   std::string header;
-  size_t tot = 0;
   for (const auto& e : entries) {
-    tot += e.size;
     header.append(e.name)
         .append(" ")
         .append(c10::to_string(e.size))
         .append("\n");
   }
   header.push_back('\n');
+  return header;
+}
+
+// Unpickles the tensors described by the "meta" section, reading the data of
+// tensor section `name` with `readSection`.
+std::vector<at::Tensor> unpickleTensors(
+    const std::pair<const char*, size_t>& metaData,
+    const std::function<at::DataPtr(const std::string&)>& readSection) {
+  size_t metaDataPos = 0;
+  auto metaDataReadFunc = [&](char* buf, size_t n) -> size_t {
+    if (metaDataPos >= metaData.second || n == 0) {
+      return 0;
+    }
+    size_t toCopy = std::min(metaDataPos + n, metaData.second) - metaDataPos;
+    memcpy(buf, metaData.first + metaDataPos, toCopy);
+    metaDataPos += toCopy;
+    return toCopy;
+  };
+
+  torch::jit::Unpickler unpickler(
+      metaDataReadFunc, nullptr, nullptr, readSection, {});
+  auto ival = unpickler.parse_ivalue();
+  std::vector<at::Tensor> tensors;
+  for (auto&& t : ival.toTensorList()) {
+    tensors.emplace_back(std::move(t));
+  }
+  return tensors;
+}
+
+std::vector<char> payloadSection(
+    const std::unordered_map<std::string, std::pair<const char*, size_t>>&
+        sections) {
+  std::vector<char> payload;
+  auto payloadIt = sections.find(kPayload);
+  if (payloadIt != sections.end() && payloadIt->second.second != 0) {
+    payload.assign(
+        payloadIt->second.first,
+        payloadIt->second.first + payloadIt->second.second);
+  }
+  return payload;
+}
+}; // namespace
+
+c10::List<at::Tensor> cloneSparseTensors(
+    const std::vector<at::Tensor>& tensors) {
+  // Sanity-check: If the majority of bits don't need to go over the wire,
+  // force a clone(). Some Tensors are effectively small views, only using
+  // ~1% of the underlying Storage.
+  auto worthRecopying = [](const at::Tensor& t) -> bool {
+    auto storageSize = t.storage().elementSize() * t.storage().numel();
+    auto usefulSize = t.element_size() * t.numel();
+    constexpr size_t kMinMultiple = 2;
+    constexpr size_t kMinRecopyBytes = 8 * 1024;
+    return storageSize >= kMinRecopyBytes &&
+        storageSize >= usefulSize * kMinMultiple;
+  };
+  c10::List<at::Tensor> pTensors;
+  pTensors.reserve(tensors.size());
+  for (const auto& t : tensors) {
+    pTensors.push_back(worthRecopying(t) ? t.clone() : t);
+  }
+  return pTensors;
+}
+
+std::string wireSerialize(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors) {
+  std::string metaEntry;
+  // tensorData is in function scope so that the data() pointers stay valid.
+  std::vector<jit::WriteableTensorData> tensorData;
+  auto entries = wireEntries(payload, tensors, metaEntry, tensorData);
+
+  std::string header = wireHeader(entries);
+  size_t tot = 0;
+  for (const auto& e : entries) {
+    tot += e.size;
+  }
 
   std::string out;
   out.reserve(header.size() + tot);
@@ -255,28 +324,11 @@ std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
     size_t data_size) {
   auto sections = parseWireSections(data, data_size);
 
-  std::vector<char> payload;
-  auto payloadIt = sections.find(kPayload);
-  if (payloadIt != sections.end() && payloadIt->second.second != 0) {
-    payload.assign(
-        payloadIt->second.first,
-        payloadIt->second.first + payloadIt->second.second);
-  }
+  std::vector<char> payload = payloadSection(sections);
 
   std::vector<at::Tensor> tensors;
   auto metaIt = sections.find(kMeta);
   if (metaIt != sections.end()) {
-    const auto& metaData = metaIt->second;
-    size_t metaDataPos = 0;
-    auto metaDataReadFunc = [&](char* buf, size_t n) -> size_t {
-      if (metaDataPos >= metaData.second || n == 0) {
-        return 0;
-      }
-      size_t toCopy = std::min(metaDataPos + n, metaData.second) - metaDataPos;
-      memcpy(buf, metaData.first + metaDataPos, toCopy);
-      metaDataPos += toCopy;
-      return toCopy;
-    };
     auto sectionReadFunc = [&](const std::string& ename) -> at::DataPtr {
       auto it = sections.find(ename);
       if (it == sections.end()) {
@@ -289,13 +341,76 @@ std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
       }
       return dptr;
     };
+    tensors = unpickleTensors(metaIt->second, sectionReadFunc);
+  }
+  return {std::move(payload), std::move(tensors)};
+}
 
-    torch::jit::Unpickler unpickler(
-        metaDataReadFunc, nullptr, nullptr, sectionReadFunc, {});
-    auto ival = unpickler.parse_ivalue();
-    for (auto&& t : ival.toTensorList()) {
-      tensors.emplace_back(std::move(t));
-    }
+std::pair<std::string, std::vector<at::Tensor>> wireSerializeScattered(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors) {
+  std::string metaEntry;
+  std::vector<jit::WriteableTensorData> tensorData;
+  auto entries = wireEntries(payload, tensors, metaEntry, tensorData);
+
+  std::string out = wireHeader(entries);
+  out.insert(out.end(), payload.begin(), payload.end());
+  out.append(metaEntry);
+
+  std::vector<at::Tensor> buffers;
+  buffers.reserve(tensorData.size());
+  for (const auto& data : tensorData) {
+    // The buffer keeps the storage (or its copy to CPU) alive.
+    buffers.push_back(torch::from_blob(
+        const_cast<char*>(data.data()),
+        {static_cast<int64_t>(data.sizeInBytes())},
+        [data](void*) {},
+        {at::kChar}));
+  }
+  return {std::move(out), std::move(buffers)};
+}
+
+std::vector<int64_t> wireBufferSizes(const void* data, size_t data_size) {
+  std::vector<int64_t> bufferSizes;
+  parseWireSections(data, data_size, &bufferSizes);
+  return bufferSizes;
+}
+
+std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserializeScattered(
+    const void* data,
+    size_t data_size,
+    std::vector<at::Tensor> buffers) {
+  std::vector<int64_t> bufferSizes;
+  auto sections = parseWireSections(data, data_size, &bufferSizes);
+  TORCH_CHECK(
+      buffers.size() == bufferSizes.size(),
+      "Expected ",
+      bufferSizes.size(),
+      " tensor buffers, got ",
+      buffers.size());
+
+  std::vector<char> payload = payloadSection(sections);
+
+  std::vector<at::Tensor> tensors;
+  auto metaIt = sections.find(kMeta);
+  if (metaIt != sections.end()) {
+    auto bufferReadFunc = [&](const std::string& ename) -> at::DataPtr {
+      size_t index = c10::stoll(ename);
+      TORCH_CHECK(index < buffers.size(), "Couldn't find entity ", ename);
+      at::Tensor& buffer = buffers[index];
+      TORCH_CHECK(
+          buffer.device().is_cpu() && buffer.is_contiguous() &&
+              static_cast<int64_t>(buffer.nbytes()) == bufferSizes[index],
+          "Tensor buffer ",
+          ename,
+          " does not match the header");
+      // The storage takes over the received buffer instead of copying it.
+      return {buffer.data_ptr(),
+              new at::Tensor(buffer),
+              [](void* ctx) { delete static_cast<at::Tensor*>(ctx); },
+              at::Device(at::kCPU)};
+    };
+    tensors = unpickleTensors(metaIt->second, bufferReadFunc);
   }
   return {std::move(payload), std::move(tensors)};
 }
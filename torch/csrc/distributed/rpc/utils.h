@@ -26,6 +26,26 @@ TORCH_API std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
     const void* data,
     size_t data_size);
 
+// Scatter/gather variant of the above, for sending large tensors without
+// copying them. Returns a header, holding the payload and the tensor metadata,
+// and one char tensor per tensor storage viewing its data. The receiver sizes
+// the buffers to receive the data into with wireBufferSizes(header), and the
+// deserialized tensors take them over.
+TORCH_API std::pair<std::string, std::vector<at::Tensor>>
+wireSerializeScattered(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors);
+
+TORCH_API std::vector<int64_t> wireBufferSizes(
+    const void* data,
+    size_t data_size);
+
+TORCH_API std::pair<std::vector<char>, std::vector<at::Tensor>>
+wireDeserializeScattered(
+    const void* data,
+    size_t data_size,
+    std::vector<at::Tensor> buffers);
+
 // Some Tensors are effectively views of larger Tensors, where only a small
 // subset of the Storage data is referenced. This normally is good and avoids
 // copies when kept locally, but if we naively push the whole Storage over the
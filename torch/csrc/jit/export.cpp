@@ -28,12 +28,18 @@ void writeArchiveAndTensors(
     const char* data,
     size_t size,
     const std::vector<WriteableTensorData>& tensors,
-    caffe2::serialize::PyTorchStreamWriter& out) {
+    caffe2::serialize::PyTorchStreamWriter& out,
+    uint64_t tensor_alignment) {
   std::string prefix = archive_name + "/";
   size_t i = 0;
   for (const auto& td : tensors) {
     std::string fname = prefix + std::to_string(i++);
-    out.writeRecord(fname, td.data(), td.sizeInBytes());
+    out.writeRecord(
+        fname,
+        td.data(),
+        td.sizeInBytes(),
+        /*compress=*/false,
+        tensor_alignment);
   }
   std::string fname = archive_name + ".pkl";
   out.writeRecord(fname, data, size);
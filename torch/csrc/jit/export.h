@@ -47,32 +47,40 @@ TORCH_API std::string pretty_print_onnx(
     const std::map<std::string, int>& custom_opsets = {},
     bool add_node_names = true);
 
+// `tensor_alignment` is the alignment of tensor data records in the archive,
+// e.g. caffe2::serialize::kPageAlignment to allow O_DIRECT reads of tensor
+// data. It must be a power of two of at least
+// caffe2::serialize::kFieldAlignment.
 TORCH_API void ExportModule(
     const script::Module& module,
     std::ostream& out,
     const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
-    bool bytecode_format = false);
+    bool bytecode_format = false,
+    uint64_t tensor_alignment = caffe2::serialize::kFieldAlignment);
 
 TORCH_API void ExportModule(
     const script::Module& module,
     const std::string& filename,
     const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
-    bool bytecode_format = false);
+    bool bytecode_format = false,
+    uint64_t tensor_alignment = caffe2::serialize::kFieldAlignment);
 
 TORCH_API void ExportModule(
     const script::Module& module,
     const std::function<size_t(const void*, size_t)>& writer_func,
     const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
-    bool bytecode_format = false);
+    bool bytecode_format = false,
+    uint64_t tensor_alignment = caffe2::serialize::kFieldAlignment);
 
 // Write the bytes of a pickle archive and the tensors referenced inside that
-// archive
+// archive, with the tensor data aligned to `tensor_alignment`
 TORCH_API void writeArchiveAndTensors(
     const std::string& archive_name,
     const char* pickle_bytes,
     size_t size,
     const std::vector<WriteableTensorData>& tensors,
-    caffe2::serialize::PyTorchStreamWriter& out);
+    caffe2::serialize::PyTorchStreamWriter& out,
+    uint64_t tensor_alignment = caffe2::serialize::kFieldAlignment);
 
 // Surrounding system can install an additional hook to produce extra files
 // with metadata based on environment every time a module is serialized.
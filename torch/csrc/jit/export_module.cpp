@@ -43,8 +43,19 @@ class ScriptModuleSerializer {
   void serialize(
       const script::Module& module,
       const script::ExtraFilesMap& extra_files,
-      bool bytecode_format) {
+      bool bytecode_format,
+      uint64_t tensor_alignment) {
     C10_LOG_API_USAGE_ONCE("torch.script.save");
+    // Checked up front, so that a bad alignment fails before any record is
+    // written rather than at the first tensor.
+    TORCH_CHECK(
+        tensor_alignment >= caffe2::serialize::kFieldAlignment &&
+            (tensor_alignment & (tensor_alignment - 1)) == 0,
+        "tensor alignment must be a power of two of at least ",
+        caffe2::serialize::kFieldAlignment,
+        ", got ",
+        tensor_alignment);
+    tensor_alignment_ = tensor_alignment;
     writeExtraFiles(module, extra_files);
     // Serialize the model object
     writeArchive("data", module._ivalue());
@@ -78,7 +89,12 @@ class ScriptModuleSerializer {
     std::string prefix = archive_name + "/";
     for (const auto& td : data_pickle.tensorData()) {
       std::string fname = prefix + c10::to_string(i++);
-      writer_.writeRecord(fname, td.data(), td.sizeInBytes());
+      writer_.writeRecord(
+          fname,
+          td.data(),
+          td.sizeInBytes(),
+          /*compress=*/false,
+          tensor_alignment_);
     }
     std::string fname = archive_name + ".pkl";
     writer_.writeRecord(fname, data.data(), data.size());
@@ -245,6 +261,7 @@ class ScriptModuleSerializer {
   }
 
   caffe2::serialize::PyTorchStreamWriter writer_;
+  uint64_t tensor_alignment_ = caffe2::serialize::kFieldAlignment;
   std::vector<at::Tensor> constant_table_;
   std::unordered_set<c10::NamedTypePtr> converted_types_;
   std::vector<c10::NamedTypePtr> class_deps_;
@@ -258,31 +275,37 @@ void ExportModule(
     const script::Module& module,
     std::ostream& out,
     const script::ExtraFilesMap& extra_files,
-    bool bytecode_format) {
+    bool bytecode_format,
+    uint64_t tensor_alignment) {
   ScriptModuleSerializer serializer(
     [&](const void* buf, size_t nbytes) -> size_t {
       out.write(static_cast<const char *>(buf), nbytes);
       return !out ? 0 : nbytes;
     });
-  serializer.serialize(module, extra_files, bytecode_format);
+  serializer.serialize(
+      module, extra_files, bytecode_format, tensor_alignment);
 }
 
 void ExportModule(
     const script::Module& module,
     const std::string& filename,
     const script::ExtraFilesMap& extra_files,
-    bool bytecode_format) {
+    bool bytecode_format,
+    uint64_t tensor_alignment) {
   ScriptModuleSerializer serializer(filename);
-  serializer.serialize(module, extra_files, bytecode_format);
+  serializer.serialize(
+      module, extra_files, bytecode_format, tensor_alignment);
 }
 
 void ExportModule(
     const script::Module& module,
     const std::function<size_t(const void*, size_t)>& writer_func,
     const script::ExtraFilesMap& extra_files,
-    bool bytecode_format) {
+    bool bytecode_format,
+    uint64_t tensor_alignment) {
   ScriptModuleSerializer serializer(writer_func);
-  serializer.serialize(module, extra_files, bytecode_format);
+  serializer.serialize(
+      module, extra_files, bytecode_format, tensor_alignment);
 }
 
 } // namespace jit
@@ -0,0 +1,175 @@
+#include <torch/csrc/jit/fork_scheduler.h>
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+std::mutex options_mutex;
+ForkSchedulerOptions scheduler_options;
+
+std::atomic<uint64_t> inlined{0};
+std::atomic<uint64_t> launched{0};
+// Launched branches that didn't finish yet.
+std::atomic<size_t> in_flight{0};
+
+int64_t wallTimeNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// CPU time of all threads of the process, or -1 where it isn't available.
+int64_t processCpuTimeNs() {
+#ifndef _WIN32
+  timespec ts;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+#endif
+  return -1;
+}
+
+double numCores() {
+  static const double cores = std::max(std::thread::hardware_concurrency(), 1u);
+  return cores;
+}
+
+bool reserveInFlight(const ForkSchedulerOptions& options) {
+  const size_t max_in_flight = options.max_in_flight > 0
+      ? options.max_in_flight
+      : static_cast<size_t>(at::get_num_interop_threads());
+  size_t current = in_flight.load();
+  while (current < max_in_flight) {
+    if (in_flight.compare_exchange_weak(current, current + 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+struct InFlightGuard {
+  ~InFlightGuard() {
+    --in_flight;
+  }
+};
+
+template <typename T>
+T movingAverage(T average, T sample) {
+  return average + (sample - average) / 4;
+}
+
+} // namespace
+
+void setForkSchedulerOptions(const ForkSchedulerOptions& new_options) {
+  std::lock_guard<std::mutex> lock(options_mutex);
+  scheduler_options = new_options;
+}
+
+ForkSchedulerOptions getForkSchedulerOptions() {
+  std::lock_guard<std::mutex> lock(options_mutex);
+  return scheduler_options;
+}
+
+ForkSchedulerStats getForkSchedulerStats() {
+  ForkSchedulerStats stats;
+  stats.inlined = inlined.load();
+  stats.launched = launched.load();
+  return stats;
+}
+
+void resetForkSchedulerStats() {
+  inlined = 0;
+  launched = 0;
+}
+
+ForkSite::Decision ForkSite::decide(const ForkSchedulerOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t run = runs_++;
+  // Launched runs are measured too, so unmeasured branches are launched.
+  if (!work_measured_) {
+    return Decision::Launch;
+  }
+  if (work_ns_ < options.min_launch_work_us * 1000) {
+    return Decision::Inline;
+  }
+  if (options.min_idle_cores <= 0) {
+    return Decision::Launch;
+  }
+  if (run >= next_measure_) {
+    next_measure_ = options.remeasure_interval > 0
+        ? run + options.remeasure_interval
+        : std::numeric_limits<size_t>::max();
+    return Decision::Measure;
+  }
+  if (numCores() - busy_cores_ < options.min_idle_cores) {
+    return Decision::Inline;
+  }
+  return Decision::Launch;
+}
+
+void ForkSite::recordWork(int64_t work_ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  work_ns_ = work_measured_ ? movingAverage(work_ns_, work_ns) : work_ns;
+  work_measured_ = true;
+}
+
+void ForkSite::recordBusyCores(double busy_cores) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  busy_cores_ = busy_cores_measured_ ? movingAverage(busy_cores_, busy_cores)
+                                     : busy_cores;
+  busy_cores_measured_ = true;
+}
+
+void ForkSite::run(std::function<void()> branch) {
+  const auto options = getForkSchedulerOptions();
+  if (!options.enabled) {
+    ++launched;
+    at::launch(std::move(branch));
+    return;
+  }
+
+  auto decision = decide(options);
+  if (decision == Decision::Launch && !reserveInFlight(options)) {
+    decision = Decision::Inline;
+  }
+  if (decision == Decision::Launch) {
+    ++launched;
+    auto self = shared_from_this();
+    at::launch([self, branch]() {
+      InFlightGuard guard;
+      const auto start = wallTimeNs();
+      branch();
+      self->recordWork(wallTimeNs() - start);
+    });
+    return;
+  }
+
+  ++inlined;
+  const bool exclusive = in_flight.load() == 0;
+  const auto start = wallTimeNs();
+  const auto cpu_start = processCpuTimeNs();
+  branch();
+  const auto cpu_time = processCpuTimeNs() - cpu_start;
+  const auto work = wallTimeNs() - start;
+  recordWork(work);
+  if (decision == Decision::Measure && exclusive && in_flight.load() == 0 &&
+      cpu_start >= 0 && work > 0) {
+    recordBusyCores(static_cast<double>(cpu_time) / work);
+  }
+}
+
+} // namespace jit
+} // namespace torch
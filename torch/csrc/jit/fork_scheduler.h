@@ -0,0 +1,94 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace torch {
+namespace jit {
+
+// Note [Scheduling forked subgraphs]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Forks written by users always go to the inter-op pool (at::launch). The
+// ones ForkIndependentBranches creates are marked with attr::scheduled:
+// such a prim::fork node measures the branch it forks, and decides on every
+// run whether the branch is launched, or runs inline on the forking thread
+// before it continues:
+//
+// - Branches that took less than min_launch_work_us run inline: handing
+//   them to another thread costs more than running them concurrently saves.
+// - Branches that leave fewer than min_idle_cores of the machine's cores idle
+//   on their own run inline too: intra-op parallelism already uses the cores,
+//   and running other branches next to them would only make them compete
+//   for those cores.
+// - Every other branch is launched, as long as fewer than max_in_flight
+//   launched branches are running; the rest run inline.
+//
+// So cores go to inter-op parallelism for the branches that leave them idle,
+// and to intra-op parallelism for the ones that don't. The intra-op thread
+// count itself stays a process-wide setting (at::set_num_threads): none of
+// the ATen parallel backends can limit it for a single branch.
+//
+// The time a branch takes is measured on every run, launched or not, and a
+// branch is launched on its first run. The cores a branch keeps busy are the
+// process CPU time spent during a run divided by its wall time, so they can
+// only be measured inline: a branch that takes long enough to be launched is
+// run inline once for that, and again every remeasure_interval runs. They
+// are only measured while no launched branch is running, but still count any
+// other thread of the process that happens to be busy. They are not measured
+// on Windows, where branches count as single threaded.
+
+struct TORCH_API ForkSchedulerOptions {
+  // When false, every scheduled branch is launched, without measuring it.
+  bool enabled = true;
+  int64_t min_launch_work_us = 50;
+  // 0 launches branches however many cores they keep busy.
+  double min_idle_cores = 1;
+  // 0 stands for at::get_num_interop_threads().
+  size_t max_in_flight = 0;
+  // 0 only measures the cores a branch keeps busy once.
+  size_t remeasure_interval = 100;
+};
+
+TORCH_API void setForkSchedulerOptions(const ForkSchedulerOptions& options);
+TORCH_API ForkSchedulerOptions getForkSchedulerOptions();
+
+struct TORCH_API ForkSchedulerStats {
+  // The number of branches run inline and launched.
+  uint64_t inlined = 0;
+  uint64_t launched = 0;
+};
+
+TORCH_API ForkSchedulerStats getForkSchedulerStats();
+TORCH_API void resetForkSchedulerStats();
+
+// The measurements of the branch of one prim::fork node.
+class TORCH_API ForkSite : public std::enable_shared_from_this<ForkSite> {
+ public:
+  // Runs `branch`, either right away or on the inter-op pool.
+  void run(std::function<void()> branch);
+
+ private:
+  enum class Decision { Measure, Inline, Launch };
+
+  Decision decide(const ForkSchedulerOptions& options);
+  void recordWork(int64_t work_ns);
+  void recordBusyCores(double busy_cores);
+
+  std::mutex mutex_;
+  size_t runs_ = 0;
+  // Exponential moving averages over the runs measured so far.
+  bool work_measured_ = false;
+  int64_t work_ns_ = 0;
+  bool busy_cores_measured_ = false;
+  double busy_cores_ = 1;
+  // The run on which to measure busy_cores_ next.
+  size_t next_measure_ = 0;
+};
+
+} // namespace jit
+} // namespace torch
@@ -330,6 +330,8 @@ std::string generateKernel(
   std::stringstream tensorOffsets;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
+  // whether every tensor is addressed by the linear index itself
+  bool all_contiguous = true;
 
   // Lambda for writing arguments
   auto emitFormal = [&](const Value* n, const TensorDesc& desc) {
@@ -343,6 +345,7 @@ std::string generateKernel(
               formals.size()); // can't be unique() because Param may be an output
       const auto nDim = desc.nDim();
       emitIndexingFor(tensorOffsets, tensor, nDim, desc.lastIsContiguous());
+      all_contiguous &= nDim <= 1 && desc.lastIsContiguous();
       env.s("tensor", tensor);
       env.d("nDim", nDim);
       env.s("scalar_type", scalarTypeName(desc.scalar_type));
@@ -509,6 +512,10 @@ std::string generateKernel(
     env.s("RandInit", "");
   }
 
+  // Contiguous CPU kernels are a plain loop over arrays, which the compiler
+  // vectorizes with the instruction set it is given (see cpu/fused_kernel.cpp)
+  env.s("simdPragma", all_contiguous ? "#pragma omp simd" : "");
+
   // Insantiates the CUDA or CPU-specific templates
   env.s("tensorOffsets", tensorOffsets.str());
   env.s("kernelBody", body.str());
@@ -1,6 +1,9 @@
 #include <torch/csrc/jit/fuser/cpu/fused_kernel.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/DispatchStub.h>
 #include <c10/util/Exception.h>
 #include <c10/util/Optional.h>
+#include <caffe2/core/macros.h>
 #include <torch/csrc/jit/code_template.h>
 #include <torch/csrc/jit/fuser/compiler.h>
 #include <torch/csrc/jit/fuser/cpu/temp_file.h>
@@ -10,7 +13,16 @@
 #include <torch/csrc/jit/fuser/cpu/msvc_arch.h>
 #endif
 
+#ifndef _MSC_VER
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -192,9 +204,13 @@ struct CompilerConfig {
     const std::string openmp_flags = "/openmp";
   #else
     std::string cxx = "g++";
-    const std::string openmp_flags = "-fopenmp";
+    // Kernels are parallelized by the caller (see launch_raw), OpenMP is only
+    // used for its simd pragma and needs no runtime library.
+    const std::string openmp_flags = "-fopenmp-simd";
   #endif
   bool openmp = true;
+  // whether to compile for the vector instruction set of the host
+  bool arch = true;
 };
 
 static CompilerConfig& getConfig() {
@@ -224,25 +240,52 @@ static std::string getArchFlags() {
     return "";
   }
 }
-static const std::string arch_flags = getArchFlags();
 static const std::string compile_string =
     "cd /D \"" + temp_dir + "\" && "
-    "${cxx} /nologo /MD /Ox " + arch_flags + " /LD /EHsc "
+    "${cxx} /nologo /MD /Ox ${arch_flags} /LD /EHsc "
     "${fopenmp} \"${cpp_file}\" /link /out:\"${so_file}\"";
 #else
+// Instead, we enable the instruction set the ATen CPU kernels are dispatched
+// to (see DispatchStub.h), which also honors ATEN_CPU_CAPABILITY. AVX512 is
+// left out for the reason above.
+static std::string getArchFlags() {
+#if defined(__x86_64__) || defined(__i386__)
+  switch (at::native::get_cpu_capability()) {
+    case at::native::CPUCapability::AVX2:
+      return "-mavx2 -mfma";
+    case at::native::CPUCapability::AVX:
+      return "-mavx";
+    default:
+      return "";
+  }
+#else
+  return "";
+#endif
+}
 static const std::string compile_string =
     "\"${cxx}\" -O3 -g "
 #ifndef __PPC64__
 //  "-march=native "
 #endif
+    "${arch_flags} "
     "-std=c++14 -fPIC ${fopenmp} -shared \"${cpp_file}\" -o \"${so_file}\" -lm";
 #endif
+static const std::string arch_flags = getArchFlags();
+
+// Everything but the file names that goes into the compiler invocation
+static std::string compileFlags() {
+  auto& config = getConfig();
+  return config.cxx + " " + (config.arch ? arch_flags : "") + " " +
+      (config.openmp ? config.openmp_flags : "");
+}
+
 static void runCompiler(
     const std::string& cpp_file,
     const std::string& so_file) {
   auto& config = getConfig();
   TemplateEnv env;
   env.s("cxx", config.cxx);
+  env.s("arch_flags", config.arch ? arch_flags : "");
   env.s("fopenmp", config.openmp ? config.openmp_flags : "");
   env.s("cpp_file", cpp_file);
   env.s("so_file", so_file);
@@ -258,6 +301,13 @@ static void runCompiler(
     config.openmp = false; // disable for future compiles
     return runCompiler(cpp_file, so_file);
   }
+  if (config.arch && !arch_flags.empty() && r != 0) {
+    std::cerr
+        << "warning: pytorch jit fuser failed to compile with " << arch_flags
+        << ", trying without it...\n";
+    config.arch = false; // disable for future compiles
+    return runCompiler(cpp_file, so_file);
+  }
   TORCH_CHECK(r == 0, "Failed to compile a fused CPU kernel");
 }
 
@@ -274,6 +324,85 @@ static void disas(const std::string& so_file) {
   AT_ASSERT(r == 0);
 }
 
+#ifndef _MSC_VER
+// Compiled kernels are kept in a directory shared across processes, as
+// <key>.cpp and <key>.so, where the key hashes the code, the compiler
+// flags, the compiler version and the PyTorch version. Nothing is ever
+// evicted; removing the directory clears the cache.
+// The directory is PYTORCH_FUSION_CACHE_DIR if set (an empty value disables
+// the cache), or torch/fuser in the user's cache directory. Returns an empty
+// string if there is no usable directory.
+static std::string getCacheDir() {
+  std::string dir;
+  if (const char* env = getenv("PYTORCH_FUSION_CACHE_DIR")) {
+    dir = env;
+  } else if (const char* xdg = getenv("XDG_CACHE_HOME")) {
+    dir = std::string(xdg) + "/torch/fuser";
+  } else if (const char* home = getenv("HOME")) {
+    dir = std::string(home) + "/.cache/torch/fuser";
+  }
+  if (dir.empty()) {
+    return dir;
+  }
+  for (size_t pos = dir.find('/', 1); pos != std::string::npos;
+       pos = dir.find('/', pos + 1)) {
+    mkdir(dir.substr(0, pos).c_str(), 0700);
+  }
+  mkdir(dir.c_str(), 0700);
+  if (access(dir.c_str(), W_OK) != 0) {
+    return "";
+  }
+  return dir;
+}
+
+// What `cxx --version` prints, so that kernels built by another compiler at
+// the same path, or by another version of it, aren't loaded.
+static const std::string& compilerVersion() {
+  static const std::string version = [] {
+    std::string result;
+    const std::string cmd = "\"" + getConfig().cxx + "\" --version 2>&1";
+    if (FILE* pipe = popen(cmd.c_str(), "r")) {
+      char buffer[128];
+      while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        result += buffer;
+      }
+      pclose(pipe);
+    }
+    return result;
+  }();
+  return version;
+}
+
+static std::string cacheKey(const std::string& code) {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  auto update = [&](const std::string& s) {
+    for (unsigned char c : s) {
+      hash = (hash ^ c) * 1099511628211ULL;
+    }
+  };
+  update(std::to_string(CAFFE2_VERSION));
+  update(compilerVersion());
+  update(compile_string);
+  update(compileFlags());
+  update(code);
+  std::ostringstream key;
+  key << "pytorch_fuser_" << std::hex << std::setw(16) << std::setfill('0')
+      << hash;
+  return key.str();
+}
+
+static bool fileContentEquals(const std::string& path, const std::string& s) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::string content(
+      (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  return content == s;
+}
+#endif
+
 FusedKernelCPU::FusedKernelCPU(
     std::string name,
     std::string code,
@@ -290,24 +419,71 @@ FusedKernelCPU::FusedKernelCPU(
           std::move(chunk_desc),
           std::move(concat_desc),
           has_random) {
+#ifdef _MSC_VER
   TempFile so_file(so_template, so_suffix_len);
   TempFile cpp_file(cpp_template, cpp_suffix_len);
   cpp_file.write(code_);
   cpp_file.sync();
-#ifdef _MSC_VER
   so_file.close();
   cpp_file.close();
-#endif
   runCompiler(cpp_file.name(), so_file.name());
   if (debugFuser() >= 2)
     disas(so_file.name());
   so_lib = make_unique<at::DynamicLibrary>(so_file.name().c_str());
+#else
+  static const std::string cache_dir = getCacheDir();
+  if (!cache_dir.empty()) {
+    // The .so is published before the .cpp, so a matching .cpp means the .so
+    // is complete. Comparing the code guards against hash collisions.
+    const std::string cached = cache_dir + "/" + cacheKey(code_);
+    if (fileContentEquals(cached + ".cpp", code_) &&
+        access((cached + ".so").c_str(), R_OK) == 0) {
+      so_lib = make_unique<at::DynamicLibrary>((cached + ".so").c_str());
+    }
+  }
+  if (!so_lib) {
+    // compiled next to the cache, so the files can be published as links
+    TempFile so_file(
+        cache_dir.empty() ? so_template
+                          : cache_dir + "/pytorch_fuserXXXXXX.so",
+        so_suffix_len);
+    TempFile cpp_file(
+        cache_dir.empty() ? cpp_template
+                          : cache_dir + "/pytorch_fuserXXXXXX.cpp",
+        cpp_suffix_len);
+    cpp_file.write(code_);
+    cpp_file.sync();
+    runCompiler(cpp_file.name(), so_file.name());
+    if (debugFuser() >= 2)
+      disas(so_file.name());
+    if (!cache_dir.empty()) {
+      // the key is computed after compiling, which may have changed the
+      // flags; failures (e.g. another process publishing the same kernel)
+      // only mean the kernel is not cached
+      const std::string cached = cache_dir + "/" + cacheKey(code_);
+      if (link(so_file.name().c_str(), (cached + ".so").c_str()) == 0 ||
+          errno == EEXIST) {
+        link(cpp_file.name().c_str(), (cached + ".cpp").c_str());
+      }
+    }
+    so_lib = make_unique<at::DynamicLibrary>(so_file.name().c_str());
+  }
+#endif
 #pragma GCC diagnostic ignored "-Wpedantic"
-  kernel =
-      reinterpret_cast<void (*)(uint32_t, void**)>(so_lib->sym(name_.c_str()));
+  kernel = reinterpret_cast<void (*)(uint32_t, uint32_t, void**)>(
+      so_lib->sym("fused_kernel"));
 #pragma GCC diagnostic pop
 }
 
+void FusedKernelCPU::launch_raw(
+    const uint32_t numel,
+    std::vector<void*>& arguments) const {
+  at::parallel_for(
+      0, numel, at::internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        kernel(begin, end, arguments.data());
+      });
+}
+
 static std::shared_ptr<FusedKernel> createFusionKernel(
     int16_t device,
     std::string name,
@@ -29,14 +29,14 @@ struct TORCH_API FusedKernelCPU : public ::torch::jit::fuser::FusedKernel {
     return at::Backend::CPU;
   }
 
+  // Splits the elements across the intra-op thread pool
   void launch_raw(const uint32_t numel, std::vector<void*>& arguments)
-      const override {
-    kernel(numel, arguments.data());
-  }
+      const override;
 
  private:
   std::unique_ptr<at::DynamicLibrary> so_lib;
-  void (*kernel)(uint32_t, void**) = nullptr;
+  // runs the elements [begin, end)
+  void (*kernel)(uint32_t, uint32_t, void**) = nullptr;
 };
 
 } // namespace cpu
@@ -76,11 +76,14 @@ using int_same_size_t = typename int_of_size<sizeof(T)>::type;
 #define ToIndexTypeLoop(x) x
 #endif
 
-#define OMP_THRESHOLD 100000
-static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
-  #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
-  for (IndexTypeLoop linearIndex = 0;
-        linearIndex < ToIndexTypeLoop(totalElements);
+// Runs elements [begin, end); the host splits the range across the intra-op
+// thread pool. When every tensor is contiguous, offsets are the linear index
+// and the loop is marked for vectorization.
+static void fused_kernel_impl(
+    IndexType begin, IndexType end, ${formals}) {
+  ${simdPragma}
+  for (IndexTypeLoop linearIndex = ToIndexTypeLoop(begin);
+        linearIndex < ToIndexTypeLoop(end);
         linearIndex += 1) {
       // Convert `linearIndex` into an offset of tensor:
       ${tensorOffsets}
@@ -95,9 +98,12 @@ static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
 #define JIT_API
 #endif
 
+// Functions have the same names in every kernel, so that the compiled
+// code does not depend on the order kernels were created in and can be
+// cached across processes.
 extern "C"
-JIT_API void ${kernelName}(IndexType totalElements, void ** args) {
-  ${kernelName}_kernel(totalElements ${,argument_loads});
+JIT_API void fused_kernel(IndexType begin, IndexType end, void ** args) {
+  fused_kernel_impl(begin, end ${,argument_loads});
 }
 )");
 
@@ -19,6 +19,7 @@
 #include <torch/csrc/jit/passes/create_autodiff_subgraphs.h>
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 #include <torch/csrc/jit/passes/decompose_ops.h>
+#include <torch/csrc/jit/passes/fork_independent_branches.h>
 #include <torch/csrc/jit/passes/graph_fuser.h>
 #include <torch/csrc/jit/passes/inline_autodiff_subgraphs.h>
 #include <torch/csrc/jit/passes/inliner.h>
@@ -76,6 +77,11 @@ thread_local std::weak_ptr<Graph> last_executed_optimized_graph;
 std::shared_ptr<Graph> lastExecutedOptimizedGraph() {
   return last_executed_optimized_graph.lock();
 }
+
+static std::atomic<bool> fork_independent_branches_mode{false};
+std::atomic<bool>& getForkIndependentBranchesMode() {
+  return fork_independent_branches_mode;
+}
 namespace {
 
 using tensor_list = std::vector<at::Tensor>;
@@ -729,6 +735,12 @@ void runNondiffOptimization(std::shared_ptr<Graph>& graph) {
 
   FuseGraph(graph);
 
+  // Fork independent branches last, so that they are made of fusion groups
+  // rather than the nodes they replaced.
+  if (getForkIndependentBranchesMode()) {
+    ForkIndependentBranches(graph);
+  }
+
   // Run custom passes that different backends can register.
   // This is done last to give internal optimization passes priority.
   for (const auto& pass : getCustomPasses()) {
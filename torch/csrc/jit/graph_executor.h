@@ -63,6 +63,11 @@ TORCH_API std::shared_ptr<Graph> lastExecutedOptimizedGraph();
 TORCH_API std::atomic<bool> &getProfilingMode();
 TORCH_API std::atomic<bool>& getExecutorMode();
 
+// Whether the graph executor moves independent branches of the graphs it
+// optimizes into prim::fork subgraphs (see ForkIndependentBranches), so that
+// they can run concurrently. Off by default.
+TORCH_API std::atomic<bool>& getForkIndependentBranchesMode();
+
 struct TORCH_API GraphOptimizerEnabledGuard {
   GraphOptimizerEnabledGuard(bool state)
       : old_state_(getGraphExecutorOptimize()) {
@@ -60,6 +60,9 @@ TORCH_API script::Module load(
 /// The reader adapter, which is for customized input stream, must contain a
 /// serialized `script::Module`, exported either via `ScriptModule.save()` in
 /// Python or `torch::jit::ExportModule` in C++.
+///
+/// Passing a `caffe2::serialize::MmapAdapter` loads without copying tensor
+/// data: CPU tensors alias a copy-on-write mapping of the file.
 TORCH_API script::Module load(
     std::unique_ptr<caffe2::serialize::ReadAdapterInterface> rai,
     c10::optional<c10::Device> device = c10::nullopt,
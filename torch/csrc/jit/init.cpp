@@ -3,6 +3,7 @@
 #include <torch/csrc/jit/argument_spec.h>
 #include <torch/csrc/jit/autodiff.h>
 #include <torch/csrc/jit/export.h>
+#include <torch/csrc/jit/fork_scheduler.h>
 #include <torch/csrc/jit/fuser/interface.h>
 #include <torch/csrc/jit/fuser/kernel_cache.h>
 #include <torch/csrc/jit/graph_executor.h>
@@ -18,6 +19,7 @@
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 #include <torch/csrc/jit/passes/decompose_ops.h>
 #include <torch/csrc/jit/passes/erase_number_types.h>
+#include <torch/csrc/jit/passes/fork_independent_branches.h>
 #include <torch/csrc/jit/passes/fuse_linear.h>
 #include <torch/csrc/jit/passes/graph_fuser.h>
 #include <torch/csrc/jit/passes/inline_fork_wait.h>
@@ -265,6 +267,13 @@ void initJITBindings(PyObject* module) {
       .def("_jit_pass_remove_expands", RemoveExpands)
       .def("_jit_pass_erase_number_types", EraseNumberTypes)
       .def("_jit_pass_inline_fork_wait", InlineForkWait)
+      .def(
+          "_jit_pass_fork_independent_branches",
+          [](std::shared_ptr<Graph>& g, size_t min_branch_size) {
+            return ForkIndependentBranches(g, min_branch_size);
+          },
+          py::arg("graph"),
+          py::arg("min_branch_size") = 1)
       .def("_jit_pass_inline", Inline)
       .def("_jit_pass_prepare_division_for_onnx", PrepareDivisionForONNX)
       .def(
@@ -340,6 +349,54 @@ void initJITBindings(PyObject* module) {
             getExecutorMode() = profiling_flag;
             return oldState;
           })
+      .def(
+          "_jit_set_interpreter_superinstructions",
+          [](bool enabled) {
+            bool oldState = getInterpreterSuperinstructions();
+            getInterpreterSuperinstructions() = enabled;
+            return oldState;
+          })
+      .def(
+          "_jit_set_memory_planning",
+          [](bool enabled) {
+            bool oldState = getMemoryPlanningMode();
+            getMemoryPlanningMode() = enabled;
+            return oldState;
+          })
+      .def(
+          "_jit_set_fork_independent_branches",
+          [](bool enabled) {
+            bool oldState = getForkIndependentBranchesMode();
+            getForkIndependentBranchesMode() = enabled;
+            return oldState;
+          })
+      .def(
+          "_jit_set_fork_scheduler_options",
+          [](bool enabled,
+             int64_t min_launch_work_us,
+             double min_idle_cores,
+             size_t max_in_flight,
+             size_t remeasure_interval) {
+            ForkSchedulerOptions options;
+            options.enabled = enabled;
+            options.min_launch_work_us = min_launch_work_us;
+            options.min_idle_cores = min_idle_cores;
+            options.max_in_flight = max_in_flight;
+            options.remeasure_interval = remeasure_interval;
+            setForkSchedulerOptions(options);
+          },
+          py::arg("enabled") = true,
+          py::arg("min_launch_work_us") = 50,
+          py::arg("min_idle_cores") = 1.0,
+          py::arg("max_in_flight") = 0,
+          py::arg("remeasure_interval") = 100)
+      .def(
+          "_jit_get_fork_scheduler_stats",
+          []() {
+            auto stats = getForkSchedulerStats();
+            return std::make_tuple(stats.inlined, stats.launched);
+          })
+      .def("_jit_reset_fork_scheduler_stats", resetForkSchedulerStats)
       .def(
           "_jit_set_inline_everything_mode",
           [](bool enabled) { script::getInlineEverythingMode() = enabled; })
@@ -492,7 +549,12 @@ void initJITBindings(PyObject* module) {
       })
       .def("get_all_records", [](PyTorchStreamReader& self) {
         return self.getAllRecords();
-      });
+      })
+      .def(
+          "get_record_location",
+          [](PyTorchStreamReader& self, const std::string& key) {
+            return self.getRecordLocation(key);
+          });
 
   m.def(
       "_jit_get_operation",
@@ -16,6 +16,7 @@ namespace jit {
 // F - index into function table
 // T - index into the type table, used for guard instructions
 // S - index into object slots
+// K - index into call site table, the register form of an operator call
 
 #define FORALL_OPCODES(_)                                                   \
   _(OP, "O") /* invoke operator X */                                        \
@@ -37,7 +38,8 @@ namespace jit {
   _(TAIL_CALL, "F") /* replace current frame with function F */             \
   _(INTERFACE_CALL, "CI") /* call method X on the first argument (of N) */  \
   _(GET_ATTR, "S") /* get attribute from slot X in an Object */             \
-  _(SET_ATTR, "S") /* set attribute to slot X in an Object */
+  _(SET_ATTR, "S") /* set attribute to slot X in an Object */               \
+  _(OPR, "K") /* LOAD*, OP, STORE of call site X in one dispatch */
 
 enum OpCode : uint8_t {
 #define DEFINE_OP(op, _) op,
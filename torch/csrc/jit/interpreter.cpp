@@ -14,9 +14,12 @@
 #include <torch/csrc/jit/instruction.h>
 #include <torch/csrc/jit/operator.h>
 #include <torch/csrc/jit/passes/bailout_graph.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <torch/csrc/jit/planned_allocator.h>
 #include <torch/csrc/jit/script/compilation_unit.h>
 #include <torch/csrc/jit/script/jit_exception.h>
 
+#include <atomic>
 #include <exception>
 #include <iostream>
 #include <memory>
@@ -339,6 +342,74 @@ struct BailoutBlock {
   std::vector<Instruction> instructions; // ends in a TAIL_CALL
 };
 
+static std::atomic<bool> interpreter_superinstructions{true};
+
+std::atomic<bool>& getInterpreterSuperinstructions() {
+  return interpreter_superinstructions;
+}
+
+static std::atomic<bool> memory_planning_mode{false};
+
+std::atomic<bool>& getMemoryPlanningMode() {
+  return memory_planning_mode;
+}
+
+// An input of an OPR call site: LOAD or MOVE of register X, or LOADC of
+// constant X, exactly as the instruction it replaces.
+struct CallOperand {
+  OpCode op;
+  int32_t X;
+};
+
+// Operators OPR runs inline on unboxed operands instead of pushing them and
+// calling through the operator table. Scalar int arithmetic and comparisons
+// make up most of the control flow (loop counters, size checks) of scripted
+// code, where the dispatch rather than the op itself dominates.
+enum class FastOp : uint8_t {
+  NONE,
+  ADD_INT,
+  SUB_INT,
+  MUL_INT,
+  LT_INT,
+  LE_INT,
+  GT_INT,
+  GE_INT,
+  EQ_INT,
+  NE_INT,
+};
+
+static FastOp fastOpFor(const Node* node) {
+  static const std::pair<const char*, FastOp> fast_ops[] = {
+      {"aten::add(int a, int b) -> int", FastOp::ADD_INT},
+      {"aten::sub(int a, int b) -> int", FastOp::SUB_INT},
+      {"aten::mul(int a, int b) -> int", FastOp::MUL_INT},
+      {"aten::lt(int a, int b) -> bool", FastOp::LT_INT},
+      {"aten::le(int a, int b) -> bool", FastOp::LE_INT},
+      {"aten::gt(int a, int b) -> bool", FastOp::GT_INT},
+      {"aten::ge(int a, int b) -> bool", FastOp::GE_INT},
+      {"aten::eq(int a, int b) -> bool", FastOp::EQ_INT},
+      {"aten::ne(int a, int b) -> bool", FastOp::NE_INT},
+  };
+  for (const auto& entry : fast_ops) {
+    if (node->matches(entry.first)) {
+      return entry.second;
+    }
+  }
+  return FastOp::NONE;
+}
+
+// The register form of an operator call, produced by fusing a run of
+// LOAD/MOVE/LOADC, the OP consuming them and the STORE/STOREN of its
+// outputs. operands index into CodeImpl::call_operands_.
+struct CallSite {
+  int32_t op; // index into the operator table
+  FastOp fast_op;
+  uint16_t n_outputs; // 0 leaves the outputs on the stack
+  int32_t output_reg; // outputs go to registers [output_reg, +n_outputs)
+  size_t operands_begin;
+  size_t n_operands;
+};
+
 struct CodeImpl {
   friend struct InterpreterState;
   std::vector<Instruction> instructions_;
@@ -348,6 +419,21 @@ struct CodeImpl {
   // instruction to be emitted?
   std::vector<Node*> instructions_source_;
 
+  // What the interpreter actually runs: instructions_ with operator calls
+  // fused into OPR superinstructions by emitExecutionCode. instructions_
+  // keeps the plain stack form, which is what gets dumped and exported
+  // as mobile bytecode.
+  std::vector<Instruction> exec_instructions_;
+  std::vector<Node*> exec_instructions_source_;
+  std::vector<CallSite> call_sites_;
+  std::vector<CallOperand> call_operands_;
+
+  // Static memory plan of graph_, if enabled and applicable (see planMemory).
+  // exec_planned_buffers_[i] lists the buffers of the plan allocated by the
+  // operator of exec_instructions_[i].
+  std::unique_ptr<PlannedArenaPool> arena_pool_;
+  std::vector<std::vector<size_t>> exec_planned_buffers_;
+
   std::vector<IValue> constant_table_;
   std::vector<Operation> operator_table_;
   std::vector<Function*> function_table_;
@@ -399,6 +485,8 @@ struct CodeImpl {
     // we deferred the emission of bailout blocks so they appear at the end
     // emit them now and patch up the jumps
     insertBailoutBlocks();
+    emitExecutionCode();
+    planMemory();
   }
 
   const std::vector<c10::IValue>& constant_table() const {
@@ -656,6 +744,138 @@ struct CodeImpl {
           instructions_source_[block.jf_instruction_index]);
     }
   }
+
+  static bool isOperandLoad(OpCode op) {
+    return op == LOAD || op == MOVE || op == LOADC;
+  }
+
+  // Builds exec_instructions_ from instructions_ by folding each
+  // LOAD*/MOVE*/LOADC*, OP, [STORE | STOREN] sequence into a single OPR,
+  // removing one dispatch per operand and output. A sequence is only fused
+  // if no jump lands inside it; relative jumps are then re-targeted to the
+  // new positions.
+  void emitExecutionCode() {
+    const size_t n = instructions_.size();
+    if (!getInterpreterSuperinstructions()) {
+      exec_instructions_ = instructions_;
+      exec_instructions_source_ = instructions_source_;
+      return;
+    }
+    std::vector<bool> is_jump_target(n + 1, false);
+    for (size_t i = 0; i < n; ++i) {
+      const Instruction& inst = instructions_[i];
+      if (inst.op == JF || inst.op == JMP || inst.op == LOOP) {
+        is_jump_target.at(i + inst.X) = true;
+      }
+    }
+
+    // new_index[i] is the position in exec_instructions_ of the instruction
+    // that executes instructions_[i]
+    std::vector<size_t> new_index(n + 1);
+    size_t i = 0;
+    while (i < n) {
+      size_t op_index = i;
+      while (op_index < n && isOperandLoad(instructions_[op_index].op) &&
+             (op_index == i || !is_jump_target[op_index])) {
+        ++op_index;
+      }
+      if (op_index == n || instructions_[op_index].op != OP ||
+          (op_index != i && is_jump_target[op_index])) {
+        // nothing to fuse: copy over the first instruction as is
+        new_index[i] = exec_instructions_.size();
+        exec_instructions_.push_back(instructions_[i]);
+        exec_instructions_source_.push_back(instructions_source_[i]);
+        ++i;
+        continue;
+      }
+      size_t end = op_index + 1;
+      uint16_t n_outputs = 0;
+      int32_t output_reg = 0;
+      if (end < n && !is_jump_target[end] &&
+          (instructions_[end].op == STORE || instructions_[end].op == STOREN)) {
+        n_outputs = instructions_[end].op == STORE ? 1 : instructions_[end].N;
+        output_reg = instructions_[end].X;
+        ++end;
+      }
+      if (end == op_index + 1 && op_index == i) {
+        // a lone OP is already a single dispatch
+        new_index[i] = exec_instructions_.size();
+        exec_instructions_.push_back(instructions_[i]);
+        exec_instructions_source_.push_back(instructions_source_[i]);
+        ++i;
+        continue;
+      }
+
+      Node* node = instructions_source_[op_index];
+      CallSite site;
+      site.op = instructions_[op_index].X;
+      site.n_outputs = n_outputs;
+      site.output_reg = output_reg;
+      site.operands_begin = call_operands_.size();
+      site.n_operands = op_index - i;
+      for (size_t j = i; j < op_index; ++j) {
+        call_operands_.push_back(
+            CallOperand{instructions_[j].op, instructions_[j].X});
+      }
+      site.fast_op = FastOp::NONE;
+      if (n_outputs <= 1 && site.n_operands == node->inputs().size() &&
+          node->outputs().size() == 1) {
+        site.fast_op = fastOpFor(node);
+      }
+
+      for (size_t j = i; j < end; ++j) {
+        new_index[j] = exec_instructions_.size();
+      }
+      exec_instructions_.emplace_back(OPR, call_sites_.size(), 0);
+      exec_instructions_source_.push_back(node);
+      call_sites_.push_back(site);
+      i = end;
+    }
+    new_index[n] = exec_instructions_.size();
+
+    for (size_t j = 0; j < n; ++j) {
+      const Instruction& inst = instructions_[j];
+      if (inst.op == JF || inst.op == JMP || inst.op == LOOP) {
+        Instruction& fused = exec_instructions_[new_index[j]];
+        TORCH_INTERNAL_ASSERT(fused.op == inst.op);
+        fused.X = static_cast<int32_t>(new_index[j + inst.X]) -
+            static_cast<int32_t>(new_index[j]);
+      }
+    }
+  }
+
+  // Plans the tensors of graph_ into an arena reused across runs, so that in
+  // the steady state their operators do not go to the allocator. Only for
+  // code that never leaves its frame: a CALL would run other code, and a
+  // WAIT could resume on another thread, under the frame's arena.
+  void planMemory() {
+    if (!getMemoryPlanningMode()) {
+      return;
+    }
+    for (const Instruction& inst : instructions_) {
+      if (inst.op == CALL || inst.op == INTERFACE_CALL || inst.op == WAIT) {
+        return;
+      }
+    }
+    MemoryPlan plan = PlanMemory(graph_);
+    if (plan.buffers.empty()) {
+      return;
+    }
+    std::unordered_map<Node*, std::vector<size_t>> node_buffers;
+    for (size_t i = 0; i < plan.buffers.size(); ++i) {
+      node_buffers[plan.buffers[i].value->node()].push_back(i);
+    }
+    exec_planned_buffers_.resize(exec_instructions_.size());
+    for (size_t i = 0; i < exec_instructions_.size(); ++i) {
+      OpCode op = exec_instructions_[i].op;
+      auto it = node_buffers.find(exec_instructions_source_[i]);
+      if ((op == OP || op == OPR) && it != node_buffers.end()) {
+        exec_planned_buffers_[i] = it->second;
+      }
+    }
+    arena_pool_ = torch::make_unique<PlannedArenaPool>(plan);
+  }
+
   void emitInterfaceCall(
       std::string method_name_str,
       c10::ArrayRef<Value*> inputs) {
@@ -797,14 +1017,24 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
     Operation* operators;
     Function** functions;
     TypePtr* types;
+    CallSite* call_sites;
+    CallOperand* call_operands;
+    // null unless the frame's code has a memory plan
+    std::vector<size_t>* planned_buffers;
 
     ActiveFrame(const Frame& frame)
         : pc(frame.pc),
-          instructions(frame.function->instructions_.data()),
+          instructions(frame.function->exec_instructions_.data()),
           constants(frame.function->constant_table_.data()),
           operators(frame.function->operator_table_.data()),
           functions(frame.function->function_table_.data()),
-          types(frame.function->type_table_.data()) {}
+          types(frame.function->type_table_.data()),
+          call_sites(frame.function->call_sites_.data()),
+          call_operands(frame.function->call_operands_.data()),
+          planned_buffers(
+              frame.function->arena_pool_
+                  ? frame.function->exec_planned_buffers_.data()
+                  : nullptr) {}
   };
 
   std::vector<Frame> frames;
@@ -832,6 +1062,90 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
     return *(registers.end() - reg);
   }
 
+  // Announces the planned buffers of the operator about to run, entering
+  // the arena of the frame on its first operator.
+  void enterPlannedOp(
+      const ActiveFrame& af,
+      c10::optional<PlannedAllocationScope>& planned_allocations) {
+    if (!planned_allocations) {
+      planned_allocations.emplace(*frames.back().function->arena_pool_);
+    }
+    const std::vector<size_t>& buffers = af.planned_buffers[af.pc];
+    planned_allocations->setBuffers(
+        buffers.data(), buffers.data() + buffers.size());
+  }
+
+  int64_t intOperand(const ActiveFrame& af, const CallOperand& operand) {
+    return operand.op == LOADC ? af.constants[operand.X].toInt()
+                               : reg(operand.X).toInt();
+  }
+
+  // Runs call site X of an OPR: the same effect as the LOAD/MOVE/LOADC,
+  // OP and STORE/STOREN instructions it was fused from.
+  void runCallSite(const ActiveFrame& af, const CallSite& site, Stack& stack) {
+    const CallOperand* operands = af.call_operands + site.operands_begin;
+    if (site.fast_op != FastOp::NONE) {
+      int64_t a = intOperand(af, operands[0]);
+      int64_t b = intOperand(af, operands[1]);
+      IValue result;
+      switch (site.fast_op) {
+        case FastOp::ADD_INT:
+          result = a + b;
+          break;
+        case FastOp::SUB_INT:
+          result = a - b;
+          break;
+        case FastOp::MUL_INT:
+          result = a * b;
+          break;
+        case FastOp::LT_INT:
+          result = a < b;
+          break;
+        case FastOp::LE_INT:
+          result = a <= b;
+          break;
+        case FastOp::GT_INT:
+          result = a > b;
+          break;
+        case FastOp::GE_INT:
+          result = a >= b;
+          break;
+        case FastOp::EQ_INT:
+          result = a == b;
+          break;
+        case FastOp::NE_INT:
+          result = a != b;
+          break;
+        case FastOp::NONE:
+          break;
+      }
+      if (site.n_outputs == 1) {
+        reg(site.output_reg) = std::move(result);
+      } else {
+        stack.emplace_back(std::move(result));
+      }
+      return;
+    }
+    for (size_t i = 0; i < site.n_operands; ++i) {
+      const CallOperand& operand = operands[i];
+      switch (operand.op) {
+        case LOAD:
+          stack.emplace_back(reg(operand.X));
+          break;
+        case MOVE:
+          stack.emplace_back(std::move(reg(operand.X)));
+          break;
+        default:
+          stack.emplace_back(af.constants[operand.X]);
+          break;
+      }
+    }
+    af.operators[site.op](stack);
+    for (size_t i = site.n_outputs; i > 0; --i) {
+      reg(site.output_reg + i - 1) = pop(stack);
+    }
+  }
+
   void dump(std::ostream& out, const Stack& stack) const {
     out << "Stack:\n";
     for (const auto& val : stack) {
@@ -854,6 +1168,9 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
     }
 
     ActiveFrame af(frames.back());
+    // open while a frame with a memory plan runs; planned code never calls
+    // out, so that frame is left only by RET or TAIL_CALL
+    c10::optional<PlannedAllocationScope> planned_allocations;
     try {
       while (true) {
 //         std::cout << "RUNNING ";
@@ -861,12 +1178,22 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
         Instruction inst = af.instructions[af.pc];
         switch (inst.op) {
           case OP:
+            if (af.planned_buffers) {
+              enterPlannedOp(af, planned_allocations);
+            }
             af.operators[inst.X](stack);
             ++af.pc;
             break;
           case OPN:
             AT_ERROR("OPN is currently supported in mobile mode only.");
             break;
+          case OPR:
+            if (af.planned_buffers) {
+              enterPlannedOp(af, planned_allocations);
+            }
+            runCallSite(af, af.call_sites[inst.X], stack);
+            ++af.pc;
+            break;
           case LOAD:
             stack.emplace_back(reg(inst.X));
             ++af.pc;
@@ -956,6 +1283,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             af = ActiveFrame(frames.back());
           } break;
           case RET:
+            planned_allocations.reset();
             if (frames.size() > 1) {
               leaveFrame();
               af = ActiveFrame(frames.back());
@@ -1039,6 +1367,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
                   std::move(stack.at(inputs_start + i));
             }
             stack.resize(base_pointer + num_inputs);
+            planned_allocations.reset();
             leaveFrame();
             enterFrame(code, base_pointer);
             af = ActiveFrame(frames.back());
@@ -1060,7 +1389,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
       size_t pc = (i == 0) ? frame.pc
                            : frame.pc -
               1; // make sure we report the call node, not the node after it
-      Node* node = frame.function->instructions_source_[pc];
+      Node* node = frame.function->exec_instructions_source_[pc];
       if (node->callstack()) {
         for (const auto& p : (*node->callstack())->vec()) {
           p.second.print_with_context(
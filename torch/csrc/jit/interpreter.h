@@ -1,5 +1,6 @@
 #pragma once
 #include <c10/util/Optional.h>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -99,6 +100,16 @@ struct InterpreterContinuation {
   bool grad_mode_enabled;
 };
 
+// Whether newly created Code fuses operand loads, operator calls and output
+// stores into single OPR instructions. On by default; turning it off runs
+// the plain stack bytecode, e.g. to compare against it.
+TORCH_API std::atomic<bool>& getInterpreterSuperinstructions();
+
+// Whether newly created Code plans the memory of intermediates with complete
+// shapes ahead of time (see PlanMemory) and runs them in a preallocated
+// arena. Off by default: it only pays off once shapes are fixed.
+TORCH_API std::atomic<bool>& getMemoryPlanningMode();
+
 // what is the tensors type, including state from the current execution context
 // that modifies how the tensor behaves. For instance if no_grad is enabled
 // this will cause the TensorType to have requires_grad=False.
@@ -0,0 +1,262 @@
+#include <torch/csrc/jit/passes/fork_independent_branches.h>
+
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+struct Branch {
+  // in program order
+  std::vector<Node*> nodes;
+  // first top-level node outside the branch using one of its values
+  Node* end = nullptr;
+};
+
+bool canJoinBranch(Node* n, const AliasDb& aliasDb) {
+  if (!n->blocks().empty() || n->hasSideEffects() ||
+      n->isNondeterministic() || aliasDb.hasWriters(n)) {
+    return false;
+  }
+  switch (n->kind()) {
+    case prim::FusionGroup:
+    case prim::DifferentiableGraph:
+    case prim::ListConstruct:
+    case prim::ListUnpack:
+    case prim::TupleConstruct:
+    case prim::TupleUnpack:
+    case prim::ConstantChunk:
+      return true;
+    case aten::wait:
+      return false;
+    default:
+      return n->kind().is_aten();
+  }
+}
+
+bool isConstant(const Value* v) {
+  return v->node()->kind() == prim::Constant;
+}
+
+class BranchForker {
+ public:
+  BranchForker(std::shared_ptr<Graph> graph, size_t min_branch_size)
+      : graph_(std::move(graph)),
+        aliasDb_(graph_),
+        min_branch_size_(min_branch_size) {}
+
+  void run() {
+    findBranches();
+    for (size_t i = 0; i < branches_.size(); ++i) {
+      if (shouldFork(i)) {
+        fork(*branches_[i]);
+      }
+    }
+  }
+
+ private:
+  // The top-level node `n` is nested in.
+  Node* topLevelNode(Node* n) const {
+    while (n->owningBlock() != graph_->block()) {
+      n = n->owningBlock()->owningNode();
+    }
+    return n;
+  }
+
+  Branch* branchOf(const Value* v) const {
+    auto it = branch_of_.find(v->node());
+    return it == branch_of_.end() ? nullptr : it->second;
+  }
+
+  // Adds the branches whose values `n`, or any node nested in it, uses.
+  void collectUsedBranches(Node* n, std::unordered_set<Branch*>& used) const {
+    for (Value* input : n->inputs()) {
+      if (Branch* branch = branchOf(input)) {
+        used.insert(branch);
+      }
+    }
+    for (Block* block : n->blocks()) {
+      for (Node* nested : block->nodes()) {
+        collectUsedBranches(nested, used);
+      }
+      collectUsedBranches(block->return_node(), used);
+    }
+  }
+
+  // Whether `n` only uses values of `branch` and ones it can take as inputs.
+  bool canExtend(const Branch& branch, Node* n) const {
+    if (branch.end) {
+      return false;
+    }
+    Node* start = branch.nodes.front();
+    for (Value* input : n->inputs()) {
+      if (branchOf(input) == &branch || isConstant(input) ||
+          input->node()->kind() == prim::Param) {
+        continue;
+      }
+      if (!input->node()->isBefore(start)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void findBranches() {
+    for (Node* n : graph_->nodes()) {
+      std::unordered_set<Branch*> used;
+      collectUsedBranches(n, used);
+
+      Branch* joined = nullptr;
+      if (canJoinBranch(n, aliasDb_)) {
+        if (used.empty()) {
+          branches_.emplace_back(new Branch());
+          joined = branches_.back().get();
+        } else if (used.size() == 1 && canExtend(**used.begin(), n)) {
+          joined = *used.begin();
+        }
+      }
+      if (joined) {
+        joined->nodes.push_back(n);
+        branch_of_[n] = joined;
+      }
+      for (Branch* branch : used) {
+        if (branch != joined && !branch->end) {
+          branch->end = n;
+        }
+      }
+    }
+    std::unordered_set<Branch*> returned;
+    collectUsedBranches(graph_->return_node(), returned);
+    for (Branch* branch : returned) {
+      if (!branch->end) {
+        branch->end = graph_->return_node();
+      }
+    }
+  }
+
+  bool shouldFork(size_t i) const {
+    const Branch& branch = *branches_[i];
+    // Nothing outside uses the branch, so it is dead code.
+    if (!branch.end || branch.nodes.size() < min_branch_size_) {
+      return false;
+    }
+    for (size_t j = i + 1; j < branches_.size(); ++j) {
+      const Branch& next = *branches_[j];
+      if (!next.nodes.front()->isBefore(branch.end)) {
+        break;
+      }
+      if (next.nodes.size() >= min_branch_size_) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void fork(const Branch& branch) {
+    auto subgraph = std::make_shared<Graph>();
+    std::unordered_map<Value*, Value*> env;
+    std::vector<Value*> fork_inputs;
+    const auto lookup = [&](Value* v) -> Value* {
+      auto it = env.find(v);
+      if (it != env.end()) {
+        return it->second;
+      }
+      Value* mapped = nullptr;
+      if (isConstant(v)) {
+        // constants have no inputs
+        mapped = subgraph
+                     ->insertNode(subgraph->createClone(
+                         v->node(), [](Value* input) { return input; }))
+                     ->output();
+      } else {
+        mapped = subgraph->addInput()->copyMetadata(v);
+        fork_inputs.push_back(v);
+      }
+      env[v] = mapped;
+      return mapped;
+    };
+    for (Node* n : branch.nodes) {
+      Node* clone = subgraph->insertNode(subgraph->createClone(n, lookup));
+      for (size_t i = 0; i < n->outputs().size(); ++i) {
+        env[n->outputs()[i]] = clone->outputs()[i];
+      }
+    }
+
+    // The values used after the branch, returned as a tuple if there are
+    // several, like forked functions with several results do.
+    std::vector<Value*> results;
+    for (Node* n : branch.nodes) {
+      for (Value* output : n->outputs()) {
+        for (const Use& use : output->uses()) {
+          auto it = branch_of_.find(topLevelNode(use.user));
+          if (it == branch_of_.end() || it->second != &branch) {
+            results.push_back(output);
+            break;
+          }
+        }
+      }
+    }
+    AT_ASSERT(!results.empty());
+    if (results.size() == 1) {
+      subgraph->registerOutput(env.at(results[0]));
+    } else {
+      std::vector<Value*> values;
+      for (Value* result : results) {
+        values.push_back(env.at(result));
+      }
+      subgraph->registerOutput(
+          subgraph->insertNode(subgraph->createTuple(values))->output());
+    }
+    const TypePtr result_type = subgraph->outputs().at(0)->type();
+
+    Node* fork_node = graph_->create(prim::fork, fork_inputs, 1)
+                          ->insertBefore(branch.nodes.front());
+    fork_node->g_(attr::Subgraph, subgraph);
+    // See Note [Scheduling forked subgraphs]
+    fork_node->i_(attr::scheduled, 1);
+    fork_node->output()->setType(FutureType::create(result_type));
+    Node* wait_node =
+        graph_->create(aten::wait, {fork_node->output()}, 1)
+            ->insertBefore(branch.end);
+    wait_node->output()->setType(result_type);
+
+    std::vector<Value*> waited{wait_node->output()};
+    if (results.size() > 1) {
+      Node* unpack = graph_->createTupleUnpack(wait_node->output())
+                         ->insertAfter(wait_node);
+      waited = unpack->outputs().vec();
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      results[i]->replaceAllUsesWith(waited[i]);
+    }
+    for (auto it = branch.nodes.rbegin(); it != branch.nodes.rend(); ++it) {
+      branch_of_.erase(*it);
+      (*it)->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+  const size_t min_branch_size_;
+  // in the order they start
+  std::vector<std::unique_ptr<Branch>> branches_;
+  std::unordered_map<Node*, Branch*> branch_of_;
+};
+
+} // namespace
+
+void ForkIndependentBranches(
+    const std::shared_ptr<Graph>& graph,
+    size_t min_branch_size) {
+  BranchForker(graph, min_branch_size).run();
+  GRAPH_DUMP("After ForkIndependentBranches: ", graph);
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/ir.h>
+
+#include <memory>
+
+namespace torch {
+namespace jit {
+
+// Finds chains of top-level nodes that don't depend on each other, e.g. the
+// towers of a multi-tower model, and moves each of them into a prim::fork
+// subgraph, with an aten::wait right before the first node outside the chain
+// that uses its results. The interpreter can then run the branches
+// concurrently. Unlike forks written by users, the ones created here are
+// marked with attr::scheduled, so that the interpreter decides where to run
+// them (see Note [Scheduling forked subgraphs]).
+//
+// A branch starts at a node none of whose inputs come from another branch,
+// and grows by the nodes that only use values of that branch, values defined
+// before it started, and constants. It ends at the first node outside of it
+// that uses one of its values. Only pure nodes without blocks join branches:
+// operators that mutate, have side effects or are nondeterministic keep their
+// place, and so do control flow and calls. A branch is forked only if
+// another branch starts before it ends, i.e. if the forking thread has other
+// branch work to do in the meantime; the last branch before a join stays
+// where it is. Branches with fewer than `min_branch_size` nodes are left
+// alone.
+TORCH_API void ForkIndependentBranches(
+    const std::shared_ptr<Graph>& graph,
+    size_t min_branch_size = 1);
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,138 @@
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <c10/core/CPUAllocator.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+#include <torch/csrc/jit/passes/liveness.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Bytes of storage the tensor of type `type` needs, if it is a CPU tensor
+// whose layout is fully known. Matches what empty/empty_strided allocate.
+c10::optional<size_t> plannedStorageSize(const TypePtr& type) {
+  auto tt = type->cast<TensorType>();
+  if (!tt || !tt->isComplete() || tt->device()->type() != at::kCPU ||
+      tt->requiresGrad().value_or(false)) {
+    return c10::nullopt;
+  }
+  auto sizes = *tt->sizes().concrete_sizes();
+  auto strides = *tt->strides().concrete_sizes();
+  size_t n_elements = 1;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (sizes[i] == 0) {
+      return c10::nullopt;
+    }
+    n_elements += (sizes[i] - 1) * strides[i];
+  }
+  return n_elements * c10::elementSize(*tt->scalarType());
+}
+
+size_t alignedSize(size_t nbytes) {
+  return (nbytes + c10::gAlignment - 1) / c10::gAlignment * c10::gAlignment;
+}
+
+struct LiveRange {
+  size_t buffer; // index into MemoryPlan::buffers
+  size_t begin; // index of the defining node
+  size_t end; // index of the last node the buffer is live at
+};
+
+} // namespace
+
+MemoryPlan PlanMemory(const std::shared_ptr<Graph>& graph) {
+  MemoryPlan plan;
+  std::vector<Node*> nodes(graph->nodes().begin(), graph->nodes().end());
+  std::unordered_map<Value*, size_t> last_live;
+  {
+    // live sets hold the values live on entry to a node, and a node with
+    // blocks is live-in for everything its blocks use
+    auto liveness = BuildLivenessSets(graph);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      for (Value* v : liveness[nodes[i]]) {
+        last_live[v] = i;
+      }
+    }
+  }
+  auto lastLive = [&](Value* v, size_t def) {
+    auto it = last_live.find(v);
+    return it == last_live.end() ? def : std::max(def, it->second);
+  };
+
+  AliasDb alias_db(graph);
+  std::vector<LiveRange> ranges;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (nodes[i]->kind() == prim::Constant) {
+      continue;
+    }
+    for (Value* output : nodes[i]->outputs()) {
+      auto nbytes = plannedStorageSize(output->type());
+      // views of the node's inputs are not allocated by it, and anything
+      // reachable from the graph's inputs or outputs outlives the run
+      if (!nbytes || alias_db.mayContainAlias(output, nodes[i]->inputs()) ||
+          alias_db.mayContainAlias(output, graph->outputs()) ||
+          alias_db.mayContainAlias(output, graph->inputs())) {
+        continue;
+      }
+      // a view of the buffer, or a container holding it, keeps it alive
+      size_t end = lastLive(output, i);
+      for (size_t j = i; j < nodes.size(); ++j) {
+        for (Value* user : nodes[j]->outputs()) {
+          size_t user_end = lastLive(user, j);
+          if (user_end > end && user != output &&
+              alias_db.mayContainAlias(output, user)) {
+            end = user_end;
+          }
+        }
+      }
+      ranges.push_back(LiveRange{plan.buffers.size(), i, end});
+      plan.buffers.push_back(PlannedBuffer{output, 0, *nbytes});
+      plan.total_size += *nbytes;
+    }
+  }
+
+  // Greedy by size: place the largest buffers first, each at the lowest
+  // offset that does not overlap a placed buffer it is live together with.
+  std::vector<LiveRange> by_size = ranges;
+  std::stable_sort(
+      by_size.begin(),
+      by_size.end(),
+      [&](const LiveRange& a, const LiveRange& b) {
+        return plan.buffers[a.buffer].nbytes > plan.buffers[b.buffer].nbytes;
+      });
+  std::vector<LiveRange> placed;
+  for (const LiveRange& range : by_size) {
+    std::vector<const PlannedBuffer*> conflicts;
+    for (const LiveRange& other : placed) {
+      if (other.begin <= range.end && range.begin <= other.end) {
+        conflicts.push_back(&plan.buffers[other.buffer]);
+      }
+    }
+    std::sort(
+        conflicts.begin(),
+        conflicts.end(),
+        [](const PlannedBuffer* a, const PlannedBuffer* b) {
+          return a->offset < b->offset;
+        });
+    PlannedBuffer& buffer = plan.buffers[range.buffer];
+    size_t size = alignedSize(buffer.nbytes);
+    size_t offset = 0;
+    for (const PlannedBuffer* conflict : conflicts) {
+      if (conflict->offset >= offset + size) {
+        break;
+      }
+      offset = std::max(offset, conflict->offset + alignedSize(conflict->nbytes));
+    }
+    buffer.offset = offset;
+    plan.arena_size = std::max(plan.arena_size, offset + size);
+    placed.push_back(range);
+  }
+  return plan;
+}
+
+} // namespace jit
+} // namespace torch
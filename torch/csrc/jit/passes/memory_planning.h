@@ -0,0 +1,43 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/ir.h>
+
+#include <memory>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+// Where an intermediate tensor lives in the arena of a MemoryPlan.
+struct PlannedBuffer {
+  Value* value;
+  size_t offset; // multiple of c10::gAlignment
+  size_t nbytes; // exact size of the tensor's storage
+};
+
+struct MemoryPlan {
+  // bytes needed to hold all buffers
+  size_t arena_size = 0;
+  // sum of the buffer sizes, i.e. what separate allocations would use if all
+  // tensors were alive at once
+  size_t total_size = 0;
+  // in the order of the nodes defining them
+  std::vector<PlannedBuffer> buffers;
+};
+
+// Ahead-of-time memory plan for the intermediates of `graph`: every CPU
+// tensor produced by a top-level node whose type has complete sizes and
+// strides (from shape propagation or profiling) gets an offset in a single
+// arena. Buffers share bytes only if their live ranges, computed with
+// BuildLivenessSets and extended to the live ranges of anything that may
+// alias them, are disjoint. Values that may alias graph inputs or outputs
+// are never planned, since they outlive a run.
+//
+// The plan is a layout only; the interpreter places allocations in it (see
+// PlannedAllocationScope), and falls back to the regular allocator for any
+// allocation that does not match it.
+TORCH_API MemoryPlan PlanMemory(const std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
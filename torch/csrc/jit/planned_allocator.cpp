@@ -0,0 +1,159 @@
+#include <torch/csrc/jit/planned_allocator.h>
+
+#include <c10/util/Exception.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <atomic>
+#include <memory>
+
+namespace torch {
+namespace jit {
+
+namespace {
+// Arenas kept for reuse per pool: one per concurrent run is enough, more
+// only hold on to memory.
+constexpr size_t kMaxFreeArenas = 4;
+
+thread_local PlannedAllocationScope* current_scope = nullptr;
+} // namespace
+
+struct PlannedArena {
+  // context of the DataPtr of a tensor placed in buffer `index`
+  struct BufferRef {
+    PlannedArena* arena;
+    size_t index;
+  };
+
+  PlannedArena(at::Allocator* allocator, size_t nbytes, size_t n_buffers)
+      : data(allocator->allocate(nbytes)),
+        refs(n_buffers),
+        in_use(new std::atomic<bool>[n_buffers]) {
+    for (size_t i = 0; i < n_buffers; ++i) {
+      refs[i] = BufferRef{this, i};
+      in_use[i] = false;
+    }
+  }
+
+  void decref() {
+    if (--refcount == 0) {
+      delete this;
+    }
+  }
+
+  static void releaseBuffer(void* ctx) {
+    auto ref = static_cast<BufferRef*>(ctx);
+    ref->arena->in_use[ref->index] = false;
+    ref->arena->decref();
+  }
+
+  c10::DataPtr data;
+  std::vector<BufferRef> refs;
+  std::unique_ptr<std::atomic<bool>[]> in_use;
+  // one for the pool or the run holding the arena, plus one per tensor
+  // placed in it
+  std::atomic<size_t> refcount{1};
+};
+
+// Installed as the thread's CPU allocator by PlannedAllocationScope. It
+// outlives the scope through the storages it allocated, which call it again
+// to resize; outside of a scope it forwards to the regular CPU allocator.
+struct PlannedCPUAllocator final : at::Allocator {
+  at::DataPtr allocate(size_t nbytes) const override {
+    if (current_scope) {
+      return current_scope->allocate(nbytes);
+    }
+    return c10::GetCPUAllocator()->allocate(nbytes);
+  }
+};
+
+static PlannedCPUAllocator planned_cpu_allocator;
+
+PlannedArenaPool::PlannedArenaPool(const MemoryPlan& plan)
+    : arena_size_(plan.arena_size), overlaps_(plan.buffers.size()) {
+  for (const PlannedBuffer& buffer : plan.buffers) {
+    offsets_.push_back(buffer.offset);
+    sizes_.push_back(buffer.nbytes);
+  }
+  for (size_t i = 0; i < sizes_.size(); ++i) {
+    for (size_t j = 0; j < sizes_.size(); ++j) {
+      if (i != j && offsets_[i] < offsets_[j] + sizes_[j] &&
+          offsets_[j] < offsets_[i] + sizes_[i]) {
+        overlaps_[i].push_back(j);
+      }
+    }
+  }
+}
+
+PlannedArenaPool::~PlannedArenaPool() {
+  for (PlannedArena* arena : free_arenas_) {
+    arena->decref();
+  }
+}
+
+PlannedArena* PlannedArenaPool::acquire(at::Allocator* allocator) {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!free_arenas_.empty()) {
+      PlannedArena* arena = free_arenas_.back();
+      free_arenas_.pop_back();
+      return arena;
+    }
+  }
+  return new PlannedArena(allocator, arena_size_, sizes_.size());
+}
+
+void PlannedArenaPool::release(PlannedArena* arena) {
+  if (arena->refcount == 1) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (free_arenas_.size() < kMaxFreeArenas) {
+      free_arenas_.push_back(arena);
+      return;
+    }
+  }
+  arena->decref();
+}
+
+PlannedAllocationScope::PlannedAllocationScope(PlannedArenaPool& pool)
+    : pool_(pool),
+      fallback_(c10::GetCPUAllocator()),
+      arena_(pool.acquire(fallback_)),
+      prev_(current_scope),
+      allocator_guard_(&planned_cpu_allocator) {
+  current_scope = this;
+}
+
+PlannedAllocationScope::~PlannedAllocationScope() {
+  current_scope = prev_;
+  pool_.release(arena_);
+}
+
+c10::DataPtr PlannedAllocationScope::allocate(size_t nbytes) {
+  for (const size_t* it = buffers_begin_; it != buffers_end_; ++it) {
+    const size_t index = *it;
+    if (pool_.sizes_[index] != nbytes || arena_->in_use[index]) {
+      continue;
+    }
+    // A tensor outliving its planned range (e.g. saved for backward) still
+    // owns its bytes; the allocation then goes to the fallback instead.
+    bool overlaps_live_buffer = false;
+    for (size_t other : pool_.overlaps_[index]) {
+      if (arena_->in_use[other]) {
+        overlaps_live_buffer = true;
+        break;
+      }
+    }
+    if (overlaps_live_buffer) {
+      continue;
+    }
+    arena_->in_use[index] = true;
+    ++arena_->refcount;
+    return {static_cast<char*>(arena_->data.get()) + pool_.offsets_[index],
+            &arena_->refs[index],
+            &PlannedArena::releaseBuffer,
+            at::Device(at::kCPU)};
+  }
+  return fallback_->allocate(nbytes);
+}
+
+} // namespace jit
+} // namespace torch
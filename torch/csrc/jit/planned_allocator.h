@@ -0,0 +1,81 @@
+#pragma once
+
+#include <c10/core/Allocator.h>
+#include <c10/core/CPUAllocator.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <mutex>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+struct MemoryPlan;
+struct PlannedArena;
+
+// The arenas a Code runs its statically planned intermediates in, laid out
+// by a MemoryPlan (see passes/memory_planning.h). Arenas are reused across
+// runs; a run acquires one for its duration.
+class TORCH_API PlannedArenaPool {
+ public:
+  explicit PlannedArenaPool(const MemoryPlan& plan);
+  ~PlannedArenaPool();
+
+  size_t arenaSize() const {
+    return arena_size_;
+  }
+
+ private:
+  friend class PlannedAllocationScope;
+
+  // Reuses a free arena, or allocates a new one with `allocator`.
+  PlannedArena* acquire(at::Allocator* allocator);
+  // Puts the arena back for reuse, unless a tensor placed in it is still
+  // alive: then it is freed together with its last tensor instead.
+  void release(PlannedArena* arena);
+
+  size_t arena_size_;
+  std::vector<size_t> offsets_;
+  std::vector<size_t> sizes_;
+  // overlaps_[i]: the other buffers sharing bytes with buffer i
+  std::vector<std::vector<size_t>> overlaps_;
+
+  std::mutex mutex_;
+  std::vector<PlannedArena*> free_arenas_;
+};
+
+// Places the CPU allocations of the current thread in an arena of `pool`
+// while alive. setBuffers() announces the buffers the next operator is
+// planned to allocate; an allocation of exactly a buffer's size takes it,
+// provided nothing still uses the bytes it shares with other buffers.
+// Everything else goes to the allocator that was in effect before.
+class TORCH_API PlannedAllocationScope {
+ public:
+  explicit PlannedAllocationScope(PlannedArenaPool& pool);
+  ~PlannedAllocationScope();
+
+  PlannedAllocationScope(const PlannedAllocationScope&) = delete;
+  PlannedAllocationScope& operator=(const PlannedAllocationScope&) = delete;
+
+  // [begin, end) indexes the buffers of the pool's plan
+  void setBuffers(const size_t* begin, const size_t* end) {
+    buffers_begin_ = begin;
+    buffers_end_ = end;
+  }
+
+ private:
+  friend struct PlannedCPUAllocator;
+
+  c10::DataPtr allocate(size_t nbytes);
+
+  PlannedArenaPool& pool_;
+  at::Allocator* fallback_;
+  PlannedArena* arena_;
+  PlannedAllocationScope* prev_;
+  const size_t* buffers_begin_ = nullptr;
+  const size_t* buffers_end_ = nullptr;
+  c10::ThreadLocalCPUAllocatorGuard allocator_guard_;
+};
+
+} // namespace jit
+} // namespace torch
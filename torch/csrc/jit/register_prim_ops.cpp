@@ -6,6 +6,7 @@
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/autograd/variable.h>
 #include <torch/csrc/jit/custom_operator.h>
+#include <torch/csrc/jit/fork_scheduler.h>
 #include <torch/csrc/jit/fuser/interface.h>
 #include <torch/csrc/jit/graph_executor.h>
 #include <torch/csrc/jit/ir.h>
@@ -1266,6 +1267,13 @@ RegisterOperators reg(
            int n_inputs = node->inputs().size();
            AT_ASSERT(node->blocks().size() == 0);
            AT_ASSERT(node->hasAttribute(attr::Subgraph));
+           // Only forks created by ForkIndependentBranches are scheduled,
+           // forks written by users always go to the inter-op pool.
+           std::shared_ptr<ForkSite> site;
+           if (node->hasAttribute(attr::scheduled) &&
+               node->i(attr::scheduled)) {
+             site = std::make_shared<ForkSite>();
+           }
            return [=](Stack& stack) {
              // Move inputs to a separate stack
              InterpreterState forked_interprester(code);
@@ -1277,7 +1285,12 @@ RegisterOperators reg(
 
              push(stack, forked_interprester.getFuture());
 
-             at::launch(std::move(continuation));
+             if (site) {
+               // See Note [Scheduling forked subgraphs]
+               site->run(std::move(continuation));
+             } else {
+               at::launch(std::move(continuation));
+             }
              return 0;
            };
          },
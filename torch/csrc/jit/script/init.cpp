@@ -24,6 +24,8 @@
 
 #include <torch/csrc/api/include/torch/ordered_dict.h>
 
+#include <caffe2/serialize/mmap_adapter.h>
+
 #include <ATen/ATen.h>
 #include <ATen/core/function_schema.h>
 #include <ATen/core/qualified_name.h>
@@ -735,19 +737,34 @@ void initJitScriptBindings(PyObject* module) {
           "save",
           [](Module& m,
              const std::string& filename,
-             const ExtraFilesMap& _extra_files = ExtraFilesMap()) {
-            m.save(filename, _extra_files);
+             const ExtraFilesMap& _extra_files,
+             uint64_t _tensor_alignment) {
+            ExportModule(
+                m,
+                filename,
+                _extra_files,
+                /*bytecode_format=*/false,
+                _tensor_alignment);
           },
           py::arg("filename"),
-          py::arg("_extra_files") = ExtraFilesMap())
+          py::arg("_extra_files") = ExtraFilesMap(),
+          py::arg("_tensor_alignment") = caffe2::serialize::kFieldAlignment)
       .def(
           "save_to_buffer",
-          [](Module& m, const ExtraFilesMap& _extra_files = ExtraFilesMap()) {
+          [](Module& m,
+             const ExtraFilesMap& _extra_files,
+             uint64_t _tensor_alignment) {
             std::ostringstream buf;
-            m.save(buf, _extra_files);
+            ExportModule(
+                m,
+                buf,
+                _extra_files,
+                /*bytecode_format=*/false,
+                _tensor_alignment);
             return py::bytes(buf.str());
           },
-          py::arg("_extra_files") = ExtraFilesMap())
+          py::arg("_extra_files") = ExtraFilesMap(),
+          py::arg("_tensor_alignment") = caffe2::serialize::kFieldAlignment)
       .def("_set_optimized", &Module::set_optimized)
       .def(
           "dump",
@@ -871,7 +888,8 @@ void initJitScriptBindings(PyObject* module) {
           "save",
           [](const StrongFunctionPtr& self,
              const std::string& filename,
-             const ExtraFilesMap& _extra_files = ExtraFilesMap()) {
+             const ExtraFilesMap& _extra_files,
+             uint64_t _tensor_alignment) {
             Module module("__torch__.PlaceholderModule");
             // [issue 27343]
             // Modules have 'training' attributes by defualt, but due to
@@ -882,23 +900,36 @@ void initJitScriptBindings(PyObject* module) {
             // be deleted.
             module.register_attribute("training", BoolType::get(), true);
             addFunctionToModule(module, self);
-            module.save(filename, _extra_files);
+            ExportModule(
+                module,
+                filename,
+                _extra_files,
+                /*bytecode_format=*/false,
+                _tensor_alignment);
           },
           py::arg("filename"),
-          py::arg("_extra_files") = ExtraFilesMap())
+          py::arg("_extra_files") = ExtraFilesMap(),
+          py::arg("_tensor_alignment") = caffe2::serialize::kFieldAlignment)
       .def(
           "save_to_buffer",
           [](const StrongFunctionPtr& self,
-             const ExtraFilesMap& _extra_files = ExtraFilesMap()) {
+             const ExtraFilesMap& _extra_files,
+             uint64_t _tensor_alignment) {
             std::ostringstream buf;
             Module module("__torch__.PlaceholderModule");
             // see [issue 27343]
             module.register_attribute("training", BoolType::get(), true);
             addFunctionToModule(module, self);
-            module.save(buf, _extra_files);
+            ExportModule(
+                module,
+                buf,
+                _extra_files,
+                /*bytecode_format=*/false,
+                _tensor_alignment);
             return py::bytes(buf.str());
           },
-          py::arg("_extra_files") = ExtraFilesMap())
+          py::arg("_extra_files") = ExtraFilesMap(),
+          py::arg("_tensor_alignment") = caffe2::serialize::kFieldAlignment)
       .def_property_readonly(
           "graph",
           [](const StrongFunctionPtr& self) { return self.function_->graph(); })
@@ -1062,13 +1093,21 @@ void initJitScriptBindings(PyObject* module) {
       [](std::shared_ptr<CompilationUnit> cu,
          const std::string& filename,
          py::object map_location,
-         ExtraFilesMap& extra_files) {
+         ExtraFilesMap& extra_files,
+         bool mmap) {
         c10::optional<at::Device> optional_device;
         if (!map_location.is(py::none())) {
           AT_ASSERT(THPDevice_Check(map_location.ptr()));
           optional_device =
               reinterpret_cast<THPDevice*>(map_location.ptr())->device;
         }
+        if (mmap) {
+          return import_ir_module(
+              std::move(cu),
+              std::make_unique<caffe2::serialize::MmapAdapter>(filename),
+              optional_device,
+              extra_files);
+        }
         return import_ir_module(
             std::move(cu), filename, optional_device, extra_files);
       });
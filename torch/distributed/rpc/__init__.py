@@ -52,8 +52,11 @@ if is_available():
                 RpcAgent consturctor. It contains RpcAgent specific
                 initialization configurations. By default, it contains
                 ``rpc_timeout = timedelta(seconds=60)``,
-                ``init_method = "env://"``, ``num_send_recv_threads = 4`` for
-                process group agent. If using the default
+                ``init_method = "env://"``, ``num_send_recv_threads = 4``
+                and ``use_shared_memory = False`` for process group agent.
+                With ``use_shared_memory = True``, the process group agent
+                sends messages between workers on the same host through
+                shared memory instead of the process group. If using the default
                 ``rpc_backend_options``, RPC would initialize the underlying
                 process group backend using ``init_method = "env://"``,
                 meaning that environment variables ``MASTER_ADDRESS`` and
@@ -79,6 +79,7 @@ def _process_group_construct_rpc_backend_options_handler(
     rpc_timeout,
     init_method,
     num_send_recv_threads=rpc_constants.DEFAULT_NUM_SEND_RECV_THREADS,
+    use_shared_memory=False,
     **kwargs
 ):
     from . import ProcessGroupRpcBackendOptions
@@ -87,6 +88,7 @@ def _process_group_construct_rpc_backend_options_handler(
     rpc_backend_options.rpc_timeout = rpc_timeout
     rpc_backend_options.init_method = init_method
     rpc_backend_options.num_send_recv_threads = num_send_recv_threads
+    rpc_backend_options.use_shared_memory = use_shared_memory
     return rpc_backend_options
 
 
@@ -125,6 +127,7 @@ def _process_group_init_backend_handler(
             group,
             rpc_backend_options.num_send_recv_threads,
             rpc_backend_options.rpc_timeout,
+            rpc_backend_options.use_shared_memory,
         )
     except Exception as ex:
         dist.destroy_process_group()
@@ -90,7 +90,7 @@ def optimized_execution(should_optimize):
 DEFAULT_EXTRA_FILES_MAP = torch._C.ExtraFilesMap()
 
 
-def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP):
+def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP, _tensor_alignment=64):
     """
         Save an offline version of this module for use in a separate process. The saved
         module serializes all of the methods, submodules, parameters, and attributes of this
@@ -109,6 +109,8 @@ def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP):
             f: A file-like object (has to implement write and flush) or a string
                containing a file name.
             _extra_files: Map from filename to contents which will be stored as part of 'f'.
+            _tensor_alignment: Alignment of the tensor data records in the archive, a power of
+                two of at least 64, e.g. 4096 to allow direct I/O or mmap of single tensors.
 
         .. warning::
             If you are using Python 2, ``torch.jit.save`` does NOT support :any:`StringIO.StringIO`
@@ -147,12 +149,12 @@ def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP):
     if isinstance(f, str) or \
             (sys.version_info[0] == 2 and isinstance(f, unicode)) or \
             (sys.version_info[0] == 3 and isinstance(f, pathlib.Path)):
-        m.save(f, _extra_files=_extra_files)
+        m.save(f, _extra_files=_extra_files, _tensor_alignment=_tensor_alignment)
     else:
-        ret = m.save_to_buffer(_extra_files=_extra_files)
+        ret = m.save_to_buffer(_extra_files=_extra_files, _tensor_alignment=_tensor_alignment)
         f.write(ret)
 
-def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP):
+def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP, mmap=False):
     r"""
         Load a :class:`ScriptModule` or :class:`ScriptFunction` previously
         saved with :func:`torch.jit.save <torch.jit.save>`
@@ -169,6 +171,12 @@ def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP):
             _extra_files (dictionary of filename to content): The extra
                 filenames given in the map would be loaded and their content
                 would be stored in the provided map.
+            mmap (bool): if ``True``, ``f`` must be a file name. The file is
+                memory-mapped copy-on-write and CPU tensors point into the
+                mapping instead of being copied, so loading is fast and
+                processes loading the same file share its pages. Modifying
+                a tensor copies only the pages it touches; the file itself is
+                never written. Not supported on Windows.
 
         Returns:
             A :class:`ScriptModule` object.
@@ -229,8 +237,10 @@ def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP):
     if isinstance(f, str) or \
             (sys.version_info[0] == 2 and isinstance(f, unicode)) or \
             (sys.version_info[0] == 3 and isinstance(f, pathlib.Path)):
-        cpp_module = torch._C.import_ir_module(cu, f, map_location, _extra_files)
+        cpp_module = torch._C.import_ir_module(cu, f, map_location, _extra_files, mmap)
     else:
+        if mmap:
+            raise ValueError("mmap=True requires f to be a file name")
         cpp_module = torch._C.import_ir_module_from_buffer(cu, f.read(), map_location, _extra_files)
 
     # TODO: Pretty sure this approach loses ConstSequential status and such
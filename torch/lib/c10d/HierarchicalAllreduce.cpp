@@ -0,0 +1,438 @@
+#include <c10d/HierarchicalAllreduce.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+namespace c10d {
+
+// Counters live on separate cache lines, as they are written by different
+// processes.
+struct alignas(64) HierarchicalAllreduceCounter {
+  std::atomic<uint64_t> value;
+};
+
+namespace {
+
+// Every local process has one of each counter, holding the sequence number
+// of the last chunk it got through the corresponding step. Only the leader
+// has a meaningful kDone.
+constexpr int kArrived = 0; // chunk copied to shared memory
+constexpr int kReduced = 1; // slice of the chunk reduced
+constexpr int kDone = 2; // chunk allreduced among the leaders
+constexpr int kConsumed = 3; // result copied back
+constexpr int kNumCounters = 4;
+
+constexpr size_t kAlignment = 64;
+
+// Longest sleep between checks of a counter, which bounds the latency a
+// late process sees once it catches up.
+constexpr std::chrono::microseconds kMaxBackoff(500);
+
+size_t alignUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+std::vector<uint8_t> toBytes(const std::string& str) {
+  return std::vector<uint8_t>(str.begin(), str.end());
+}
+
+std::string toString(const std::vector<uint8_t>& bytes) {
+  return std::string(bytes.begin(), bytes.end());
+}
+
+std::string segmentName() {
+  static std::atomic<uint64_t> counter{0};
+  return "/c10d_hierarchical_" + std::to_string(getpid()) + "_" +
+      std::to_string(counter++);
+}
+
+size_t segmentSize(int localSize, size_t chunkBytes) {
+  // Two sets of buffers, each with a copy per process and the result
+  return kNumCounters * localSize * sizeof(HierarchicalAllreduceCounter) +
+      2 * (localSize + 1) * chunkBytes;
+}
+
+void* mapSegment(int fd, size_t size) {
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+void* createSegment(const std::string& name, size_t size) {
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1) {
+    throw std::system_error(
+        errno,
+        std::system_category(),
+        "Failed to create shared memory segment " + name);
+  }
+  void* ptr = nullptr;
+  if (ftruncate(fd, size) == 0) {
+    ptr = mapSegment(fd, size);
+  }
+  const int err = errno;
+  ::close(fd);
+  if (!ptr) {
+    shm_unlink(name.c_str());
+    throw std::system_error(
+        err,
+        std::system_category(),
+        "Failed to map shared memory segment " + name);
+  }
+  // ftruncate zero fills the segment, which initializes the counters
+  return ptr;
+}
+
+void* openSegment(const std::string& name, size_t size) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd == -1) {
+    throw std::system_error(
+        errno,
+        std::system_category(),
+        "Failed to open shared memory segment " + name +
+            " (are the processes with the same host id really on one host?)");
+  }
+  void* ptr = mapSegment(fd, size);
+  const int err = errno;
+  ::close(fd);
+  if (!ptr) {
+    throw std::system_error(
+        err,
+        std::system_category(),
+        "Failed to map shared memory segment " + name);
+  }
+  return ptr;
+}
+
+} // namespace
+
+std::shared_ptr<HierarchicalAllreduce> HierarchicalAllreduce::create(
+    Store& store,
+    int rank,
+    int size,
+    const std::string& hostId,
+    size_t chunkBytes,
+    std::chrono::milliseconds timeout) {
+  // Every process in the group creates the same number of instances, so
+  // this tells apart the keys of instances sharing the store.
+  const auto instance = store.add("hierarchical/" + std::to_string(rank), 1);
+  const std::string prefix = "hierarchical/" + std::to_string(instance) + "/";
+
+  std::vector<std::string> hostKeys(size);
+  for (int i = 0; i < size; i++) {
+    hostKeys[i] = prefix + "host/" + std::to_string(i);
+  }
+  store.set(hostKeys[rank], toBytes(hostId));
+  const auto hostIds = store.multiGet(hostKeys);
+
+  // Hosts are numbered in the order of their lowest rank, which leads them.
+  std::unordered_map<std::string, int> hostIndices;
+  int localRank = 0;
+  int localSize = 0;
+  for (int i = 0; i < size; i++) {
+    const auto id = toString(hostIds[i]);
+    hostIndices.emplace(id, hostIndices.size());
+    if (id == hostId) {
+      localRank += i < rank ? 1 : 0;
+      localSize++;
+    }
+  }
+  const int hostIndex = hostIndices.at(hostId);
+  const int numHosts = hostIndices.size();
+
+  chunkBytes = alignUp(std::max<size_t>(chunkBytes, 1));
+  const size_t mappingSize = segmentSize(localSize, chunkBytes);
+  const auto hostPrefix = prefix + std::to_string(hostIndex) + "/";
+  void* mapping;
+  std::string name;
+  if (localRank == 0) {
+    name = segmentName();
+    mapping = createSegment(name, mappingSize);
+    store.set(hostPrefix + "segment", toBytes(name));
+  } else {
+    name = toString(store.get(hostPrefix + "segment"));
+    mapping = openSegment(name, mappingSize);
+  }
+  std::shared_ptr<HierarchicalAllreduce> instancePtr(new HierarchicalAllreduce(
+      localRank,
+      localSize,
+      hostIndex,
+      numHosts,
+      chunkBytes,
+      timeout,
+      mapping,
+      mappingSize));
+
+  // Once every process on the host mapped the segment, the name is not
+  // needed anymore, and unlinking it right away means it can't leak.
+  if (store.add(hostPrefix + "attached", 1) == localSize) {
+    store.set(hostPrefix + "ready", {});
+  }
+  if (localRank == 0) {
+    store.wait({hostPrefix + "ready"}, timeout);
+    shm_unlink(name.c_str());
+  }
+  return instancePtr;
+}
+
+std::string HierarchicalAllreduce::defaultHostId() {
+  char hostname[256] = {0};
+  gethostname(hostname, sizeof(hostname) - 1);
+  std::string hostId(hostname);
+  std::ifstream bootIdFile("/proc/sys/kernel/random/boot_id");
+  std::string bootId;
+  if (bootIdFile >> bootId) {
+    hostId.append("/").append(bootId);
+  }
+  return hostId;
+}
+
+HierarchicalAllreduce::HierarchicalAllreduce(
+    int localRank,
+    int localSize,
+    int hostIndex,
+    int numHosts,
+    size_t chunkBytes,
+    std::chrono::milliseconds timeout,
+    void* mapping,
+    size_t mappingSize)
+    : localRank_(localRank),
+      localSize_(localSize),
+      hostIndex_(hostIndex),
+      numHosts_(numHosts),
+      chunkBytes_(chunkBytes),
+      timeout_(timeout),
+      mapping_(mapping),
+      mappingSize_(mappingSize),
+      counters_(static_cast<HierarchicalAllreduceCounter*>(mapping)),
+      buffers_(
+          static_cast<char*>(mapping) +
+          kNumCounters * localSize * sizeof(HierarchicalAllreduceCounter)) {
+  if (isLeader() && numHosts_ > 1) {
+    leaderThread_ = std::thread(&HierarchicalAllreduce::leaderLoop, this);
+  }
+}
+
+HierarchicalAllreduce::~HierarchicalAllreduce() {
+  if (leaderThread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(leaderMutex_);
+      stop_ = true;
+    }
+    leaderCV_.notify_one();
+    leaderThread_.join();
+  }
+  munmap(mapping_, mappingSize_);
+}
+
+uint64_t HierarchicalAllreduce::nextTicket() {
+  std::lock_guard<std::mutex> lock(ticketMutex_);
+  return nextTicket_++;
+}
+
+void HierarchicalAllreduce::run(
+    uint64_t ticket,
+    void* data,
+    size_t count,
+    size_t elementSize,
+    const ReduceFunc& fn,
+    const LeaderAllreduce& leaderAllreduce) {
+  std::unique_lock<std::mutex> lock(ticketMutex_);
+  ticketCV_.wait(lock, [&] { return currentTicket_ == ticket; });
+  lock.unlock();
+
+  std::exception_ptr eptr;
+  try {
+    if (failed_) {
+      throw std::runtime_error(
+          "A previous hierarchical allreduce failed, leaving the processes "
+          "on this host out of step");
+    }
+    runChunks(static_cast<char*>(data), count, elementSize, fn, leaderAllreduce);
+  } catch (...) {
+    failed_ = true;
+    eptr = std::current_exception();
+  }
+
+  lock.lock();
+  currentTicket_++;
+  lock.unlock();
+  ticketCV_.notify_all();
+
+  if (eptr) {
+    std::rethrow_exception(eptr);
+  }
+}
+
+void HierarchicalAllreduce::runChunks(
+    char* data,
+    size_t count,
+    size_t elementSize,
+    const ReduceFunc& fn,
+    const LeaderAllreduce& leaderAllreduce) {
+  const size_t chunkElements = std::max<size_t>(chunkBytes_ / elementSize, 1);
+  const size_t numChunks = (count + chunkElements - 1) / chunkElements;
+  const uint64_t firstSeq = seq_ + 1;
+  const bool runLeaderStage = isLeader() && numHosts_ > 1;
+
+  auto chunkOffset = [&](uint64_t seq) {
+    return (seq - firstSeq) * chunkElements;
+  };
+  auto chunkSize = [&](uint64_t seq) {
+    return std::min(chunkElements, count - chunkOffset(seq));
+  };
+
+  // The leader stages of the chunk before the one being reduced, and of the
+  // one being reduced
+  std::future<void> pending;
+  std::future<void> next;
+  try {
+    for (uint64_t seq = firstSeq; seq <= firstSeq + numChunks; seq++) {
+      if (seq < firstSeq + numChunks) {
+        const size_t n = chunkSize(seq);
+        // The buffers were last used by chunk seq - 2
+        if (seq > 2) {
+          waitForAll(kConsumed, seq - 2);
+        }
+        memcpy(
+            buffer(seq, localRank_),
+            data + chunkOffset(seq) * elementSize,
+            n * elementSize);
+        publish(kArrived, localRank_, seq);
+        waitForAll(kArrived, seq);
+
+        // Reduce our slice of the chunk across all copies
+        const size_t begin = n * localRank_ / localSize_;
+        const size_t end = n * (localRank_ + 1) / localSize_;
+        const size_t offset = begin * elementSize;
+        char* result = buffer(seq, localSize_) + offset;
+        if (localSize_ == 1) {
+          memcpy(result, buffer(seq, 0) + offset, (end - begin) * elementSize);
+        } else if (end > begin) {
+          fn(result,
+             buffer(seq, 0) + offset,
+             buffer(seq, 1) + offset,
+             end - begin);
+          for (int i = 2; i < localSize_; i++) {
+            fn(result, result, buffer(seq, i) + offset, end - begin);
+          }
+        }
+        publish(kReduced, localRank_, seq);
+
+        if (runLeaderStage) {
+          waitForAll(kReduced, seq);
+          char* reduced = buffer(seq, localSize_);
+          next = enqueueLeaderWork([reduced, n, seq, &leaderAllreduce] {
+            leaderAllreduce(reduced, n, static_cast<uint32_t>(seq));
+          });
+        }
+      }
+
+      if (seq > firstSeq) {
+        const uint64_t prev = seq - 1;
+        if (runLeaderStage) {
+          pending.get();
+          publish(kDone, 0, prev);
+        } else if (isLeader()) {
+          waitForAll(kReduced, prev);
+          publish(kDone, 0, prev);
+        } else {
+          waitFor(kDone, 0, prev);
+        }
+        memcpy(
+            data + chunkOffset(prev) * elementSize,
+            buffer(prev, localSize_),
+            chunkSize(prev) * elementSize);
+        publish(kConsumed, localRank_, prev);
+      }
+      pending = std::move(next);
+    }
+  } catch (...) {
+    // The leader stage refers to `leaderAllreduce`, which must outlive it.
+    for (auto future : {&pending, &next}) {
+      if (future->valid()) {
+        future->wait();
+      }
+    }
+    throw;
+  }
+  seq_ += numChunks;
+}
+
+char* HierarchicalAllreduce::buffer(uint64_t seq, int localRank) const {
+  return buffers_ + ((seq % 2) * (localSize_ + 1) + localRank) * chunkBytes_;
+}
+
+void HierarchicalAllreduce::publish(int counter, int localRank, uint64_t seq) {
+  counters_[counter * localSize_ + localRank].value.store(
+      seq, std::memory_order_release);
+}
+
+void HierarchicalAllreduce::waitFor(int counter, int localRank, uint64_t seq) {
+  const auto& value = counters_[counter * localSize_ + localRank].value;
+  // The other processes are normally a memcpy away, so spin a little. When
+  // one of them is late, e.g. still in backward, it may take a while: sleep
+  // for exponentially longer, so as not to take a core from it.
+  for (size_t spins = 0; spins < 1024; spins++) {
+    if (value.load(std::memory_order_acquire) >= seq) {
+      return;
+    }
+  }
+  const auto start = std::chrono::steady_clock::now();
+  auto backoff = std::chrono::microseconds(1);
+  while (value.load(std::memory_order_acquire) < seq) {
+    if (timeout_ != Store::kNoTimeout &&
+        std::chrono::steady_clock::now() - start > timeout_) {
+      throw std::runtime_error(
+          "Timed out in hierarchical allreduce waiting for local rank " +
+          std::to_string(localRank));
+    }
+    std::this_thread::sleep_for(backoff);
+    backoff = std::min(backoff * 2, kMaxBackoff);
+  }
+}
+
+void HierarchicalAllreduce::waitForAll(int counter, uint64_t seq) {
+  for (int i = 0; i < localSize_; i++) {
+    waitFor(counter, i, seq);
+  }
+}
+
+std::future<void> HierarchicalAllreduce::enqueueLeaderWork(
+    std::function<void()> fn) {
+  std::packaged_task<void()> task(std::move(fn));
+  auto future = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(leaderMutex_);
+    leaderQueue_.push_back(std::move(task));
+  }
+  leaderCV_.notify_one();
+  return future;
+}
+
+void HierarchicalAllreduce::leaderLoop() {
+  std::unique_lock<std::mutex> lock(leaderMutex_);
+  while (true) {
+    leaderCV_.wait(lock, [&] { return stop_ || !leaderQueue_.empty(); });
+    if (leaderQueue_.empty()) {
+      return;
+    }
+    auto task = std::move(leaderQueue_.front());
+    leaderQueue_.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
+
+} // namespace c10d
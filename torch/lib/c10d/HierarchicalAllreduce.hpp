@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <c10d/Store.hpp>
+
+namespace c10d {
+
+struct HierarchicalAllreduceCounter;
+
+// HierarchicalAllreduce implements the allreduce of ProcessGroupGloo's
+// hierarchical mode, for processes of which several run on the same host.
+//
+// Every chunk of the buffer goes through three stages:
+// 1) The processes on a host copy it to a shared memory segment, and each
+//    of them reduces a slice of it across all their copies.
+// 2) One leader process per host allreduces the result with the other
+//    leaders, through the caller provided `LeaderAllreduce`.
+// 3) The processes on a host copy the result back.
+//
+// Two chunks are in flight at any time: the leader allreduces one chunk on a
+// background thread while its host reduces the next one.
+//
+// All processes in the group must call `run` in the same order. Calls from
+// multiple threads are serialized in the order of their tickets.
+class HierarchicalAllreduce {
+ public:
+  // c = reduce(a, b) over n elements.
+  using ReduceFunc =
+      std::function<void(void*, const void*, const void*, size_t)>;
+
+  // Allreduces `count` elements at `data` among the leaders, in place. The
+  // `tag` is unique among concurrent calls.
+  using LeaderAllreduce =
+      std::function<void(void* data, size_t count, uint32_t tag)>;
+
+  // Finds the processes in the group running on the same host as this one,
+  // as given by `hostId`, and attaches them to a shared memory segment with
+  // room for chunks of `chunkBytes` bytes. Must be called by all processes
+  // in the group.
+  static std::shared_ptr<HierarchicalAllreduce> create(
+      Store& store,
+      int rank,
+      int size,
+      const std::string& hostId,
+      size_t chunkBytes,
+      std::chrono::milliseconds timeout);
+
+  // Identifies this host by its hostname and boot id, so that processes in
+  // separate containers on the same machine are still told apart.
+  static std::string defaultHostId();
+
+  ~HierarchicalAllreduce();
+
+  HierarchicalAllreduce(const HierarchicalAllreduce&) = delete;
+  HierarchicalAllreduce& operator=(const HierarchicalAllreduce&) = delete;
+
+  bool isLeader() const {
+    return localRank_ == 0;
+  }
+
+  // Index of this host among all hosts, ordered by their lowest rank.
+  int hostIndex() const {
+    return hostIndex_;
+  }
+
+  int numHosts() const {
+    return numHosts_;
+  }
+
+  int localSize() const {
+    return localSize_;
+  }
+
+  // Reserves the turn of a call to `run`, in the order calls must happen.
+  uint64_t nextTicket();
+
+  // Allreduces `count` elements of `elementSize` bytes at `data`, in place.
+  // `leaderAllreduce` is only called on leaders, and only if there are
+  // multiple hosts.
+  void run(
+      uint64_t ticket,
+      void* data,
+      size_t count,
+      size_t elementSize,
+      const ReduceFunc& fn,
+      const LeaderAllreduce& leaderAllreduce);
+
+ private:
+  HierarchicalAllreduce(
+      int localRank,
+      int localSize,
+      int hostIndex,
+      int numHosts,
+      size_t chunkBytes,
+      std::chrono::milliseconds timeout,
+      void* mapping,
+      size_t mappingSize);
+
+  void runChunks(
+      char* data,
+      size_t count,
+      size_t elementSize,
+      const ReduceFunc& fn,
+      const LeaderAllreduce& leaderAllreduce);
+
+  // Blocks until the counter `counter` of all local processes reaches `seq`.
+  void waitForAll(int counter, uint64_t seq);
+  void waitFor(int counter, int localRank, uint64_t seq);
+  void publish(int counter, int localRank, uint64_t seq);
+
+  // The copy of chunk `seq` made by `localRank`, or the reduced chunk if
+  // `localRank` is localSize_. Chunks alternate between two sets of buffers.
+  char* buffer(uint64_t seq, int localRank) const;
+
+  std::future<void> enqueueLeaderWork(std::function<void()> fn);
+  void leaderLoop();
+
+  const int localRank_;
+  const int localSize_;
+  const int hostIndex_;
+  const int numHosts_;
+  const size_t chunkBytes_;
+  const std::chrono::milliseconds timeout_;
+
+  void* const mapping_;
+  const size_t mappingSize_;
+  HierarchicalAllreduceCounter* const counters_;
+  char* const buffers_;
+
+  // Set when a call failed half way, leaving the processes on this host out
+  // of step.
+  bool failed_ = false;
+
+  // Sequence number of the last chunk processed, the same on all processes
+  // on the host.
+  uint64_t seq_ = 0;
+
+  uint64_t nextTicket_ = 0;
+  uint64_t currentTicket_ = 0;
+  std::mutex ticketMutex_;
+  std::condition_variable ticketCV_;
+
+  // Runs the leader stage of a chunk while the next one is reduced.
+  std::thread leaderThread_;
+  std::deque<std::packaged_task<void()>> leaderQueue_;
+  std::mutex leaderMutex_;
+  std::condition_variable leaderCV_;
+  bool stop_ = false;
+};
+
+} // namespace c10d
@@ -29,6 +29,19 @@ std::vector<uint8_t> PrefixStore::get(const std::string& key) {
   return store_.get(joinKey(key));
 }
 
+void PrefixStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  auto joinedKeys = joinKeys(keys);
+  store_.multiSet(joinedKeys, values);
+}
+
+std::vector<std::vector<uint8_t>> PrefixStore::multiGet(
+    const std::vector<std::string>& keys) {
+  auto joinedKeys = joinKeys(keys);
+  return store_.multiGet(joinedKeys);
+}
+
 int64_t PrefixStore::add(const std::string& key, int64_t value) {
   return store_.add(joinKey(key), value);
 }
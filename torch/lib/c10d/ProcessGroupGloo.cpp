@@ -217,6 +217,11 @@ void setOutput(O& opts, at::Tensor& tensor, std::vector<size_t>& counts) {
   opts.setOutput(getDataPointer<T>(tensor), counts);
 }
 
+template <typename T, typename O>
+void setOutput(O& opts, void* data, size_t count) {
+  opts.setOutput(static_cast<T*>(data), count);
+}
+
 #ifdef USE_CUDA
 
 at::Tensor pinnedLike(at::Tensor& tensor) {
@@ -382,7 +387,10 @@ void ProcessGroupGloo::RecvWork::abort() {
 }
 
 ProcessGroupGloo::Options::Options()
-    : timeout(std::chrono::milliseconds(10 * 1000)), threads(2) {}
+    : timeout(std::chrono::milliseconds(10 * 1000)),
+      threads(2),
+      hierarchicalAllreduce(false),
+      hierarchicalChunkBytes(1 << 20) {}
 
 namespace {
 
@@ -527,6 +535,27 @@ ProcessGroupGloo::ProcessGroupGloo(
     contexts_.push_back(std::move(context));
   }
 
+  if (options.hierarchicalAllreduce) {
+    hierarchicalAllreduce_ = HierarchicalAllreduce::create(
+        *store,
+        rank_,
+        size_,
+        options.hostId.empty() ? HierarchicalAllreduce::defaultHostId()
+                               : options.hostId,
+        options.hierarchicalChunkBytes,
+        options.timeout);
+    if (hierarchicalAllreduce_->isLeader() &&
+        hierarchicalAllreduce_->numHosts() > 1) {
+      auto context = std::make_shared<::gloo::rendezvous::Context>(
+          hierarchicalAllreduce_->hostIndex(),
+          hierarchicalAllreduce_->numHosts());
+      auto store = ::gloo::rendezvous::PrefixStore("leaders", *store_);
+      context->setTimeout(options.timeout);
+      context->connectFullMesh(store, options.devices[0]);
+      leaderContext_ = std::move(context);
+    }
+  }
+
   // Every worker thread stores the AsyncWork object it's currently
   // working on in the workInProgress_ vector. It must have size equal
   // to the number of workers such that they can simply index into it
@@ -829,6 +858,52 @@ class AsyncAllreduceCoalescedWork : public AsyncAllreduceWork {
   }
 };
 
+class AsyncHierarchicalAllreduceWork : public AsyncAllreduceWork {
+ public:
+  // The context is the leader context, or null if there is none.
+  AsyncHierarchicalAllreduceWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag,
+      std::shared_ptr<HierarchicalAllreduce> hierarchicalAllreduce)
+      : AsyncAllreduceWork(context, inputs, reduceOp, tag),
+        hierarchicalAllreduce(std::move(hierarchicalAllreduce)),
+        ticket(this->hierarchicalAllreduce->nextTicket()) {}
+
+  const std::shared_ptr<HierarchicalAllreduce> hierarchicalAllreduce;
+  const uint64_t ticket;
+
+  void run() override {
+    const auto& scalarType = inputs[0].scalar_type();
+    const auto fn = getFunction(scalarType, reduceOp);
+    // Reduce the local inputs first, then across processes.
+    auto output = inputs[0].contiguous();
+    for (size_t i = 1; i < inputs.size(); i++) {
+      auto input = inputs[i].contiguous();
+      fn(output.data_ptr(), output.data_ptr(), input.data_ptr(), output.numel());
+    }
+    hierarchicalAllreduce->run(
+        ticket,
+        output.data_ptr(),
+        output.numel(),
+        output.element_size(),
+        fn,
+        [&](void* data, size_t count, uint32_t tag) {
+          gloo::AllreduceOptions opts(context);
+          opts.setReduceFunction(fn);
+          opts.setTag(tag);
+          GENERATE_ALL_TYPES(scalarType, setOutput, opts, data, count);
+          gloo::allreduce(opts);
+        });
+    for (auto& input : inputs) {
+      if (!input.is_same(output)) {
+        input.copy_(output);
+      }
+    }
+  }
+};
+
 class AsyncSparseAllreduceWork : public ProcessGroupGloo::AsyncWork {
  public:
   AsyncSparseAllreduceWork(
@@ -1254,7 +1329,10 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
   auto tag = nextTag();
   auto context = getContext(tag);
   if (device.type() == at::kCPU) {
-    if (layout == c10::kStrided) {
+    if (layout == c10::kStrided && hierarchicalAllreduce_) {
+      work = std::make_shared<AsyncHierarchicalAllreduceWork>(
+          leaderContext_, inputs, opts.reduceOp, tag, hierarchicalAllreduce_);
+    } else if (layout == c10::kStrided) {
       work = std::make_shared<AsyncAllreduceWork>(
           std::move(context), inputs, opts.reduceOp, tag);
     } else if (layout == c10::kSparse) {
@@ -20,6 +20,7 @@
 #include <c10/cuda/CUDAStream.h>
 #endif
 
+#include <c10d/HierarchicalAllreduce.hpp>
 #include <c10d/ProcessGroup.hpp>
 #include <c10d/Store.hpp>
 #include <c10d/Types.hpp>
@@ -129,6 +130,18 @@ class ProcessGroupGloo : public ProcessGroup {
     std::vector<std::shared_ptr<::gloo::transport::Device>> devices;
     std::chrono::milliseconds timeout;
     int threads;
+
+    // Allreduce dense CPU tensors in three stages: a reduction among the
+    // processes on every host through shared memory, a ring allreduce among
+    // one leader process per host, and a copy of the result back to the
+    // processes on every host. Tensors are split in chunks of
+    // `hierarchicalChunkBytes` bytes, which are pipelined through the stages.
+    bool hierarchicalAllreduce;
+    size_t hierarchicalChunkBytes;
+
+    // Processes with the same host id share memory in hierarchical
+    // allreduce. Defaults to an id of the host the process runs on.
+    std::string hostId;
   };
 
   // Helper functions to create a new device object.
@@ -226,6 +239,12 @@ class ProcessGroupGloo : public ProcessGroup {
   std::vector<std::thread> threads_;
   bool stop_;
 
+  // Only set in hierarchical allreduce mode. The leader context connects the
+  // leader processes of every host, and is only set on leaders if there are
+  // multiple hosts.
+  std::shared_ptr<HierarchicalAllreduce> hierarchicalAllreduce_;
+  std::shared_ptr<::gloo::Context> leaderContext_;
+
   // Incremented for every collective we kick off.
   // The value is used as tag for collective operations. Collectives are kicked
   // off in identical order across processes. Therefore the tag can be used
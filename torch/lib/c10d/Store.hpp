@@ -28,6 +28,15 @@ class Store {
 
   virtual std::vector<uint8_t> get(const std::string& key) = 0;
 
+  // Sets or gets several keys at once. Stores that talk to a server override
+  // these to do it in a single round trip.
+  virtual void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values);
+
+  virtual std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys);
+
   virtual int64_t add(const std::string& key, int64_t value) = 0;
 
   virtual bool check(const std::vector<std::string>& keys) = 0;
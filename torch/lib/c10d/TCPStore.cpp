@@ -1,26 +1,258 @@
 #include <c10d/TCPStore.hpp>
 
 #include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <system_error>
+#include <unordered_set>
 
 namespace c10d {
 
 namespace {
 
-enum class QueryType : uint8_t { SET, GET, ADD, CHECK, WAIT };
+enum class QueryType : uint8_t {
+  SET,
+  GET,
+  ADD,
+  CHECK,
+  WAIT,
+  MULTI_SET,
+  MULTI_GET
+};
 
 enum class CheckResponseType : uint8_t { READY, NOT_READY };
 
 enum class WaitResponseType : uint8_t { STOP_WAITING };
 
+std::vector<std::string> recvKeys(int socket) {
+  SizeType nargs;
+  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  std::vector<std::string> keys(nargs);
+  for (size_t i = 0; i < nargs; i++) {
+    keys[i] = tcputil::recvString(socket);
+  }
+  return keys;
+}
+
+// sends keys as received by recvKeys
+void sendKeys(int socket, const std::vector<std::string>& keys) {
+  SizeType nkeys = keys.size();
+  tcputil::sendBytes<SizeType>(socket, &nkeys, 1, (nkeys > 0));
+  for (size_t i = 0; i < nkeys; i++) {
+    tcputil::sendString(socket, keys[i], (i != (nkeys - 1)));
+  }
+}
+
+} // anonymous namespace
+
+// A client blocked in a wait. It is answered by whichever thread sets the
+// last of the keys it waits on, so the socket is only written to, and closed,
+// with `mutex` held.
+struct TCPStoreWaiter {
+  explicit TCPStoreWaiter(int socket) : socket(socket) {}
+
+  std::mutex mutex;
+  const int socket;
+  // Keys not set yet, plus one held by the wait handler while it registers
+  size_t keysRemaining = 1;
+  // Set when the socket was closed or the client started another wait
+  std::atomic<bool> cancelled{false};
+};
+
+namespace {
+
+// Drops one of the keys `waiter` waits on, and answers it if it was the last.
+void releaseWaiter(TCPStoreWaiter& waiter) {
+  std::lock_guard<std::mutex> lock(waiter.mutex);
+  if (--waiter.keysRemaining == 0 && !waiter.cancelled) {
+    try {
+      tcputil::sendValue<WaitResponseType>(
+          waiter.socket, WaitResponseType::STOP_WAITING);
+    } catch (...) {
+      // The connection is gone, the worker owning the socket will close it.
+    }
+  }
+}
+
 } // anonymous namespace
 
+// Serves the queries arriving on the sockets handed to it by the daemon. It
+// waits for them on its own epoll instance, or with poll where there is no
+// epoll. Every socket is read from by a single worker only.
+class TCPStoreWorker {
+ public:
+  TCPStoreWorker(TCPStoreDaemon& daemon, int stopFd);
+  ~TCPStoreWorker();
+
+  void addSocket(int socket);
+  void join();
+
+ private:
+  void run();
+  // Fills `ready` with the sockets that have a query. Returns false once the
+  // daemon is stopping.
+  bool waitForQueries(std::vector<int>& ready);
+  void closeSocket(int socket);
+
+  TCPStoreDaemon& daemon_;
+  const int stopFd_;
+
+  std::mutex socketsMutex_;
+  std::unordered_set<int> sockets_;
+  // Only accessed by the worker thread
+  std::unordered_map<int, std::shared_ptr<TCPStoreWaiter>> waiters_;
+
+#ifdef __linux__
+  int epollFd_ = -1;
+#else
+  // Wakes up poll when a socket is added
+  std::vector<int> wakeupPipeFd_{-1, -1};
+#endif
+
+  std::thread thread_;
+};
+
+TCPStoreWorker::TCPStoreWorker(TCPStoreDaemon& daemon, int stopFd)
+    : daemon_(daemon), stopFd_(stopFd) {
+#ifdef __linux__
+  SYSCHECK_ERR_RETURN_NEG1(epollFd_ = epoll_create1(EPOLL_CLOEXEC));
+  // The read end of the control pipe hangs up when the daemon stops
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = stopFd_;
+  SYSCHECK_ERR_RETURN_NEG1(
+      epoll_ctl(epollFd_, EPOLL_CTL_ADD, stopFd_, &event));
+#else
+  if (pipe(wakeupPipeFd_.data()) == -1) {
+    throw std::runtime_error(
+        "Failed to create the wakeup pipe of a TCPStore worker");
+  }
+#endif
+  thread_ = std::thread(&TCPStoreWorker::run, this);
+}
+
+TCPStoreWorker::~TCPStoreWorker() {
+  for (auto socket : sockets_) {
+    ::close(socket);
+  }
+#ifdef __linux__
+  ::close(epollFd_);
+#else
+  for (auto fd : wakeupPipeFd_) {
+    ::close(fd);
+  }
+#endif
+}
+
+void TCPStoreWorker::join() {
+  thread_.join();
+}
+
+void TCPStoreWorker::addSocket(int socket) {
+  std::lock_guard<std::mutex> lock(socketsMutex_);
+  sockets_.insert(socket);
+#ifdef __linux__
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = socket;
+  SYSCHECK_ERR_RETURN_NEG1(epoll_ctl(epollFd_, EPOLL_CTL_ADD, socket, &event));
+#else
+  char byte = 0;
+  SYSCHECK_ERR_RETURN_NEG1(::write(wakeupPipeFd_[1], &byte, 1));
+#endif
+}
+
+bool TCPStoreWorker::waitForQueries(std::vector<int>& ready) {
+  ready.clear();
+#ifdef __linux__
+  std::array<struct epoll_event, 64> events;
+  int numEvents;
+  SYSCHECK_ERR_RETURN_NEG1(
+      numEvents = epoll_wait(epollFd_, events.data(), events.size(), -1));
+  for (int i = 0; i < numEvents; i++) {
+    if (events[i].data.fd == stopFd_) {
+      return false;
+    }
+    ready.push_back(events[i].data.fd);
+  }
+#else
+  std::vector<struct pollfd> fds;
+  fds.push_back({.fd = stopFd_, .events = POLLHUP});
+  fds.push_back({.fd = wakeupPipeFd_[0], .events = POLLIN});
+  {
+    std::lock_guard<std::mutex> lock(socketsMutex_);
+    for (auto socket : sockets_) {
+      fds.push_back({.fd = socket, .events = POLLIN});
+    }
+  }
+  SYSCHECK_ERR_RETURN_NEG1(::poll(fds.data(), fds.size(), -1));
+  if (fds[0].revents != 0) {
+    return false;
+  }
+  if (fds[1].revents != 0) {
+    char bytes[64];
+    SYSCHECK_ERR_RETURN_NEG1(::read(wakeupPipeFd_[0], bytes, sizeof(bytes)));
+  }
+  for (size_t i = 2; i < fds.size(); i++) {
+    if (fds[i].revents != 0) {
+      ready.push_back(fds[i].fd);
+    }
+  }
+#endif
+  return true;
+}
+
+void TCPStoreWorker::run() {
+  std::vector<int> ready;
+  while (waitForQueries(ready)) {
+    for (int socket : ready) {
+      try {
+        daemon_.query(socket, waiters_[socket]);
+      } catch (...) {
+        // There was an error when processing query. Probably an exception
+        // occurred in recv/send what would indicate that socket on the other
+        // side has been closed. If the closing was due to normal exit, then
+        // the store should continue executing. Otherwise, if it was different
+        // exception, other connections will get an exception once they try to
+        // use the store. We will go ahead and close this connection whenever
+        // we hit an exception here.
+        closeSocket(socket);
+      }
+    }
+  }
+}
+
+void TCPStoreWorker::closeSocket(int socket) {
+  {
+    std::lock_guard<std::mutex> lock(socketsMutex_);
+    sockets_.erase(socket);
+#ifdef __linux__
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, socket, nullptr);
+#endif
+  }
+  // Keys set later must not answer on a reused file descriptor. The waiter
+  // stays registered on the keys until they are set.
+  std::unique_lock<std::mutex> waiterLock;
+  auto it = waiters_.find(socket);
+  if (it != waiters_.end() && it->second) {
+    waiterLock = std::unique_lock<std::mutex>(it->second->mutex);
+    it->second->cancelled = true;
+  }
+  ::close(socket);
+  if (waiterLock) {
+    waiterLock.unlock();
+  }
+  waiters_.erase(socket);
+}
+
 // TCPStoreDaemon class methods
 // Simply start the daemon thread
-TCPStoreDaemon::TCPStoreDaemon(int storeListenSocket)
+TCPStoreDaemon::TCPStoreDaemon(int storeListenSocket, size_t numWorkers)
     : storeListenSocket_(storeListenSocket) {
   // Use control pipe to signal instance destruction to the daemon thread.
   if (pipe(controlPipeFd_.data()) == -1) {
@@ -28,20 +260,19 @@ TCPStoreDaemon::TCPStoreDaemon(int storeListenSocket)
         "Failed to create the control pipe to start the "
         "TCPStoreDaemon run");
   }
+  for (size_t i = 0; i < std::max<size_t>(numWorkers, 1); i++) {
+    workers_.emplace_back(new TCPStoreWorker(*this, controlPipeFd_[0]));
+  }
   daemonThread_ = std::thread(&TCPStoreDaemon::run, this);
 }
 
 TCPStoreDaemon::~TCPStoreDaemon() {
   // Stop the run
   stop();
-  // Join the thread
+  // Join the threads
   join();
   // Close unclosed sockets
-  for (auto socket : sockets_) {
-    if (socket != -1) {
-      ::close(socket);
-    }
-  }
+  workers_.clear();
   // Now close the rest control pipe
   for (auto fd : controlPipeFd_) {
     if (fd != -1) {
@@ -52,6 +283,13 @@ TCPStoreDaemon::~TCPStoreDaemon() {
 
 void TCPStoreDaemon::join() {
   daemonThread_.join();
+  for (auto& worker : workers_) {
+    worker->join();
+  }
+}
+
+size_t TCPStoreDaemon::defaultNumWorkers() {
+  return std::max(1u, std::min(std::thread::hardware_concurrency(), 8u));
 }
 
 void TCPStoreDaemon::run() {
@@ -60,29 +298,14 @@ void TCPStoreDaemon::run() {
   // Push the read end of the pipe to signal the stopping of the daemon run
   fds.push_back({.fd = controlPipeFd_[0], .events = POLLHUP});
 
-  // receive the queries
-  bool finished = false;
-  while (!finished) {
-    for (size_t i = 0; i < sockets_.size(); i++) {
-      fds[i].revents = 0;
+  // accept the connections
+  while (true) {
+    for (auto& fd : fds) {
+      fd.revents = 0;
     }
 
     SYSCHECK_ERR_RETURN_NEG1(::poll(fds.data(), fds.size(), -1));
 
-    // TCPStore's listening socket has an event and it should now be able to
-    // accept new connections.
-    if (fds[0].revents != 0) {
-      if (fds[0].revents ^ POLLIN) {
-        throw std::system_error(
-            ECONNABORTED,
-            std::system_category(),
-            "Unexpected poll revent on the master's listening socket: " +
-                std::to_string(fds[0].revents));
-      }
-      int sockFd = std::get<0>(tcputil::accept(storeListenSocket_));
-      sockets_.push_back(sockFd);
-      fds.push_back({.fd = sockFd, .events = POLLIN});
-    }
     // The pipe receives an event which tells us to shutdown the daemon
     if (fds[1].revents != 0) {
       // Will be POLLUP when the pipe is closed
@@ -93,57 +316,20 @@ void TCPStoreDaemon::run() {
             "Unexpected poll revent on the control pipe's reading fd: " +
                 std::to_string(fds[1].revents));
       }
-      finished = true;
       break;
     }
-    // Skipping the fds[0] and fds[1],
-    // fds[0] is master's listening socket
-    // fds[1] is control pipe's reading fd
-    for (size_t fdIdx = 2; fdIdx < fds.size(); ++fdIdx) {
-      if (fds[fdIdx].revents == 0) {
-        continue;
-      }
-
-      // Now query the socket that has the event
-      try {
-        query(fds[fdIdx].fd);
-      } catch (...) {
-        // There was an error when processing query. Probably an exception
-        // occurred in recv/send what would indicate that socket on the other
-        // side has been closed. If the closing was due to normal exit, then
-        // the store should continue executing. Otherwise, if it was different
-        // exception, other connections will get an exception once they try to
-        // use the store. We will go ahead and close this connection whenever
-        // we hit an exception here.
-        ::close(fds[fdIdx].fd);
-
-        // Remove all the tracking state of the close FD
-        for (auto it = waitingSockets_.begin(); it != waitingSockets_.end();) {
-          for (auto vecIt = it->second.begin(); vecIt != it->second.end();) {
-            if (*vecIt == fds[fdIdx].fd) {
-              vecIt = it->second.erase(vecIt);
-            } else {
-              ++vecIt;
-            }
-          }
-          if (it->second.size() == 0) {
-            it = waitingSockets_.erase(it);
-          } else {
-            ++it;
-          }
-        }
-        for (auto it = keysAwaited_.begin(); it != keysAwaited_.end();) {
-          if (it->first == fds[fdIdx].fd) {
-            it = keysAwaited_.erase(it);
-          } else {
-            ++it;
-          }
-        }
-        fds.erase(fds.begin() + fdIdx);
-        sockets_.erase(sockets_.begin() + fdIdx - 2);
-        --fdIdx;
-        continue;
+    // TCPStore's listening socket has an event and it should now be able to
+    // accept new connections.
+    if (fds[0].revents != 0) {
+      if (fds[0].revents ^ POLLIN) {
+        throw std::system_error(
+            ECONNABORTED,
+            std::system_category(),
+            "Unexpected poll revent on the master's listening socket: " +
+                std::to_string(fds[0].revents));
       }
+      int sockFd = std::get<0>(tcputil::accept(storeListenSocket_));
+      workers_[nextWorker_++ % workers_.size()]->addSocket(sockFd);
     }
   }
 }
@@ -159,82 +345,139 @@ void TCPStoreDaemon::stop() {
 // query communicates with the worker. The format
 // of the query is as follows:
 // type of query | size of arg1 | arg1 | size of arg2 | arg2 | ...
-// or, in the case of wait
+// or, in the case of wait, check and multi get
 // type of query | number of args | size of arg1 | arg1 | ...
-void TCPStoreDaemon::query(int socket) {
+// or, in the case of multi set
+// type of query | number of keys | size of key1 | key1 | size of value1 |
+// value1 | ...
+void TCPStoreDaemon::query(
+    int socket,
+    std::shared_ptr<TCPStoreWaiter>& waiter) {
   QueryType qt;
   tcputil::recvBytes<QueryType>(socket, &qt, 1);
 
   if (qt == QueryType::SET) {
     setHandler(socket);
 
+  } else if (qt == QueryType::MULTI_SET) {
+    multiSetHandler(socket);
+
   } else if (qt == QueryType::ADD) {
     addHandler(socket);
 
   } else if (qt == QueryType::GET) {
     getHandler(socket);
 
+  } else if (qt == QueryType::MULTI_GET) {
+    multiGetHandler(socket);
+
   } else if (qt == QueryType::CHECK) {
     checkHandler(socket);
 
   } else if (qt == QueryType::WAIT) {
-    waitHandler(socket);
+    waitHandler(socket, waiter);
 
   } else {
     throw std::runtime_error("Unexpected query type");
   }
 }
 
-void TCPStoreDaemon::wakeupWaitingClients(const std::string& key) {
-  auto socketsToWait = waitingSockets_.find(key);
-  if (socketsToWait != waitingSockets_.end()) {
-    for (int socket : socketsToWait->second) {
-      if (--keysAwaited_[socket] == 0) {
-        tcputil::sendValue<WaitResponseType>(
-            socket, WaitResponseType::STOP_WAITING);
-      }
+TCPStoreDaemon::Shard& TCPStoreDaemon::shardFor(const std::string& key) {
+  return shards_[std::hash<std::string>()(key) % kNumShards];
+}
+
+void TCPStoreDaemon::wakeupWaitingClients(
+    std::vector<std::shared_ptr<TCPStoreWaiter>> waiters) {
+  for (auto& waiter : waiters) {
+    releaseWaiter(*waiter);
+  }
+}
+
+void TCPStoreDaemon::setValue(
+    const std::string& key,
+    std::vector<uint8_t> value) {
+  std::vector<std::shared_ptr<TCPStoreWaiter>> waiters;
+  {
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.values[key] = std::move(value);
+    auto it = shard.waiters.find(key);
+    if (it != shard.waiters.end()) {
+      waiters = std::move(it->second);
+      shard.waiters.erase(it);
     }
-    waitingSockets_.erase(socketsToWait);
   }
+  // On "set", wake up all clients that have been waiting
+  wakeupWaitingClients(std::move(waiters));
+}
+
+std::vector<uint8_t> TCPStoreDaemon::getValue(const std::string& key) {
+  auto& shard = shardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.values.at(key);
 }
 
 void TCPStoreDaemon::setHandler(int socket) {
   std::string key = tcputil::recvString(socket);
-  tcpStore_[key] = tcputil::recvVector<uint8_t>(socket);
-  // On "set", wake up all clients that have been waiting
-  wakeupWaitingClients(key);
+  setValue(key, tcputil::recvVector<uint8_t>(socket));
+}
+
+void TCPStoreDaemon::multiSetHandler(int socket) {
+  SizeType nargs;
+  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  for (size_t i = 0; i < nargs; i++) {
+    std::string key = tcputil::recvString(socket);
+    setValue(key, tcputil::recvVector<uint8_t>(socket));
+  }
 }
 
 void TCPStoreDaemon::addHandler(int socket) {
   std::string key = tcputil::recvString(socket);
   int64_t addVal = tcputil::recvValue<int64_t>(socket);
 
-  if (tcpStore_.find(key) != tcpStore_.end()) {
-    auto buf = reinterpret_cast<const char*>(tcpStore_[key].data());
-    auto len = tcpStore_[key].size();
-    addVal += std::stoll(std::string(buf, len));
+  std::vector<std::shared_ptr<TCPStoreWaiter>> waiters;
+  {
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& value = shard.values[key];
+    if (!value.empty()) {
+      auto buf = reinterpret_cast<const char*>(value.data());
+      addVal += std::stoll(std::string(buf, value.size()));
+    }
+    auto addValStr = std::to_string(addVal);
+    value = std::vector<uint8_t>(addValStr.begin(), addValStr.end());
+    auto it = shard.waiters.find(key);
+    if (it != shard.waiters.end()) {
+      waiters = std::move(it->second);
+      shard.waiters.erase(it);
+    }
   }
-  auto addValStr = std::to_string(addVal);
-  tcpStore_[key] = std::vector<uint8_t>(addValStr.begin(), addValStr.end());
   // Now send the new value
   tcputil::sendValue<int64_t>(socket, addVal);
   // On "add", wake up all clients that have been waiting
-  wakeupWaitingClients(key);
+  wakeupWaitingClients(std::move(waiters));
 }
 
-void TCPStoreDaemon::getHandler(int socket) const {
+void TCPStoreDaemon::getHandler(int socket) {
   std::string key = tcputil::recvString(socket);
-  auto data = tcpStore_.at(key);
+  auto data = getValue(key);
   tcputil::sendVector<uint8_t>(socket, data);
 }
 
-void TCPStoreDaemon::checkHandler(int socket) const {
-  SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
-  std::vector<std::string> keys(nargs);
-  for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
+void TCPStoreDaemon::multiGetHandler(int socket) {
+  auto keys = recvKeys(socket);
+  std::vector<std::vector<uint8_t>> values;
+  values.reserve(keys.size());
+  for (const auto& key : keys) {
+    values.push_back(getValue(key));
   }
+  for (size_t i = 0; i < values.size(); i++) {
+    tcputil::sendVector<uint8_t>(socket, values[i], i != values.size() - 1);
+  }
+}
+
+void TCPStoreDaemon::checkHandler(int socket) {
+  auto keys = recvKeys(socket);
   // Now we have received all the keys
   if (checkKeys(keys)) {
     tcputil::sendValue<CheckResponseType>(socket, CheckResponseType::READY);
@@ -243,27 +486,46 @@ void TCPStoreDaemon::checkHandler(int socket) const {
   }
 }
 
-void TCPStoreDaemon::waitHandler(int socket) {
-  SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
-  std::vector<std::string> keys(nargs);
-  for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
+void TCPStoreDaemon::waitHandler(
+    int socket,
+    std::shared_ptr<TCPStoreWaiter>& waiter) {
+  auto keys = recvKeys(socket);
+  // A client only waits again after its previous wait timed out, which must
+  // not be answered anymore.
+  if (waiter) {
+    waiter->cancelled = true;
   }
-  if (checkKeys(keys)) {
-    tcputil::sendValue<WaitResponseType>(
-        socket, WaitResponseType::STOP_WAITING);
-  } else {
-    for (auto& key : keys) {
-      waitingSockets_[key].push_back(socket);
+  waiter = std::make_shared<TCPStoreWaiter>(socket);
+  for (const auto& key : keys) {
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.values.count(key) > 0) {
+      continue;
     }
-    keysAwaited_[socket] = keys.size();
+    {
+      std::lock_guard<std::mutex> waiterLock(waiter->mutex);
+      waiter->keysRemaining++;
+    }
+    auto& waiters = shard.waiters[key];
+    waiters.erase(
+        std::remove_if(
+            waiters.begin(),
+            waiters.end(),
+            [](const std::shared_ptr<TCPStoreWaiter>& w) {
+              return w->cancelled.load();
+            }),
+        waiters.end());
+    waiters.push_back(waiter);
   }
+  // Answers right away if all keys were there or have been set meanwhile
+  releaseWaiter(*waiter);
 }
 
-bool TCPStoreDaemon::checkKeys(const std::vector<std::string>& keys) const {
+bool TCPStoreDaemon::checkKeys(const std::vector<std::string>& keys) {
   return std::all_of(keys.begin(), keys.end(), [this](const std::string& s) {
-    return tcpStore_.count(s) > 0;
+    auto& shard = shardFor(s);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.values.count(s) > 0;
   });
 }
 
@@ -349,6 +611,38 @@ std::vector<uint8_t> TCPStore::getHelper_(const std::string& key) {
   return tcputil::recvVector<uint8_t>(storeSocket_);
 }
 
+void TCPStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument(
+        "multiSet expects as many values as keys, got " +
+        std::to_string(values.size()) + " values for " +
+        std::to_string(keys.size()) + " keys");
+  }
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::MULTI_SET);
+  SizeType nkeys = keys.size();
+  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
+  for (size_t i = 0; i < nkeys; i++) {
+    tcputil::sendString(storeSocket_, regularPrefix_ + keys[i], true);
+    tcputil::sendVector<uint8_t>(storeSocket_, values[i], (i != (nkeys - 1)));
+  }
+}
+
+std::vector<std::vector<uint8_t>> TCPStore::multiGet(
+    const std::vector<std::string>& keys) {
+  auto regKeys = regularKeys_(keys);
+  waitHelper_(regKeys, timeout_);
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::MULTI_GET);
+  sendKeys(storeSocket_, regKeys);
+  std::vector<std::vector<uint8_t>> values;
+  values.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    values.push_back(tcputil::recvVector<uint8_t>(storeSocket_));
+  }
+  return values;
+}
+
 int64_t TCPStore::add(const std::string& key, int64_t value) {
   std::string regKey = regularPrefix_ + key;
   return addHelper_(regKey, value);
@@ -363,12 +657,7 @@ int64_t TCPStore::addHelper_(const std::string& key, int64_t value) {
 
 bool TCPStore::check(const std::vector<std::string>& keys) {
   tcputil::sendValue<QueryType>(storeSocket_, QueryType::CHECK);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    std::string regKey = regularPrefix_ + keys[i];
-    tcputil::sendString(storeSocket_, regKey, (i != (nkeys - 1)));
-  }
+  sendKeys(storeSocket_, regularKeys_(keys));
   auto checkResponse = tcputil::recvValue<CheckResponseType>(storeSocket_);
   if (checkResponse == CheckResponseType::READY) {
     return true;
@@ -386,12 +675,17 @@ void TCPStore::wait(const std::vector<std::string>& keys) {
 void TCPStore::wait(
     const std::vector<std::string>& keys,
     const std::chrono::milliseconds& timeout) {
+  waitHelper_(regularKeys_(keys), timeout);
+}
+
+std::vector<std::string> TCPStore::regularKeys_(
+    const std::vector<std::string>& keys) {
   std::vector<std::string> regKeys;
   regKeys.resize(keys.size());
   for (size_t i = 0; i < keys.size(); ++i) {
     regKeys[i] = regularPrefix_ + keys[i];
   }
-  waitHelper_(regKeys, timeout);
+  return regKeys;
 }
 
 void TCPStore::waitHelper_(
@@ -409,11 +703,7 @@ void TCPStore::waitHelper_(
         sizeof(timeoutTV)));
   }
   tcputil::sendValue<QueryType>(storeSocket_, QueryType::WAIT);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    tcputil::sendString(storeSocket_, keys[i], (i != (nkeys - 1)));
-  }
+  sendKeys(storeSocket_, keys);
   auto waitResponse = tcputil::recvValue<WaitResponseType>(storeSocket_);
   if (waitResponse != WaitResponseType::STOP_WAITING) {
     throw std::runtime_error("Stop_waiting response is expected");
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 
@@ -9,36 +11,63 @@
 
 namespace c10d {
 
+class TCPStoreWorker;
+struct TCPStoreWaiter;
+
+// The TCPStore server. The daemon thread accepts connections and hands each
+// one to a worker thread, which serves all queries arriving on it. The keys
+// are spread over shards that are locked independently, so queries on
+// different keys proceed in parallel.
 class TCPStoreDaemon {
  public:
-  explicit TCPStoreDaemon(int storeListenSocket);
+  explicit TCPStoreDaemon(
+      int storeListenSocket,
+      size_t numWorkers = defaultNumWorkers());
   ~TCPStoreDaemon();
 
   void join();
 
+  static size_t defaultNumWorkers();
+
  protected:
+  friend class TCPStoreWorker;
+
+  static constexpr size_t kNumShards = 64;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<uint8_t>> values;
+    // From key -> the clients waiting on it
+    std::unordered_map<std::string, std::vector<std::shared_ptr<TCPStoreWaiter>>>
+        waiters;
+  };
+
   void run();
   void stop();
 
-  void query(int socket);
+  // `waiter` holds the last wait issued on `socket`
+  void query(int socket, std::shared_ptr<TCPStoreWaiter>& waiter);
 
   void setHandler(int socket);
+  void multiSetHandler(int socket);
   void addHandler(int socket);
-  void getHandler(int socket) const;
-  void checkHandler(int socket) const;
-  void waitHandler(int socket);
-
-  bool checkKeys(const std::vector<std::string>& keys) const;
-  void wakeupWaitingClients(const std::string& key);
+  void getHandler(int socket);
+  void multiGetHandler(int socket);
+  void checkHandler(int socket);
+  void waitHandler(int socket, std::shared_ptr<TCPStoreWaiter>& waiter);
+
+  Shard& shardFor(const std::string& key);
+  void setValue(const std::string& key, std::vector<uint8_t> value);
+  std::vector<uint8_t> getValue(const std::string& key);
+  bool checkKeys(const std::vector<std::string>& keys);
+  void wakeupWaitingClients(
+      std::vector<std::shared_ptr<TCPStoreWaiter>> waiters);
 
   std::thread daemonThread_;
-  std::unordered_map<std::string, std::vector<uint8_t>> tcpStore_;
-  // From key -> the list of sockets waiting on it
-  std::unordered_map<std::string, std::vector<int>> waitingSockets_;
-  // From socket -> number of keys awaited
-  std::unordered_map<int, size_t> keysAwaited_;
+  std::array<Shard, kNumShards> shards_;
+  std::vector<std::unique_ptr<TCPStoreWorker>> workers_;
+  size_t nextWorker_ = 0;
 
-  std::vector<int> sockets_;
   int storeListenSocket_;
   std::vector<int> controlPipeFd_{-1, -1};
 };
@@ -58,6 +87,13 @@ class TCPStore : public Store {
 
   std::vector<uint8_t> get(const std::string& key) override;
 
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values) override;
+
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys) override;
+
   int64_t add(const std::string& key, int64_t value) override;
 
   bool check(const std::vector<std::string>& keys) override;
@@ -71,6 +107,7 @@ class TCPStore : public Store {
  protected:
   int64_t addHelper_(const std::string& key, int64_t value);
   std::vector<uint8_t> getHelper_(const std::string& key);
+  std::vector<std::string> regularKeys_(const std::vector<std::string>& keys);
   void waitHelper_(
       const std::vector<std::string>& keys,
       const std::chrono::milliseconds& timeout);
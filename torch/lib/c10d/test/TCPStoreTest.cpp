@@ -111,3 +111,81 @@ TEST(TCPStoreTest, testHelper) {
 TEST(TCPStoreTest, testHelperPrefix) {
   testHelper(29501, "testPrefix");
 }
+
+// Clients waiting on keys set by other clients, in batches.
+void testMultiKey(int port) {
+  const auto numClients = 32;
+  // Every client waits on one connection and sets on another
+  const auto numWorkers = 2 * numClients + 1;
+  const auto keysPerClient = 8;
+
+  std::unique_ptr<c10d::TCPStore> serverStore;
+  auto serverThread = std::thread([&serverStore, &numWorkers, &port] {
+    serverStore = std::make_unique<c10d::TCPStore>(
+        "127.0.0.1", port, numWorkers, true, std::chrono::seconds(30));
+  });
+
+  std::vector<std::unique_ptr<c10d::TCPStore>> waitStores;
+  std::vector<std::unique_ptr<c10d::TCPStore>> setStores;
+  for (auto i = 0; i < numClients; i++) {
+    waitStores.push_back(std::unique_ptr<c10d::TCPStore>(
+        new c10d::TCPStore("127.0.0.1", port, numWorkers, false)));
+    setStores.push_back(std::unique_ptr<c10d::TCPStore>(
+        new c10d::TCPStore("127.0.0.1", port, numWorkers, false)));
+  }
+  serverThread.join();
+
+  auto keyOf = [](int client, int j) {
+    return "client_" + std::to_string(client) + "_" + std::to_string(j);
+  };
+
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < numClients; i++) {
+    threads.push_back(std::thread([&waitStores, &setStores, &keyOf, i] {
+      // Every client waits on the keys of the next one while setting its
+      // own, so most waits are answered by another connection.
+      std::vector<std::string> nextKeys;
+      for (auto j = 0; j < keysPerClient; j++) {
+        nextKeys.push_back(keyOf((i + 1) % numClients, j));
+      }
+      auto& store = *waitStores[i];
+      std::thread waiter([&store, &nextKeys] { store.wait(nextKeys); });
+
+      std::vector<std::string> keys;
+      std::vector<std::vector<uint8_t>> values;
+      for (auto j = 0; j < keysPerClient; j++) {
+        keys.push_back(keyOf(i, j));
+        auto value = "value_" + keys.back();
+        values.emplace_back(value.begin(), value.end());
+      }
+      setStores[i]->multiSet(keys, values);
+      waiter.join();
+
+      auto got = store.multiGet(nextKeys);
+      EXPECT_EQ(got.size(), nextKeys.size());
+      for (size_t j = 0; j < got.size(); j++) {
+        EXPECT_EQ(
+            std::string(got[j].begin(), got[j].end()), "value_" + nextKeys[j]);
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<std::string> allKeys;
+  for (auto i = 0; i < numClients; i++) {
+    for (auto j = 0; j < keysPerClient; j++) {
+      allKeys.push_back(keyOf(i, j));
+    }
+  }
+  EXPECT_TRUE(serverStore->check(allKeys));
+  EXPECT_EQ(serverStore->multiGet(allKeys).size(), allKeys.size());
+  EXPECT_THROW(
+      serverStore->multiSet({"a", "b"}, {std::vector<uint8_t>()}),
+      std::invalid_argument);
+}
+
+TEST(TCPStoreTest, testMultiKey) {
+  testMultiKey(29502);
+}
@@ -6,6 +6,7 @@ import torch
 
 import torch.cuda.comm
 import torch.distributed as dist
+from torch._six import string_classes
 
 if dist.is_available():
     from torch.distributed.distributed_c10d import _get_default_group
@@ -379,7 +380,8 @@ class DistributedDataParallel(Module):
             parameters,
             list(reversed(bucket_indices)),
             self.process_group,
-            expect_sparse_gradient)
+            expect_sparse_gradient,
+            self.bucket_bytes_cap)
 
         # passing a handle to torch.nn.SyncBatchNorm layer
         self._passing_sync_batchnorm_handle(self._module_copies)
@@ -437,6 +439,35 @@ class DistributedDataParallel(Module):
         finally:
             self.require_backward_grad_sync = old_require_backward_grad_sync
 
+    def register_comm_hook(self, hook, **options):
+        r"""
+        Replaces the allreduce of every bucket of dense gradients with
+        ``hook``, e.g. to compress gradients before sending them to the other
+        processes. Hooks run on a background thread while the backward pass
+        carries on, and are called for the buckets in the same order on all
+        processes.
+
+        Arguments:
+            hook (str): name of a hook in the C++ ``c10d::CommHookRegistry``,
+                to which C++ extensions can add their own. Built in are
+                ``"fp16"``, which allreduces gradients in half precision,
+                ``"topk"``, which only exchanges the ``ratio`` (default 0.01)
+                largest entries of each bucket, and ``"powersgd"``, which
+                allreduces a ``rank`` (default 2) approximation of each
+                bucket. The latter two add what they leave out to the
+                gradients of the next iteration. A hook object created by
+                a C++ extension is accepted as well.
+            **options: numeric options of the hook.
+
+        Example::
+
+            >>> ddp = torch.nn.DistributedDataParallel(model, pg)
+            >>> ddp.register_comm_hook("topk", ratio=0.01)
+        """
+        if isinstance(hook, string_classes):
+            hook = dist._create_comm_hook(hook, options)
+        self.reducer.register_comm_hook(hook)
+
     def forward(self, *inputs, **kwargs):
         if self.require_forward_param_sync:
             self._sync_params()